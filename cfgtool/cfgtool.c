@@ -39,6 +39,8 @@
 #include "cfgtool_reset.h"
 #include "cfgtool_status.h"
 #include "cfgtool_bin2hex.h"
+#include "cfgtool_relay.h"
+#include "cfgtool_sim.h"
 
 
 /* ****************************************************************************************************************** */
@@ -59,6 +61,10 @@ typedef struct CMD_s
     bool          may_u;
     bool          may_U;
     bool          may_R;
+    bool          need_d;
+    bool          may_f;
+    bool          may_s;
+    bool          may_b;
     const char   *info;
     const char *(*help)(void);
     int         (*run)(void);
@@ -86,6 +92,11 @@ typedef struct ARGS_s
     bool         doEpoch;
     bool         updateOnly;
     bool         allowReplace;
+    const char  *dstPort;
+    const char  *filter;
+    const char  *simOpts;
+    const char  *cacheFile;
+    const char  *upshift;
 
 } ARGS_t;
 
@@ -106,17 +117,22 @@ static int status(void)  { return statusRun( gArgs.rxPort, gArgs.extraInfo, gArg
 static int bin2hex(void) { return bin2hexRun(); }
 static int hex2bin(void) { return hex2binRun(); }
 static int cmd2rx(void)  { return cmd2rxRun( gArgs.rxPort, gArgs.noProbe, gArgs.extraInfo); }
+static int relay(void)   { return relayRun(  gArgs.rxPort, gArgs.dstPort, gArgs.filter, gArgs.noProbe); }
+static int sim(void)     { return simRun(    gArgs.rxPort, gArgs.simOpts); }
 
 const CMD_t kCmds[] =
 {
     { .name = "cfg2rx",  .info = "Configure a receiver from a configuration file",             .help = cfg2rxHelp,  .run = cfg2rx,
-      .need_i = true,  .need_o = false, .need_p = true,  .need_l = true,  .may_r  = true,  .may_n = false, .may_e = false, .may_u = true,  .may_U = true,  .may_R = true,  },
+      .need_i = true,  .need_o = false, .need_p = true,  .need_l = true,  .may_r  = true,  .may_n = false, .may_e = false, .may_u = true,  .may_U = true,  .may_R = true,
+      .may_b = true, },
 
     { .name = "rx2cfg",  .info = "Create configuration file from config in a receiver",        .help = rx2cfgHelp,  .run = rx2cfg,
-      .need_i = false, .need_o = true,  .need_p = true,  .need_l = true,  .need_r = false, .may_n = false, .may_e = false, .may_u = false, .may_U = false, .may_R = false, },
+      .need_i = false, .need_o = true,  .need_p = true,  .need_l = true,  .need_r = false, .may_n = false, .may_e = false, .may_u = false, .may_U = false, .may_R = false,
+      .may_b = true, },
 
     { .name = "rx2list", .info = "Like rx2cfg but output a flat list of key-value pairs",      .help = rx2listHelp, .run = rx2list,
-      .need_i = false, .need_o = true,  .need_p = true,  .need_l = true,  .need_r = false, .may_n = false, .may_e = false, .may_u = false, .may_U = false, .may_R = true,  },
+      .need_i = false, .need_o = true,  .need_p = true,  .need_l = true,  .need_r = false, .may_n = false, .may_e = false, .may_u = false, .may_U = false, .may_R = true,
+      .may_b = true, },
 
     { .name = "cfg2ubx", .info = "Convert config file to UBX-CFG-VALSET message(s)",           .help = cfg2ubxHelp, .run = cfg2ubx,
       .need_i = true,  .need_o = true,  .need_p = false, .need_l = true,  .need_r = false, .may_n = false, .may_e = false, .may_u = false, .may_U = false, .may_R = true,  },
@@ -154,6 +170,14 @@ const CMD_t kCmds[] =
     { .name = "cmd2rx", .info = "Send commands to a receiver",                                 .help = cmd2rxHelp,  .run = cmd2rx,
       .need_i = true,  .need_o = false, .need_p = true,  .need_l = false, .need_r = false, .may_n = true,  .may_e = false, .may_u = false, .may_U = false, .may_R = false, },
 
+    { .name = "relay",   .info = "Forward data from a receiver to another port (or clients)",  .help = relayHelp,   .run = relay,
+      .need_i = false, .need_o = false, .need_p = true,  .need_l = false, .need_r = false, .may_n = true,  .may_e = false, .may_u = false, .may_U = false, .may_R = false,
+      .need_d = true,  .may_f = true, },
+
+    { .name = "sim",     .info = "Simulate a receiver (for testing)",                          .help = simHelp,     .run = sim,
+      .need_i = false, .need_o = false, .need_p = true,  .need_l = false, .need_r = false, .may_n = false, .may_e = false, .may_u = false, .may_U = false, .may_R = false,
+      .may_s = true, },
+
 };
 
 const char * const kTitleStr =
@@ -199,6 +223,8 @@ const char * const kHelpStr =
     "                       [ser://]<device>[:<baudrate>]\n"
     "                       tcp://<host>:<port>[:<baudrate>]\n"
     "                       telnet://<host>:<port>[:<baudrate>]\n"
+    "                       file://<path>[@<baudrate>], fd://<fd>, unix://<path>,\n"
+    "                       pty://<path> (see below)\n"
     "    -l <layer(s)>  Configuration layer(s) to use:\n"
     "                       RAM, BBR, Flash, Default\n"
     "    -r <reset>     Reset mode to use to reset the receiver:\n"
@@ -209,6 +235,11 @@ const char * const kHelpStr =
     "    -a             Activate configuration after storing\n"
     "    -n             Do not probe/autobaud receiver, use passive reading only.\n"
     "                   For example, for other receivers or read-only connection.\n"
+    "    -d <port>      Destination port (same format as -p, or tcpsrv://[<addr>]:<port>)\n"
+    "    -f <filter>    Message filter\n"
+    "    -s <options>   Simulator options\n"
+    "    -c <file>      Cache receiver detection results (baudrate, etc.) in file\n"
+    "    -b <baudrate>  Temporarily increase the receiver baudrate up to <baudrate>\n"
     "\n"
     // -----------------------------------------------------------------------------
     "    Available <commands>s:\n"
@@ -240,14 +271,18 @@ const char * const kLicenseHelp =
 const char * const kPortHelp =
     "Serial ports:\n"
     "\n"
-    "    Local serial ports: [ser://]<device>[@<baudrate>], where:\n"
+    "    Local serial ports: [ser://]<device>[@<baudrate>][?lowlat], where:\n"
     "\n"
 #ifdef _WIN
     "        <device>     COM1, COM23, etc.\n"
 #else
     "        <device>     /dev/ttyUSB0, /dev/ttyACM1, /dev/serial/..., etc.\n"
 #endif
-    "        <baudrate>   Baudrate (optional)\n"
+    "        <baudrate>   Baudrate (optional), standard rates (9600, ..., 921600)\n"
+    "                     or any other rate (e.g. 3000000) on Linux and Windows\n"
+    "        lowlat       Low-latency mode (optional, Linux only): set the\n"
+    "                     ASYNC_LOW_LATENCY flag and the latency timer of USB\n"
+    "                     serial (FTDI) adapters to 1ms (may require permissions)\n"
     "\n"
     "        Note that 'ser://' is the default and can be omitted. If no <baudrate>\n"
     "        is specified, it is be automatically detected. That is, '-p <device>'\n"
@@ -277,7 +312,56 @@ const char * const kPortHelp =
     "        A minimal ser2net command line that should work is:\n"
     "           ser2net -d -C \"12345:telnet:0:/dev/ttyUSB0: remctl\"\n"
     "        This should allow using '-p telnet://localhost:12345'.\n"
-    "\n";
+    "\n"
+#ifndef _WIN32
+    "    Recorded data: file://<path>[@<baudrate>], where:\n"
+    "\n"
+    "        <path>       File with data previously received from a receiver\n"
+    "        <baudrate>   Replay the data paced at this baudrate (optional). By\n"
+    "                     default the data is replayed as fast as possible.\n"
+    "\n"
+    "        No receiver detection is done. Data sent to the receiver is discarded.\n"
+    "\n"
+    "    File descriptors: fd://<fd> or fd://-, where:\n"
+    "\n"
+    "        <fd>         File descriptor (number) to read from and write to\n"
+    "        -            Read from stdin and write to stdout\n"
+    "\n"
+    "    Unix domain sockets: unix://<path>, where:\n"
+    "\n"
+    "        <path>       Path of the (stream) socket\n"
+    "\n"
+    "    Pseudo terminals: pty://<path>, where:\n"
+    "\n"
+    "        <path>       Path of a symlink to the created pseudo terminal device\n"
+    "\n"
+    "        Other programs can use this like a serial port to talk to us.\n"
+    "\n"
+    "    TCP/IP server: tcpsrv://[<addr>]:<port>, where:\n"
+    "\n"
+    "        <addr>       Address to listen on (optional, default all)\n"
+    "        <port>       Port number\n"
+    "\n"
+    "        Data is sent to all connected clients. Clients that cannot keep up\n"
+    "        are disconnected. See the 'relay' command.\n"
+    "\n"
+#endif
+    "    The 'dump', 'status' and 'relay' commands reconnect tcp:// and telnet://\n"
+    "    ports automatically if the connection is lost.\n"
+    "\n"
+    "    With '-b <baudrate>' the 'cfg2rx', 'rx2cfg' and 'rx2list' commands\n"
+    "    temporarily change the baudrate of the receiver UART (in the RAM layer) and\n"
+    "    the port to the highest standard baudrate up to <baudrate> (e.g. 921600),\n"
+    "    which makes the transfer of the configuration much faster on slow links.\n"
+    "    The original baudrate is restored at the end.\n"
+    "\n"
+    "    With '-c <file>' the baudrate and the detection method of a receiver are\n"
+    "    stored in the file, keyed by the port and the device (e.g. USB serial\n"
+    "    number). The next time the receiver is tried at the stored baudrate first,\n"
+    "    which avoids the (slow) autobauding. Stale entries are detected and updated\n"
+    "    automatically.\n"
+    "\n"
+    ;
 
 const char * const kLayersHelp =
     // -----------------------------------------------------------------------------
@@ -419,6 +503,11 @@ int main(int argc, char **argv)
         _ARGS_STR("-p", gArgs.rxPort)
         _ARGS_STR("-l", gArgs.cfgLayer)
         _ARGS_STR("-r", gArgs.resetType)
+        _ARGS_STR("-d", gArgs.dstPort)
+        _ARGS_STR("-f", gArgs.filter)
+        _ARGS_STR("-s", gArgs.simOpts)
+        _ARGS_STR("-c", gArgs.cacheFile)
+        _ARGS_STR("-b", gArgs.upshift)
         _ARGS_BOOL("-u", gArgs.useUnknown, true)
         _ARGS_BOOL("-x", gArgs.extraInfo, true)
         _ARGS_BOOL("-a", gArgs.applyConfig, true)
@@ -598,6 +687,59 @@ int main(int argc, char **argv)
         res = false;
     }
 
+    // Require -d arg?
+    if ( (gArgs.cmd != NULL) && gArgs.cmd->need_d )
+    {
+        if ( (gArgs.dstPort == NULL) || (gArgs.dstPort[0] == '\0') )
+        {
+            WARNING("Need '-d <port>' argument!");
+            res = false;
+        }
+    }
+    else if ( (gArgs.cmd != NULL) && !gArgs.cmd->need_d && (gArgs.dstPort != NULL) )
+    {
+        WARNING("Illegal argument '-d %s'!", gArgs.dstPort);
+        res = false;
+    }
+
+    // May use -f arg?
+    if ( (gArgs.cmd != NULL) && !gArgs.cmd->may_f && (gArgs.filter != NULL) )
+    {
+        WARNING("Illegal argument '-f %s'!", gArgs.filter);
+        res = false;
+    }
+
+    // May use -s arg?
+    if ( (gArgs.cmd != NULL) && !gArgs.cmd->may_s && (gArgs.simOpts != NULL) )
+    {
+        WARNING("Illegal argument '-s %s'!", gArgs.simOpts);
+        res = false;
+    }
+
+    // May use -c arg?
+    if ( (gArgs.cmd != NULL) && (!gArgs.cmd->need_p || gArgs.cmd->may_s) && (gArgs.cacheFile != NULL) )
+    {
+        WARNING("Illegal argument '-c %s'!", gArgs.cacheFile);
+        res = false;
+    }
+    setRxCacheFile(gArgs.cacheFile);
+
+    // May use -b arg?
+    if ( (gArgs.cmd != NULL) && (gArgs.upshift != NULL) )
+    {
+        char *end = NULL;
+        const long baudrate = strtol(gArgs.upshift, &end, 10);
+        if (!gArgs.cmd->may_b || (*end != '\0') || (baudrate < PORT_BAUDRATE_MIN) || (baudrate > PORT_BAUDRATE_MAX))
+        {
+            WARNING("Illegal argument '-b %s'!", gArgs.upshift);
+            res = false;
+        }
+        else
+        {
+            setRxUpshift(baudrate);
+        }
+    }
+
     // May use -n arg?
     if ( (gArgs.cmd != NULL) && (!gArgs.cmd->may_n && gArgs.noProbe) )
     {
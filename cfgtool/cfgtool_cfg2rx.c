@@ -41,6 +41,7 @@ const char *cfg2rxHelp(void)
 "Command 'cfg2rx':\n"
 "\n"
 "    Usage: cfgtool cfg2rx [-i <infile>] -p <port> -l <layers> [-r <reset>] [-a] [-U] [-R]\n"
+"                          [-b <baudrate>]\n"
 "\n"
 "    This configures a receiver from a configuration file. The configuration is\n"
 "    stored to one or more (comma-separated) of the following <layers>: 'RAM',\n"
@@ -59,6 +60,9 @@ const char *cfg2rxHelp(void)
 "    early. Additionally, with '-r factory', the items not covered by <infile>\n"
 "    are checked against the default configuration.\n"
 "\n"
+"    The -b flag increases the baudrate for the transfer (see general help),\n"
+"    unless the configuration changes the baudrate of a UART in the RAM layer.\n"
+"\n"
 "    A configuration file consists of one or more lines of configuration\n"
 "    parameters. Leading and trailing whitespace, empty lines as well as comments\n"
 "    (# style) are ignored. Acceptable separators for the tokens are (any number\n"
@@ -183,7 +187,8 @@ int cfg2rxRun(const char *portArg, const char *layerArg, const char *resetArg, c
         return EXIT_OTHERFAIL;
     }
 
-    RX_t *rx = rxInit(portArg, NULL);
+    RX_OPTS_t opts = getRxOpts();
+    RX_t *rx = rxInit(portArg, &opts);
     if ( (rx == NULL) || !rxOpen(rx) )
     {
         free(allKvCfg);
@@ -191,19 +196,37 @@ int cfg2rxRun(const char *portArg, const char *layerArg, const char *resetArg, c
         return EXIT_RXFAIL;
     }
 
+    // Changing the baudrate in RAM ourselves would not go well with restoring it later
+    bool cfgBaudrate = false;
+    for (int ix = 0; ram && (ix < nAllKvCfg); ix++)
+    {
+        if ( (allKvCfg[ix].id == UBLOXCFG_CFG_UART1_BAUDRATE_ID) || (allKvCfg[ix].id == UBLOXCFG_CFG_UART2_BAUDRATE_ID) )
+        {
+            cfgBaudrate = true;
+        }
+    }
+    if (!cfgBaudrate)
+    {
+        upshiftRx(rx);
+    }
+
     // Check current config
     if (updateOnly)
     {
         bool configNeedsUpdate = false;
         // Get current and default config
         const uint32_t keys[] = { UBX_CFG_VALGET_V0_ALL_WILDCARD };
-        PRINT("Getting current configuration");
+        PRINT("Getting current%s configuration", reset == RX_RESET_FACTORY ? " and default" : "");
         UBLOXCFG_KEYVAL_t allKvRam[3000];
-        const int nAllKvRam = rxGetConfig(rx, UBLOXCFG_LAYER_RAM, keys, NUMOF(keys), allKvRam, NUMOF(allKvRam));
-        PRINT("Getting default configuration");
         UBLOXCFG_KEYVAL_t allKvDef[NUMOF(allKvRam)];
-        const int nAllKvDef = reset == RX_RESET_FACTORY ?
-            rxGetConfig(rx, UBLOXCFG_LAYER_DEFAULT, keys, NUMOF(keys), allKvDef, NUMOF(allKvDef)) : 0;
+        RX_GETCONFIG_t reqs[] =
+        {
+            { .layer = UBLOXCFG_LAYER_RAM,     .keys = keys, .numKeys = NUMOF(keys), .kv = allKvRam, .maxKv = NUMOF(allKvRam) },
+            { .layer = UBLOXCFG_LAYER_DEFAULT, .keys = keys, .numKeys = NUMOF(keys), .kv = allKvDef, .maxKv = NUMOF(allKvDef) },
+        };
+        rxGetConfigMulti(rx, reqs, reset == RX_RESET_FACTORY ? 2 : 1);
+        const int nAllKvRam = reqs[0].numKv;
+        const int nAllKvDef = reset == RX_RESET_FACTORY ? reqs[1].numKv : 0;
 
         // Check current configuration
         for (int ixKvRam = 0; ixKvRam < nAllKvRam; ixKvRam++)
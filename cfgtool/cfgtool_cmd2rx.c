@@ -368,6 +368,7 @@ static bool _strToMsg(MSG_t *msg, char *str, const char** errorHint)
 
 static bool _processCommand(RX_t* rx, const CMD_RSP_t* cmdRsp, const bool extraInfo);
 static bool _processMessage(RX_t* rx, const CMD_RSP_t* cmdRsp, const bool extraInfo);
+static void _waitRx(RX_t *rx, const uint64_t t0, const uint32_t timeout);
 
 int cmd2rxRun(const char* portArg, const bool noProbe, const bool extraInfo)
 {
@@ -383,8 +384,10 @@ int cmd2rxRun(const char* portArg, const bool noProbe, const bool extraInfo)
         return EXIT_OTHERFAIL;
     }
 
-    RX_OPTS_t rxOpts = RX_OPTS_DEFAULT();
+    RX_OPTS_t rxOpts = getRxOpts();
     rxOpts.detect = RX_DET_PASSIVE; // Should work for non u-blox receivers, too
+    // Don't block the read path on slow links while commands are being sent
+    NOT_WIN( rxOpts.txQueueSize = 64 * 1024 );
     if (noProbe) {
         rxOpts.autobaud = false;
         rxOpts.detect   = RX_DET_NONE;
@@ -416,7 +419,7 @@ int cmd2rxRun(const char* portArg, const bool noProbe, const bool extraInfo)
                 while ((TIME() - t0) < cmdRsp->timeout) {
                     PARSER_MSG_t *msg = rxGetNextMessage(rx);
                     if (msg == NULL) {
-                        SLEEP(5);
+                        _waitRx(rx, t0, cmdRsp->timeout);
                     }
                 }
                 break;
@@ -468,6 +471,19 @@ static void _printMessage(const PARSER_MSG_t* msg, const bool extraInfo)
     }
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Wait for data from the receiver, at most until the timeout
+static void _waitRx(RX_t *rx, const uint64_t t0, const uint32_t timeout)
+{
+    const uint64_t dt = TIME() - t0;
+    if (dt < timeout) {
+        rxWaitReadable(rx, timeout - dt);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
 static bool _processCommand(RX_t *rx, const CMD_RSP_t* cmdRsp, const bool extraInfo)
 {
     // Send command
@@ -497,7 +513,7 @@ static bool _processCommand(RX_t *rx, const CMD_RSP_t* cmdRsp, const bool extraI
                 }
             }
         } else {
-            SLEEP(5);
+            _waitRx(rx, t0, cmdRsp->timeout);
         }
     }
 
@@ -526,7 +542,7 @@ static bool _processMessage(RX_t *rx, const CMD_RSP_t* cmdRsp, const bool extraI
                 _printMessage(msg, extraInfo);
             }
         } else {
-            SLEEP(5);
+            _waitRx(rx, t0, cmdRsp->timeout);
         }
     }
 
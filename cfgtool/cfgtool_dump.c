@@ -41,6 +41,12 @@ const char *dumpHelp(void)
 "    and optionally a hex dump of the messages until SIGINT (e.g. CTRL-C)"NOT_WIN(", SIGHUP")"\n"
 "    or SIGTERM is received.\n"
 "\n"
+"    At the end, message statistics and port I/O statistics are output: bytes,\n"
+"    reads and writes (and their rates), a histogram of the bytes per read, the\n"
+"    read latency (time from data becoming available to the read), transmit\n"
+"    queue use and, for serial ports on Linux, line errors (framing, parity and\n"
+"    break) and overruns (UART, i.e. driver, and tty buffer, i.e. application).\n"
+"\n"
 "    Returns success (0) if receiver was detected and at least one message was\n"
 "    received. Otherwise returns "STRINGIFY(EXIT_RXFAIL)" (rx not detected) or "STRINGIFY(EXIT_RXNODATA)" (no messages).\n"
 "\n"
@@ -70,7 +76,10 @@ static void _sigHandler(int signal)
 
 int dumpRun(const char *portArg, const bool extraInfo, const bool noProbe)
 {
-    RX_OPTS_t opts = RX_OPTS_DEFAULT();
+    RX_OPTS_t opts = getRxOpts();
+    // Read port in a separate thread so that data isn't lost while we're busy writing the output
+    NOT_WIN( opts.ringSize = 1024 * 1024 );
+    opts.reconnect = true;
     if (noProbe)
     {
         opts.autobaud = false;
@@ -91,9 +100,12 @@ int dumpRun(const char *portArg, const bool extraInfo, const bool noProbe)
 
     const uint64_t tOffs = TIME() - timeOfDay(); // Offset between wall clock and parser time reference
     uint32_t nEpochs = 0;
+    uint32_t nSigDropped = 0;
+    uint32_t nSatDropped = 0;
+    static EPOCH_ARENA_t arena;
     EPOCH_t coll;
     EPOCH_t epoch;
-    epochInit(&coll);
+    epochInitArena(&coll, &arena);
 
     PRINT("Dumping received data...");
     const PARSER_t *parser = rxGetParser(rx);
@@ -106,6 +118,8 @@ int dumpRun(const char *portArg, const bool extraInfo, const bool noProbe)
             if (epochCollect(&coll, msg, &epoch))
             {
                 nEpochs++;
+                nSigDropped += epoch.numSignalsDropped;
+                nSatDropped += epoch.numSatellitesDropped;
                 ioOutputStr("epoch %4u, %s\n", epoch.seq, epoch.str);
                 if (!ioWriteOutput(parser->nMsgs == 1 ? false : true))
                 {
@@ -123,10 +137,15 @@ int dumpRun(const char *portArg, const bool extraInfo, const bool noProbe)
                 break;
             }
         }
-        // No data, yield
+        // No more data (end of replayed file)
+        else if (rxIsEof(rx))
+        {
+            break;
+        }
+        // No data, wait for more
         else
         {
-            SLEEP(5);
+            rxWaitReadable(rx, 1000);
         }
     }
 
@@ -137,7 +156,19 @@ int dumpRun(const char *portArg, const bool extraInfo, const bool noProbe)
     ioOutputStr("stats NOVATEL  count %6u (%5.1f%%)  size %10u (%5.1f%%)\n", parser->nUbx,     parser->nMsgs > 0 ? (double)parser->nNovatel / (double)parser->nMsgs * 1e2 : 0.0, parser->sNovatel, parser->sMsgs > 0 ? (double)parser->sNovatel / (double)parser->sMsgs * 1e2 : 0.0);
     ioOutputStr("stats GARBAGE  count %6u (%5.1f%%)  size %10u (%5.1f%%)\n", parser->nGarbage, parser->nMsgs > 0 ? (double)parser->nGarbage / (double)parser->nMsgs * 1e2 : 0.0, parser->sGarbage, parser->sMsgs > 0 ? (double)parser->sGarbage / (double)parser->sMsgs * 1e2 : 0.0);
     ioOutputStr("stats Total    count %6u (100.0%%)  size %10u (100.0%%)\n", parser->nMsgs, parser->sMsgs);
-    ioOutputStr("stats EPOCH    count %6u (%5.1f%%)\n", nEpochs, parser->nMsgs > 0 ? (double)nEpochs / (double)parser->nMsgs * 1e2 : 0.0);
+    ioOutputStr("stats EPOCH    count %6u (%5.1f%%)  dropped %u signals, %u satellites\n", nEpochs, parser->nMsgs > 0 ? (double)nEpochs / (double)parser->nMsgs * 1e2 : 0.0, nSigDropped, nSatDropped);
+    RX_RING_STATS_t ring;
+    if (rxGetRingStats(rx, &ring) && ring.active)
+    {
+        ioOutputStr("stats RING     size %u, high water %u (%.1f%%), chunks %u, overruns %u (%u bytes)\n",
+            ring.size, ring.highWater, (double)ring.highWater / (double)ring.size * 1e2, ring.numChunks,
+            ring.numOverruns, ring.numDropped);
+    }
+    PORT_STATS_t portStats;
+    if (rxGetPortStats(rx, &portStats))
+    {
+        ioAddOutputPortStats(&portStats);
+    }
 
     bool res = ioWriteOutput(true);
     const uint32_t nMsgs = parser->nMsgs;
@@ -71,10 +71,13 @@ int parseRun(const bool extraInfo, const bool doEpoch)
     PARSER_t parser;
     parserInit(&parser);
 
+    static EPOCH_ARENA_t arena;
     EPOCH_t coll;
     EPOCH_t epoch;
     PARSER_MSG_t msg;
-    epochInit(&coll);
+    epochInitArena(&coll, &arena);
+    uint32_t nSigDropped = 0;
+    uint32_t nSatDropped = 0;
     bool done = false;
     while (!(gAbort || done))
     {
@@ -86,7 +89,7 @@ int parseRun(const bool extraInfo, const bool doEpoch)
         }
         else if (num == 0) // wait
         {
-            SLEEP(5);
+            ioWaitInput(1000);
             continue;
         }
         if (num > 0)
@@ -99,6 +102,8 @@ int parseRun(const bool extraInfo, const bool doEpoch)
             if (doEpoch && epochCollect(&coll, &msg, &epoch))
             {
                 nEpochs++;
+                nSigDropped += epoch.numSignalsDropped;
+                nSatDropped += epoch.numSatellitesDropped;
                 ioOutputStr("epoch   %4d, size    0, NONE     EPOCH                %s\n", nEpochs, epoch.str);
             }
             ioOutputStr("message %4u, size %4d, %-8s %-20s %s\n",
@@ -135,7 +140,7 @@ int parseRun(const bool extraInfo, const bool doEpoch)
     ioOutputStr("stats Total    count %6u (100.0%%)  size %10u (100.0%%)\n", parser.nMsgs, parser.sMsgs);
     if (doEpoch)
     {
-        ioOutputStr("stats EPOCH    count %6u (%5.1f%%)\n", nEpochs, parser.nMsgs > 0 ? (double)nEpochs / (double)parser.nMsgs * 1e2 : 0.0);
+        ioOutputStr("stats EPOCH    count %6u (%5.1f%%)  dropped %u signals, %u satellites\n", nEpochs, parser.nMsgs > 0 ? (double)nEpochs / (double)parser.nMsgs * 1e2 : 0.0, nSigDropped, nSatDropped);
     }
 
     return ioWriteOutput(true) ? EXIT_SUCCESS : EXIT_OTHERFAIL;
@@ -0,0 +1,210 @@
+// clang-format off
+/* ****************************************************************************************************************** */
+// u-blox positioning receivers configuration tool
+//
+// Copyright (c) Philippe Kehl (flipflip at oinkzwurgl dot org) and contributors
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+// even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program.
+// If not, see <https://www.gnu.org/licenses/>.
+
+#include <string.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <signal.h>
+
+#include "cfgtool_util.h"
+
+#include "ff_rx.h"
+#include "ff_port.h"
+
+#include "cfgtool_relay.h"
+
+/* ****************************************************************************************************************** */
+
+const char *relayHelp(void)
+{
+    return
+// -----------------------------------------------------------------------------
+"Command 'relay':\n"
+"\n"
+"    Usage: cfgtool relay -p <port> -d <port> [-f <filter>] [-n]\n"
+"\n"
+"    Connects to the receiver (-p) and forwards the received data to another\n"
+"    port (-d) until SIGINT (e.g. CTRL-C)"NOT_WIN(", SIGHUP")" or SIGTERM is received.\n"
+"    Data received on the other port is sent to the receiver (for example,\n"
+"    RTCM3 corrections).\n"
+"\n"
+"    With a tcpsrv://[<addr>]:<port> destination the data is distributed to\n"
+"    any number of clients. Clients that cannot keep up are disconnected.\n"
+"\n"
+"    Without a <filter> all data is forwarded as received. The <filter> is a\n"
+"    comma-separated list of message names (or prefixes thereof) to forward,\n"
+"    for example 'UBX-NAV-PVT,NMEA-GN,RTCM3'.\n"
+"\n"
+"    Examples:\n"
+"\n"
+#ifdef _WIN32
+"        cfgtool relay -p COM3 -d tcp://192.168.1.2:12345\n"
+#else
+"        cfgtool relay -p /dev/ttyUSB0 -d tcpsrv://:12345\n"
+"        cfgtool relay -p /dev/ttyUSB0 -d tcpsrv://localhost:12345 -f UBX-NAV,UBX-RXM\n"
+#endif
+"\n";
+}
+
+/* ****************************************************************************************************************** */
+
+#define RELAY_MAX_FILTERS 50
+
+static bool gAbort;
+
+static void _sigHandler(int signal)
+{
+    if ( (signal == SIGINT) || (signal == SIGTERM) NOT_WIN(|| (signal == SIGHUP)) )
+    {
+        PRINT("Aborting...");
+        gAbort = true;
+    }
+}
+
+static bool _match(const char * const *filters, const int nFilters, const char *name)
+{
+    if (nFilters == 0)
+    {
+        return true;
+    }
+    for (int ix = 0; ix < nFilters; ix++)
+    {
+        if (strncmp(name, filters[ix], strlen(filters[ix])) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int relayRun(const char *portArg, const char *dstArg, const char *filterArg, const bool noProbe)
+{
+    // Message name filters
+    char filterStr[1000];
+    const char *filters[RELAY_MAX_FILTERS];
+    int nFilters = 0;
+    snprintf(filterStr, sizeof(filterStr), "%s", filterArg != NULL ? filterArg : "");
+    for (char *tok = strtok(filterStr, ","); tok != NULL; tok = strtok(NULL, ","))
+    {
+        if (nFilters >= RELAY_MAX_FILTERS)
+        {
+            WARNING("Too many filters!");
+            return EXIT_BADARGS;
+        }
+        filters[nFilters++] = tok;
+    }
+
+    RX_OPTS_t opts = getRxOpts();
+    // Sending data from the other port to the receiver should not delay reading from the receiver
+    NOT_WIN( opts.txQueueSize = 64 * 1024 );
+    opts.reconnect = true;
+    if (noProbe)
+    {
+        opts.autobaud = false;
+        opts.detect   = RX_DET_NONE;
+    }
+
+    RX_t *rx = rxInit(portArg, &opts);
+    if ( (rx == NULL) || !rxOpen(rx) )
+    {
+        free(rx);
+        return EXIT_RXFAIL;
+    }
+
+    PORT_t dst;
+    if (!portInit(&dst, dstArg) || !portOpen(&dst))
+    {
+        rxClose(rx);
+        free(rx);
+        return EXIT_OTHERFAIL;
+    }
+
+    gAbort = false;
+    signal(SIGINT, _sigHandler);
+    signal(SIGTERM, _sigHandler);
+    NOT_WIN( signal(SIGHUP, _sigHandler) );
+
+    PRINT("Relaying data...");
+    uint32_t nMsgs = 0;
+    uint32_t nRelayed = 0;
+    uint32_t nFailed = 0;
+    uint32_t nBytesToRx = 0;
+    int nClients = 0;
+    while (!gAbort)
+    {
+        PARSER_MSG_t *msg = rxGetNextMessage(rx);
+        bool dstReadable = false;
+        if (msg != NULL)
+        {
+            nMsgs++;
+            if (_match(filters, nFilters, msg->name))
+            {
+                if (portWrite(&dst, msg->data, msg->size))
+                {
+                    nRelayed++;
+                }
+                else
+                {
+                    nFailed++;
+                }
+            }
+            // Don't neglect the other side while there's a lot of data from the receiver
+            if ((nMsgs % 100) != 0)
+            {
+                continue;
+            }
+            dstReadable = portWaitReadable(&dst, 0);
+        }
+        else if (rxIsEof(rx))
+        {
+            break;
+        }
+        // Wait for data from the receiver or the other side. This also accepts new clients (tcpsrv) and sends them
+        // pending data once they can take it.
+        else
+        {
+            rxWaitReadablePort(rx, &dst, 1000, &dstReadable);
+        }
+
+        // Data from the other side to the receiver
+        uint8_t buf[1024];
+        int size = 0;
+        while (dstReadable && portRead(&dst, buf, sizeof(buf), &size) && (size > 0))
+        {
+            if (rxSend(rx, buf, size))
+            {
+                nBytesToRx += size;
+            }
+        }
+        if ( (dst.type == PORT_TYPE_TCPSRV) && (portTcpsrvNumClients(&dst) != nClients) )
+        {
+            nClients = portTcpsrvNumClients(&dst);
+            PRINT("%d client%s connected", nClients, nClients == 1 ? "" : "s");
+        }
+    }
+
+    PRINT("Relayed %u of %u messages (%u failed), %u bytes to receiver", nRelayed, nMsgs, nFailed, nBytesToRx);
+
+    portClose(&dst);
+    rxClose(rx);
+    free(rx);
+
+    return nMsgs > 0 ? EXIT_SUCCESS : EXIT_RXNODATA;
+}
+
+/* ****************************************************************************************************************** */
+// eof
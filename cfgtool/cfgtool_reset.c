@@ -142,7 +142,8 @@ int resetRun(const char *portArg, const char *resetArg)
         return EXIT_BADARGS;
     }
 
-    RX_t *rx = rxInit(portArg, NULL);
+    RX_OPTS_t opts = getRxOpts();
+    RX_t *rx = rxInit(portArg, &opts);
     if ( (rx == NULL) || !rxOpen(rx) )
     {
         free(rx);
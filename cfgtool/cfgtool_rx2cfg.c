@@ -36,6 +36,7 @@ const char *rx2cfgHelp(void)
 "Command 'rx2cfg':\n"
 "\n"
 "    Usage: cfgtool rx2cfg [-o <outfile>] [-y] -p <port> -l <layer> [-u] [-x]\n"
+"                          [-b <baudrate>]\n"
 "\n"
 "    This reads the configuration of a layer in the receiver and saves the data\n"
 "    as a configuration file (see the 'cfg2rx' command for a specification of\n"
@@ -45,6 +46,7 @@ const char *rx2cfgHelp(void)
 "\n"
 "    The '-u' flag adds all unknown (to this tool) configuration items.\n"
 "    The '-x' flag adds the item description as a comment.\n"
+"    The '-b' flag increases the baudrate for the transfer (see general help).\n"
 "\n"
 "    Entries in the generated configuration file are commented out if their\n"
 "    values are the default values.\n"
@@ -57,6 +59,7 @@ const char *rx2listHelp(void)
 "Command 'rx2list':\n"
 "\n"
 "    Usage: cfgtool rx2list [-o <outfile>] [-y] -p <port> -l <layer> [-u] [-x]\n"
+"                          [-b <baudrate>]\n"
 "\n"
 "    This behaves like the 'rx2cfg' command with the differnece that all\n"
 "    configuration is reported as <key> <value> pairs. That is, no <port> or\n"
@@ -86,7 +89,7 @@ typedef struct CFG_DB_s
 } CFG_DB_t;
 
 // Forward declarations
-static CFG_DB_t *_getCfgDb(RX_t *rx, const UBLOXCFG_LAYER_t layer);
+static bool _getCfgDbs(RX_t *rx, const UBLOXCFG_LAYER_t layer, CFG_DB_t **dbLayer, CFG_DB_t **dbDefault);
 static const UBLOXCFG_KEYVAL_t *_dbFindKeyVal(const CFG_DB_t *db, const uint32_t id);
 static void _dbFlag(CFG_DB_t *db, const uint32_t id);
 static void _addOutputItemDesc(const UBLOXCFG_ITEM_t *item);
@@ -119,16 +122,19 @@ int rx2cfgRun(const char *portArg, const char *layerArg, const bool useUnknownIt
         return EXIT_BADARGS;
     }
 
-    RX_t *rx = rxInit(portArg, NULL);
+    RX_OPTS_t opts = getRxOpts();
+    RX_t *rx = rxInit(portArg, &opts);
     if ( (rx == NULL) || !rxOpen(rx) )
     {
         free(rx);
         return EXIT_RXFAIL;
     }
+    upshiftRx(rx);
 
-    // Get configuration
-    CFG_DB_t *dbLayer = _getCfgDb(rx, layer);
-    if (dbLayer == NULL)
+    // Get configuration, and the default configuration, too
+    CFG_DB_t *dbLayer = NULL;
+    CFG_DB_t *dbDefault = NULL;
+    if (!_getCfgDbs(rx, layer, &dbLayer, &dbDefault))
     {
         rxClose(rx);
         free(rx);
@@ -142,16 +148,10 @@ int rx2cfgRun(const char *portArg, const char *layerArg, const bool useUnknownIt
     if (!generateOutput)
     {
         WARNING("No configuration available in layer %s!", layerName);
-        free(dbLayer);
-        rxClose(rx);
-        free(rx);
-        return EXIT_RXNODATA;
-    }
-
-    // Maybe get default configuration, too
-    CFG_DB_t *dbDefault = layer == UBLOXCFG_LAYER_DEFAULT ? dbLayer : _getCfgDb(rx, UBLOXCFG_LAYER_DEFAULT);
-    if (dbDefault == NULL)
-    {
+        if (dbDefault != dbLayer)
+        {
+            free(dbDefault);
+        }
         free(dbLayer);
         rxClose(rx);
         free(rx);
@@ -395,16 +395,19 @@ int rx2listRun(const char *portArg, const char *layerArg, const bool useUnknownI
     const char *layerName = ubloxcfg_layerName(layer);
 
     // Connect and detect receiver
-    RX_t *rx = rxInit(portArg, NULL);
+    RX_OPTS_t opts = getRxOpts();
+    RX_t *rx = rxInit(portArg, &opts);
     if ( (rx == NULL) || !rxOpen(rx) )
     {
         free(rx);
         return EXIT_RXFAIL;
     }
+    upshiftRx(rx);
 
-    // Get configuration
-    CFG_DB_t *dbLayer = _getCfgDb(rx, layer);
-    if (dbLayer == NULL)
+    // Get configuration, and the default configuration, too
+    CFG_DB_t *dbLayer = NULL;
+    CFG_DB_t *dbDefault = NULL;
+    if (!_getCfgDbs(rx, layer, &dbLayer, &dbDefault))
     {
         rxClose(rx);
         free(rx);
@@ -416,16 +419,10 @@ int rx2listRun(const char *portArg, const char *layerArg, const bool useUnknownI
     if (!generateOutput)
     {
         WARNING("No configuration available in layer %s!", layerName);
-        free(dbLayer);
-        rxClose(rx);
-        free(rx);
-        return EXIT_RXNODATA;
-    }
-
-    // Maybe get default configuration, too
-    CFG_DB_t *dbDefault = layer == UBLOXCFG_LAYER_DEFAULT ? dbLayer : _getCfgDb(rx, UBLOXCFG_LAYER_DEFAULT);
-    if (dbDefault == NULL)
-    {
+        if (dbDefault != dbLayer)
+        {
+            free(dbDefault);
+        }
         free(dbLayer);
         rxClose(rx);
         free(rx);
@@ -479,36 +476,10 @@ int rx2listRun(const char *portArg, const char *layerArg, const bool useUnknownI
 
 static int _dbSortFunc(const void *a, const void *b);
 
-static CFG_DB_t *_getCfgDb(RX_t *rx, UBLOXCFG_LAYER_t layer)
+static void _initCfgDb(CFG_DB_t *db, const UBLOXCFG_KEYVAL_t *kv, const int nKv)
 {
-    CFG_DB_t *db = malloc(sizeof(CFG_DB_t));
-    UBLOXCFG_KEYVAL_t *kv = malloc(sizeof(UBLOXCFG_KEYVAL_t) * NUMOF(db->recs));
-    if ( (db == NULL) || (kv == NULL) )
-    {
-        WARNING("_getCfgDb() malloc fail");
-        free(db);
-        free(kv);
-        return NULL;
-    }
-    memset(db, 0, sizeof(*db));
-    db->layer = layer;
-    const char *layerName = ubloxcfg_layerName(layer);
-
-    // Poll all configuration items
-    PRINT("Polling receiver configuration for layer %s", layerName);
-
-
-    const uint32_t keys[] = { UBX_CFG_VALGET_V0_ALL_WILDCARD };
-    db->nKv = rxGetConfig(rx, layer, keys, NUMOF(keys), kv, NUMOF(db->recs));
-
-    if (db->nKv < 0)
-    {
-        free(db);
-        free(kv);
-        return NULL;
-    }
-
     // Check items, stringify and mark known ones
+    db->nKv = nKv;
     for (int ix = 0; ix < db->nKv; ix++)
     {
         db->recs[ix].kv   = kv[ix];
@@ -526,11 +497,63 @@ static CFG_DB_t *_getCfgDb(RX_t *rx, UBLOXCFG_LAYER_t layer)
     // Sort
     qsort(db->recs, db->nKv, sizeof(*db->recs), _dbSortFunc);
 
-    PRINT("Layer %s: %d items (%d known, %d unknown)", layerName,
+    PRINT("Layer %s: %d items (%d known, %d unknown)", ubloxcfg_layerName(db->layer),
         db->nKv, db->nKvKnown, db->nKvUnknown);
+}
 
-    free(kv);
-    return db;
+// Get configuration of the layer and of the Default layer, polling both at once. For the Default layer both are the
+// same db.
+static bool _getCfgDbs(RX_t *rx, const UBLOXCFG_LAYER_t layer, CFG_DB_t **dbLayer, CFG_DB_t **dbDefault)
+{
+    const UBLOXCFG_LAYER_t layers[] = { layer, UBLOXCFG_LAYER_DEFAULT };
+    const int numLayers = layer == UBLOXCFG_LAYER_DEFAULT ? 1 : 2;
+    const uint32_t keys[] = { UBX_CFG_VALGET_V0_ALL_WILDCARD };
+    CFG_DB_t *dbs[NUMOF(layers)] = { NULL, NULL };
+    UBLOXCFG_KEYVAL_t *kvs[NUMOF(layers)] = { NULL, NULL };
+    RX_GETCONFIG_t reqs[NUMOF(layers)];
+    bool res = true;
+    for (int ix = 0; ix < numLayers; ix++)
+    {
+        dbs[ix] = malloc(sizeof(CFG_DB_t));
+        kvs[ix] = malloc(sizeof(UBLOXCFG_KEYVAL_t) * MAX_ITEMS);
+        if ( (dbs[ix] == NULL) || (kvs[ix] == NULL) )
+        {
+            WARNING("_getCfgDbs() malloc fail");
+            res = false;
+            break;
+        }
+        memset(dbs[ix], 0, sizeof(*dbs[ix]));
+        dbs[ix]->layer = layers[ix];
+        reqs[ix] = (RX_GETCONFIG_t)
+        {
+            .layer = layers[ix], .keys = keys, .numKeys = NUMOF(keys), .kv = kvs[ix], .maxKv = MAX_ITEMS
+        };
+        PRINT("Polling receiver configuration for layer %s", ubloxcfg_layerName(layers[ix]));
+    }
+
+    if (res)
+    {
+        res = rxGetConfigMulti(rx, reqs, numLayers);
+    }
+
+    for (int ix = 0; ix < numLayers; ix++)
+    {
+        if (res)
+        {
+            _initCfgDb(dbs[ix], kvs[ix], reqs[ix].numKv);
+        }
+        else
+        {
+            free(dbs[ix]);
+        }
+        free(kvs[ix]);
+    }
+    if (res)
+    {
+        *dbLayer = dbs[0];
+        *dbDefault = numLayers > 1 ? dbs[1] : dbs[0];
+    }
+    return res;
 }
 
 static int _dbSortFunc(const void *a, const void *b)
@@ -0,0 +1,224 @@
+// clang-format off
+/* ****************************************************************************************************************** */
+// u-blox positioning receivers configuration tool
+//
+// Copyright (c) Philippe Kehl (flipflip at oinkzwurgl dot org) and contributors
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+// even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program.
+// If not, see <https://www.gnu.org/licenses/>.
+
+#include <string.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <inttypes.h>
+
+#include "cfgtool_util.h"
+
+#include "ff_rxsim.h"
+
+#include "cfgtool_sim.h"
+
+/* ****************************************************************************************************************** */
+
+const char *simHelp(void)
+{
+    return
+// -----------------------------------------------------------------------------
+"Command 'sim':\n"
+"\n"
+"    Usage: cfgtool sim -p <port> [-s <options>]\n"
+"\n"
+"    Simulates a u-blox receiver on the port (-p), usually a pty://<path> or a\n"
+"    tcpsrv://[<addr>]:<port>, until SIGINT (e.g. CTRL-C)"NOT_WIN(", SIGHUP")" or SIGTERM\n"
+"    is received. This is useful for testing the other commands (and other\n"
+"    software) without a receiver.\n"
+"\n"
+"    The simulator answers UBX-MON-VER, UBX-CFG-VALGET, UBX-CFG-VALSET,\n"
+"    UBX-CFG-VALDEL (incl. transactions), UBX-CFG-CFG and UBX-CFG-RST and polls\n"
+"    from a configuration database with all known items. It outputs (synthetic)\n"
+"    UBX-NAV-PVT, UBX-RXM-RAWX, NMEA-STANDARD-GGA, NMEA-STANDARD-RMC,\n"
+"    RTCM-3X-TYPE1005 and RTCM-3X-TYPE1077 messages as configured, paced at the\n"
+"    configured baudrate (CFG-UART1-BAUDRATE).\n"
+"\n"
+"    The <options> are a comma-separated list of:\n"
+"\n"
+"        baud=<baudrate>     Initial baudrate (default 38400)\n"
+"        rate=<ms>           Measurement period (CFG-RATE-MEAS, default 1000)\n"
+"        out=<msg>:<rate>    Output message <msg> every <rate> epochs, e.g.\n"
+"                            out=UBX-NAV-PVT:1 (CFG-MSGOUT-...-UART1)\n"
+"        latency=<ms>        Delay all output by <ms> milliseconds\n"
+"        loss=<prob>         Drop output messages with probability <prob>\n"
+"        nak=<prob>          Reject UBX-CFG-VAL* with probability <prob>\n"
+"        reset=<ms>          Time unresponsive after a reset (default 500)\n"
+"        seed=<n>            Seed for loss and nak (default random)\n"
+"\n"
+"    The options change the Default layer of the configuration database.\n"
+"\n"
+"    Examples:\n"
+"\n"
+#ifdef _WIN32
+"        cfgtool sim -p tcpsrv://:12345 -s baud=115200,out=UBX-NAV-PVT:1\n"
+#else
+"        cfgtool sim -p pty:///tmp/rxsim -s baud=115200,out=UBX-NAV-PVT:1\n"
+"        cfgtool rx2list -p /tmp/rxsim -l Default\n"
+"        cfgtool sim -p tcpsrv://:12345 -s latency=50,nak=0.05,loss=0.01\n"
+#endif
+"\n";
+}
+
+/* ****************************************************************************************************************** */
+
+#define SIM_MAX_KV 50
+
+static bool gAbort;
+
+static void _sigHandler(int signal)
+{
+    if ( (signal == SIGINT) || (signal == SIGTERM) NOT_WIN(|| (signal == SIGHUP)) )
+    {
+        PRINT("Aborting...");
+        gAbort = true;
+    }
+}
+
+static bool _parseOpts(const char *simArg, RXSIM_OPTS_t *opts, UBLOXCFG_KEYVAL_t *kv, int *nKv)
+{
+    char str[1000];
+    snprintf(str, sizeof(str), "%s", simArg != NULL ? simArg : "");
+    bool res = true;
+    for (char *tok = strtok(str, ","); res && (tok != NULL); tok = strtok(NULL, ","))
+    {
+        char *val = strchr(tok, '=');
+        if (val == NULL)
+        {
+            WARNING("Bad option '%s'!", tok);
+            res = false;
+            break;
+        }
+        *val = '\0';
+        val++;
+        char *end = NULL;
+        if (strcmp(tok, "baud") == 0)
+        {
+            opts->baudrate = strtol(val, &end, 10);
+            res = (*end == '\0') && (opts->baudrate >= PORT_BAUDRATE_MIN) && (opts->baudrate <= PORT_BAUDRATE_MAX);
+        }
+        else if (strcmp(tok, "latency") == 0)
+        {
+            opts->latency = strtoul(val, &end, 10);
+            res = (*end == '\0');
+        }
+        else if (strcmp(tok, "loss") == 0)
+        {
+            opts->loss = strtod(val, &end);
+            res = (*end == '\0') && (opts->loss >= 0.0) && (opts->loss <= 1.0);
+        }
+        else if (strcmp(tok, "nak") == 0)
+        {
+            opts->nak = strtod(val, &end);
+            res = (*end == '\0') && (opts->nak >= 0.0) && (opts->nak <= 1.0);
+        }
+        else if (strcmp(tok, "reset") == 0)
+        {
+            opts->resetTime = strtoul(val, &end, 10);
+            res = (*end == '\0');
+        }
+        else if (strcmp(tok, "seed") == 0)
+        {
+            opts->seed = strtoul(val, &end, 10);
+            res = (*end == '\0');
+        }
+        else if ( (strcmp(tok, "rate") == 0) && (*nKv < SIM_MAX_KV) )
+        {
+            const unsigned long rate = strtoul(val, &end, 10);
+            res = (*end == '\0') && (rate > 0) && (rate <= 0xffff);
+            kv[*nKv].id = UBLOXCFG_CFG_RATE_MEAS_ID;
+            kv[*nKv].val.U2 = rate;
+            (*nKv)++;
+        }
+        else if ( (strcmp(tok, "out") == 0) && (*nKv < SIM_MAX_KV) )
+        {
+            char *rateStr = strrchr(val, ':');
+            if (rateStr != NULL)
+            {
+                *rateStr = '\0';
+                rateStr++;
+            }
+            const UBLOXCFG_MSGRATE_t *msgrate = ubloxcfg_getMsgRateCfg(val);
+            const unsigned long rate = rateStr != NULL ? strtoul(rateStr, &end, 10) : 1;
+            res = (msgrate != NULL) && (msgrate->itemUart1 != NULL) && ((rateStr == NULL) || (*end == '\0')) && (rate <= 0xff);
+            if (res)
+            {
+                kv[*nKv].id = msgrate->itemUart1->id;
+                kv[*nKv].val.U1 = rate;
+                (*nKv)++;
+            }
+        }
+        else
+        {
+            res = false;
+        }
+        if (!res)
+        {
+            WARNING("Bad option '%s=%s'!", tok, val);
+        }
+    }
+    return res;
+}
+
+int simRun(const char *portArg, const char *simArg)
+{
+    RXSIM_OPTS_t opts = RXSIM_OPTS_DEFAULT();
+    UBLOXCFG_KEYVAL_t kv[SIM_MAX_KV];
+    int nKv = 0;
+    if (!_parseOpts(simArg, &opts, kv, &nKv))
+    {
+        return EXIT_BADARGS;
+    }
+
+    RXSIM_t *sim = rxSimCreate(portArg, &opts);
+    if (sim == NULL)
+    {
+        return EXIT_OTHERFAIL;
+    }
+    if ( (nKv > 0) && !rxSimSetConfig(sim, UBLOXCFG_LAYER_DEFAULT, kv, nKv) )
+    {
+        rxSimDestroy(sim);
+        return EXIT_OTHERFAIL;
+    }
+
+    gAbort = false;
+    signal(SIGINT, _sigHandler);
+    signal(SIGTERM, _sigHandler);
+    NOT_WIN( signal(SIGHUP, _sigHandler) );
+
+    bool res = true;
+    while (!gAbort && res)
+    {
+        res = rxSimRun(sim, 100);
+    }
+
+    RXSIM_STATS_t stats;
+    rxSimGetStats(sim, &stats);
+    PRINT("Received %u messages (%u VALGET, %u VALSET, %u VALDEL), %u ACKs, %u NAKs (%u injected), %u resets",
+        stats.numMsgsIn, stats.numValget, stats.numValset, stats.numValdel, stats.numAcks, stats.numNaks,
+        stats.numNaksInj, stats.numResets);
+    PRINT("Sent %u messages (%"PRIu64" bytes) in %u epochs, %u lost, %u overflow, %u bytes garbage received",
+        stats.numMsgsOut, stats.numBytesOut, stats.numEpochs, stats.numLost, stats.numOverflow, stats.numGarbage);
+
+    rxSimDestroy(sim);
+
+    return res ? EXIT_SUCCESS : EXIT_OTHERFAIL;
+}
+
+/* ****************************************************************************************************************** */
+// eof
@@ -42,6 +42,12 @@ const char *statusHelp(void)
 "    detected epoch. This requires navigation messages, such as UBX-NAV-PVT to\n"
 "    be enabled. The program stops when SIGINT (e.g. CTRL-C)"NOT_WIN(", SIGHUP")"\n"
 "    or SIGTERM is received.\n"
+"\n"
+"    With -x the receiver is additionally polled for UBX-MON-HW, UBX-MON-RF\n"
+"    and UBX-MON-COMMS every few seconds (unless -n is used), and their\n"
+"    information is output.\n"
+"\n"
+"    At the end, port I/O statistics are output (see the 'dump' command).\n"
 "\n";
 }
 
@@ -70,6 +76,39 @@ typedef struct INFO_s
     uint32_t       nMsgs;
 } INFO_t;
 
+#define STATUS_MON_PERIOD 5000 // Period for polling monitoring messages [ms]
+
+static void _monPollCb(RX_t *rx, const int pollId, const RX_POLL_RES_t res, const PARSER_MSG_t *msg, void *arg)
+{
+    (void)rx;
+    (void)pollId;
+    (void)arg;
+    if (res == RX_POLL_OK)
+    {
+        ioOutputStr("%-13s %s\n", msg->name, msg->info != NULL ? msg->info : "");
+        ioWriteOutput(true);
+    }
+    else
+    {
+        DEBUG("Monitoring poll failed (%d)", res);
+    }
+}
+
+// Poll monitoring messages, all at once so that the round trips overlap
+static void _monPoll(RX_t *rx)
+{
+    const RX_POLL_UBX_t polls[] =
+    {
+        { .clsId = UBX_MON_CLSID, .msgId = UBX_MON_HW_MSGID,    .timeout = 1000, .retries = 1 },
+        { .clsId = UBX_MON_CLSID, .msgId = UBX_MON_RF_MSGID,    .timeout = 1000, .retries = 1 },
+        { .clsId = UBX_MON_CLSID, .msgId = UBX_MON_COMMS_MSGID, .timeout = 1000, .retries = 1 },
+    };
+    for (int ix = 0; ix < NUMOF(polls); ix++)
+    {
+        rxPollUbxAsync(rx, &polls[ix], _monPollCb, NULL);
+    }
+}
+
 typedef enum STATUS_COLOUR_e
 {
     STATUS_COLOUR_NOFIX, STATUS_COLOUR_MASKED, STATUS_COLOUR_FIXOK,
@@ -165,7 +204,8 @@ static bool _printInfo(const bool colours, const INFO_t *info, const EPOCH_t *ep
 
 int statusRun(const char *portArg, const bool extraInfo, const bool noProbe)
 {
-    RX_OPTS_t opts = RX_OPTS_DEFAULT();
+    RX_OPTS_t opts = getRxOpts();
+    opts.reconnect = true;
     if (noProbe)
     {
         opts.autobaud = false;
@@ -181,7 +221,8 @@ int statusRun(const char *portArg, const bool extraInfo, const bool noProbe)
     DEBUG_CFG_t debugCfg;
     debugGetCfg(&debugCfg);
 
-    (void)extraInfo;
+    const bool monPoll = extraInfo && !noProbe;
+    uint64_t lastMonPoll = 0;
 
     INFO_t info;
     memset(&info, 0, sizeof(info));
@@ -191,9 +232,11 @@ int statusRun(const char *portArg, const bool extraInfo, const bool noProbe)
     signal(SIGTERM, _sigHandler);
     NOT_WIN( signal(SIGHUP, _sigHandler) );
 
+    static EPOCH_ARENA_t arena;
     EPOCH_t coll;
     EPOCH_t epoch;
-    epochInit(&coll);
+    epochInitArena(&coll, &arena);
+    bool warnDropped = true;
 
     PRINT("Dumping receiver status...");
 
@@ -213,6 +256,12 @@ int statusRun(const char *portArg, const bool extraInfo, const bool noProbe)
             {
                 info.nEpoch++;
                 lastEpoch = now;
+                if ( warnDropped && ((epoch.numSignalsDropped > 0) || (epoch.numSatellitesDropped > 0)) )
+                {
+                    WARNING("Epoch %u: dropped %d signals and %d satellites (too many)", epoch.seq,
+                        epoch.numSignalsDropped, epoch.numSatellitesDropped);
+                    warnDropped = false;
+                }
                 if (!_printInfo(debugCfg.colour, &info, &epoch))
                 {
                     break;
@@ -255,10 +304,16 @@ int statusRun(const char *portArg, const bool extraInfo, const bool noProbe)
                     break;
             }
         }
-        // No data, yield
+        // No data, wait for more
         else
         {
-            SLEEP(5);
+            rxWaitReadable(rx, 1000);
+        }
+        // Monitoring polls complete while we're reading messages
+        if ( monPoll && ((now - lastMonPoll) >= STATUS_MON_PERIOD) && (rxPollPending(rx) == 0) )
+        {
+            _monPoll(rx);
+            lastMonPoll = now;
         }
         if ( (now - lastEpoch) > 5000 )
         {
@@ -266,6 +321,11 @@ int statusRun(const char *portArg, const bool extraInfo, const bool noProbe)
             lastEpoch = now;
         }
     }
+    PORT_STATS_t portStats;
+    if (rxGetPortStats(rx, &portStats))
+    {
+        ioAddOutputPortStats(&portStats);
+    }
     bool res = ioWriteOutput(true);
 
     rxClose(rx);
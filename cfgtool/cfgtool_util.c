@@ -24,6 +24,9 @@
 #include <stdarg.h>
 #include <fcntl.h>
 #include <limits.h>
+#ifndef _WIN32
+#  include <poll.h>
+#endif
 
 #include "ubloxcfg/ubloxcfg.h"
 
@@ -136,6 +139,22 @@ int ioReadInput(uint8_t *data, const int size)
     return res;
 }
 
+// Wait for input to become available (up to timeout [ms]), returns true if ioReadInput() should be called
+bool ioWaitInput(const uint32_t timeout)
+{
+    if (gInFile == NULL)
+    {
+        return false;
+    }
+#ifdef _WIN32
+    SLEEP(MIN(timeout, 5));
+    return true;
+#else
+    struct pollfd pfd = { .fd = fileno(gInFile), .events = POLLIN, .revents = 0 };
+    return poll(&pfd, 1, timeout > INT_MAX ? INT_MAX : (int)timeout) > 0;
+#endif
+}
+
 
 static char gOutputBuf[1024 * 1024] = { 0 };
 static int gOutputBufSize = 0;
@@ -257,6 +276,25 @@ void ioAddOutputHexdump(const uint8_t *data, const int size)
     }
 }
 
+void ioAddOutputPortStats(const PORT_STATS_t *stats)
+{
+    ioOutputStr("stats PORT     opens %u, rx %"PRIu64" (%.0f/s), reads %u (%.1f/s, %u empty), tx %"PRIu64" (%.0f/s), writes %u\n",
+        stats->numOpens, stats->rxBytes, stats->rxRate, stats->numReads, stats->readRate, stats->numReadsEmpty,
+        stats->txBytes, stats->txRate, stats->numWrites);
+    ioOutputStr("stats READS   ");
+    for (int ix = 0; ix < PORT_STATS_HIST_SIZE; ix++)
+    {
+        ioOutputStr(" %u%s:%u", 1 << ix, ix == (PORT_STATS_HIST_SIZE - 1) ? "+" : "", stats->readHist[ix]);
+    }
+    ioOutputStr(", latency mean %uus max %uus\n", stats->readLatMean, stats->readLatMax);
+    ioOutputStr("stats TXQ      pending %d, high water %d, full %u\n", stats->txPending, stats->txHighWater, stats->txNumFull);
+    if (stats->haveIcount)
+    {
+        ioOutputStr("stats LINE     frame %u, parity %u, break %u, overrun %u, buffer overrun %u\n",
+            stats->frameErrors, stats->parityErrors, stats->breaks, stats->overruns, stats->bufOverruns);
+    }
+}
+
 bool ioWriteOutput(const bool append)
 {
     const int totSize = sizeof(gOutputBuf);
@@ -363,5 +401,37 @@ bool layersStringToFlags(const char *layers, bool *ram, bool *bbr, bool *flash,
     return res;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+
+static const char *gRxCacheFile;
+
+void setRxCacheFile(const char *cacheFile)
+{
+    gRxCacheFile = cacheFile;
+}
+
+RX_OPTS_t getRxOpts(void)
+{
+    RX_OPTS_t opts = RX_OPTS_DEFAULT();
+    opts.cacheFile = gRxCacheFile;
+    return opts;
+}
+
+static int gRxUpshift;
+
+void setRxUpshift(const int maxBaudrate)
+{
+    gRxUpshift = maxBaudrate;
+}
+
+void upshiftRx(RX_t *rx)
+{
+    // Not fatal, we can continue at the current baudrate
+    if ( (gRxUpshift > 0) && !rxUpshift(rx, gRxUpshift) )
+    {
+        WARNING("Continuing at baudrate %d", rxGetBaudrate(rx));
+    }
+}
+
 /* ****************************************************************************************************************** */
 // eof
@@ -23,6 +23,8 @@
 #include "ubloxcfg/ubloxcfg.h"
 #include "ff_debug.h"
 #include "ff_stuff.h"
+#include "ff_port.h"
+#include "ff_rx.h"
 
 #ifndef __CFGTOOL_UTIL_H__
 #define __CFGTOOL_UTIL_H__
@@ -47,14 +49,24 @@ void ioSetOutput(const char *name, FILE *file, const bool overwrite);
 void ioSetInput(const char *name, FILE *file);
 IO_LINE_t *ioGetNextInputLine(void);
 int  ioReadInput(uint8_t *data, const int size);
+bool ioWaitInput(const uint32_t timeout);
 void ioOutputStr(const char *fmt, ...);
 void ioAddOutputBin(const uint8_t *data, const int size);
 void ioAddOutputHex(const uint8_t *data, const int size, const int wordsPerLine, const bool ugly);
 void ioAddOutputHexdump(const uint8_t *data, const int size);
 void ioAddOutputC(const uint8_t *data, const int size, const int wordsPerLine, const char *indent);
+void ioAddOutputPortStats(const PORT_STATS_t *stats);
 bool ioWriteOutput(const bool append);
 
 bool layersStringToFlags(const char *layers, bool *ram, bool *bbr, bool *flash, bool *def);
 
+// Receiver options for rxInit(): RX_OPTS_DEFAULT() and the detection cache file (-c), if any
+void setRxCacheFile(const char *cacheFile);
+RX_OPTS_t getRxOpts(void);
+
+// Increase the receiver baudrate for bulk transfers (-b), if requested, see rxUpshift()
+void setRxUpshift(const int maxBaudrate);
+void upshiftRx(RX_t *rx);
+
 /* ****************************************************************************************************************** */
 #endif // __CFGTOOL_UTIL_H__
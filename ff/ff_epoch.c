@@ -20,8 +20,10 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <math.h>
 #include <float.h>
+#include <time.h>
 
 #include "ff_stuff.h"
 #include "ff_ubx.h"
@@ -38,9 +40,46 @@
 //#define EPOCH_DEBUG(fmt, args...) DEBUG("epoch: " fmt, ## args)
 #define EPOCH_DEBUG(...) /* nothing */
 
+// Point signals and satellites to the storage for collected (or output) data
+static void _epochSetStorage(EPOCH_t *epoch, EPOCH_ARENA_t *arena, const bool output)
+{
+    epoch->_arena = arena;
+    if (arena != NULL)
+    {
+        EPOCH_STORAGE_t *storage = output ? &arena->_epoch : &arena->_coll;
+        epoch->signals       = storage->_signals;
+        epoch->satellites    = storage->_satellites;
+        epoch->maxSignals    = NUMOF(storage->_signals);
+        epoch->maxSatellites = NUMOF(storage->_satellites);
+    }
+    else
+    {
+        epoch->signals       = epoch->_signals;
+        epoch->satellites    = epoch->_satellites;
+        epoch->maxSignals    = NUMOF(epoch->_signals);
+        epoch->maxSatellites = NUMOF(epoch->_satellites);
+    }
+}
+
 void epochInit(EPOCH_t *coll)
 {
     memset(coll, 0, sizeof(*coll));
+    _epochSetStorage(coll, NULL, false);
+}
+
+void epochInitArena(EPOCH_t *coll, EPOCH_ARENA_t *arena)
+{
+    memset(coll, 0, sizeof(*coll));
+    _epochSetStorage(coll, arena, false);
+}
+
+void epochInitStorage(EPOCH_t *epoch, EPOCH_STORAGE_t *storage)
+{
+    memset(epoch, 0, sizeof(*epoch));
+    epoch->signals       = storage->_signals;
+    epoch->satellites    = storage->_satellites;
+    epoch->maxSignals    = NUMOF(storage->_signals);
+    epoch->maxSatellites = NUMOF(storage->_satellites);
 }
 
 // "Quality" (precision) if information: UBX better than NMEA, UBX high-precision messages better than normal UBX
@@ -74,6 +113,8 @@ STATIC_ASSERT(SIZEOF_MEMBER(EPOCH_t, _collect) >= sizeof(EPOCH_COLLECT_t));
 
 typedef struct EPOCH_DETECT_s
 {
+    uint64_t     firstTs;
+    bool         haveFirstTs;
     uint32_t     seq;
     uint32_t     ubxItow;
     bool         haveUbxItow;
@@ -89,7 +130,8 @@ static bool _detectNmea(EPOCH_DETECT_t *detect, const NMEA_MSG_t *nmea);
 static void _collectUbx(EPOCH_t *coll, EPOCH_COLLECT_t *collect, const PARSER_MSG_t *msg);
 static void _collectNmea(EPOCH_t *coll, EPOCH_COLLECT_t *collect, const NMEA_MSG_t *nmea);
 
-static void _epochComplete(const EPOCH_COLLECT_t *collect, EPOCH_t *epoch);
+static void _epochOutput(EPOCH_t *coll, const PARSER_MSG_t *msg, const bool eoe, EPOCH_t *epoch);
+static void _epochComplete(const EPOCH_t *coll, EPOCH_t *epoch);
 
 bool epochCollect(EPOCH_t *coll, const PARSER_MSG_t *msg, EPOCH_t *epoch)
 {
@@ -100,6 +142,18 @@ bool epochCollect(EPOCH_t *coll, const PARSER_MSG_t *msg, EPOCH_t *epoch)
     EPOCH_COLLECT_t *collect = (EPOCH_COLLECT_t *)coll->_collect;
     EPOCH_DETECT_t  *detect  = (EPOCH_DETECT_t *)coll->_detect;
 
+    // Fast path for the end-of-epoch marker: the epoch is complete right now and the marker itself carries no data that
+    // would have to be collected. Output the epoch without touching the message any further.
+    const bool isUbxNav = (msg->type == PARSER_MSGTYPE_UBX) && (UBX_CLSID(msg->data) == UBX_NAV_CLSID);
+    if (isUbxNav && (UBX_MSGID(msg->data) == UBX_NAV_EOE_MSGID))
+    {
+        EPOCH_DEBUG("detect %s", msg->name);
+        detect->haveUbxItow = false;
+        detect->haveNmeaMs = false;
+        _epochOutput(coll, msg, true, epoch);
+        return true;
+    }
+
     // Decode NMEA here, as this is quite expensive
     NMEA_MSG_t nmea;
     bool haveNmea = false;
@@ -108,7 +162,7 @@ bool epochCollect(EPOCH_t *coll, const PARSER_MSG_t *msg, EPOCH_t *epoch)
         haveNmea = nmeaDecode(&nmea, msg->data, msg->size);
     }
 
-    // Detect end of epoch / start of next epoch
+    // Detect start of next epoch
     bool complete = false;
     switch (msg->type)
     {
@@ -132,28 +186,19 @@ bool epochCollect(EPOCH_t *coll, const PARSER_MSG_t *msg, EPOCH_t *epoch)
         default:
             break;
     }
-    // TODO: in case of UBX-NAV-EOE, output that first and complete epoch on next call (if it can be done nicely..)
 
     // Output epoch
     if (complete)
     {
-        detect->seq++;
-        if (epoch != NULL)
-        {
-            memcpy(epoch, coll, sizeof(*epoch));
-            epoch->seq = detect->seq;
-            _epochComplete(collect, epoch);
-        }
-
-        // Initialise collector
-        const EPOCH_DETECT_t saveDetect = *detect;
-        memset(coll, 0, sizeof(*coll));
-        *detect = saveDetect;
-
-        //DEBUG("epoch %u ubx %u %d nmea %d %d", seq, tow, detectHaveTow, ms, detectHaveMs);
+        _epochOutput(coll, msg, false, epoch);
     }
 
     // Collect data
+    if (!detect->haveFirstTs && (isUbxNav || haveNmea))
+    {
+        detect->firstTs = msg->ts;
+        detect->haveFirstTs = true;
+    }
     switch (msg->type)
     {
         case PARSER_MSGTYPE_UBX:
@@ -172,6 +217,85 @@ bool epochCollect(EPOCH_t *coll, const PARSER_MSG_t *msg, EPOCH_t *epoch)
     return complete;
 }
 
+// Monotonic time [us], for the output latency, which is well below the resolution of TIME()
+static uint64_t _epochTimeUs(void)
+{
+#ifdef _WIN32
+    return TIME() * 1000;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + ((uint64_t)ts.tv_nsec / 1000);
+#endif
+}
+
+static void _epochOutput(EPOCH_t *coll, const PARSER_MSG_t *msg, const bool eoe, EPOCH_t *epoch)
+{
+    EPOCH_DETECT_t *detect = (EPOCH_DETECT_t *)coll->_detect;
+
+    detect->seq++;
+    if (epoch != NULL)
+    {
+        const uint64_t t0 = _epochTimeUs();
+        memcpy(epoch, coll, sizeof(*epoch));
+        _epochSetStorage(epoch, coll->_arena, true);
+        epoch->seq = detect->seq;
+        epoch->detectEoe = eoe;
+        _epochComplete(coll, epoch);
+        epoch->latencyCollect = detect->haveFirstTs && (msg->ts >= detect->firstTs) ?
+            (float)(msg->ts - detect->firstTs) * 1e-3f : 0.0f;
+        epoch->latencyOutput  = (float)(_epochTimeUs() - t0) * 1e-6f;
+    }
+
+    // Initialise collector
+    EPOCH_DETECT_t saveDetect = *detect;
+    saveDetect.haveFirstTs = false;
+    EPOCH_ARENA_t *arena = coll->_arena;
+    memset(coll, 0, sizeof(*coll));
+    *detect = saveDetect;
+    _epochSetStorage(coll, arena, false);
+
+    //DEBUG("epoch %u ubx %u %d nmea %d %d", seq, tow, detectHaveTow, ms, detectHaveMs);
+}
+
+void epochCopy(EPOCH_t *dst, const EPOCH_t *src)
+{
+    if (dst == src)
+    {
+        return;
+    }
+
+    // Copy everything but the inline storage, and keep the storage of dst
+    EPOCH_SIGINFO_t *signals    = dst->signals;
+    EPOCH_SATINFO_t *satellites = dst->satellites;
+    const int maxSignals        = dst->maxSignals;
+    const int maxSatellites     = dst->maxSatellites;
+    memcpy(dst, src, offsetof(EPOCH_t, _signals));
+    dst->_arena        = NULL;
+    dst->signals       = signals;
+    dst->satellites    = satellites;
+    dst->maxSignals    = maxSignals;
+    dst->maxSatellites = maxSatellites;
+
+    dst->numSignals    = MIN(src->numSignals, dst->maxSignals);
+    dst->numSatellites = MIN(src->numSatellites, dst->maxSatellites);
+    dst->numSignalsDropped    += src->numSignals - dst->numSignals;
+    dst->numSatellitesDropped += src->numSatellites - dst->numSatellites;
+    memcpy(dst->signals, src->signals, dst->numSignals * sizeof(*dst->signals));
+    memcpy(dst->satellites, src->satellites, dst->numSatellites * sizeof(*dst->satellites));
+
+    if (dst->numSatellites < src->numSatellites)
+    {
+        for (int ix = 0; ix < dst->numSignals; ix++)
+        {
+            if (dst->signals[ix].satIx >= dst->numSatellites)
+            {
+                dst->signals[ix].satIx = EPOCH_NO_SV;
+            }
+        }
+    }
+}
+
 static bool _detectUbx(EPOCH_DETECT_t *detect, const PARSER_MSG_t *msg)
 {
     const uint8_t clsId = UBX_CLSID(msg->data);
@@ -183,11 +307,7 @@ static bool _detectUbx(EPOCH_DETECT_t *detect, const PARSER_MSG_t *msg)
     bool complete = false;
     switch (msgId)
     {
-        case UBX_NAV_EOE_MSGID:
-            EPOCH_DEBUG("detect %s", msg->name);
-            detect->haveUbxItow = false;
-            complete = true;
-            break;
+        // UBX_NAV_EOE_MSGID is handled in epochCollect()
         case UBX_NAV_PVT_MSGID:
         case UBX_NAV_SAT_MSGID:
         case UBX_NAV_ORB_MSGID:
@@ -278,34 +398,365 @@ static bool _detectNmea(EPOCH_DETECT_t *detect, const NMEA_MSG_t *nmea)
 
 #define FLAG(field, flag) ( ((field) & (flag)) == (flag) )
 
+// Mapping of receiver specific identifiers to the EPOCH_*_t enums. These tables replace switch statements in the code
+// that runs for every signal and satellite. Unspecified entries map to the *_UNKNOWN (= 0) enum values.
+
+// UBX gnssId to EPOCH_GNSS_t
+static const uint8_t kEpochUbxGnss[] =
+{
+    [UBX_GNSSID_GPS]   = EPOCH_GNSS_GPS,
+    [UBX_GNSSID_SBAS]  = EPOCH_GNSS_SBAS,
+    [UBX_GNSSID_GAL]   = EPOCH_GNSS_GAL,
+    [UBX_GNSSID_BDS]   = EPOCH_GNSS_BDS,
+    [UBX_GNSSID_QZSS]  = EPOCH_GNSS_QZSS,
+    [UBX_GNSSID_GLO]   = EPOCH_GNSS_GLO,
+    [UBX_GNSSID_NAVIC] = EPOCH_GNSS_NAVIC,
+};
+
+// UBX gnssId and sigId to EPOCH_SIGNAL_t
+static const uint8_t kEpochUbxSignal[][16] =
+{
+    [UBX_GNSSID_GPS] =
+    {
+        [UBX_SIGID_GPS_L1CA]  = EPOCH_SIGNAL_GPS_L1CA,
+        [UBX_SIGID_GPS_L2CL]  = EPOCH_SIGNAL_GPS_L2C,
+        [UBX_SIGID_GPS_L2CM]  = EPOCH_SIGNAL_GPS_L2C,
+        [UBX_SIGID_GPS_L5I]   = EPOCH_SIGNAL_GPS_L5,
+        [UBX_SIGID_GPS_L5Q]   = EPOCH_SIGNAL_GPS_L5,
+    },
+    [UBX_GNSSID_SBAS] =
+    {
+        [UBX_SIGID_SBAS_L1CA] = EPOCH_SIGNAL_SBAS_L1CA,
+    },
+    [UBX_GNSSID_GAL] =
+    {
+        [UBX_SIGID_GAL_E1C]   = EPOCH_SIGNAL_GAL_E1,
+        [UBX_SIGID_GAL_E1B]   = EPOCH_SIGNAL_GAL_E1,
+        [UBX_SIGID_GAL_E5BI]  = EPOCH_SIGNAL_GAL_E5B,
+        [UBX_SIGID_GAL_E5BQ]  = EPOCH_SIGNAL_GAL_E5B,
+        [UBX_SIGID_GAL_E5AI]  = EPOCH_SIGNAL_GAL_E5A,
+        [UBX_SIGID_GAL_E5AQ]  = EPOCH_SIGNAL_GAL_E5A,
+        [UBX_SIGID_GAL_E6B]   = EPOCH_SIGNAL_GAL_E6,
+        [UBX_SIGID_GAL_E6C]   = EPOCH_SIGNAL_GAL_E6,
+        [UBX_SIGID_GAL_E6A]   = EPOCH_SIGNAL_GAL_E6,
+    },
+    [UBX_GNSSID_BDS] =
+    {
+        [UBX_SIGID_BDS_B1CP]  = EPOCH_SIGNAL_BDS_B1C,
+        [UBX_SIGID_BDS_B1CD]  = EPOCH_SIGNAL_BDS_B1C,
+        [UBX_SIGID_BDS_B1ID1] = EPOCH_SIGNAL_BDS_B1I,
+        [UBX_SIGID_BDS_B1ID2] = EPOCH_SIGNAL_BDS_B1I,
+        [UBX_SIGID_BDS_B2ID1] = EPOCH_SIGNAL_BDS_B2I,
+        [UBX_SIGID_BDS_B2ID2] = EPOCH_SIGNAL_BDS_B2I,
+        [UBX_SIGID_BDS_B2AP]  = EPOCH_SIGNAL_BDS_B2A,
+        [UBX_SIGID_BDS_B2AD]  = EPOCH_SIGNAL_BDS_B2A,
+        [UBX_SIGID_BDS_B3ID1] = EPOCH_SIGNAL_BDS_B3I,
+        [UBX_SIGID_BDS_B3ID2] = EPOCH_SIGNAL_BDS_B3I,
+    },
+    [UBX_GNSSID_QZSS] =
+    {
+        [UBX_SIGID_QZSS_L1CA] = EPOCH_SIGNAL_QZSS_L1CA,
+        [UBX_SIGID_QZSS_L1S]  = EPOCH_SIGNAL_QZSS_L1S,
+        [UBX_SIGID_QZSS_L2CM] = EPOCH_SIGNAL_QZSS_L2C,
+        [UBX_SIGID_QZSS_L2CL] = EPOCH_SIGNAL_QZSS_L2C,
+        [UBX_SIGID_QZSS_L5I]  = EPOCH_SIGNAL_QZSS_L5,
+        [UBX_SIGID_QZSS_L5Q]  = EPOCH_SIGNAL_QZSS_L5,
+    },
+    [UBX_GNSSID_GLO] =
+    {
+        [UBX_SIGID_GLO_L1OF]  = EPOCH_SIGNAL_GLO_L1OF,
+        [UBX_SIGID_GLO_L2OF]  = EPOCH_SIGNAL_GLO_L2OF,
+    },
+    [UBX_GNSSID_NAVIC] =
+    {
+        [UBX_SIGID_NAVIC_L5A] = EPOCH_SIGNAL_NAVIC_L5A,
+    },
+};
+
+// UBX-NAV-SIG qualityInd to EPOCH_SIGUSE_t
+static const uint8_t kEpochUbxSigUse[] =
+{
+    [UBX_NAV_SIG_V0_QUALITYIND_NOSIG]     = EPOCH_SIGUSE_NONE,
+    [UBX_NAV_SIG_V0_QUALITYIND_SEARCH]    = EPOCH_SIGUSE_SEARCH,
+    [UBX_NAV_SIG_V0_QUALITYIND_ACQUIRED]  = EPOCH_SIGUSE_ACQUIRED,
+    [UBX_NAV_SIG_V0_QUALITYIND_UNUSED]    = EPOCH_SIGUSE_UNUSABLE,
+    [UBX_NAV_SIG_V0_QUALITYIND_CODELOCK]  = EPOCH_SIGUSE_CODELOCK,
+    [UBX_NAV_SIG_V0_QUALITYIND_CARRLOCK1] = EPOCH_SIGUSE_CARRLOCK,
+    [UBX_NAV_SIG_V0_QUALITYIND_CARRLOCK2] = EPOCH_SIGUSE_CARRLOCK,
+    [UBX_NAV_SIG_V0_QUALITYIND_CARRLOCK3] = EPOCH_SIGUSE_CARRLOCK,
+};
+
+// UBX-NAV-SIG corrSource to EPOCH_SIGCORR_t
+static const uint8_t kEpochUbxSigCorr[] =
+{
+    [UBX_NAV_SIG_V0_CORRUSED_NONE]      = EPOCH_SIGCORR_NONE,
+    [UBX_NAV_SIG_V0_CORRUSED_SBAS]      = EPOCH_SIGCORR_SBAS,
+    [UBX_NAV_SIG_V0_CORRUSED_BDS]       = EPOCH_SIGCORR_BDS,
+    [UBX_NAV_SIG_V0_CORRUSED_RTCM2]     = EPOCH_SIGCORR_RTCM2,
+    [UBX_NAV_SIG_V0_CORRUSED_RTCM3_OSR] = EPOCH_SIGCORR_RTCM3_OSR,
+    [UBX_NAV_SIG_V0_CORRUSED_RTCM3_SSR] = EPOCH_SIGCORR_RTCM3_SSR,
+    [UBX_NAV_SIG_V0_CORRUSED_QZSS_SLAS] = EPOCH_SIGCORR_QZSS_SLAS,
+    [UBX_NAV_SIG_V0_CORRUSED_SPARTN]    = EPOCH_SIGCORR_SPARTN,
+};
+
+// UBX-NAV-SIG ionoModel to EPOCH_SIGIONO_t
+static const uint8_t kEpochUbxSigIono[] =
+{
+    [UBX_NAV_SIG_V0_IONOMODEL_NONE]     = EPOCH_SIGIONO_NONE,
+    [UBX_NAV_SIG_V0_IONOMODEL_KLOB_GPS] = EPOCH_SIGIONO_KLOB_GPS,
+    [UBX_NAV_SIG_V0_IONOMODEL_SBAS]     = EPOCH_SIGIONO_SBAS,
+    [UBX_NAV_SIG_V0_IONOMODEL_KLOB_BDS] = EPOCH_SIGIONO_KLOB_BDS,
+    [UBX_NAV_SIG_V0_IONOMODEL_DUALFREQ] = EPOCH_SIGIONO_DUAL_FREQ,
+};
+
+// UBX-NAV-SIG sigFlags health to EPOCH_SIGHEALTH_t
+static const uint8_t kEpochUbxSigHealth[] =
+{
+    [UBX_NAV_SIG_V0_SIGFLAGS_HEALTH_UNKNO]     = EPOCH_SIGHEALTH_UNKNOWN,
+    [UBX_NAV_SIG_V0_SIGFLAGS_HEALTH_HEALTHY]   = EPOCH_SIGHEALTH_HEALTHY,
+    [UBX_NAV_SIG_V0_SIGFLAGS_HEALTH_UNHEALTHY] = EPOCH_SIGHEALTH_UNHEALTHY,
+};
+
+// UBX-NAV-SAT flags orbitSource to EPOCH_SATORB_t (all 3 bits values)
+static const uint8_t kEpochUbxSatOrb[8] =
+{
+    [UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_NONE]   = EPOCH_SATORB_NONE,
+    [UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_EPH]    = EPOCH_SATORB_EPH,
+    [UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_ALM]    = EPOCH_SATORB_ALM,
+    [UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_ANO]    = EPOCH_SATORB_PRED,
+    [UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_ANA]    = EPOCH_SATORB_PRED,
+    [UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_OTHER1] = EPOCH_SATORB_OTHER,
+    [UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_OTHER2] = EPOCH_SATORB_OTHER,
+    [UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_OTHER3] = EPOCH_SATORB_OTHER,
+};
+
+// NMEA_GNSS_t to EPOCH_GNSS_t
+static const uint8_t kEpochNmeaGnss[] =
+{
+    [NMEA_GNSS_UNKNOWN] = EPOCH_GNSS_UNKNOWN,
+    [NMEA_GNSS_GPS]     = EPOCH_GNSS_GPS,
+    [NMEA_GNSS_GLO]     = EPOCH_GNSS_GLO,
+    [NMEA_GNSS_BDS]     = EPOCH_GNSS_BDS,
+    [NMEA_GNSS_GAL]     = EPOCH_GNSS_GAL,
+    [NMEA_GNSS_SBAS]    = EPOCH_GNSS_SBAS,
+    [NMEA_GNSS_QZSS]    = EPOCH_GNSS_QZSS,
+    [NMEA_GNSS_NAVIC]   = EPOCH_GNSS_NAVIC,
+};
+
+// NMEA_SIGNAL_t to EPOCH_SIGNAL_t
+static const uint8_t kEpochNmeaSignal[] =
+{
+    [NMEA_SIGNAL_UNKNOWN]   = EPOCH_SIGNAL_UNKNOWN,
+    [NMEA_SIGNAL_GPS_L1CA]  = EPOCH_SIGNAL_GPS_L1CA,
+    [NMEA_SIGNAL_GPS_L2CL]  = EPOCH_SIGNAL_GPS_L2C,
+    [NMEA_SIGNAL_GPS_L2CM]  = EPOCH_SIGNAL_GPS_L2C,
+    [NMEA_SIGNAL_GPS_L5I]   = EPOCH_SIGNAL_GPS_L5,
+    [NMEA_SIGNAL_GPS_L5Q]   = EPOCH_SIGNAL_GPS_L5,
+    [NMEA_SIGNAL_GLO_L1OF]  = EPOCH_SIGNAL_GLO_L1OF,
+    [NMEA_SIGNAL_GLO_L2OF]  = EPOCH_SIGNAL_GLO_L2OF,
+    [NMEA_SIGNAL_GAL_E1]    = EPOCH_SIGNAL_GAL_E1,
+    [NMEA_SIGNAL_GAL_E5A]   = EPOCH_SIGNAL_GAL_E5A,
+    [NMEA_SIGNAL_GAL_E5B]   = EPOCH_SIGNAL_GAL_E5B,
+    [NMEA_SIGNAL_BDS_B1ID]  = EPOCH_SIGNAL_BDS_B1I,
+    [NMEA_SIGNAL_BDS_B2ID]  = EPOCH_SIGNAL_BDS_B2I,
+    [NMEA_SIGNAL_BDS_B1C]   = EPOCH_SIGNAL_BDS_B1C,
+    [NMEA_SIGNAL_BDS_B2A]   = EPOCH_SIGNAL_BDS_B2A,
+    [NMEA_SIGNAL_QZSS_L1CA] = EPOCH_SIGNAL_QZSS_L1CA,
+    [NMEA_SIGNAL_QZSS_L1S]  = EPOCH_SIGNAL_QZSS_L1S,
+    [NMEA_SIGNAL_QZSS_L2CM] = EPOCH_SIGNAL_QZSS_L2C,
+    [NMEA_SIGNAL_QZSS_L2CL] = EPOCH_SIGNAL_QZSS_L2C,
+    [NMEA_SIGNAL_QZSS_L5I]  = EPOCH_SIGNAL_QZSS_L5,
+    [NMEA_SIGNAL_QZSS_L5Q]  = EPOCH_SIGNAL_QZSS_L5,
+    [NMEA_SIGNAL_NAVIC_L5A] = EPOCH_SIGNAL_NAVIC_L5A,
+};
+
+// EPOCH_SIGNAL_t to EPOCH_GNSS_t
+static const uint8_t kEpochSignalGnss[] =
+{
+    [EPOCH_SIGNAL_UNKNOWN]   = EPOCH_GNSS_UNKNOWN,
+    [EPOCH_SIGNAL_GPS_L1CA]  = EPOCH_GNSS_GPS,
+    [EPOCH_SIGNAL_GPS_L2C]   = EPOCH_GNSS_GPS,
+    [EPOCH_SIGNAL_GPS_L5]    = EPOCH_GNSS_GPS,
+    [EPOCH_SIGNAL_SBAS_L1CA] = EPOCH_GNSS_SBAS,
+    [EPOCH_SIGNAL_GAL_E1]    = EPOCH_GNSS_GAL,
+    [EPOCH_SIGNAL_GAL_E5B]   = EPOCH_GNSS_GAL,
+    [EPOCH_SIGNAL_GAL_E5A]   = EPOCH_GNSS_GAL,
+    [EPOCH_SIGNAL_GAL_E6]    = EPOCH_GNSS_GAL,
+    [EPOCH_SIGNAL_BDS_B1C]   = EPOCH_GNSS_BDS,
+    [EPOCH_SIGNAL_BDS_B1I]   = EPOCH_GNSS_BDS,
+    [EPOCH_SIGNAL_BDS_B2I]   = EPOCH_GNSS_BDS,
+    [EPOCH_SIGNAL_BDS_B3I]   = EPOCH_GNSS_BDS,
+    [EPOCH_SIGNAL_BDS_B2A]   = EPOCH_GNSS_BDS,
+    [EPOCH_SIGNAL_QZSS_L1CA] = EPOCH_GNSS_QZSS,
+    [EPOCH_SIGNAL_QZSS_L1S]  = EPOCH_GNSS_QZSS,
+    [EPOCH_SIGNAL_QZSS_L2C]  = EPOCH_GNSS_QZSS,
+    [EPOCH_SIGNAL_QZSS_L5]   = EPOCH_GNSS_QZSS,
+    [EPOCH_SIGNAL_GLO_L1OF]  = EPOCH_GNSS_GLO,
+    [EPOCH_SIGNAL_GLO_L2OF]  = EPOCH_GNSS_GLO,
+    [EPOCH_SIGNAL_NAVIC_L5A] = EPOCH_GNSS_NAVIC,
+};
+
+// EPOCH_SIGNAL_t to EPOCH_BAND_t
+static const uint8_t kEpochSignalBand[] =
+{
+    [EPOCH_SIGNAL_UNKNOWN]   = EPOCH_BAND_UNKNOWN,
+    [EPOCH_SIGNAL_GPS_L1CA]  = EPOCH_BAND_L1,
+    [EPOCH_SIGNAL_GPS_L2C]   = EPOCH_BAND_L2,
+    [EPOCH_SIGNAL_GPS_L5]    = EPOCH_BAND_L5,
+    [EPOCH_SIGNAL_SBAS_L1CA] = EPOCH_BAND_L1,
+    [EPOCH_SIGNAL_GAL_E1]    = EPOCH_BAND_L1,
+    [EPOCH_SIGNAL_GAL_E5B]   = EPOCH_BAND_L2,
+    [EPOCH_SIGNAL_GAL_E5A]   = EPOCH_BAND_L5,
+    [EPOCH_SIGNAL_GAL_E6]    = EPOCH_BAND_E6,
+    [EPOCH_SIGNAL_BDS_B1C]   = EPOCH_BAND_L1,
+    [EPOCH_SIGNAL_BDS_B1I]   = EPOCH_BAND_L1,
+    [EPOCH_SIGNAL_BDS_B2I]   = EPOCH_BAND_L2,
+    [EPOCH_SIGNAL_BDS_B3I]   = EPOCH_BAND_E6,
+    [EPOCH_SIGNAL_BDS_B2A]   = EPOCH_BAND_L5,
+    [EPOCH_SIGNAL_QZSS_L1CA] = EPOCH_BAND_L1,
+    [EPOCH_SIGNAL_QZSS_L1S]  = EPOCH_BAND_L1,
+    [EPOCH_SIGNAL_QZSS_L2C]  = EPOCH_BAND_L2,
+    [EPOCH_SIGNAL_QZSS_L5]   = EPOCH_BAND_L5,
+    [EPOCH_SIGNAL_GLO_L1OF]  = EPOCH_BAND_L1,
+    [EPOCH_SIGNAL_GLO_L2OF]  = EPOCH_BAND_L2,
+    [EPOCH_SIGNAL_NAVIC_L5A] = EPOCH_BAND_L5,
+};
+
 static EPOCH_GNSS_t _ubxGnssIdToGnss(const uint8_t gnssId)
 {
-    switch (gnssId)
+    return gnssId < NUMOF(kEpochUbxGnss) ? (EPOCH_GNSS_t)kEpochUbxGnss[gnssId] : EPOCH_GNSS_UNKNOWN;
+}
+
+static EPOCH_SIGNAL_t _ubxSigIdToSignal(const uint8_t gnssId, const uint8_t sigId)
+{
+    return (gnssId < NUMOF(kEpochUbxSignal)) && (sigId < NUMOF(kEpochUbxSignal[0])) ?
+        (EPOCH_SIGNAL_t)kEpochUbxSignal[gnssId][sigId] : EPOCH_SIGNAL_UNKNOWN;
+}
+
+static EPOCH_GNSS_t _nmeaGnssToGnss(const NMEA_GNSS_t gnss)
+{
+    return (gnss >= 0) && (gnss < NUMOF(kEpochNmeaGnss)) ? (EPOCH_GNSS_t)kEpochNmeaGnss[gnss] : EPOCH_GNSS_UNKNOWN;
+}
+
+static EPOCH_SIGNAL_t _nmeaSignalToSignal(const NMEA_SIGNAL_t signal)
+{
+    return (signal >= 0) && (signal < NUMOF(kEpochNmeaSignal)) ? (EPOCH_SIGNAL_t)kEpochNmeaSignal[signal] : EPOCH_SIGNAL_UNKNOWN;
+}
+
+static EPOCH_SIGUSE_t _ubxSigUse(const uint8_t qualityInd)
+{
+    return qualityInd < NUMOF(kEpochUbxSigUse) ? (EPOCH_SIGUSE_t)kEpochUbxSigUse[qualityInd] : EPOCH_SIGUSE_UNKNOWN;
+}
+
+static EPOCH_SIGCORR_t _ubxSigCorrSource(const uint8_t corrSource)
+{
+    return corrSource < NUMOF(kEpochUbxSigCorr) ? (EPOCH_SIGCORR_t)kEpochUbxSigCorr[corrSource] : EPOCH_SIGCORR_UNKNOWN;
+}
+
+static EPOCH_SIGIONO_t _ubxIonoModel(const uint8_t ionoModel)
+{
+    return ionoModel < NUMOF(kEpochUbxSigIono) ? (EPOCH_SIGIONO_t)kEpochUbxSigIono[ionoModel] : EPOCH_SIGIONO_UNKNOWN;
+}
+
+static EPOCH_SIGHEALTH_t _ubxSigHealth(const uint8_t health)
+{
+    return health < NUMOF(kEpochUbxSigHealth) ? (EPOCH_SIGHEALTH_t)kEpochUbxSigHealth[health] : EPOCH_SIGHEALTH_UNKNOWN;
+}
+
+EPOCH_GNSS_t epochSignalGnss(const EPOCH_SIGNAL_t signal)
+{
+    return (signal >= 0) && (signal < NUMOF(kEpochSignalGnss)) ? (EPOCH_GNSS_t)kEpochSignalGnss[signal] : EPOCH_GNSS_UNKNOWN;
+}
+
+EPOCH_BAND_t epochSignalBand(const EPOCH_SIGNAL_t signal)
+{
+    return (signal >= 0) && (signal < NUMOF(kEpochSignalBand)) ? (EPOCH_BAND_t)kEpochSignalBand[signal] : EPOCH_BAND_UNKNOWN;
+}
+
+// First SV number, number of SVs and offset into the epochSvToIx() index for each GNSS
+static const struct { int first; int num; int offs; } kEpochSvIx[] =
+{
+    [EPOCH_GNSS_GPS]   = { EPOCH_FIRST_GPS,   EPOCH_NUM_GPS,   0 },
+    [EPOCH_GNSS_GLO]   = { EPOCH_FIRST_GLO,   EPOCH_NUM_GLO,   EPOCH_NUM_GPS },
+    [EPOCH_GNSS_GAL]   = { EPOCH_FIRST_GAL,   EPOCH_NUM_GAL,   EPOCH_NUM_GPS + EPOCH_NUM_GLO },
+    [EPOCH_GNSS_BDS]   = { EPOCH_FIRST_BDS,   EPOCH_NUM_BDS,   EPOCH_NUM_GPS + EPOCH_NUM_GLO + EPOCH_NUM_GAL },
+    [EPOCH_GNSS_SBAS]  = { EPOCH_FIRST_SBAS,  EPOCH_NUM_SBAS,  EPOCH_NUM_GPS + EPOCH_NUM_GLO + EPOCH_NUM_GAL + EPOCH_NUM_BDS },
+    [EPOCH_GNSS_QZSS]  = { EPOCH_FIRST_QZSS,  EPOCH_NUM_QZSS,  EPOCH_NUM_GPS + EPOCH_NUM_GLO + EPOCH_NUM_GAL + EPOCH_NUM_BDS + EPOCH_NUM_SBAS },
+    [EPOCH_GNSS_NAVIC] = { EPOCH_FIRST_NAVIC, EPOCH_NUM_NAVIC, EPOCH_NUM_GPS + EPOCH_NUM_GLO + EPOCH_NUM_GAL + EPOCH_NUM_BDS + EPOCH_NUM_SBAS + EPOCH_NUM_QZSS },
+};
+
+int epochSvToIx(const EPOCH_GNSS_t gnss, const int sv)
+{
+    if ( (gnss >= 0) && (gnss < NUMOF(kEpochSvIx)) )
     {
-        case UBX_GNSSID_GPS:   return EPOCH_GNSS_GPS;
-        case UBX_GNSSID_SBAS:  return EPOCH_GNSS_SBAS;
-        case UBX_GNSSID_GAL:   return EPOCH_GNSS_GAL;
-        case UBX_GNSSID_BDS:   return EPOCH_GNSS_BDS;
-        case UBX_GNSSID_QZSS:  return EPOCH_GNSS_QZSS;
-        case UBX_GNSSID_GLO:   return EPOCH_GNSS_GLO;
-        default:               return EPOCH_GNSS_UNKNOWN;
+        const int n = sv - kEpochSvIx[gnss].first;
+        if ( (n >= 0) && (n < kEpochSvIx[gnss].num) )
+        {
+            return kEpochSvIx[gnss].offs + n;
+        }
     }
+    return EPOCH_NO_SV;
 }
 
-static EPOCH_GNSS_t _nmeaGnssToGnss(NMEA_GNSS_t gnss)
+// Satellite names, in the order of epochSvToIx()
+static const char * const kEpochSvStrs[EPOCH_NUM_SV] =
 {
-    switch (gnss)
+    // GPS
+    "G01", "G02", "G03", "G04", "G05", "G06", "G07", "G08", "G09", "G10",
+    "G11", "G12", "G13", "G14", "G15", "G16", "G17", "G18", "G19", "G20",
+    "G21", "G22", "G23", "G24", "G25", "G26", "G27", "G28", "G29", "G30",
+    "G31", "G32",
+    // GLO
+    "R01", "R02", "R03", "R04", "R05", "R06", "R07", "R08", "R09", "R10",
+    "R11", "R12", "R13", "R14", "R15", "R16", "R17", "R18", "R19", "R20",
+    "R21", "R22", "R23", "R24", "R25", "R26", "R27", "R28", "R29", "R30",
+    "R31", "R32",
+    // GAL
+    "E01", "E02", "E03", "E04", "E05", "E06", "E07", "E08", "E09", "E10",
+    "E11", "E12", "E13", "E14", "E15", "E16", "E17", "E18", "E19", "E20",
+    "E21", "E22", "E23", "E24", "E25", "E26", "E27", "E28", "E29", "E30",
+    "E31", "E32", "E33", "E34", "E35", "E36",
+    // BDS
+    "B01", "B02", "B03", "B04", "B05", "B06", "B07", "B08", "B09", "B10",
+    "B11", "B12", "B13", "B14", "B15", "B16", "B17", "B18", "B19", "B20",
+    "B21", "B22", "B23", "B24", "B25", "B26", "B27", "B28", "B29", "B30",
+    "B31", "B32", "B33", "B34", "B35", "B36", "B37", "B38", "B39", "B40",
+    "B41", "B42", "B43", "B44", "B45", "B46", "B47", "B48", "B49", "B50",
+    "B51", "B52", "B53", "B54", "B55", "B56", "B57", "B58", "B59", "B60",
+    "B61", "B62", "B63",
+    // SBAS
+    "S120", "S121", "S122", "S123", "S124", "S125", "S126", "S127", "S128", "S129",
+    "S130", "S131", "S132", "S133", "S134", "S135", "S136", "S137", "S138", "S139",
+    "S140", "S141", "S142", "S143", "S144", "S145", "S146", "S147", "S148", "S149",
+    "S150", "S151", "S152", "S153", "S154", "S155", "S156", "S157", "S158",
+    // QZSS
+    "Q01", "Q02", "Q03", "Q04", "Q05", "Q06", "Q07", "Q08", "Q09", "Q10",
+    // NAVIC
+    "I01", "I02", "I03", "I04", "I05", "I06", "I07", "I08", "I09", "I10",
+    "I11", "I12", "I13", "I14",
+};
+
+// Names for invalid SV numbers
+static const char * const kEpochSvUnknownStrs[] =
+{
+    [EPOCH_GNSS_UNKNOWN] = "?",
+    [EPOCH_GNSS_GPS]     = "G?",
+    [EPOCH_GNSS_GLO]     = "R?",
+    [EPOCH_GNSS_GAL]     = "E?",
+    [EPOCH_GNSS_BDS]     = "B?",
+    [EPOCH_GNSS_SBAS]    = "S?",
+    [EPOCH_GNSS_QZSS]    = "Q?",
+    [EPOCH_GNSS_NAVIC]   = "I?",
+};
+
+const char *epochSvStr(const EPOCH_GNSS_t gnss, const int sv)
+{
+    const int ix = epochSvToIx(gnss, sv);
+    if (ix < EPOCH_NUM_SV)
     {
-        case NMEA_GNSS_UNKNOWN: break;
-        case NMEA_GNSS_GPS:     return EPOCH_GNSS_GPS;
-        case NMEA_GNSS_GLO:     return EPOCH_GNSS_GLO;
-        case NMEA_GNSS_BDS:     return EPOCH_GNSS_BDS;
-        case NMEA_GNSS_GAL:     return EPOCH_GNSS_GAL;
-        case NMEA_GNSS_SBAS:    return EPOCH_GNSS_SBAS;
-        case NMEA_GNSS_QZSS:    return EPOCH_GNSS_QZSS;
-        case NMEA_GNSS_NAVIC:   return EPOCH_GNSS_QZSS;
+        return kEpochSvStrs[ix];
     }
-    return EPOCH_GNSS_UNKNOWN;
+    return (gnss >= 0) && (gnss < NUMOF(kEpochSvUnknownStrs)) ? kEpochSvUnknownStrs[gnss] : kEpochSvUnknownStrs[EPOCH_GNSS_UNKNOWN];
 }
 
 static const char * const kEpochGnssStrs[] =
@@ -325,108 +776,7 @@ const char *epochGnssStr(const EPOCH_GNSS_t gnss)
     return (gnss >= 0) && (gnss < NUMOF(kEpochGnssStrs)) ? kEpochGnssStrs[gnss] : kEpochGnssStrs[EPOCH_GNSS_UNKNOWN];
 }
 
-static EPOCH_SIGNAL_t _ubxSigIdToSignal(const uint8_t gnssId, const uint8_t sigId)
-{
-    switch (gnssId)
-    {
-        case UBX_GNSSID_GPS:
-            switch (sigId)
-            {
-                case UBX_SIGID_GPS_L1CA: return EPOCH_SIGNAL_GPS_L1CA;
-                case UBX_SIGID_GPS_L2CL:
-                case UBX_SIGID_GPS_L2CM: return EPOCH_SIGNAL_GPS_L2C;
-                case UBX_SIGID_GPS_L5I:
-                case UBX_SIGID_GPS_L5Q:  return EPOCH_SIGNAL_GPS_L5;
-            }
-            break;
-        case UBX_GNSSID_SBAS:
-            switch (sigId)
-            {
-                case UBX_SIGID_SBAS_L1CA: return EPOCH_SIGNAL_SBAS_L1CA;
-            }
-            break;
-        case UBX_GNSSID_GAL:
-            switch (sigId)
-            {
-                case UBX_SIGID_GAL_E1C:
-                case UBX_SIGID_GAL_E1B:  return EPOCH_SIGNAL_GAL_E1;
-                case UBX_SIGID_GAL_E5BI:
-                case UBX_SIGID_GAL_E5BQ: return EPOCH_SIGNAL_GAL_E5B;
-                case UBX_SIGID_GAL_E5AI:
-                case UBX_SIGID_GAL_E5AQ: return EPOCH_SIGNAL_GAL_E5A;
-                case UBX_SIGID_GAL_E6B:
-                case UBX_SIGID_GAL_E6C:
-                case UBX_SIGID_GAL_E6A:  return EPOCH_SIGNAL_GAL_E6;
-            }
-            break;
-        case UBX_GNSSID_BDS:
-            switch (sigId)
-            {
-                case UBX_SIGID_BDS_B1CP:
-                case UBX_SIGID_BDS_B1CD:  return EPOCH_SIGNAL_BDS_B1C;
-                case UBX_SIGID_BDS_B1ID1:
-                case UBX_SIGID_BDS_B1ID2: return EPOCH_SIGNAL_BDS_B1I;
-                case UBX_SIGID_BDS_B2ID1:
-                case UBX_SIGID_BDS_B2ID2: return EPOCH_SIGNAL_BDS_B2I;
-                case UBX_SIGID_BDS_B2AP:
-                case UBX_SIGID_BDS_B2AD:  return EPOCH_SIGNAL_BDS_B2A;
-                case UBX_SIGID_BDS_B3ID1:
-                case UBX_SIGID_BDS_B3ID2: return EPOCH_SIGNAL_BDS_B3I;
-            }
-            break;
-        case UBX_GNSSID_QZSS:
-            switch (sigId)
-            {
-                case UBX_SIGID_QZSS_L1CA: return EPOCH_SIGNAL_QZSS_L1CA;
-                case UBX_SIGID_QZSS_L1S:  return EPOCH_SIGNAL_QZSS_L1S;
-                case UBX_SIGID_QZSS_L2CM:
-                case UBX_SIGID_QZSS_L2CL: return EPOCH_SIGNAL_QZSS_L2C;
-                case UBX_SIGID_QZSS_L5I:
-                case UBX_SIGID_QZSS_L5Q:  return EPOCH_SIGNAL_QZSS_L5;
-            }
-            break;
-        case UBX_GNSSID_GLO:
-            switch (sigId)
-            {
-                case UBX_SIGID_GLO_L1OF:  return EPOCH_SIGNAL_GLO_L1OF;
-                case UBX_SIGID_GLO_L2OF:  return EPOCH_SIGNAL_GLO_L2OF;
-            }
-            break;
-        }
-    return EPOCH_SIGNAL_UNKNOWN;
-}
-
-static EPOCH_SIGNAL_t _nmeaSignalToSignal(NMEA_SIGNAL_t signal)
-{
-    switch (signal)
-    {
-        case NMEA_SIGNAL_UNKNOWN:     break;
-        case NMEA_SIGNAL_GPS_L1CA:    return EPOCH_SIGNAL_GPS_L1CA;
-        case NMEA_SIGNAL_GPS_L2CL:
-        case NMEA_SIGNAL_GPS_L2CM:    return EPOCH_SIGNAL_GPS_L2C;
-        case NMEA_SIGNAL_GPS_L5I:
-        case NMEA_SIGNAL_GPS_L5Q:     return EPOCH_SIGNAL_GPS_L5;
-        case NMEA_SIGNAL_GLO_L1OF:    return EPOCH_SIGNAL_GLO_L1OF;
-        case NMEA_SIGNAL_GLO_L2OF:    return EPOCH_SIGNAL_GLO_L2OF;
-        case NMEA_SIGNAL_GAL_E1:      return EPOCH_SIGNAL_GAL_E1;
-        case NMEA_SIGNAL_GAL_E5A:     return EPOCH_SIGNAL_GAL_E5A;
-        case NMEA_SIGNAL_GAL_E5B:     return EPOCH_SIGNAL_GAL_E5B;
-        case NMEA_SIGNAL_BDS_B1ID:
-        case NMEA_SIGNAL_BDS_B2ID:    return EPOCH_SIGNAL_BDS_B1I;
-        case NMEA_SIGNAL_BDS_B1C:     return EPOCH_SIGNAL_BDS_B1C;
-        case NMEA_SIGNAL_BDS_B2A:     return EPOCH_SIGNAL_BDS_B2A;
-        case NMEA_SIGNAL_QZSS_L1CA:   return EPOCH_SIGNAL_QZSS_L1CA;
-        case NMEA_SIGNAL_QZSS_L1S:    return EPOCH_SIGNAL_QZSS_L1S;
-        case NMEA_SIGNAL_QZSS_L2CM:
-        case NMEA_SIGNAL_QZSS_L2CL:   return EPOCH_SIGNAL_QZSS_L2C;
-        case NMEA_SIGNAL_QZSS_L5I:
-        case NMEA_SIGNAL_QZSS_L5Q:    return EPOCH_SIGNAL_QZSS_L5;
-        case NMEA_SIGNAL_NAVIC_L5A:   return EPOCH_SIGNAL_NAVIC_L5A;
-    }
-    return EPOCH_SIGNAL_UNKNOWN;
-}
-
-const char * const kEpochSignalStrs[] =
+static const char * const kEpochSignalStrs[] =
 {
     [EPOCH_SIGNAL_UNKNOWN]   = "?",
     [EPOCH_SIGNAL_GPS_L1CA]  = "L1CA",
@@ -456,89 +806,7 @@ const char *epochSignalStr(const EPOCH_SIGNAL_t signal)
     return (signal >= 0) && (signal < NUMOF(kEpochSignalStrs)) ? kEpochSignalStrs[signal] : kEpochSignalStrs[EPOCH_SIGNAL_UNKNOWN];
 }
 
-EPOCH_GNSS_t epochSignalGnss(const EPOCH_SIGNAL_t signal)
-{
-    switch (signal)
-    {
-        case EPOCH_SIGNAL_UNKNOWN:     return EPOCH_GNSS_UNKNOWN;
-        case EPOCH_SIGNAL_GPS_L1CA:
-        case EPOCH_SIGNAL_GPS_L2C:
-        case EPOCH_SIGNAL_GPS_L5:      return EPOCH_GNSS_GPS;
-        case EPOCH_SIGNAL_SBAS_L1CA:   return EPOCH_GNSS_SBAS;
-        case EPOCH_SIGNAL_GAL_E1:
-        case EPOCH_SIGNAL_GAL_E5B:
-        case EPOCH_SIGNAL_GAL_E5A:
-        case EPOCH_SIGNAL_GAL_E6:      return EPOCH_GNSS_GAL;
-        case EPOCH_SIGNAL_BDS_B1C:
-        case EPOCH_SIGNAL_BDS_B1I:
-        case EPOCH_SIGNAL_BDS_B2I:
-        case EPOCH_SIGNAL_BDS_B3I:
-        case EPOCH_SIGNAL_BDS_B2A:     return EPOCH_GNSS_BDS;
-        case EPOCH_SIGNAL_QZSS_L1CA:
-        case EPOCH_SIGNAL_QZSS_L1S:
-        case EPOCH_SIGNAL_QZSS_L2C:
-        case EPOCH_SIGNAL_QZSS_L5:     return EPOCH_GNSS_QZSS;
-        case EPOCH_SIGNAL_GLO_L1OF:
-        case EPOCH_SIGNAL_GLO_L2OF:    return EPOCH_GNSS_GLO;
-        case EPOCH_SIGNAL_NAVIC_L5A:   return EPOCH_GNSS_NAVIC;
-    }
-    return EPOCH_GNSS_UNKNOWN;
-}
-
-int epochSvToIx(const EPOCH_GNSS_t gnss, const int sv)
-{
-    int ix = EPOCH_NO_SV;
-    switch (gnss)
-    {
-        case EPOCH_GNSS_UNKNOWN:
-            break;
-        case EPOCH_GNSS_GPS:
-            if ( (sv >= EPOCH_FIRST_GPS) && (sv <= EPOCH_NUM_GPS) )
-            {
-                ix = sv - EPOCH_FIRST_GPS;
-            }
-            break;
-        case EPOCH_GNSS_GLO:
-            if ( (sv >= EPOCH_FIRST_GLO) && (sv <= EPOCH_NUM_GLO) )
-            {
-                ix = EPOCH_NUM_GPS + sv - EPOCH_FIRST_GLO;
-            }
-            break;
-        case EPOCH_GNSS_GAL:
-            if ( (sv >= EPOCH_FIRST_GAL) && (sv <= EPOCH_NUM_GAL) )
-            {
-                ix = EPOCH_NUM_GPS + EPOCH_NUM_GLO + sv - EPOCH_FIRST_GAL;
-            }
-            break;
-        case EPOCH_GNSS_BDS:
-            if ( (sv >= EPOCH_FIRST_BDS) && (sv <= EPOCH_NUM_BDS) )
-            {
-                ix = EPOCH_NUM_GPS + EPOCH_NUM_GLO + EPOCH_NUM_GAL + sv - EPOCH_FIRST_BDS;
-            }
-            break;
-        case EPOCH_GNSS_SBAS:
-            if ( (sv >= EPOCH_FIRST_SBAS) && (sv <= EPOCH_NUM_SBAS) )
-            {
-                ix = EPOCH_NUM_GPS + EPOCH_NUM_GLO + EPOCH_NUM_GAL + EPOCH_NUM_BDS + sv - EPOCH_FIRST_SBAS;
-            }
-            break;
-        case EPOCH_GNSS_QZSS:
-            if ( (sv >= EPOCH_FIRST_QZSS) && (sv <= EPOCH_NUM_QZSS) )
-            {
-                ix = EPOCH_NUM_GPS + EPOCH_NUM_GLO + EPOCH_NUM_GAL + EPOCH_NUM_BDS + EPOCH_NUM_SBAS + sv - EPOCH_FIRST_QZSS;
-            }
-            break;
-        case EPOCH_GNSS_NAVIC:
-            if ( (sv >= EPOCH_FIRST_NAVIC) && (sv <= EPOCH_NUM_NAVIC) )
-            {
-                ix = EPOCH_NUM_GPS + EPOCH_NUM_GLO + EPOCH_NUM_GAL + EPOCH_NUM_BDS + EPOCH_NUM_SBAS + EPOCH_NUM_QZSS + sv - EPOCH_FIRST_NAVIC;
-            }
-            break;
-        }
-    return ix;
-}
-
-const char * const kEpochBandStrs[] =
+static const char * const kEpochBandStrs[] =
 {
     [EPOCH_BAND_UNKNOWN] = "?",
     [EPOCH_BAND_L1]      = "L1",
@@ -547,148 +815,9 @@ const char * const kEpochBandStrs[] =
     [EPOCH_BAND_L5]      = "L5",
 };
 
-static const char *_epochSvStr(const EPOCH_GNSS_t gnss, const uint8_t sv)
+const char *epochBandStr(const EPOCH_BAND_t band)
 {
-    switch (gnss)
-    {
-        case EPOCH_GNSS_GPS:
-        {
-            const char * const strs[] =
-            {
-                "G01", "G02", "G03", "G04", "G05", "G06", "G07", "G08", "G09", "G10",
-                "G11", "G12", "G13", "G14", "G15", "G16", "G17", "G18", "G19", "G20",
-                "G21", "G22", "G23", "G24", "G25", "G26", "G27", "G28", "G29", "G30",
-                "G31", "G32"
-            };
-            const int ix = sv - 1;
-            if ( (ix >= 0) && (ix < NUMOF(strs)) )
-            {
-                return strs[ix];
-            }
-            else
-            {
-                return "G?";
-            }
-        }
-        case EPOCH_GNSS_GLO:
-        {
-            const char * const strs[] =
-            {
-                "R01", "R02", "R03", "R04", "R05", "R06", "R07", "R08", "R09", "R10",
-                "R11", "R12", "R13", "R14", "R15", "R16", "R17", "R18", "R19", "R20",
-                "R21", "R22", "R23", "R24", "R25", "R26", "R27", "R28", "R29", "R30",
-                "R31", "R32"
-            };
-            const int ix = sv - 1;
-            if ( (ix >= 0) && (ix < NUMOF(strs)) )
-            {
-                return strs[ix];
-            }
-            else
-            {
-                return "R?";
-            }
-        }
-        case EPOCH_GNSS_GAL:
-        {
-            const char * const strs[] =
-            {
-                "E01", "E02", "E03", "E04", "E05", "E06", "E07", "E08", "E09", "E10",
-                "E11", "E12", "E13", "E14", "E15", "E16", "E17", "E18", "E19", "E20",
-                "E21", "E22", "E23", "E24", "E25", "E26", "E27", "E28", "E29", "E30",
-                "E31", "E32", "E33", "E34", "E35", "E36"
-            };
-            const int ix = sv - 1;
-            if ( (ix >= 0) && (ix < NUMOF(strs)) )
-            {
-                return strs[ix];
-            }
-            else
-            {
-                return "E?";
-            }
-        }
-        case EPOCH_GNSS_BDS:
-        {
-            const char * const strs[] =
-            {
-                "B01", "B02", "B03", "B04", "B05", "B06", "B07", "B08", "B09", "B10",
-                "B11", "B12", "B13", "B14", "B15", "B16", "B17", "B18", "B19", "B20",
-                "B21", "B22", "B23", "B24", "B25", "B26", "B27", "B28", "B29", "B30",
-                "B31", "B32", "B33", "B34", "B35", "B36", "B37", "B38", "B30", "B40",
-                "B31", "B32", "B33", "B34", "B35", "B36", "B37", "B38", "B30", "B40",
-                "B41", "B42", "B43", "B44", "B45", "B46", "B47", "B48", "B40", "B50",
-                "B51", "B52", "B53", "B54", "B55", "B56", "B57", "B58", "B50", "B60",
-                "B61", "B62", "B63"
-            };
-            const int ix = sv - 1;
-            if ( (ix >= 0) && (ix < NUMOF(strs)) )
-            {
-                return strs[ix];
-            }
-            else
-            {
-                return "B?";
-            }
-        }
-        case EPOCH_GNSS_SBAS:
-        {
-            const char * const strs[] =
-            {
-                "S120", "S121", "S122", "S123", "S123", "S124", "S126", "S127", "S128", "S129"
-                "S130", "S131", "S132", "S133", "S133", "S134", "S136", "S137", "S138", "S139"
-                "S140", "S141", "S142", "S143", "S143", "S144", "S146", "S147", "S148", "S149"
-                "S150", "S151", "S152", "S153", "S153", "S154", "S156", "S157", "S158"
-            };
-            const int ix = sv - 120;
-            if ( (ix >= 0) && (ix < NUMOF(strs)) )
-            {
-                return strs[ix];
-            }
-            else
-            {
-                return "G?";
-            }
-        }
-        case EPOCH_GNSS_QZSS:
-        {
-            const char * const strs[] =
-            {
-                "Q01", "Q02", "Q03", "Q04", "Q05", "Q06", "Q07", "Q08", "Q09", "Q10",
-                "Q11", "Q12", "Q13", "Q14", "Q15", "Q16", "Q17", "Q18", "Q19", "Q20",
-                "Q21", "Q22", "Q23", "Q24", "Q25", "Q26", "Q27", "Q28", "Q29", "Q30",
-                "Q31", "Q32"
-            };
-            const int ix = sv - 1;
-            if ( (ix >= 0) && (ix < NUMOF(strs)) )
-            {
-                return strs[ix];
-            }
-            else
-            {
-                return "Q?";
-            }
-        }
-        default:
-            break;
-    }
-    return "?";
-}
-
-static EPOCH_SIGUSE_t _ubxSigUse(const uint8_t qualityInd)
-{
-    switch (qualityInd)
-    {
-        case UBX_NAV_SIG_V0_QUALITYIND_SEARCH:    return EPOCH_SIGUSE_SEARCH;
-        case UBX_NAV_SIG_V0_QUALITYIND_ACQUIRED:  return EPOCH_SIGUSE_ACQUIRED;
-        case UBX_NAV_SIG_V0_QUALITYIND_UNUSED:    return EPOCH_SIGUSE_UNUSABLE;
-        case UBX_NAV_SIG_V0_QUALITYIND_CODELOCK:  return EPOCH_SIGUSE_CODELOCK;
-        case UBX_NAV_SIG_V0_QUALITYIND_CARRLOCK1:
-        case UBX_NAV_SIG_V0_QUALITYIND_CARRLOCK2:
-        case UBX_NAV_SIG_V0_QUALITYIND_CARRLOCK3: return EPOCH_SIGUSE_CARRLOCK;
-        case UBX_NAV_SIG_V0_QUALITYIND_NOSIG:     return EPOCH_SIGUSE_NONE;
-        default:                                  return EPOCH_SIGUSE_UNKNOWN;
-    }
+    return (band >= 0) && (band < NUMOF(kEpochBandStrs)) ? kEpochBandStrs[band] : kEpochBandStrs[EPOCH_BAND_UNKNOWN];
 }
 
 static const char * const kEpochSiqUseStrs[] =
@@ -702,20 +831,9 @@ static const char * const kEpochSiqUseStrs[] =
     [EPOCH_SIGUSE_CARRLOCK] = "CARRLOCK",
 };
 
-static EPOCH_SIGCORR_t _ubxSigCorrSource(const uint8_t corrSource)
+const char *epochSigUseStr(const EPOCH_SIGUSE_t use)
 {
-    switch (corrSource)
-    {
-        case UBX_NAV_SIG_V0_CORRUSED_NONE:      return EPOCH_SIGCORR_NONE;
-        case UBX_NAV_SIG_V0_CORRUSED_SBAS:      return EPOCH_SIGCORR_SBAS;
-        case UBX_NAV_SIG_V0_CORRUSED_BDS:       return EPOCH_SIGCORR_BDS;
-        case UBX_NAV_SIG_V0_CORRUSED_RTCM2:     return EPOCH_SIGCORR_RTCM2;
-        case UBX_NAV_SIG_V0_CORRUSED_RTCM3_OSR: return EPOCH_SIGCORR_RTCM3_OSR;
-        case UBX_NAV_SIG_V0_CORRUSED_RTCM3_SSR: return EPOCH_SIGCORR_RTCM3_SSR;
-        case UBX_NAV_SIG_V0_CORRUSED_QZSS_SLAS: return EPOCH_SIGCORR_QZSS_SLAS;
-        case UBX_NAV_SIG_V0_CORRUSED_SPARTN:    return EPOCH_SIGCORR_SPARTN;
-        default:                                return EPOCH_SIGCORR_UNKNOWN;
-    }
+    return (use >= 0) && (use < NUMOF(kEpochSiqUseStrs)) ? kEpochSiqUseStrs[use] : kEpochSiqUseStrs[EPOCH_SIGUSE_UNKNOWN];
 }
 
 static const char * const kEpochSigCorrStrs[] =
@@ -731,17 +849,9 @@ static const char * const kEpochSigCorrStrs[] =
     [EPOCH_SIGCORR_SPARTN]    = "SPARTN",
 };
 
-static EPOCH_SIGIONO_t _ubxIonoModel(const uint8_t ionoModel)
+const char *epochSigCorrStr(const EPOCH_SIGCORR_t corr)
 {
-    switch (ionoModel)
-    {
-        case UBX_NAV_SIG_V0_IONOMODEL_NONE:     return EPOCH_SIGIONO_NONE;
-        case UBX_NAV_SIG_V0_IONOMODEL_KLOB_GPS: return EPOCH_SIGIONO_KLOB_GPS;
-        case UBX_NAV_SIG_V0_IONOMODEL_KLOB_BDS: return EPOCH_SIGIONO_KLOB_BDS;
-        case UBX_NAV_SIG_V0_IONOMODEL_SBAS:     return EPOCH_SIGIONO_SBAS;
-        case UBX_NAV_SIG_V0_IONOMODEL_DUALFREQ: return EPOCH_SIGIONO_DUAL_FREQ;
-        default:                                return EPOCH_SIGIONO_UNKNOWN;
-    }
+    return (corr >= 0) && (corr < NUMOF(kEpochSigCorrStrs)) ? kEpochSigCorrStrs[corr] : kEpochSigCorrStrs[EPOCH_SIGCORR_UNKNOWN];
 }
 
 static const char * const kEpochSigIonoStrs[] =
@@ -754,15 +864,9 @@ static const char * const kEpochSigIonoStrs[] =
     [EPOCH_SIGIONO_DUAL_FREQ] = "DUAL-FREQ",
 };
 
-static EPOCH_SIGHEALTH_t _ubxSigHealth(const uint8_t health)
+const char *epochSigIonoStr(const EPOCH_SIGIONO_t iono)
 {
-    switch (health)
-    {
-        case UBX_NAV_SIG_V0_SIGFLAGS_HEALTH_HEALTHY:   return EPOCH_SIGHEALTH_HEALTHY;
-        case UBX_NAV_SIG_V0_SIGFLAGS_HEALTH_UNHEALTHY: return EPOCH_SIGHEALTH_UNHEALTHY;
-        case UBX_NAV_SIG_V0_SIGFLAGS_HEALTH_UNKNO:
-        default:                                       return EPOCH_SIGHEALTH_UNKNOWN;
-    }
+    return (iono >= 0) && (iono < NUMOF(kEpochSigIonoStrs)) ? kEpochSigIonoStrs[iono] : kEpochSigIonoStrs[EPOCH_SIGIONO_UNKNOWN];
 }
 
 static const char * const kEpochSigHealthStrs[] =
@@ -772,6 +876,11 @@ static const char * const kEpochSigHealthStrs[] =
     [EPOCH_SIGHEALTH_UNHEALTHY] = "UNHEALTHY",
 };
 
+const char *epochSigHealthStr(const EPOCH_SIGHEALTH_t health)
+{
+    return (health >= 0) && (health < NUMOF(kEpochSigHealthStrs)) ? kEpochSigHealthStrs[health] : kEpochSigHealthStrs[EPOCH_SIGHEALTH_UNKNOWN];
+}
+
 static const char * const kEpochOrbStrs[] =
 {
     [EPOCH_SATORB_NONE]  = "NONE",
@@ -781,18 +890,112 @@ static const char * const kEpochOrbStrs[] =
     [EPOCH_SATORB_OTHER] = "OTHER",
 };
 
-static int _epochSigInfoSort(const void *a, const void *b)
+const char *epochSatOrbStr(const EPOCH_SATORB_t orb)
+{
+    return (orb >= 0) && (orb < NUMOF(kEpochOrbStrs)) ? kEpochOrbStrs[orb] : kEpochOrbStrs[EPOCH_SATORB_NONE];
+}
+
+// Position of a signal within the signals of its satellite, see EPOCH_NUM_SIGSLOTS
+static const uint8_t kEpochSignalSlot[] =
+{
+    [EPOCH_SIGNAL_UNKNOWN]   = 0, // e.g. NMEA GSV before NMEA 4.10
+    [EPOCH_SIGNAL_GPS_L1CA]  = 1,
+    [EPOCH_SIGNAL_GPS_L2C]   = 2,
+    [EPOCH_SIGNAL_GPS_L5]    = 3,
+    [EPOCH_SIGNAL_SBAS_L1CA] = 1,
+    [EPOCH_SIGNAL_GAL_E1]    = 1,
+    [EPOCH_SIGNAL_GAL_E5B]   = 2,
+    [EPOCH_SIGNAL_GAL_E5A]   = 3,
+    [EPOCH_SIGNAL_GAL_E6]    = 4,
+    [EPOCH_SIGNAL_BDS_B1C]   = 1,
+    [EPOCH_SIGNAL_BDS_B1I]   = 2,
+    [EPOCH_SIGNAL_BDS_B2I]   = 3,
+    [EPOCH_SIGNAL_BDS_B3I]   = 4,
+    [EPOCH_SIGNAL_BDS_B2A]   = 5,
+    [EPOCH_SIGNAL_QZSS_L1CA] = 1,
+    [EPOCH_SIGNAL_QZSS_L1S]  = 2,
+    [EPOCH_SIGNAL_QZSS_L2C]  = 3,
+    [EPOCH_SIGNAL_QZSS_L5]   = 4,
+    [EPOCH_SIGNAL_GLO_L1OF]  = 1,
+    [EPOCH_SIGNAL_GLO_L2OF]  = 2,
+    [EPOCH_SIGNAL_NAVIC_L5A] = 1,
+};
+
+// Signals and satellites are stored in arrival order in EPOCH_t.signals resp. EPOCH_t.satellites. The slot (given by
+// epochSvToIx() and the signal) of each entry is marked in a bitmap (_sigMap, _satMap) and the index of the entry is
+// stored in a lookup table (_sigIx, _satIx). Iterating the bitmap gives the entries in the final order. Entries for
+// satellites unknown to epochSvToIx() have no slot. They are kept in arrival order after the others.
+
+// Get entry for a new signal, returns NULL if the signal is already present or there is no more space
+static EPOCH_SIGINFO_t *_epochSigSlot(EPOCH_t *coll, const EPOCH_GNSS_t gnss, const int sv, const EPOCH_SIGNAL_t signal)
 {
-    const EPOCH_SIGINFO_t *sA = (const EPOCH_SIGINFO_t *)a;
-    const EPOCH_SIGINFO_t *sB = (const EPOCH_SIGINFO_t *)b;
-    return (int32_t)(sA->_order - sB->_order);
+    const int svIx = epochSvToIx(gnss, sv);
+    const EPOCH_SIGNAL_t sigId = (signal >= 0) && (signal < NUMOF(kEpochSignalSlot)) ? signal : EPOCH_SIGNAL_UNKNOWN;
+    const int slot = (svIx * EPOCH_NUM_SIGSLOTS) + kEpochSignalSlot[sigId];
+    const uint64_t bit = (uint64_t)1 << (slot % 64);
+    if ( (svIx < EPOCH_NUM_SV) && ((coll->_sigMap[slot / 64] & bit) != 0) )
+    {
+        return NULL;
+    }
+    if (coll->numSignals >= coll->maxSignals)
+    {
+        coll->numSignalsDropped++;
+        return NULL;
+    }
+    if (svIx < EPOCH_NUM_SV)
+    {
+        coll->_sigMap[slot / 64] |= bit;
+        coll->_sigIx[slot] = coll->numSignals;
+    }
+    EPOCH_SIGINFO_t *sig = &coll->signals[coll->numSignals];
+    coll->numSignals++;
+    memset(sig, 0, sizeof(*sig));
+    sig->gnss   = gnss;
+    sig->sv     = sv;
+    sig->signal = sigId;
+    sig->band   = (EPOCH_BAND_t)kEpochSignalBand[sigId];
+    return sig;
+}
+
+// Get entry for a new satellite, returns NULL if the satellite is already present or there is no more space
+static EPOCH_SATINFO_t *_epochSatSlot(EPOCH_t *coll, const EPOCH_GNSS_t gnss, const int sv)
+{
+    const int svIx = epochSvToIx(gnss, sv);
+    const uint64_t bit = (uint64_t)1 << (svIx % 64);
+    if ( (svIx < EPOCH_NUM_SV) && ((coll->_satMap[svIx / 64] & bit) != 0) )
+    {
+        return NULL;
+    }
+    if (coll->numSatellites >= coll->maxSatellites)
+    {
+        coll->numSatellitesDropped++;
+        return NULL;
+    }
+    if (svIx < EPOCH_NUM_SV)
+    {
+        coll->_satMap[svIx / 64] |= bit;
+        coll->_satIx[svIx] = coll->numSatellites;
+    }
+    EPOCH_SATINFO_t *sat = &coll->satellites[coll->numSatellites];
+    coll->numSatellites++;
+    memset(sat, 0, sizeof(*sat));
+    sat->gnss = gnss;
+    sat->sv   = sv;
+    return sat;
 }
 
-static int _epochSatInfoSort(const void *a, const void *b)
+static void _epochSigClear(EPOCH_t *coll)
 {
-    const EPOCH_SATINFO_t *sA = (const EPOCH_SATINFO_t *)a;
-    const EPOCH_SATINFO_t *sB = (const EPOCH_SATINFO_t *)b;
-    return (int32_t)(sA->_order - sB->_order);
+    memset(coll->_sigMap, 0, sizeof(coll->_sigMap));
+    coll->numSignals = 0;
+    coll->numSignalsDropped = 0;
+}
+
+static void _epochSatClear(EPOCH_t *coll)
+{
+    memset(coll->_satMap, 0, sizeof(coll->_satMap));
+    coll->numSatellites = 0;
+    coll->numSatellitesDropped = 0;
 }
 
 static void _collectUbx(EPOCH_t *coll, EPOCH_COLLECT_t *collect, const PARSER_MSG_t *msg)
@@ -1022,16 +1225,18 @@ static void _collectUbx(EPOCH_t *coll, EPOCH_COLLECT_t *collect, const PARSER_MS
                     collect->haveSig = HAVE_UBX;
                     UBX_NAV_SIG_V0_GROUP0_t head;
                     memcpy(&head, &msg->data[UBX_HEAD_SIZE], sizeof(head));
-                    int ix;
-                    for (coll->numSignals = 0, ix = 0; (coll->numSignals < (int)head.numSigs) && (coll->numSignals < NUMOF(coll->signals)); coll->numSignals++, ix++)
+                    _epochSigClear(coll);
+                    for (int ix = 0; ix < (int)head.numSigs; ix++)
                     {
                         UBX_NAV_SIG_V0_GROUP1_t uInfo;
                         memcpy(&uInfo, &msg->data[UBX_HEAD_SIZE + sizeof(UBX_NAV_SIG_V0_GROUP0_t) + (ix * sizeof(uInfo))], sizeof(uInfo));
-                        EPOCH_SIGINFO_t *eInfo = &coll->signals[ix];
+                        EPOCH_SIGINFO_t *eInfo = _epochSigSlot(coll, _ubxGnssIdToGnss(uInfo.gnssId), uInfo.svId,
+                            _ubxSigIdToSignal(uInfo.gnssId, uInfo.sigId));
+                        if (eInfo == NULL)
+                        {
+                            continue;
+                        }
                         eInfo->valid       = true;
-                        eInfo->gnss        = _ubxGnssIdToGnss(uInfo.gnssId);
-                        eInfo->sv          = uInfo.svId;
-                        eInfo->signal      = _ubxSigIdToSignal(uInfo.gnssId, uInfo.sigId);
                         eInfo->gloFcn      = (int)uInfo.freqId - 7;
                         eInfo->prRes       = (float)uInfo.prRes * (float)UBX_NAV_SIG_V0_PRRES_SCALE;
                         eInfo->cno         = uInfo.cno;
@@ -1058,30 +1263,20 @@ static void _collectUbx(EPOCH_t *coll, EPOCH_COLLECT_t *collect, const PARSER_MS
                     collect->haveSat = HAVE_UBX;
                     UBX_NAV_SAT_V1_GROUP0_t head;
                     memcpy(&head, &msg->data[UBX_HEAD_SIZE], sizeof(head));
-                    int ix;
-                    for (coll->numSatellites = 0, ix = 0; (coll->numSatellites < (int)head.numSvs) && (coll->numSatellites < NUMOF(coll->satellites)); coll->numSatellites++, ix++)
+                    _epochSatClear(coll);
+                    for (int ix = 0; ix < (int)head.numSvs; ix++)
                     {
                         UBX_NAV_SAT_V1_GROUP1_t uInfo;
                         memcpy(&uInfo, &msg->data[UBX_HEAD_SIZE + sizeof(UBX_NAV_SAT_V1_GROUP0_t) + (ix * sizeof(uInfo))], sizeof(uInfo));
-                        EPOCH_SATINFO_t *eInfo = &coll->satellites[ix];
-                        eInfo->valid       = true;
-                        eInfo->gnss        = _ubxGnssIdToGnss(uInfo.gnssId);
-                        eInfo->sv          = uInfo.svId;
-                        const int orbSrc = UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_GET(uInfo.flags);
-                        eInfo->orbUsed = EPOCH_SATORB_NONE;
-                        eInfo->azim = uInfo.azim;
-                        eInfo->elev = uInfo.elev;
-                        switch (orbSrc)
+                        EPOCH_SATINFO_t *eInfo = _epochSatSlot(coll, _ubxGnssIdToGnss(uInfo.gnssId), uInfo.svId);
+                        if (eInfo == NULL)
                         {
-                            case UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_NONE: break;
-                            case UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_EPH:    eInfo->orbUsed = EPOCH_SATORB_EPH; break;
-                            case UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_ALM:    eInfo->orbUsed = EPOCH_SATORB_ALM; break;
-                            case UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_ANO:    /* FALLTHROUGH */
-                            case UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_ANA:    eInfo->orbUsed = EPOCH_SATORB_PRED; break;
-                            case UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_OTHER1: /* FALLTHROUGH */
-                            case UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_OTHER2: /* FALLTHROUGH */
-                            case UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_OTHER3: eInfo->orbUsed = EPOCH_SATORB_OTHER; break;
+                            continue;
                         }
+                        eInfo->valid       = true;
+                        eInfo->orbUsed     = (EPOCH_SATORB_t)kEpochUbxSatOrb[UBX_NAV_SAT_V1_FLAGS_ORBITSOURCE_GET(uInfo.flags)];
+                        eInfo->azim        = uInfo.azim;
+                        eInfo->elev        = uInfo.elev;
                         if (FLAG(uInfo.flags, UBX_NAV_SAT_V1_FLAGS_EPHAVAIL))
                         {
                             eInfo->orbAvail |= BIT(EPOCH_SATORB_EPH);
@@ -1281,43 +1476,36 @@ static void _collectNmea(EPOCH_t *coll, EPOCH_COLLECT_t *collect, const NMEA_MSG
             if (collect->haveSat <= HAVE_NMEA) // multiple NMEA-Gx-GSV messages!
             {
                 collect->haveSat = HAVE_NMEA;
-                for (int ix = 0; (ix < nmea->gsv.nSvs) && (coll->numSatellites < (int)NUMOF(coll->satellites)); ix++)
+                for (int ix = 0; ix < nmea->gsv.nSvs; ix++)
                 {
-                    EPOCH_SATINFO_t *sat = &coll->satellites[coll->numSatellites];
-                    sat->gnss      = _nmeaGnssToGnss(nmea->gsv.svs[ix].gnss);
-                    sat->sv        = nmea->gsv.svs[ix].svId;
+                    EPOCH_SATINFO_t *sat = _epochSatSlot(coll, _nmeaGnssToGnss(nmea->gsv.svs[ix].gnss), nmea->gsv.svs[ix].svId);
+                    if (sat == NULL)
+                    {
+                        continue;
+                    }
+                    sat->valid     = true;
                     sat->orbUsed   = EPOCH_SATORB_EPH;       // presumably..
                     sat->orbAvail |= BIT(EPOCH_SATORB_EPH);  // presumably..
                     sat->elev      = nmea->gsv.svs[ix].elev;
                     sat->azim      = nmea->gsv.svs[ix].azim;
-                    coll->numSatellites++;
                 }
             }
             if (collect->haveSig <= HAVE_NMEA) // multiple NMEA-Gx-GSV messages!
             {
                 collect->haveSig = HAVE_NMEA;
-                for (int ix = 0; (ix < nmea->gsv.nSvs) && (coll->numSignals < (int)NUMOF(coll->signals)); ix++)
+                for (int ix = 0; ix < nmea->gsv.nSvs; ix++)
                 {
-                    EPOCH_SIGINFO_t *sig = &coll->signals[coll->numSignals];
-                    switch (nmea->gsv.svs[ix].gnss)
+                    EPOCH_SIGINFO_t *sig = _epochSigSlot(coll, _nmeaGnssToGnss(nmea->gsv.svs[ix].gnss), nmea->gsv.svs[ix].svId,
+                        _nmeaSignalToSignal(nmea->gsv.svs[ix].sig));
+                    if (sig == NULL)
                     {
-                        case NMEA_GNSS_UNKNOWN: sig->gnss = EPOCH_GNSS_UNKNOWN; break;
-                        case NMEA_GNSS_GPS:     sig->gnss = EPOCH_GNSS_GPS;     break;
-                        case NMEA_GNSS_GLO:     sig->gnss = EPOCH_GNSS_GLO;     break;
-                        case NMEA_GNSS_BDS:     sig->gnss = EPOCH_GNSS_BDS;     break;
-                        case NMEA_GNSS_GAL:     sig->gnss = EPOCH_GNSS_GAL;     break;
-                        case NMEA_GNSS_SBAS:    sig->gnss = EPOCH_GNSS_SBAS;    break;
-                        case NMEA_GNSS_QZSS:    sig->gnss = EPOCH_GNSS_QZSS;    break;
-                        case NMEA_GNSS_NAVIC:   sig->gnss = EPOCH_GNSS_NAVIC;   break;
+                        continue;
                     }
-                    sig->gnss      = _nmeaGnssToGnss(nmea->gsv.svs[ix].gnss);
-                    sig->sv        = nmea->gsv.svs[ix].svId;
-                    sig->signal    = _nmeaSignalToSignal(nmea->gsv.svs[ix].sig);
+                    sig->valid     = true;
                     sig->cno       = nmea->gsv.svs[ix].cno;
                     sig->use       = EPOCH_SIGUSE_CODELOCK;   // presumably..
                     sig->health    = EPOCH_SIGHEALTH_HEALTHY; // presumably..
                     sig->prUsed    = true; // presumably..
-                    coll->numSignals++;
                 }
             }
             break;
@@ -1328,8 +1516,9 @@ static void _collectNmea(EPOCH_t *coll, EPOCH_COLLECT_t *collect, const NMEA_MSG
     }
 }
 
-static void _epochComplete(const EPOCH_COLLECT_t *collect, EPOCH_t *epoch)
+static void _epochComplete(const EPOCH_t *coll, EPOCH_t *epoch)
 {
+    const EPOCH_COLLECT_t *collect = (const EPOCH_COLLECT_t *)coll->_collect;
     epoch->valid = true;
     epoch->ts = TIME();
     const double now = posixNow();
@@ -1378,67 +1567,66 @@ static void _epochComplete(const EPOCH_COLLECT_t *collect, EPOCH_t *epoch)
         epoch->vel3d = sqrt( velNEsq + (epoch->velNed[2] * epoch->velNed[2]) );
     }
 
-    // Stringify and sort list of satellites
-    for (int ix = 0; ix < epoch->numSatellites; ix++)
+    // Ordered list of satellites, and lookup table for signal to satellite
+    uint8_t satIxs[EPOCH_NUM_SV] = { [0 ... (EPOCH_NUM_SV-1)] = EPOCH_NO_SV };
+    epoch->numSatellites = 0;
+    for (int wIx = 0; wIx < NUMOF(coll->_satMap); wIx++)
     {
-        EPOCH_SATINFO_t *sat = &epoch->satellites[ix];
-        sat->gnssStr    = sat->gnss    < NUMOF(kEpochGnssStrs) ? kEpochGnssStrs[sat->gnss]   : kEpochGnssStrs[EPOCH_GNSS_UNKNOWN];
-        sat->orbUsedStr = sat->orbUsed < NUMOF(kEpochOrbStrs)  ? kEpochOrbStrs[sat->orbUsed] : kEpochOrbStrs[EPOCH_SATORB_NONE];
-        sat->svStr      = _epochSvStr(sat->gnss, sat->sv);
-        sat->_order     = ((sat->gnss & 0xff) << 24) | ((sat->sv & 0xff) << 16);
+        for (uint64_t bits = coll->_satMap[wIx]; bits != 0; bits &= bits - 1)
+        {
+            const int svIx = (wIx * 64) + __builtin_ctzll(bits);
+            EPOCH_SATINFO_t *sat = &epoch->satellites[epoch->numSatellites];
+            *sat = coll->satellites[ coll->_satIx[svIx] ];
+            satIxs[svIx] = epoch->numSatellites;
+            epoch->numSatellites++;
+        }
     }
-    qsort(epoch->satellites, epoch->numSatellites, sizeof(*epoch->satellites), _epochSatInfoSort);
-
-    // Create lookup table for signal to satellite
-    uint8_t satIxs[EPOCH_NUM_SV] = { [0 ... (EPOCH_NUM_SV-1)] = EPOCH_NO_SV };
-    for (int ix = 0; ix < epoch->numSatellites; ix++)
+    const int numSatSlotted = epoch->numSatellites;
+    for (int ix = 0; ix < coll->numSatellites; ix++)
     {
-        EPOCH_SATINFO_t *sat = &epoch->satellites[ix];
-        satIxs[ epochSvToIx(sat->gnss, sat->sv) ] = ix;
+        const EPOCH_SATINFO_t *sat = &coll->satellites[ix];
+        if (epochSvToIx(sat->gnss, sat->sv) >= EPOCH_NUM_SV)
+        {
+            epoch->satellites[epoch->numSatellites] = *sat;
+            epoch->numSatellites++;
+        }
     }
 
-    // Process, stringify and sort list of signals
-    for (int ix = 0; ix < epoch->numSignals; ix++)
+    // Ordered list of signals
+    epoch->numSignals = 0;
+    for (int wIx = 0; wIx < NUMOF(coll->_sigMap); wIx++)
+    {
+        for (uint64_t bits = coll->_sigMap[wIx]; bits != 0; bits &= bits - 1)
+        {
+            const int slot = (wIx * 64) + __builtin_ctzll(bits);
+            EPOCH_SIGINFO_t *sig = &epoch->signals[epoch->numSignals];
+            *sig = coll->signals[ coll->_sigIx[slot] ];
+            epoch->numSignals++;
+            sig->anyUsed     = sig->prUsed || sig->crUsed || sig->doUsed;
+            sig->satIx       = satIxs[slot / EPOCH_NUM_SIGSLOTS];
+        }
+    }
+    for (int ix = 0; ix < coll->numSignals; ix++)
     {
-        EPOCH_SIGINFO_t *sig = &epoch->signals[ix];
-        switch (sig->signal)
+        const EPOCH_SIGINFO_t *collSig = &coll->signals[ix];
+        if (epochSvToIx(collSig->gnss, collSig->sv) < EPOCH_NUM_SV)
         {
-            case EPOCH_SIGNAL_UNKNOWN:    sig->band = EPOCH_BAND_UNKNOWN; break;
-            case EPOCH_SIGNAL_GPS_L1CA:   sig->band = EPOCH_BAND_L1; break;
-            case EPOCH_SIGNAL_GPS_L2C:    sig->band = EPOCH_BAND_L2; break;
-            case EPOCH_SIGNAL_SBAS_L1CA:  sig->band = EPOCH_BAND_L1; break;
-            case EPOCH_SIGNAL_GAL_E1:     sig->band = EPOCH_BAND_L1; break;
-            case EPOCH_SIGNAL_GAL_E5B:    sig->band = EPOCH_BAND_L2; break;
-            case EPOCH_SIGNAL_GAL_E5A:    sig->band = EPOCH_BAND_L5; break;
-            case EPOCH_SIGNAL_BDS_B1C:    sig->band = EPOCH_BAND_L1; break;
-            case EPOCH_SIGNAL_BDS_B1I:    sig->band = EPOCH_BAND_L1; break;
-            case EPOCH_SIGNAL_BDS_B2A:    sig->band = EPOCH_BAND_L5; break;
-            case EPOCH_SIGNAL_BDS_B2I:    sig->band = EPOCH_BAND_L2; break;
-            case EPOCH_SIGNAL_BDS_B3I:    sig->band = EPOCH_BAND_E6; break;
-            case EPOCH_SIGNAL_QZSS_L1CA:  sig->band = EPOCH_BAND_L1; break;
-            case EPOCH_SIGNAL_QZSS_L1S:   sig->band = EPOCH_BAND_L1; break;
-            case EPOCH_SIGNAL_QZSS_L2C:   sig->band = EPOCH_BAND_L2; break;
-            case EPOCH_SIGNAL_GLO_L1OF:   sig->band = EPOCH_BAND_L1; break;
-            case EPOCH_SIGNAL_GLO_L2OF:   sig->band = EPOCH_BAND_L2; break;
-            case EPOCH_SIGNAL_GPS_L5:     sig->band = EPOCH_BAND_L5; break;
-            case EPOCH_SIGNAL_GAL_E6:     sig->band = EPOCH_BAND_E6; break;
-            case EPOCH_SIGNAL_QZSS_L5:    sig->band = EPOCH_BAND_L5; break;
-            case EPOCH_SIGNAL_NAVIC_L5A:  sig->band = EPOCH_BAND_L5; break;
+            continue;
         }
+        EPOCH_SIGINFO_t *sig = &epoch->signals[epoch->numSignals];
+        *sig = *collSig;
+        epoch->numSignals++;
         sig->anyUsed     = sig->prUsed || sig->crUsed || sig->doUsed;
-        sig->gnssStr     = sig->gnss   < NUMOF(kEpochGnssStrs)      ? kEpochGnssStrs[sig->gnss]        : kEpochGnssStrs[EPOCH_GNSS_UNKNOWN];
-        sig->svStr       = _epochSvStr(sig->gnss, sig->sv);
-        sig->signalStr   = sig->signal < NUMOF(kEpochSignalStrs)    ? kEpochSignalStrs[sig->signal]    : kEpochSignalStrs[EPOCH_SIGNAL_UNKNOWN];
-        sig->bandStr     = sig->band   < NUMOF(kEpochBandStrs)      ? kEpochBandStrs[sig->band]        : kEpochBandStrs[EPOCH_BAND_UNKNOWN];
-        sig->useStr      = sig->use    < NUMOF(kEpochSiqUseStrs)    ? kEpochSiqUseStrs[sig->use]       : kEpochSiqUseStrs[EPOCH_SIGUSE_UNKNOWN];
-        sig->corrStr     = sig->corr   < NUMOF(kEpochSigCorrStrs)   ? kEpochSigCorrStrs[sig->corr]     : kEpochSigCorrStrs[EPOCH_SIGCORR_UNKNOWN];
-        sig->ionoStr     = sig->iono   < NUMOF(kEpochSigIonoStrs)   ? kEpochSigIonoStrs[sig->iono]     : kEpochSigIonoStrs[EPOCH_SIGIONO_UNKNOWN];
-        sig->healthStr   = sig->health < NUMOF(kEpochSigHealthStrs) ? kEpochSigHealthStrs[sig->health] : kEpochSigHealthStrs[EPOCH_SIGHEALTH_UNKNOWN];
-        sig->satIx       = satIxs[epochSvToIx(sig->gnss, sig->sv)];
-
-        sig->_order = ((sig->gnss & 0xff) << 24) | ((sig->sv & 0xffff) << 8) | ((sig->signal & 0xff) << 0);
+        sig->satIx       = EPOCH_NO_SV;
+        for (int satIx = numSatSlotted; satIx < epoch->numSatellites; satIx++)
+        {
+            if ( (epoch->satellites[satIx].gnss == sig->gnss) && (epoch->satellites[satIx].sv == sig->sv) )
+            {
+                sig->satIx = satIx;
+                break;
+            }
+        }
     }
-    qsort(&epoch->signals, epoch->numSignals, sizeof(*epoch->signals), _epochSigInfoSort);
 
     // TODO: time/date <--(leapSec)--> wno/tow
 
@@ -1465,7 +1653,7 @@ static void _epochComplete(const EPOCH_COLLECT_t *collect, EPOCH_t *epoch)
         epoch->haveNumSig = true;
         epoch->haveNumSat = true;
         epoch->haveSigCnoHist = true;
-        const char *prevSvStr = "";
+        int prevSvIx = EPOCH_NO_SV;
         for (int ix = 0; ix < epoch->numSignals; ix++)
         {
             const EPOCH_SIGINFO_t *sig = &epoch->signals[ix];
@@ -1494,7 +1682,8 @@ static void _epochComplete(const EPOCH_COLLECT_t *collect, EPOCH_t *epoch)
                     case EPOCH_GNSS_UNKNOWN: break;
                 }
 
-                if (/*strcmp(prevSvStr, sig->svStr) != 0*/ prevSvStr != sig->svStr)
+                const int svIx = epochSvToIx(sig->gnss, sig->sv); // signals are ordered by this
+                if (svIx != prevSvIx)
                 {
                     epoch->numSatUsed++;
                     switch (sig->gnss)
@@ -1509,7 +1698,7 @@ static void _epochComplete(const EPOCH_COLLECT_t *collect, EPOCH_t *epoch)
                         case EPOCH_GNSS_UNKNOWN: break;
                     }
                 }
-                prevSvStr = sig->svStr;
+                prevSvIx = svIx;
             }
         }
     }
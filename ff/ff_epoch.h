@@ -106,11 +106,15 @@
     - The consequence of the two detection methods are:
       - If a end-of-epoch marker is available, epochDetect() returns true and provides the epoch data right away as
         soon as this marker message is received. There is no delay besides the time it takes the receiver to
-        calculate and output the navigation solution.
+        calculate and output the navigation solution. The marker message itself is not collected into the next epoch.
       - If no end-of-epoch marker is available, the detection relies on observing changes in the time fields. As the
         change can only be observed in a subsequent navigation solution output, epochDetect() returns true only once the
         receiver starts to output a next navigation solution. That is, if the navigation output rate is 1Hz, the
         epochDetect() repots the epoch with 1s delay (or 0.5s at 2Hz, etc.)
+    - The latency budget of each epoch is reported in EPOCH_t.latency (end-to-end, only available when reading from a
+      live receiver), EPOCH_t.latencyCollect (time to receive all messages of the epoch) and EPOCH_t.latencyOutput
+      (time spent completing and outputting the epoch once the message that completed it was given to epochCollect()).
+      EPOCH_t.detectEoe tells which of the two detection methods was used.
 
     @{
 */
@@ -246,6 +250,29 @@ typedef enum EPOCH_BAND_e
     // Keep in sync with kEpochBandStrs!
 } EPOCH_BAND_t;
 
+#define EPOCH_NUM_GPS        32
+#define EPOCH_NUM_SBAS       39
+#define EPOCH_NUM_GAL        36
+#define EPOCH_NUM_BDS        63
+#define EPOCH_NUM_GLO        32
+#define EPOCH_NUM_QZSS       10
+#define EPOCH_NUM_NAVIC      14
+#define EPOCH_FIRST_GPS       1
+#define EPOCH_FIRST_SBAS    120
+#define EPOCH_FIRST_GAL       1
+#define EPOCH_FIRST_BDS       1
+#define EPOCH_FIRST_GLO       1
+#define EPOCH_FIRST_QZSS      1
+#define EPOCH_FIRST_NAVIC     1
+#define EPOCH_NUM_SV (EPOCH_NUM_GPS + EPOCH_NUM_SBAS + EPOCH_NUM_GAL + EPOCH_NUM_BDS + EPOCH_NUM_QZSS + EPOCH_NUM_GLO + EPOCH_NUM_NAVIC)
+#define EPOCH_NO_SV (EPOCH_NUM_SV + 1)
+#define EPOCH_NUM_SIGSLOTS    6 //!< Signals per satellite: EPOCH_SIGNAL_UNKNOWN and up to 5 distinct EPOCH_SIGNAL_t of one GNSS
+#define EPOCH_NUM_BANDS       4 //!< Number of frequency bands (EPOCH_BAND_t, without EPOCH_BAND_UNKNOWN)
+#define EPOCH_MAX_SIGNALS    (EPOCH_NUM_SV * EPOCH_NUM_BANDS) //!< Maximum number of signals with an arena (EPOCH_ARENA_t)
+#define EPOCH_MAX_SATELLITES EPOCH_NUM_SV                     //!< Maximum number of satellites with an arena (EPOCH_ARENA_t)
+#define EPOCH_DEF_SIGNALS     100 //!< Maximum number of signals without an arena
+#define EPOCH_DEF_SATELLITES  100 //!< Maximum number of satellites without an arena
+
 //! Signal information
 typedef struct EPOCH_SIGINFO_s
 {
@@ -268,18 +295,7 @@ typedef struct EPOCH_SIGINFO_s
     bool              prCorrUsed;
     bool              crCorrUsed;
     bool              doCorrUsed;
-    const char       *gnssStr;
-    const char       *svStr;
-    const char       *signalStr;
-    const char       *bandStr;
-    const char       *useStr;
-    const char       *corrStr;
-    const char       *ionoStr;
-    const char       *healthStr;
-    int               satIx;
-
-    // Private
-    uint32_t          _order;
+    int               satIx;    //!< Index into EPOCH_t.satellites, or EPOCH_NO_SV if no satellite info is available
 } EPOCH_SIGINFO_t;
 
 //! Satellite orbit source
@@ -303,12 +319,6 @@ typedef struct EPOCH_SATINFO_s
     int               orbAvail; //!< Bits of EPOCH_SATORB_e
     int8_t            elev;     //!< Elevation [deg] (-90..+90), only valid if orbUsed > EPOCH_SATORB_NONE
     int16_t           azim;     //!< Azimuth [deg] (0..359), only valid if orbUsed > EPOCH_SATORB_NONE
-    const char       *gnssStr;
-    const char       *svStr;
-    const char       *orbUsedStr;
-
-    // Private
-    uint32_t          _order;
 } EPOCH_SATINFO_t;
 
 
@@ -393,13 +403,20 @@ typedef struct EPOCH_s
     double              clockDrift;
 
     bool                haveLatency;
-    float               latency;
+    float               latency;        //!< End-to-end latency [s]: navigation solution time (posixTime) to epoch output
+    float               latencyCollect; //!< Time [s] from the first message of the epoch to the message that completed it
+    float               latencyOutput;  //!< Time [s] it took to complete and output the epoch (microsecond resolution)
+    bool                detectEoe;      //!< Epoch was completed by an end-of-epoch marker (e.g. UBX-NAV-EOE)
 
-    EPOCH_SIGINFO_t     signals[100];
-    int                 numSignals;
+    EPOCH_SIGINFO_t    *signals;              //!< Signals, ordered by epochSvToIx() and signal
+    int                 numSignals;           //!< Number of signals
+    int                 maxSignals;           //!< Capacity of signals (EPOCH_DEF_SIGNALS or EPOCH_MAX_SIGNALS)
+    int                 numSignalsDropped;    //!< Number of signals dropped due to insufficient capacity
 
-    EPOCH_SATINFO_t     satellites[100];
-    int                 numSatellites;
+    EPOCH_SATINFO_t    *satellites;           //!< Satellites, ordered by epochSvToIx()
+    int                 numSatellites;        //!< Number of satellites
+    int                 maxSatellites;        //!< Capacity of satellites (EPOCH_DEF_SATELLITES or EPOCH_MAX_SATELLITES)
+    int                 numSatellitesDropped; //!< Number of satellites dropped due to insufficient capacity
 
     bool                haveNumSig;
     int                 numSigUsed;
@@ -433,27 +450,33 @@ typedef struct EPOCH_s
     char                uptimeStr[20];
 
     // Private states for epoch detection and collection
-    uint64_t            _detect[3];
+    uint64_t            _detect[4];
     uint64_t            _collect[8];
+    uint64_t            _sigMap[((EPOCH_NUM_SV * EPOCH_NUM_SIGSLOTS) + 63) / 64];
+    uint64_t            _satMap[(EPOCH_NUM_SV + 63) / 64];
+    uint16_t            _sigIx[EPOCH_NUM_SV * EPOCH_NUM_SIGSLOTS];
+    uint8_t             _satIx[EPOCH_NUM_SV];
+    struct EPOCH_ARENA_s *_arena;
+    EPOCH_SIGINFO_t     _signals[EPOCH_DEF_SIGNALS];
+    EPOCH_SATINFO_t     _satellites[EPOCH_DEF_SATELLITES];
 
 } EPOCH_t;
 
-#define EPOCH_NUM_GPS        32
-#define EPOCH_NUM_SBAS       39
-#define EPOCH_NUM_GAL        36
-#define EPOCH_NUM_BDS        63
-#define EPOCH_NUM_GLO        32
-#define EPOCH_NUM_QZSS       10
-#define EPOCH_NUM_NAVIC      14
-#define EPOCH_FIRST_GPS       1
-#define EPOCH_FIRST_SBAS    120
-#define EPOCH_FIRST_GAL       1
-#define EPOCH_FIRST_BDS       1
-#define EPOCH_FIRST_GLO       1
-#define EPOCH_FIRST_QZSS      1
-#define EPOCH_FIRST_NAVIC     1
-#define EPOCH_NUM_SV (EPOCH_NUM_GPS + EPOCH_NUM_SBAS + EPOCH_NUM_GAL + EPOCH_NUM_BDS + EPOCH_NUM_QZSS + EPOCH_NUM_GLO + EPOCH_NUM_NAVIC)
-#define EPOCH_NO_SV (EPOCH_NUM_SV + 1)
+//! Storage for the signals and satellites of one epoch, see epochInitStorage()
+typedef struct EPOCH_STORAGE_s
+{
+    // Private
+    EPOCH_SIGINFO_t     _signals[EPOCH_MAX_SIGNALS];
+    EPOCH_SATINFO_t     _satellites[EPOCH_MAX_SATELLITES];
+} EPOCH_STORAGE_t;
+
+//! Storage for epochs with up to EPOCH_MAX_SIGNALS signals and EPOCH_MAX_SATELLITES satellites, see epochInitArena()
+typedef struct EPOCH_ARENA_s
+{
+    // Private
+    EPOCH_STORAGE_t     _coll;
+    EPOCH_STORAGE_t     _epoch;
+} EPOCH_ARENA_t;
 
 // ---------------------------------------------------------------------------------------------------------------------
 
@@ -463,6 +486,32 @@ typedef struct EPOCH_s
 */
 void epochInit(EPOCH_t *coll);
 
+//! Initialise epoch collector with external storage for signals and satellites
+/*!
+    By default the collector handles up to EPOCH_DEF_SIGNALS signals and EPOCH_DEF_SATELLITES satellites, which are
+    stored in the EPOCH_t structures. This is not enough for multi-band multi-constellation receivers. With an arena
+    the collector handles up to EPOCH_MAX_SIGNALS signals and EPOCH_MAX_SATELLITES satellites. The arena is provided
+    by the caller (e.g. static or allocated once) and must be valid for as long as the collector is used. No memory
+    is allocated while collecting epochs.
+
+    \param[out]  coll   collector structure
+    \param[in]   arena  storage for signals and satellites of the collector and the output epochs
+
+    \note With an arena EPOCH_t.signals and EPOCH_t.satellites of the output epochs point into the arena, which
+          is overwritten for each new epoch.
+*/
+void epochInitArena(EPOCH_t *coll, EPOCH_ARENA_t *arena);
+
+//! Initialise epoch with external storage for signals and satellites
+/*!
+    This is for epochs that epochCopy() copies to, so that they can hold up to EPOCH_MAX_SIGNALS signals and
+    EPOCH_MAX_SATELLITES satellites (instead of EPOCH_DEF_SIGNALS resp. EPOCH_DEF_SATELLITES with epochInit()).
+
+    \param[out]  epoch    epoch structure
+    \param[in]   storage  storage for signals and satellites, must be valid for as long as the epoch is used
+*/
+void epochInitStorage(EPOCH_t *epoch, EPOCH_STORAGE_t *storage);
+
 //! Collect message, determine if a complete epoch is available
 /*!
     \param[in,out]  coll   collector structure
@@ -473,9 +522,23 @@ void epochInit(EPOCH_t *coll);
 
     \note While \c coll has the same type as \c epoch, it must not be used by the user. Only the data returned in
           \c epoch is valid, consistent and complete.
+    \note EPOCH_t.signals and EPOCH_t.satellites point to storage inside \c epoch (or into the arena, see
+          epochInitArena()), which is overwritten by the next epoch. A plain copy of the structure (assignment,
+          memcpy()) still points to that storage. Use epochCopy() to keep an epoch.
 */
 bool epochCollect(EPOCH_t *coll, const PARSER_MSG_t *msg, EPOCH_t *epoch);
 
+//! Copy epoch
+/*!
+    \param[in,out]  dst  destination epoch, initialised by epochInit() or epochInitStorage()
+    \param[in]      src  source epoch (from epochCollect())
+
+    \note Unlike a plain copy of the structure, \c dst gets its own copy of the signals and satellites, in the storage
+          it was initialised with. If that is too small (epochInit()), the remaining signals and satellites are
+          counted in EPOCH_t.numSignalsDropped and EPOCH_t.numSatellitesDropped.
+*/
+void epochCopy(EPOCH_t *dst, const EPOCH_t *src);
+
 // ---------------------------------------------------------------------------------------------------------------------
 
 //! Epoch stringification header
@@ -505,6 +568,63 @@ const char *epochSignalStr(const EPOCH_SIGNAL_t signal);
 */
 EPOCH_GNSS_t epochSignalGnss(const EPOCH_SIGNAL_t signal);
 
+//! Get frequency band from signal identifier
+/*!
+    \param[in]  signal  signal identifier
+    \returns the frequency band for the given signal identifier
+*/
+EPOCH_BAND_t epochSignalBand(const EPOCH_SIGNAL_t signal);
+
+//! Stringify satellite
+/*!
+    \param[in]  gnss  GNSS identifier
+    \param[in]  sv    SV number
+    \returns a concise unique string for the satellite ("G01", "R12", "E05", "S123", etc.)
+*/
+const char *epochSvStr(const EPOCH_GNSS_t gnss, const int sv);
+
+//! Stringify frequency band
+/*!
+    \param[in]  band  frequency band
+    \returns a concise string for the band ("L1", "L2", etc.)
+*/
+const char *epochBandStr(const EPOCH_BAND_t band);
+
+//! Stringify signal use
+/*!
+    \param[in]  use  signal use
+    \returns a concise string for the signal use ("SEARCH", "CODELOCK", etc.)
+*/
+const char *epochSigUseStr(const EPOCH_SIGUSE_t use);
+
+//! Stringify signal correction data availability
+/*!
+    \param[in]  corr  signal correction data availability
+    \returns a concise string for the correction data ("SBAS", "RTCM3-OSR", etc.)
+*/
+const char *epochSigCorrStr(const EPOCH_SIGCORR_t corr);
+
+//! Stringify ionosphere corrections
+/*!
+    \param[in]  iono  ionosphere corrections
+    \returns a concise string for the ionosphere corrections ("KLOB-GPS", "DUAL-FREQ", etc.)
+*/
+const char *epochSigIonoStr(const EPOCH_SIGIONO_t iono);
+
+//! Stringify signal health
+/*!
+    \param[in]  health  signal health
+    \returns a concise string for the signal health ("HEALTHY", "UNHEALTHY", etc.)
+*/
+const char *epochSigHealthStr(const EPOCH_SIGHEALTH_t health);
+
+//! Stringify satellite orbit source
+/*!
+    \param[in]  orb  orbit source
+    \returns a concise string for the orbit source ("EPH", "ALM", etc.)
+*/
+const char *epochSatOrbStr(const EPOCH_SATORB_t orb);
+
 
 //! GNSS + SV to index
 /*!
@@ -0,0 +1,315 @@
+// clang-format off
+// flipflip's multi-receiver navigation epoch merging
+//
+// Copyright (c) Philippe Kehl (flipflip at oinkzwurgl dot org) and contributors
+// https://oinkzwurgl.org/projaeggd/ubloxcfg/
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+// even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program.
+// If not, see <https://www.gnu.org/licenses/>.
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "ff_stuff.h"
+#include "ff_debug.h"
+#include "ff_time.h"
+
+#include "ff_epochmerge.h"
+
+/* ****************************************************************************************************************** */
+
+//#define EPOCHMERGE_DEBUG(fmt, args...) DEBUG("epochmerge: " fmt, ## args)
+#define EPOCHMERGE_DEBUG(...) /* nothing */
+
+// Per-source queue. The epochs (with storage for all signals and satellites) are allocated once. Epochs are copied
+// into the queue, and output by swapping the queue entry with the one of the previous output.
+typedef struct EPOCHMERGE_SRC_s
+{
+    EPOCH_t            *epochs[EPOCHMERGE_QUEUE_SIZE];
+    EPOCH_t            *out;                           // Epoch of the last set output
+    double              gpsTs[EPOCHMERGE_QUEUE_SIZE];  // GPS time of epochs (see wnoTow2ts())
+    int                 head;                          // Index of oldest epoch
+    int                 num;                           // Number of epochs in queue
+    bool                haveWatermark;
+    double              watermark;                     // GPS time of latest epoch added
+} EPOCHMERGE_SRC_t;
+
+struct EPOCHMERGE_s
+{
+    int                 numSrc;
+    double              tolerance;
+    uint64_t            maxLatency;
+    EPOCHMERGE_SRC_t    src[EPOCHMERGE_MAX_SRC];
+    EPOCH_t            *epochs;                        // numSrc * (EPOCHMERGE_QUEUE_SIZE + 1) epochs...
+    EPOCH_STORAGE_t    *storage;                       // ...and their storage
+    bool                haveLastTs;
+    double              lastTs;                        // GPS time of the last set output
+    EPOCHMERGE_STATS_t  stats;
+    double              sumTimeSkew;
+    double              sumArrivalSkew;
+    double              sumLatency;
+};
+
+/* ****************************************************************************************************************** */
+
+EPOCHMERGE_t *epochMergeCreate(const int numSrc, const double tolerance, const uint32_t maxLatency)
+{
+    if ( (numSrc < 2) || (numSrc > EPOCHMERGE_MAX_SRC) || (tolerance < 0.0) )
+    {
+        WARNING("epochmerge: bad parameters");
+        return NULL;
+    }
+    EPOCHMERGE_t *merge = calloc(1, sizeof(EPOCHMERGE_t));
+    if (merge == NULL)
+    {
+        WARNING("epochmerge: malloc fail");
+        return NULL;
+    }
+    const int numEpochs = numSrc * (EPOCHMERGE_QUEUE_SIZE + 1);
+    merge->epochs  = malloc(numEpochs * sizeof(*merge->epochs));
+    merge->storage = malloc(numEpochs * sizeof(*merge->storage));
+    if ( (merge->epochs == NULL) || (merge->storage == NULL) )
+    {
+        WARNING("epochmerge: malloc fail");
+        epochMergeDestroy(merge);
+        return NULL;
+    }
+    merge->numSrc     = numSrc;
+    merge->tolerance  = tolerance;
+    merge->maxLatency = maxLatency;
+    for (int ix = 0; ix < numEpochs; ix++)
+    {
+        epochInitStorage(&merge->epochs[ix], &merge->storage[ix]);
+    }
+    for (int srcIx = 0; srcIx < numSrc; srcIx++)
+    {
+        EPOCHMERGE_SRC_t *src = &merge->src[srcIx];
+        EPOCH_t *epochs = &merge->epochs[srcIx * (EPOCHMERGE_QUEUE_SIZE + 1)];
+        for (int ix = 0; ix < EPOCHMERGE_QUEUE_SIZE; ix++)
+        {
+            src->epochs[ix] = &epochs[ix];
+        }
+        src->out = &epochs[EPOCHMERGE_QUEUE_SIZE];
+    }
+    return merge;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+void epochMergeDestroy(EPOCHMERGE_t *merge)
+{
+    if (merge != NULL)
+    {
+        free(merge->epochs);
+        free(merge->storage);
+        free(merge);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+bool epochMergeAdd(EPOCHMERGE_t *merge, const int srcIx, const EPOCH_t *epoch)
+{
+    if ( (merge == NULL) || (srcIx < 0) || (srcIx >= merge->numSrc) || (epoch == NULL) )
+    {
+        return false;
+    }
+    EPOCHMERGE_SRC_t *src = &merge->src[srcIx];
+    EPOCHMERGE_SRCSTATS_t *stats = &merge->stats.src[srcIx];
+    stats->numAdded++;
+
+    if (!epoch->valid || !epoch->haveGpsWeek || !epoch->haveGpsTow)
+    {
+        stats->numRejected++;
+        return false;
+    }
+
+    // Too late (set already output) or out of order
+    const double ts = wnoTow2ts(epoch->gpsWeek, epoch->gpsTow);
+    if ( (merge->haveLastTs && (ts <= (merge->lastTs + merge->tolerance))) ||
+         (src->haveWatermark && (ts <= src->watermark)) )
+    {
+        EPOCHMERGE_DEBUG("src %d late %.3f", srcIx, ts);
+        stats->numLate++;
+        return false;
+    }
+
+    // Queue full, drop oldest
+    if (src->num >= EPOCHMERGE_QUEUE_SIZE)
+    {
+        EPOCHMERGE_DEBUG("src %d overflow", srcIx);
+        src->head = (src->head + 1) % EPOCHMERGE_QUEUE_SIZE;
+        src->num--;
+        stats->numOverflow++;
+    }
+
+    const int ix = (src->head + src->num) % EPOCHMERGE_QUEUE_SIZE;
+    epochCopy(src->epochs[ix], epoch);
+    src->gpsTs[ix] = ts;
+    src->num++;
+    src->watermark = ts;
+    src->haveWatermark = true;
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+bool epochMergeGet(EPOCHMERGE_t *merge, EPOCHMERGE_SET_t *set)
+{
+    if ( (merge == NULL) || (set == NULL) )
+    {
+        return false;
+    }
+
+    // Time of the next set is the earliest epoch in the queues
+    bool haveTs = false;
+    double setTs = 0.0;
+    for (int srcIx = 0; srcIx < merge->numSrc; srcIx++)
+    {
+        const EPOCHMERGE_SRC_t *src = &merge->src[srcIx];
+        if ( (src->num > 0) && (!haveTs || (src->gpsTs[src->head] < setTs)) )
+        {
+            setTs = src->gpsTs[src->head];
+            haveTs = true;
+        }
+    }
+    if (!haveTs)
+    {
+        return false;
+    }
+
+    // Find the epochs that belong to the set, and determine if the set is ready
+    const double maxTs = setTs + merge->tolerance;
+    bool match[EPOCHMERGE_MAX_SRC] = { false };
+    int numMatch = 0;
+    bool missingKnown = true;
+    uint64_t firstArrival = 0;
+    for (int srcIx = 0; srcIx < merge->numSrc; srcIx++)
+    {
+        const EPOCHMERGE_SRC_t *src = &merge->src[srcIx];
+        if ( (src->num > 0) && (src->gpsTs[src->head] <= maxTs) )
+        {
+            const uint64_t arrival = src->epochs[src->head]->ts;
+            if ( (numMatch == 0) || (arrival < firstArrival) )
+            {
+                firstArrival = arrival;
+            }
+            match[srcIx] = true;
+            numMatch++;
+        }
+        // Source has not (yet) delivered an epoch after the set
+        else if (!src->haveWatermark || (src->watermark <= maxTs))
+        {
+            missingKnown = false;
+        }
+    }
+    const uint64_t now = TIME();
+    const uint64_t latency = now > firstArrival ? now - firstArrival : 0;
+    const bool complete = (numMatch == merge->numSrc);
+    const bool timeout = (latency >= merge->maxLatency);
+    if (!complete && !missingKnown && !timeout)
+    {
+        return false;
+    }
+
+    // Output set
+    memset(set, 0, sizeof(*set));
+    set->complete = complete;
+    set->latency  = (double)latency * 1e-3;
+    double minTs = 0.0;
+    double lastTs = 0.0;
+    uint64_t minArrival = 0;
+    uint64_t maxArrival = 0;
+    for (int srcIx = 0; srcIx < merge->numSrc; srcIx++)
+    {
+        EPOCHMERGE_SRC_t *src = &merge->src[srcIx];
+        if (!match[srcIx])
+        {
+            merge->stats.src[srcIx].numMissing++;
+            continue;
+        }
+        const EPOCH_t *epoch = src->epochs[src->head];
+        const double ts = src->gpsTs[src->head];
+        if (set->numEpochs == 0)
+        {
+            minTs = lastTs = ts;
+            minArrival = maxArrival = epoch->ts;
+            set->gpsWeek = epoch->gpsWeek;
+            set->gpsTow = epoch->gpsTow;
+        }
+        else
+        {
+            if (ts < minTs)
+            {
+                minTs = ts;
+                set->gpsWeek = epoch->gpsWeek;
+                set->gpsTow = epoch->gpsTow;
+            }
+            lastTs = MAX(lastTs, ts);
+            minArrival = MIN(minArrival, epoch->ts);
+            maxArrival = MAX(maxArrival, epoch->ts);
+        }
+        EPOCH_t *prevOut = src->out;
+        src->out = src->epochs[src->head];
+        src->epochs[src->head] = prevOut;
+        set->epochs[srcIx] = src->out;
+        set->numEpochs++;
+        src->head = (src->head + 1) % EPOCHMERGE_QUEUE_SIZE;
+        src->num--;
+        merge->stats.src[srcIx].numMerged++;
+    }
+    set->timeSkew    = lastTs - minTs;
+    set->arrivalSkew = (double)(maxArrival - minArrival) * 1e-3;
+
+    merge->haveLastTs = true;
+    merge->lastTs = setTs;
+
+    EPOCHMERGE_STATS_t *stats = &merge->stats;
+    stats->numSets++;
+    if (complete)
+    {
+        stats->numComplete++;
+    }
+    else if (!missingKnown)
+    {
+        stats->numTimeout++;
+    }
+    stats->timeSkewMax    = MAX(stats->timeSkewMax, set->timeSkew);
+    stats->arrivalSkewMax = MAX(stats->arrivalSkewMax, set->arrivalSkew);
+    stats->latencyMax     = MAX(stats->latencyMax, set->latency);
+    merge->sumTimeSkew    += set->timeSkew;
+    merge->sumArrivalSkew += set->arrivalSkew;
+    merge->sumLatency     += set->latency;
+
+    EPOCHMERGE_DEBUG("set %d %.3f: %d/%d epochs, skew %.3f/%.3f, latency %.3f", set->gpsWeek, set->gpsTow,
+        set->numEpochs, merge->numSrc, set->timeSkew, set->arrivalSkew, set->latency);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+void epochMergeStats(const EPOCHMERGE_t *merge, EPOCHMERGE_STATS_t *stats)
+{
+    if ( (merge == NULL) || (stats == NULL) )
+    {
+        return;
+    }
+    *stats = merge->stats;
+    if (stats->numSets > 0)
+    {
+        stats->timeSkewMean    = merge->sumTimeSkew    / (double)stats->numSets;
+        stats->arrivalSkewMean = merge->sumArrivalSkew / (double)stats->numSets;
+        stats->latencyMean     = merge->sumLatency     / (double)stats->numSets;
+    }
+}
+
+/* ****************************************************************************************************************** */
+// eof
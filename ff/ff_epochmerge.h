@@ -0,0 +1,171 @@
+// clang-format off
+// flipflip's multi-receiver navigation epoch merging
+//
+// Copyright (c) Philippe Kehl (flipflip at oinkzwurgl dot org) and contributors
+// https://oinkzwurgl.org/projaeggd/ubloxcfg/
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+// even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program.
+// If not, see <https://www.gnu.org/licenses/>.
+
+/*!
+    \defgroup FF_EPOCHMERGE Multi-receiver epoch merging
+
+    \b Concept
+
+    - Epochs (see \ref FF_EPOCH) from several receivers (sources) are added to the merger
+    - Each source has a small queue of epochs. If it is full, the oldest epoch is dropped. The queues are allocated
+      once and can hold epochs with up to EPOCH_MAX_SIGNALS signals and EPOCH_MAX_SATELLITES satellites.
+    - Epochs are grouped by GPS time (week and time of week). Epochs of different sources within the tolerance
+      belong to the same set.
+    - A set is output when all sources have contributed to it, when all sources that have not contributed have
+      already delivered a later epoch (watermark), or when the first epoch of the set is older than the maximum
+      latency. In the latter two cases the set is incomplete.
+    - Epochs that arrive after their set was output are late and are dropped
+    - Epochs without GPS time are rejected
+    - Statistics include the difference in GPS time (time skew) and the difference in arrival time (arrival skew)
+      of the epochs in a set
+
+    \b Example
+
+    \code{.c}
+    EPOCHMERGE_t *merge = epochMergeCreate(2, 0.01, 500);
+    ...
+    if (epochCollect(&coll[0], msg0, &epoch))
+    {
+        epochMergeAdd(merge, 0, &epoch);
+    }
+    if (epochCollect(&coll[1], msg1, &epoch))
+    {
+        epochMergeAdd(merge, 1, &epoch);
+    }
+    EPOCHMERGE_SET_t set;
+    while (epochMergeGet(merge, &set))
+    {
+        ...
+    }
+    ...
+    epochMergeDestroy(merge);
+    \endcode
+
+    @{
+*/
+
+#ifndef __FF_EPOCHMERGE_H__
+#define __FF_EPOCHMERGE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ff_epoch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************************************************** */
+
+//! Epoch merger handle
+typedef struct EPOCHMERGE_s EPOCHMERGE_t;
+
+#define EPOCHMERGE_MAX_SRC    4 //!< Maximum number of sources
+#define EPOCHMERGE_QUEUE_SIZE 8 //!< Number of epochs queued per source
+
+//! Set of epochs
+typedef struct EPOCHMERGE_SET_s
+{
+    int             gpsWeek;                          //!< GPS week of the set (of the earliest epoch)
+    double          gpsTow;                           //!< GPS time of week [s] of the set (of the earliest epoch)
+    bool            complete;                         //!< All sources have an epoch in this set
+    int             numEpochs;                        //!< Number of epochs in the set
+    const EPOCH_t  *epochs[EPOCHMERGE_MAX_SRC];       //!< Epochs by source, NULL if missing (valid until the next
+                                                      //!  call to epochMergeGet())
+    double          timeSkew;                         //!< Difference of GPS time of the epochs [s]
+    double          arrivalSkew;                      //!< Difference of arrival time (EPOCH_t.ts) of the epochs [s]
+    double          latency;                          //!< Time from arrival of the first epoch to output [s]
+} EPOCHMERGE_SET_t;
+
+//! Per-source statistics
+typedef struct EPOCHMERGE_SRCSTATS_s
+{
+    uint32_t        numAdded;         //!< Number of epochs added
+    uint32_t        numMerged;        //!< Number of epochs output in sets
+    uint32_t        numRejected;      //!< Number of epochs rejected (no GPS time)
+    uint32_t        numLate;          //!< Number of epochs dropped because they were late
+    uint32_t        numOverflow;      //!< Number of epochs dropped because the queue was full
+    uint32_t        numMissing;       //!< Number of sets output without an epoch from this source
+} EPOCHMERGE_SRCSTATS_t;
+
+//! Statistics
+typedef struct EPOCHMERGE_STATS_s
+{
+    uint32_t              numSets;            //!< Number of sets output
+    uint32_t              numComplete;        //!< Number of complete sets output
+    uint32_t              numTimeout;         //!< Number of sets output due to maximum latency
+    double                timeSkewMax;        //!< Maximum time skew [s]
+    double                timeSkewMean;       //!< Mean time skew [s]
+    double                arrivalSkewMax;     //!< Maximum arrival skew [s]
+    double                arrivalSkewMean;    //!< Mean arrival skew [s]
+    double                latencyMax;         //!< Maximum latency [s]
+    double                latencyMean;        //!< Mean latency [s]
+    EPOCHMERGE_SRCSTATS_t src[EPOCHMERGE_MAX_SRC]; //!< Per-source statistics
+} EPOCHMERGE_STATS_t;
+
+//! Create epoch merger
+/*!
+    \param[in]  numSrc      Number of sources (2 ... EPOCHMERGE_MAX_SRC)
+    \param[in]  tolerance   Maximum difference in GPS time of epochs in a set [s]
+    \param[in]  maxLatency  Maximum time to wait for missing epochs [ms]
+
+    \returns the merger handle, or NULL on error
+*/
+EPOCHMERGE_t *epochMergeCreate(const int numSrc, const double tolerance, const uint32_t maxLatency);
+
+//! Destroy epoch merger
+/*!
+    \param[in]  merge  Merger handle (can be NULL)
+*/
+void epochMergeDestroy(EPOCHMERGE_t *merge);
+
+//! Add epoch
+/*!
+    \param[in]  merge   Merger handle
+    \param[in]  srcIx   Source index (0 ... numSrc - 1)
+    \param[in]  epoch   Epoch (it is copied, see epochCopy())
+
+    \returns true if the epoch was queued, false if it was rejected or late
+*/
+bool epochMergeAdd(EPOCHMERGE_t *merge, const int srcIx, const EPOCH_t *epoch);
+
+//! Get set of epochs
+/*!
+    This should be called repeatedly until it returns false, after adding epochs and also periodically (so that sets
+    with missing epochs are output after the maximum latency).
+
+    \param[in]  merge  Merger handle
+    \param[out] set    The set of epochs
+
+    \returns true if a set was output, false otherwise
+*/
+bool epochMergeGet(EPOCHMERGE_t *merge, EPOCHMERGE_SET_t *set);
+
+//! Get statistics
+/*!
+    \param[in]  merge  Merger handle
+    \param[out] stats  Statistics
+*/
+void epochMergeStats(const EPOCHMERGE_t *merge, EPOCHMERGE_STATS_t *stats);
+
+/* ****************************************************************************************************************** */
+#ifdef __cplusplus
+}
+#endif
+#endif // __FF_EPOCHMERGE_H__
+///@}
@@ -0,0 +1,501 @@
+// clang-format off
+// flipflip's navigation epoch store
+//
+// Copyright (c) Philippe Kehl (flipflip at oinkzwurgl dot org) and contributors
+// https://oinkzwurgl.org/projaeggd/ubloxcfg/
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+// even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program.
+// If not, see <https://www.gnu.org/licenses/>.
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#ifndef _WIN32
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+#include "ff_stuff.h"
+#include "ff_debug.h"
+#include "ff_time.h"
+
+#include "ff_epochstore.h"
+
+/* ****************************************************************************************************************** */
+
+//#define EPOCHSTORE_DEBUG(fmt, args...) DEBUG("epochstore: " fmt, ## args)
+#define EPOCHSTORE_DEBUG(...) /* nothing */
+
+#define EPOCHSTORE_MAGIC    "FFEPOCHS"
+#define EPOCHSTORE_VERSION  1
+#define EPOCHSTORE_HDR_SIZE 4096
+
+// File header, followed by the blocks. Each block has EPOCHSTORE_BLOCK_SIZE values of the first column, then of the
+// second column, etc.
+typedef struct EPOCHSTORE_HDR_s
+{
+    char                magic[8];
+    uint32_t            version;
+    uint32_t            blockSize;
+    uint32_t            numCols;
+    uint8_t             colSizes[32];
+    uint32_t            reserved;
+    uint64_t            numRecs;
+} EPOCHSTORE_HDR_t;
+
+STATIC_ASSERT(sizeof(EPOCHSTORE_HDR_t) <= EPOCHSTORE_HDR_SIZE);
+STATIC_ASSERT(EPOCHSTORE_NUM_COLS <= SIZEOF_MEMBER(EPOCHSTORE_HDR_t, colSizes));
+
+// Size of the values in each column
+static const uint8_t kEpochStoreCols[] =
+{
+    [EPOCHSTORE_COL_TIME]       = sizeof(double),
+    [EPOCHSTORE_COL_LAT]        = sizeof(double),
+    [EPOCHSTORE_COL_LON]        = sizeof(double),
+    [EPOCHSTORE_COL_HEIGHT]     = sizeof(double),
+    [EPOCHSTORE_COL_X]          = sizeof(double),
+    [EPOCHSTORE_COL_Y]          = sizeof(double),
+    [EPOCHSTORE_COL_Z]          = sizeof(double),
+    [EPOCHSTORE_COL_VELN]       = sizeof(float),
+    [EPOCHSTORE_COL_VELE]       = sizeof(float),
+    [EPOCHSTORE_COL_VELD]       = sizeof(float),
+    [EPOCHSTORE_COL_HACC]       = sizeof(float),
+    [EPOCHSTORE_COL_VACC]       = sizeof(float),
+    [EPOCHSTORE_COL_PACC]       = sizeof(float),
+    [EPOCHSTORE_COL_VELACC]     = sizeof(float),
+    [EPOCHSTORE_COL_PDOP]       = sizeof(float),
+    [EPOCHSTORE_COL_FIX]        = sizeof(uint8_t),
+    [EPOCHSTORE_COL_FLAGS]      = sizeof(uint8_t),
+    [EPOCHSTORE_COL_NUMSV]      = sizeof(uint8_t),
+    [EPOCHSTORE_COL_NUMSIGUSED] = sizeof(uint16_t),
+};
+
+STATIC_ASSERT(NUMOF(kEpochStoreCols) == EPOCHSTORE_NUM_COLS);
+
+struct EPOCHSTORE_s
+{
+    int                 fd;
+    bool                writable;
+    char                path[256];
+    uint8_t            *map;                            // Mapped file
+    size_t              mapSize;                        // Size of mapping (= file size)
+    EPOCHSTORE_HDR_t   *hdr;                            // Header in mapped file
+    int64_t             numRecs;                        // Number of records
+    int64_t             numBlocks;                      // Number of blocks in the file
+    size_t              blockBytes;                     // Size of a block
+    size_t              colOffs[EPOCHSTORE_NUM_COLS];   // Offset of columns in a block
+    double              lastTs;                         // Time of last record
+};
+
+/* ****************************************************************************************************************** */
+#ifndef _WIN32
+
+static void _epochStoreInitLayout(EPOCHSTORE_t *store)
+{
+    size_t offs = 0;
+    for (int col = 0; col < EPOCHSTORE_NUM_COLS; col++)
+    {
+        store->colOffs[col] = offs;
+        offs += (size_t)kEpochStoreCols[col] * EPOCHSTORE_BLOCK_SIZE;
+    }
+    store->blockBytes = offs;
+}
+
+static inline uint8_t *_epochStoreVal(const EPOCHSTORE_t *store, const int col, const int64_t ix)
+{
+    const int64_t block = ix / EPOCHSTORE_BLOCK_SIZE;
+    const int64_t pos   = ix % EPOCHSTORE_BLOCK_SIZE;
+    return &store->map[ EPOCHSTORE_HDR_SIZE + ((size_t)block * store->blockBytes) +
+        store->colOffs[col] + ((size_t)pos * kEpochStoreCols[col]) ];
+}
+
+static inline double _epochStoreTs(const EPOCHSTORE_t *store, const int64_t ix)
+{
+    double ts;
+    memcpy(&ts, _epochStoreVal(store, EPOCHSTORE_COL_TIME, ix), sizeof(ts));
+    return ts;
+}
+
+// Resize file to the given number of blocks and (re-)map it. On failure the previous mapping (if any) remains valid.
+// The file only shrinks on open (before it is mapped), so growing it leaves the previous mapping intact.
+static bool _epochStoreMap(EPOCHSTORE_t *store, const int64_t numBlocks)
+{
+    const size_t size = EPOCHSTORE_HDR_SIZE + ((size_t)numBlocks * store->blockBytes);
+    if (store->writable && (ftruncate(store->fd, (off_t)size) != 0))
+    {
+        WARNING("epochstore: %s: resize fail: %s", store->path, strerror(errno));
+        return false;
+    }
+    void *map = mmap(NULL, size, store->writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, store->fd, 0);
+    if (map == MAP_FAILED)
+    {
+        WARNING("epochstore: %s: map fail: %s", store->path, strerror(errno));
+        return false;
+    }
+    if (store->map != NULL)
+    {
+        munmap(store->map, store->mapSize);
+    }
+    store->map       = map;
+    store->mapSize   = size;
+    store->hdr       = (EPOCHSTORE_HDR_t *)map;
+    store->numBlocks = numBlocks;
+    EPOCHSTORE_DEBUG("%s: %"PRIi64" blocks, %"PRIuMAX" bytes", store->path, numBlocks, (uintmax_t)size);
+    return true;
+}
+
+static bool _epochStoreCheckHdr(const EPOCHSTORE_t *store)
+{
+    const EPOCHSTORE_HDR_t *hdr = store->hdr;
+    if ( (memcmp(hdr->magic, EPOCHSTORE_MAGIC, sizeof(hdr->magic)) != 0) || (hdr->version != EPOCHSTORE_VERSION) ||
+         (hdr->blockSize != EPOCHSTORE_BLOCK_SIZE) || (hdr->numCols != EPOCHSTORE_NUM_COLS) ||
+         (memcmp(hdr->colSizes, kEpochStoreCols, sizeof(kEpochStoreCols)) != 0) )
+    {
+        WARNING("epochstore: %s: bad header", store->path);
+        return false;
+    }
+    const int64_t numBlocks = (store->mapSize - EPOCHSTORE_HDR_SIZE) / store->blockBytes;
+    if ( (int64_t)hdr->numRecs > (numBlocks * EPOCHSTORE_BLOCK_SIZE) )
+    {
+        WARNING("epochstore: %s: truncated file", store->path);
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+EPOCHSTORE_t *epochStoreOpen(const char *path, const bool writable)
+{
+    if (path == NULL)
+    {
+        return NULL;
+    }
+    EPOCHSTORE_t *store = calloc(1, sizeof(EPOCHSTORE_t));
+    if (store == NULL)
+    {
+        WARNING("epochstore: malloc fail");
+        return NULL;
+    }
+    snprintf(store->path, sizeof(store->path), "%s", path);
+    store->writable = writable;
+    _epochStoreInitLayout(store);
+
+    store->fd = open(path, writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    struct stat st;
+    if ( (store->fd < 0) || (fstat(store->fd, &st) != 0) )
+    {
+        WARNING("epochstore: %s: open fail: %s", path, strerror(errno));
+        epochStoreClose(store);
+        return NULL;
+    }
+
+    // New file
+    if (st.st_size == 0)
+    {
+        if (!writable || !_epochStoreMap(store, 1))
+        {
+            WARNING("epochstore: %s: empty file", path);
+            epochStoreClose(store);
+            return NULL;
+        }
+        EPOCHSTORE_HDR_t *hdr = store->hdr;
+        memcpy(hdr->magic, EPOCHSTORE_MAGIC, sizeof(hdr->magic));
+        hdr->version   = EPOCHSTORE_VERSION;
+        hdr->blockSize = EPOCHSTORE_BLOCK_SIZE;
+        hdr->numCols   = EPOCHSTORE_NUM_COLS;
+        memcpy(hdr->colSizes, kEpochStoreCols, sizeof(kEpochStoreCols));
+        hdr->numRecs   = 0;
+    }
+    // Existing file
+    else
+    {
+        if ( (st.st_size < (EPOCHSTORE_HDR_SIZE + (off_t)store->blockBytes)) ||
+             (((st.st_size - EPOCHSTORE_HDR_SIZE) % store->blockBytes) != 0) )
+        {
+            WARNING("epochstore: %s: bad file size", path);
+            epochStoreClose(store);
+            return NULL;
+        }
+        if (!_epochStoreMap(store, (st.st_size - EPOCHSTORE_HDR_SIZE) / store->blockBytes) ||
+            !_epochStoreCheckHdr(store))
+        {
+            epochStoreClose(store);
+            return NULL;
+        }
+        store->numRecs = store->hdr->numRecs;
+        if (store->numRecs > 0)
+        {
+            store->lastTs = _epochStoreTs(store, store->numRecs - 1);
+        }
+    }
+
+    DEBUG("epochstore: %s: %"PRIi64" epochs (%s)", path, store->numRecs, writable ? "rw" : "ro");
+    return store;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+void epochStoreClose(EPOCHSTORE_t *store)
+{
+    if (store == NULL)
+    {
+        return;
+    }
+    if (store->map != NULL)
+    {
+        if (store->writable)
+        {
+            msync(store->map, store->mapSize, MS_SYNC);
+        }
+        munmap(store->map, store->mapSize);
+    }
+    if (store->fd >= 0)
+    {
+        close(store->fd);
+    }
+    free(store);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+#define _STORE(_col_, _type_, _val_) do { const _type_ __v = (_type_)(_val_); \
+        memcpy(_epochStoreVal(store, (_col_), ix), &__v, sizeof(__v)); } while (0)
+
+bool epochStoreAppend(EPOCHSTORE_t *store, const EPOCH_t *epoch)
+{
+    if ( (store == NULL) || !store->writable || (epoch == NULL) || !epoch->valid ||
+         !epoch->haveGpsWeek || !epoch->haveGpsTow )
+    {
+        return false;
+    }
+    const double ts = wnoTow2ts(epoch->gpsWeek, epoch->gpsTow);
+    if ( (store->numRecs > 0) && (ts < store->lastTs) )
+    {
+        WARNING("epochstore: %s: epoch out of order (%.3f < %.3f)", store->path, ts, store->lastTs);
+        return false;
+    }
+
+    const int64_t ix = store->numRecs;
+    if (ix >= (store->numBlocks * EPOCHSTORE_BLOCK_SIZE))
+    {
+        if (!_epochStoreMap(store, store->numBlocks + 1))
+        {
+            return false;
+        }
+    }
+
+    const uint8_t flags =
+        (epoch->fixOk        ? EPOCHSTORE_FLAGS_FIXOK   : 0) |
+        (epoch->havePos      ? EPOCHSTORE_FLAGS_POS     : 0) |
+        (epoch->haveVel      ? EPOCHSTORE_FLAGS_VEL     : 0) |
+        (epoch->leapSecKnown ? EPOCHSTORE_FLAGS_LEAPSEC : 0);
+
+    _STORE(EPOCHSTORE_COL_TIME,       double,   ts);
+    _STORE(EPOCHSTORE_COL_LAT,        double,   epoch->llh[0]);
+    _STORE(EPOCHSTORE_COL_LON,        double,   epoch->llh[1]);
+    _STORE(EPOCHSTORE_COL_HEIGHT,     double,   epoch->llh[2]);
+    _STORE(EPOCHSTORE_COL_X,          double,   epoch->xyz[0]);
+    _STORE(EPOCHSTORE_COL_Y,          double,   epoch->xyz[1]);
+    _STORE(EPOCHSTORE_COL_Z,          double,   epoch->xyz[2]);
+    _STORE(EPOCHSTORE_COL_VELN,       float,    epoch->velNed[0]);
+    _STORE(EPOCHSTORE_COL_VELE,       float,    epoch->velNed[1]);
+    _STORE(EPOCHSTORE_COL_VELD,       float,    epoch->velNed[2]);
+    _STORE(EPOCHSTORE_COL_HACC,       float,    epoch->horizAcc);
+    _STORE(EPOCHSTORE_COL_VACC,       float,    epoch->vertAcc);
+    _STORE(EPOCHSTORE_COL_PACC,       float,    epoch->posAcc);
+    _STORE(EPOCHSTORE_COL_VELACC,     float,    epoch->velAcc);
+    _STORE(EPOCHSTORE_COL_PDOP,       float,    epoch->pDOP);
+    _STORE(EPOCHSTORE_COL_FIX,        uint8_t,  epoch->fix);
+    _STORE(EPOCHSTORE_COL_FLAGS,      uint8_t,  flags);
+    _STORE(EPOCHSTORE_COL_NUMSV,      uint8_t,  epoch->numSv);
+    _STORE(EPOCHSTORE_COL_NUMSIGUSED, uint16_t, epoch->numSigUsed);
+
+    store->numRecs++;
+    store->hdr->numRecs = store->numRecs;
+    store->lastTs = ts;
+    return true;
+}
+
+#undef _STORE
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+bool epochStoreSync(EPOCHSTORE_t *store)
+{
+    if ( (store == NULL) || !store->writable )
+    {
+        return false;
+    }
+    if (msync(store->map, store->mapSize, MS_SYNC) != 0)
+    {
+        WARNING("epochstore: %s: sync fail: %s", store->path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+int64_t epochStoreSize(const EPOCHSTORE_t *store)
+{
+    return store != NULL ? store->numRecs : 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+#define _LOAD(_col_, _type_, _dst_) do { _type_ __v; \
+        memcpy(&__v, _epochStoreVal(store, (_col_), ix), sizeof(__v)); _dst_ = __v; } while (0)
+
+bool epochStoreGet(const EPOCHSTORE_t *store, const int64_t ix, EPOCHSTORE_REC_t *rec)
+{
+    if ( (store == NULL) || (rec == NULL) || (ix < 0) || (ix >= store->numRecs) )
+    {
+        return false;
+    }
+    memset(rec, 0, sizeof(*rec));
+    const double ts = _epochStoreTs(store, ix);
+    rec->gpsWeek = (int)(ts / (double)(7 * 86400));
+    rec->gpsTow  = ts - wnoTow2ts(rec->gpsWeek, 0.0);
+    uint8_t fix;
+    _LOAD(EPOCHSTORE_COL_LAT,        double,   rec->llh[0]);
+    _LOAD(EPOCHSTORE_COL_LON,        double,   rec->llh[1]);
+    _LOAD(EPOCHSTORE_COL_HEIGHT,     double,   rec->llh[2]);
+    _LOAD(EPOCHSTORE_COL_X,          double,   rec->xyz[0]);
+    _LOAD(EPOCHSTORE_COL_Y,          double,   rec->xyz[1]);
+    _LOAD(EPOCHSTORE_COL_Z,          double,   rec->xyz[2]);
+    _LOAD(EPOCHSTORE_COL_VELN,       float,    rec->velNed[0]);
+    _LOAD(EPOCHSTORE_COL_VELE,       float,    rec->velNed[1]);
+    _LOAD(EPOCHSTORE_COL_VELD,       float,    rec->velNed[2]);
+    _LOAD(EPOCHSTORE_COL_HACC,       float,    rec->horizAcc);
+    _LOAD(EPOCHSTORE_COL_VACC,       float,    rec->vertAcc);
+    _LOAD(EPOCHSTORE_COL_PACC,       float,    rec->posAcc);
+    _LOAD(EPOCHSTORE_COL_VELACC,     float,    rec->velAcc);
+    _LOAD(EPOCHSTORE_COL_PDOP,       float,    rec->pDOP);
+    _LOAD(EPOCHSTORE_COL_FIX,        uint8_t,  fix);
+    _LOAD(EPOCHSTORE_COL_FLAGS,      uint8_t,  rec->flags);
+    _LOAD(EPOCHSTORE_COL_NUMSV,      uint8_t,  rec->numSv);
+    _LOAD(EPOCHSTORE_COL_NUMSIGUSED, uint16_t, rec->numSigUsed);
+    rec->fix = (EPOCH_FIX_t)fix;
+    return true;
+}
+
+#undef _LOAD
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+int64_t epochStoreFind(const EPOCHSTORE_t *store, const int gpsWeek, const double gpsTow)
+{
+    if ( (store == NULL) || (store->numRecs < 1) )
+    {
+        return -1;
+    }
+    const double ts = wnoTow2ts(gpsWeek, gpsTow);
+    int64_t lo = 0;
+    int64_t hi = store->numRecs;
+    while (lo < hi)
+    {
+        const int64_t mid = lo + ((hi - lo) / 2);
+        if (_epochStoreTs(store, mid) < ts)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo < store->numRecs ? lo : -1;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+const void *epochStoreColumn(const EPOCHSTORE_t *store, const EPOCHSTORE_COL_t col, const int64_t ix, int *num)
+{
+    if ( (store == NULL) || ((int)col < 0) || (col >= EPOCHSTORE_NUM_COLS) || (ix < 0) || (ix >= store->numRecs) )
+    {
+        return NULL;
+    }
+    if (num != NULL)
+    {
+        const int64_t blockEnd = ((ix / EPOCHSTORE_BLOCK_SIZE) + 1) * EPOCHSTORE_BLOCK_SIZE;
+        *num = (int)((blockEnd < store->numRecs ? blockEnd : store->numRecs) - ix);
+    }
+    return _epochStoreVal(store, col, ix);
+}
+
+/* ****************************************************************************************************************** */
+#else // _WIN32
+
+EPOCHSTORE_t *epochStoreOpen(const char *path, const bool writable)
+{
+    (void)writable;
+    WARNING("epochstore: %s: not supported on this platform", path);
+    return NULL;
+}
+
+void epochStoreClose(EPOCHSTORE_t *store)
+{
+    (void)store;
+}
+
+bool epochStoreAppend(EPOCHSTORE_t *store, const EPOCH_t *epoch)
+{
+    (void)store;
+    (void)epoch;
+    return false;
+}
+
+bool epochStoreSync(EPOCHSTORE_t *store)
+{
+    (void)store;
+    return false;
+}
+
+int64_t epochStoreSize(const EPOCHSTORE_t *store)
+{
+    (void)store;
+    return 0;
+}
+
+bool epochStoreGet(const EPOCHSTORE_t *store, const int64_t ix, EPOCHSTORE_REC_t *rec)
+{
+    (void)store;
+    (void)ix;
+    (void)rec;
+    return false;
+}
+
+int64_t epochStoreFind(const EPOCHSTORE_t *store, const int gpsWeek, const double gpsTow)
+{
+    (void)store;
+    (void)gpsWeek;
+    (void)gpsTow;
+    return -1;
+}
+
+const void *epochStoreColumn(const EPOCHSTORE_t *store, const EPOCHSTORE_COL_t col, const int64_t ix, int *num)
+{
+    (void)store;
+    (void)col;
+    (void)ix;
+    (void)num;
+    return NULL;
+}
+
+#endif // _WIN32
+/* ****************************************************************************************************************** */
+// eof
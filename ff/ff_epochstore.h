@@ -0,0 +1,205 @@
+// clang-format off
+// flipflip's navigation epoch store
+//
+// Copyright (c) Philippe Kehl (flipflip at oinkzwurgl dot org) and contributors
+// https://oinkzwurgl.org/projaeggd/ubloxcfg/
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+// even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program.
+// If not, see <https://www.gnu.org/licenses/>.
+
+/*!
+    \defgroup FF_EPOCHSTORE Navigation epoch store
+
+    \b Concept
+
+    - Completed epochs (see \ref FF_EPOCH) are appended to a file, which is memory-mapped
+    - The data is stored in columns (one array per field, e.g. time, latitude, fix type, ...), so that analysis tools
+      can scan a single field of many epochs without touching the other data
+    - The file starts with a small header, followed by blocks of EPOCHSTORE_BLOCK_SIZE epochs. Each block contains
+      all columns for that number of epochs.
+    - Access by index is O(1). Epochs are stored in order of GPS time, so finding an epoch by time is a binary search.
+    - Only epochs with a valid GPS time (week and time of week) can be stored
+    - Not available on Windows
+
+    \b Example
+
+    \code{.c}
+    EPOCHSTORE_t *store = epochStoreOpen("epochs.bin", true);
+    ...
+    if (epochCollect(&coll, msg, &epoch))
+    {
+        epochStoreAppend(store, &epoch);
+    }
+    ...
+    epochStoreClose(store);
+
+    store = epochStoreOpen("epochs.bin", false);
+    const int64_t ix = epochStoreFind(store, 2250, 345600.0);
+    EPOCHSTORE_REC_t rec;
+    if ( (ix >= 0) && epochStoreGet(store, ix, &rec) )
+    {
+        ...
+    }
+    \endcode
+
+    @{
+*/
+
+#ifndef __FF_EPOCHSTORE_H__
+#define __FF_EPOCHSTORE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ff_epoch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************************************************** */
+
+//! Epoch store handle
+typedef struct EPOCHSTORE_s EPOCHSTORE_t;
+
+//! Number of epochs per block in the file
+#define EPOCHSTORE_BLOCK_SIZE 4096
+
+//! Columns
+typedef enum EPOCHSTORE_COL_e
+{
+    EPOCHSTORE_COL_TIME = 0,   //!< GPS time [s] since GPS epoch (double)
+    EPOCHSTORE_COL_LAT,        //!< Latitude [rad] (double)
+    EPOCHSTORE_COL_LON,        //!< Longitude [rad] (double)
+    EPOCHSTORE_COL_HEIGHT,     //!< Height [m] (double)
+    EPOCHSTORE_COL_X,          //!< ECEF X [m] (double)
+    EPOCHSTORE_COL_Y,          //!< ECEF Y [m] (double)
+    EPOCHSTORE_COL_Z,          //!< ECEF Z [m] (double)
+    EPOCHSTORE_COL_VELN,       //!< Velocity north [m/s] (float)
+    EPOCHSTORE_COL_VELE,       //!< Velocity east [m/s] (float)
+    EPOCHSTORE_COL_VELD,       //!< Velocity down [m/s] (float)
+    EPOCHSTORE_COL_HACC,       //!< Horizontal accuracy estimate [m] (float)
+    EPOCHSTORE_COL_VACC,       //!< Vertical accuracy estimate [m] (float)
+    EPOCHSTORE_COL_PACC,       //!< Position accuracy estimate [m] (float)
+    EPOCHSTORE_COL_VELACC,     //!< Velocity accuracy estimate [m/s] (float)
+    EPOCHSTORE_COL_PDOP,       //!< Position DOP (float)
+    EPOCHSTORE_COL_FIX,        //!< Fix type (EPOCH_FIX_t, uint8_t)
+    EPOCHSTORE_COL_FLAGS,      //!< Flags (EPOCHSTORE_FLAGS_..., uint8_t)
+    EPOCHSTORE_COL_NUMSV,      //!< Number of satellites used (uint8_t)
+    EPOCHSTORE_COL_NUMSIGUSED, //!< Number of signals used (uint16_t)
+    // Keep in sync with kEpochStoreCols!
+    EPOCHSTORE_NUM_COLS
+} EPOCHSTORE_COL_t;
+
+#define EPOCHSTORE_FLAGS_FIXOK   0x01 //!< Fix is OK (EPOCH_t.fixOk)
+#define EPOCHSTORE_FLAGS_POS     0x02 //!< Position is valid (EPOCH_t.havePos)
+#define EPOCHSTORE_FLAGS_VEL     0x04 //!< Velocity is valid (EPOCH_t.haveVel)
+#define EPOCHSTORE_FLAGS_LEAPSEC 0x08 //!< Leap seconds are known (EPOCH_t.leapSecKnown)
+
+//! One epoch record
+typedef struct EPOCHSTORE_REC_s
+{
+    int         gpsWeek;     //!< GPS week number
+    double      gpsTow;      //!< GPS time of week [s]
+    double      llh[3];      //!< Latitude [rad], longitude [rad], height [m]
+    double      xyz[3];      //!< ECEF position [m]
+    float       velNed[3];   //!< Velocity north, east, down [m/s]
+    float       horizAcc;    //!< Horizontal accuracy estimate [m]
+    float       vertAcc;     //!< Vertical accuracy estimate [m]
+    float       posAcc;      //!< Position accuracy estimate [m]
+    float       velAcc;      //!< Velocity accuracy estimate [m/s]
+    float       pDOP;        //!< Position DOP
+    EPOCH_FIX_t fix;         //!< Fix type
+    uint8_t     flags;       //!< Flags (EPOCHSTORE_FLAGS_...)
+    int         numSv;       //!< Number of satellites used
+    int         numSigUsed;  //!< Number of signals used
+} EPOCHSTORE_REC_t;
+
+//! Open epoch store
+/*!
+    \param[in]  path      Path of the file
+    \param[in]  writable  Open for appending epochs (the file is created if it does not exist), otherwise read-only
+
+    \returns the store handle, or NULL on error
+*/
+EPOCHSTORE_t *epochStoreOpen(const char *path, const bool writable);
+
+//! Close epoch store
+/*!
+    \param[in]  store  Store handle (can be NULL)
+*/
+void epochStoreClose(EPOCHSTORE_t *store);
+
+//! Append epoch
+/*!
+    \param[in]  store  Store handle (opened writable)
+    \param[in]  epoch  Epoch, must have GPS week and time of week, and must not be older than the last stored epoch
+
+    \returns true if the epoch was stored, false otherwise
+*/
+bool epochStoreAppend(EPOCHSTORE_t *store, const EPOCH_t *epoch);
+
+//! Flush stored epochs to disk
+/*!
+    \param[in]  store  Store handle
+
+    \returns true on success, false otherwise
+*/
+bool epochStoreSync(EPOCHSTORE_t *store);
+
+//! Get number of stored epochs
+/*!
+    \param[in]  store  Store handle
+
+    \returns the number of stored epochs
+*/
+int64_t epochStoreSize(const EPOCHSTORE_t *store);
+
+//! Get epoch record
+/*!
+    \param[in]  store  Store handle
+    \param[in]  ix     Index (0 ... epochStoreSize() - 1)
+    \param[out] rec    Epoch record
+
+    \returns true if \c rec is valid, false otherwise (invalid index)
+*/
+bool epochStoreGet(const EPOCHSTORE_t *store, const int64_t ix, EPOCHSTORE_REC_t *rec);
+
+//! Find epoch by GPS time
+/*!
+    \param[in]  store    Store handle
+    \param[in]  gpsWeek  GPS week number
+    \param[in]  gpsTow   GPS time of week [s]
+
+    \returns the index of the first epoch at or after the given time, or -1 if there is no such epoch
+*/
+int64_t epochStoreFind(const EPOCHSTORE_t *store, const int gpsWeek, const double gpsTow);
+
+//! Get column data
+/*!
+    Columns are stored in blocks of EPOCHSTORE_BLOCK_SIZE epochs. This returns the data of one column from the given
+    index up to the end of the block (or the last epoch).
+
+    \param[in]  store  Store handle
+    \param[in]  col    Column
+    \param[in]  ix     Index (0 ... epochStoreSize() - 1)
+    \param[out] num    Number of values available at the returned pointer
+
+    \returns a pointer to the column data (type as documented in EPOCHSTORE_COL_t), or NULL for invalid parameters
+*/
+const void *epochStoreColumn(const EPOCHSTORE_t *store, const EPOCHSTORE_COL_t col, const int64_t ix, int *num);
+
+/* ****************************************************************************************************************** */
+#ifdef __cplusplus
+}
+#endif
+#endif // __FF_EPOCHSTORE_H__
+///@}
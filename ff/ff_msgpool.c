@@ -0,0 +1,346 @@
+// clang-format off
+// flipflip's message pool
+//
+// Copyright (c) Philippe Kehl (flipflip at oinkzwurgl dot org) and contributors
+// https://oinkzwurgl.org/projaeggd/ubloxcfg/
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+// even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program.
+// If not, see <https://www.gnu.org/licenses/>.
+
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#ifndef _WIN32
+#  include <sched.h>
+#endif
+#ifdef _WIN32
+#  define NOGDI
+#  include <windows.h>
+#endif
+
+#include "ff_stuff.h"
+#include "ff_debug.h"
+
+#include "ff_msgpool.h"
+
+/* ****************************************************************************************************************** */
+
+//#define MSGPOOL_DEBUG(fmt, args...) DEBUG("msgpool: " fmt, ## args)
+#define MSGPOOL_DEBUG(...) /* nothing */
+
+// Block size classes (message data, name and info), the last one fits any message
+static const uint32_t kMsgPoolClasses[MSGPOOL_NUM_CLASSES] =
+{
+    256, 1024, 4096, PARSER_MAX_ANY_SIZE + PARSER_MAX_NAME_SIZE + PARSER_MAX_INFO_SIZE
+};
+
+typedef struct MSGPOOL_BLOCK_s
+{
+    MSGPOOL_t              *pool;
+    struct MSGPOOL_BLOCK_s *next;      // Next free block
+    uint32_t                refs;      // Number of references, 0 = free
+    int                     cls;       // Size class
+    PARSER_MSG_t            msg;       // The message, pointing to buf[]
+    uint8_t                 buf[];     // Message data, name and info
+} MSGPOOL_BLOCK_t;
+
+typedef struct MSGPOOL_SLAB_s
+{
+    struct MSGPOOL_SLAB_s  *next;
+    uint64_t                pad;       // Keep the blocks aligned
+} MSGPOOL_SLAB_t;
+
+struct MSGPOOL_s
+{
+    MSGPOOL_BLOCK_t        *free[MSGPOOL_NUM_CLASSES];  // Free blocks, by class
+    uint32_t                numFree[MSGPOOL_NUM_CLASSES];
+    uint32_t                numUsed[MSGPOOL_NUM_CLASSES];
+    MSGPOOL_SLAB_t         *slabs;
+    uint32_t                numSlabs;  // Including the ones being allocated
+    uint32_t                maxSize;
+    uint64_t                numCopies;
+    uint64_t                numFails;
+    bool                    lock;      // Protects all of the above
+};
+
+// The critical sections are a few instructions only (slabs are allocated outside), so a spinlock is good enough, and
+// cheaper than a mutex. Give up the CPU if the lock holder was preempted (or runs on the same CPU).
+static void _msgPoolLock(MSGPOOL_t *pool)
+{
+    int spins = 0;
+    while (__atomic_test_and_set(&pool->lock, __ATOMIC_ACQUIRE))
+    {
+        while (__atomic_load_n(&pool->lock, __ATOMIC_RELAXED))
+        {
+            spins++;
+            if (spins > 100)
+            {
+#ifndef _WIN32
+                sched_yield();
+#else
+                Sleep(0);
+#endif
+                spins = 0;
+            }
+        }
+    }
+}
+
+static void _msgPoolUnlock(MSGPOOL_t *pool)
+{
+    __atomic_clear(&pool->lock, __ATOMIC_RELEASE);
+}
+
+// Size of a block of a class, a multiple of the alignment of the block header
+static uint32_t _msgPoolBlockSize(const int cls)
+{
+    const uint32_t align = sizeof(uint64_t);
+    return (((uint32_t)sizeof(MSGPOOL_BLOCK_t) + kMsgPoolClasses[cls] + align - 1) / align) * align;
+}
+
+STATIC_ASSERT((sizeof(MSGPOOL_SLAB_t) % sizeof(uint64_t)) == 0);
+STATIC_ASSERT(MSGPOOL_SLAB_SIZE >= (2 * (PARSER_MAX_ANY_SIZE + PARSER_MAX_NAME_SIZE + PARSER_MAX_INFO_SIZE)));
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+MSGPOOL_t *msgPoolCreate(const uint32_t maxSize)
+{
+    MSGPOOL_t *pool = calloc(1, sizeof(MSGPOOL_t));
+    if (pool == NULL)
+    {
+        WARNING("msgpool: malloc fail");
+        return NULL;
+    }
+    pool->maxSize = maxSize;
+    return pool;
+}
+
+void msgPoolDestroy(MSGPOOL_t *pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+    uint32_t numUsed = 0;
+    for (int cls = 0; cls < MSGPOOL_NUM_CLASSES; cls++)
+    {
+        numUsed += pool->numUsed[cls];
+    }
+    if (numUsed > 0)
+    {
+        WARNING("msgpool: %u messages still in use!", numUsed);
+    }
+    while (pool->slabs != NULL)
+    {
+        MSGPOOL_SLAB_t *slab = pool->slabs;
+        pool->slabs = slab->next;
+        free(slab);
+    }
+    free(pool);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Allocate a slab and split it into blocks of a class, linked into a list (pool not locked)
+static MSGPOOL_SLAB_t *_msgPoolNewSlab(MSGPOOL_t *pool, const int cls, MSGPOOL_BLOCK_t **first,
+    MSGPOOL_BLOCK_t **last, uint32_t *numBlocks)
+{
+    MSGPOOL_SLAB_t *slab = malloc(MSGPOOL_SLAB_SIZE);
+    if (slab == NULL)
+    {
+        WARNING("msgpool: malloc fail");
+        return NULL;
+    }
+    slab->next = NULL;
+
+    const uint32_t blockSize = _msgPoolBlockSize(cls);
+    *numBlocks = (MSGPOOL_SLAB_SIZE - sizeof(MSGPOOL_SLAB_t)) / blockSize;
+    uint8_t *blocks = (uint8_t *)slab + sizeof(MSGPOOL_SLAB_t);
+    *first = NULL;
+    *last = (MSGPOOL_BLOCK_t *)&blocks[0];
+    for (uint32_t ix = 0; ix < *numBlocks; ix++)
+    {
+        MSGPOOL_BLOCK_t *block = (MSGPOOL_BLOCK_t *)&blocks[ix * blockSize];
+        block->pool = pool;
+        block->cls  = cls;
+        block->refs = 0;
+        block->next = *first;
+        *first = block;
+    }
+    MSGPOOL_DEBUG("new slab: class %d (%u), %u blocks of %u bytes", cls, kMsgPoolClasses[cls], *numBlocks, blockSize);
+    return slab;
+}
+
+// Take a free block of a class (pool locked)
+static MSGPOOL_BLOCK_t *_msgPoolTake(MSGPOOL_t *pool, const int cls)
+{
+    MSGPOOL_BLOCK_t *block = pool->free[cls];
+    if (block != NULL)
+    {
+        pool->free[cls] = block->next;
+        pool->numFree[cls]--;
+        pool->numUsed[cls]++;
+        pool->numCopies++;
+    }
+    return block;
+}
+
+PARSER_MSG_t *msgPoolCopy(MSGPOOL_t *pool, const PARSER_MSG_t *msg)
+{
+    if ( (pool == NULL) || (msg == NULL) || (msg->data == NULL) || (msg->size < 0) )
+    {
+        return NULL;
+    }
+    const uint32_t nameSize = (msg->name != NULL ? strlen(msg->name) + 1 : 0);
+    const uint32_t infoSize = (msg->info != NULL ? strlen(msg->info) + 1 : 0);
+    const uint32_t size = (uint32_t)msg->size + nameSize + infoSize;
+    int cls = 0;
+    while ( (cls < MSGPOOL_NUM_CLASSES) && (size > kMsgPoolClasses[cls]) )
+    {
+        cls++;
+    }
+    if (cls >= MSGPOOL_NUM_CLASSES)
+    {
+        return NULL;
+    }
+
+    // Take a free block, or reserve a new slab (counting it now keeps concurrent callers within maxSize)
+    _msgPoolLock(pool);
+    MSGPOOL_BLOCK_t *block = _msgPoolTake(pool, cls);
+    bool addSlab = false;
+    if (block == NULL)
+    {
+        if ( (pool->maxSize == 0) || (((pool->numSlabs + 1) * MSGPOOL_SLAB_SIZE) <= pool->maxSize) )
+        {
+            pool->numSlabs++;
+            addSlab = true;
+        }
+        else
+        {
+            pool->numFails++;
+        }
+    }
+    _msgPoolUnlock(pool);
+
+    // Allocate and split the slab without holding the lock, then add it and take a block (which may as well be one
+    // that was released meanwhile)
+    if (addSlab)
+    {
+        MSGPOOL_BLOCK_t *first = NULL;
+        MSGPOOL_BLOCK_t *last = NULL;
+        uint32_t numBlocks = 0;
+        MSGPOOL_SLAB_t *slab = _msgPoolNewSlab(pool, cls, &first, &last, &numBlocks);
+        _msgPoolLock(pool);
+        if (slab != NULL)
+        {
+            slab->next = pool->slabs;
+            pool->slabs = slab;
+            last->next = pool->free[cls];
+            pool->free[cls] = first;
+            pool->numFree[cls] += numBlocks;
+            block = _msgPoolTake(pool, cls);
+        }
+        else
+        {
+            pool->numSlabs--;
+            pool->numFails++;
+        }
+        _msgPoolUnlock(pool);
+    }
+    if (block == NULL)
+    {
+        return NULL;
+    }
+
+    block->next = NULL;
+    block->refs = 1;
+    block->msg  = *msg;
+    memcpy(block->buf, msg->data, msg->size);
+    block->msg.data = block->buf;
+    if (nameSize > 0)
+    {
+        char *name = (char *)&block->buf[msg->size];
+        memcpy(name, msg->name, nameSize);
+        block->msg.name = name;
+    }
+    if (infoSize > 0)
+    {
+        char *info = (char *)&block->buf[msg->size + nameSize];
+        memcpy(info, msg->info, infoSize);
+        block->msg.info = info;
+    }
+    return &block->msg;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static MSGPOOL_BLOCK_t *_msgPoolBlock(PARSER_MSG_t *msg)
+{
+    return (MSGPOOL_BLOCK_t *)((uint8_t *)msg - offsetof(MSGPOOL_BLOCK_t, msg));
+}
+
+PARSER_MSG_t *msgPoolRetain(PARSER_MSG_t *msg)
+{
+    if (msg != NULL)
+    {
+        __atomic_add_fetch(&_msgPoolBlock(msg)->refs, 1, __ATOMIC_RELAXED);
+    }
+    return msg;
+}
+
+void msgPoolRelease(PARSER_MSG_t *msg)
+{
+    if (msg == NULL)
+    {
+        return;
+    }
+    MSGPOOL_BLOCK_t *block = _msgPoolBlock(msg);
+    if (__atomic_sub_fetch(&block->refs, 1, __ATOMIC_ACQ_REL) != 0)
+    {
+        return;
+    }
+    MSGPOOL_t *pool = block->pool;
+    _msgPoolLock(pool);
+    block->next = pool->free[block->cls];
+    pool->free[block->cls] = block;
+    pool->numFree[block->cls]++;
+    pool->numUsed[block->cls]--;
+    _msgPoolUnlock(pool);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+bool msgPoolGetStats(MSGPOOL_t *pool, MSGPOOL_STATS_t *stats)
+{
+    if ( (pool == NULL) || (stats == NULL) )
+    {
+        return false;
+    }
+    memset(stats, 0, sizeof(*stats));
+    _msgPoolLock(pool);
+    stats->numSlabs  = pool->numSlabs;
+    stats->size      = pool->numSlabs * MSGPOOL_SLAB_SIZE;
+    stats->numCopies = pool->numCopies;
+    stats->numFails  = pool->numFails;
+    for (int cls = 0; cls < MSGPOOL_NUM_CLASSES; cls++)
+    {
+        stats->classSize[cls] = kMsgPoolClasses[cls];
+        stats->classUsed[cls] = pool->numUsed[cls];
+        stats->classFree[cls] = pool->numFree[cls];
+        stats->numUsed += pool->numUsed[cls];
+        stats->numFree += pool->numFree[cls];
+    }
+    _msgPoolUnlock(pool);
+    return true;
+}
+
+/* ****************************************************************************************************************** */
+// eof
@@ -0,0 +1,140 @@
+// clang-format off
+// flipflip's message pool
+//
+// Copyright (c) Philippe Kehl (flipflip at oinkzwurgl dot org) and contributors
+// https://oinkzwurgl.org/projaeggd/ubloxcfg/
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+// even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program.
+// If not, see <https://www.gnu.org/licenses/>.
+
+/*!
+    \defgroup FF_MSGPOOL Message pool
+
+    \b Concept
+
+    - The messages from the parser (see \ref FF_PARSER) resp. rxGetNextMessage() are only valid until the next call.
+      msgPoolCopy() copies a message (data, name and info) into the pool, where it stays valid until it is released.
+    - Messages are reference counted: msgPoolRetain() adds a reference, msgPoolRelease() drops one. The message goes
+      back to the pool when the last reference is dropped. Messages can be released in another thread than they were
+      copied in, e.g. after passing them to a worker thread.
+    - The memory is allocated in slabs of MSGPOOL_SLAB_SIZE bytes, which are split into blocks of a fixed size class
+      (small for NMEA and most UBX-NAV messages, medium, large for UBX-RXM-RAWX and the like, and one for the largest
+      possible message). Blocks are recycled, the slabs are only freed by msgPoolDestroy(). Once the pool has grown to
+      the working set, copying messages does not allocate memory anymore.
+
+    \b Example
+
+    \code{.c}
+    MSGPOOL_t *pool = msgPoolCreate(0);
+    ...
+    PARSER_MSG_t *msg = rxGetNextMessage(rx);
+    PARSER_MSG_t *copy = (msg != NULL ? msgPoolCopy(pool, msg) : NULL);
+    if (copy != NULL)
+    {
+        queuePush(workerQueue, copy); // The worker calls msgPoolRelease() when done
+    }
+    ...
+    msgPoolDestroy(pool);
+    \endcode
+
+    @{
+*/
+
+#ifndef __FF_MSGPOOL_H__
+#define __FF_MSGPOOL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ff_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************************************************** */
+
+//! Message pool handle
+typedef struct MSGPOOL_s MSGPOOL_t;
+
+#define MSGPOOL_SLAB_SIZE   (64 * 1024) //!< Size of the slabs [bytes]
+#define MSGPOOL_NUM_CLASSES 4           //!< Number of block size classes
+
+//! Pool statistics
+typedef struct MSGPOOL_STATS_s
+{
+    uint32_t size;                             //!< Memory allocated for slabs [bytes]
+    uint32_t numSlabs;                         //!< Number of slabs
+    uint32_t numUsed;                          //!< Number of messages in use (not released)
+    uint32_t numFree;                          //!< Number of free blocks
+    uint64_t numCopies;                        //!< Number of messages copied into the pool
+    uint64_t numFails;                         //!< Number of failed copies (pool full, see msgPoolCreate())
+    uint32_t classSize[MSGPOOL_NUM_CLASSES];   //!< Block size class (maximum message data, name and info size) [bytes]
+    uint32_t classUsed[MSGPOOL_NUM_CLASSES];   //!< Number of messages in use per class
+    uint32_t classFree[MSGPOOL_NUM_CLASSES];   //!< Number of free blocks per class
+} MSGPOOL_STATS_t;
+
+//! Create message pool
+/*!
+    \param[in]  maxSize  Maximum memory for the slabs [bytes], 0 for no limit
+
+    \returns the pool handle, or NULL on error
+*/
+MSGPOOL_t *msgPoolCreate(const uint32_t maxSize);
+
+//! Destroy message pool
+/*!
+    All messages must have been released. Messages still in use are freed anyway (and a warning is printed).
+
+    \param[in]  pool  Pool handle (can be NULL)
+*/
+void msgPoolDestroy(MSGPOOL_t *pool);
+
+//! Copy message into the pool
+/*!
+    \param[in]  pool  Pool handle
+    \param[in]  msg   The message to copy (data, name and info are copied)
+
+    \returns a copy of the message, with one reference, or NULL if the pool is full (see msgPoolCreate())
+*/
+PARSER_MSG_t *msgPoolCopy(MSGPOOL_t *pool, const PARSER_MSG_t *msg);
+
+//! Add a reference to a message
+/*!
+    \param[in]  msg  Message from msgPoolCopy()
+
+    \returns the message
+*/
+PARSER_MSG_t *msgPoolRetain(PARSER_MSG_t *msg);
+
+//! Drop a reference to a message
+/*!
+    The message goes back to the pool when the last reference is dropped. It must not be used after that.
+
+    \param[in]  msg  Message from msgPoolCopy() (can be NULL)
+*/
+void msgPoolRelease(PARSER_MSG_t *msg);
+
+//! Get pool statistics
+/*!
+    \param[in]  pool   Pool handle
+    \param[out] stats  Statistics
+
+    \returns true on success, false otherwise (bad parameters)
+*/
+bool msgPoolGetStats(MSGPOOL_t *pool, MSGPOOL_STATS_t *stats);
+
+/* ****************************************************************************************************************** */
+#ifdef __cplusplus
+}
+#endif
+#endif // __FF_MSGPOOL_H__
+///@}
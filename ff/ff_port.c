@@ -15,6 +15,8 @@
 // You should have received a copy of the GNU General Public License along with this program.
 // If not, see <https://www.gnu.org/licenses/>.
 
+#define _GNU_SOURCE // posix_openpt() and friends
+
 #include <string.h>
 #include <stddef.h>
 #include <stdlib.h>
@@ -26,6 +28,8 @@
 #include <fcntl.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <inttypes.h>
+#include <time.h>
 #include <sys/file.h>
 #include <sys/types.h>
 
@@ -38,9 +42,44 @@
 #  include <netdb.h>
 #  include <sys/socket.h>
 #  include <sys/ioctl.h>
+#  include <poll.h>
 #  include <termios.h>
 #  include <netinet/in.h>
 #  include <netinet/tcp.h>
+#  include <sys/un.h>
+#  include <sys/stat.h>
+#endif
+#ifdef __linux__
+#  include <linux/serial.h>
+#endif
+
+// Linux termios2 for arbitrary baudrates. We cannot include <asm/termbits.h> along with <termios.h>, so we define
+// what we need here. The layout is the same on most architectures (but not on, e.g., PowerPC, MIPS or SPARC).
+#if defined(__linux__) && ( defined(__x86_64__) || defined(__i386__) || defined(__aarch64__) || defined(__arm__) || defined(__riscv) )
+#  define PORT_HAVE_TERMIOS2 1
+struct termios2
+{
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t     c_line;
+    cc_t     c_cc[19];
+    speed_t  c_ispeed;
+    speed_t  c_ospeed;
+};
+#  ifndef BOTHER
+#    define BOTHER 0010000
+#  endif
+#  ifndef IBSHIFT
+#    define IBSHIFT 16
+#  endif
+#  ifndef TCGETS2
+#    define TCGETS2 _IOR('T', 0x2A, struct termios2)
+#    define TCSETS2 _IOW('T', 0x2B, struct termios2)
+#  endif
+#else
+#  define PORT_HAVE_TERMIOS2 0
 #endif
 
 #include "ff_debug.h"
@@ -66,6 +105,8 @@
     WARNING("port(%s) " fmt, portSpecStr(port), __VA_ARGS__); \
     port->lastWarn = now; } } while (false);
 
+#define TCPIP_MAX_PACKET_SIZE 256
+
 static const char *portSpecStr(PORT_t *port)
 {
     if (port == NULL)
@@ -76,7 +117,8 @@ static const char *portSpecStr(PORT_t *port)
     switch (port->type)
     {
         case PORT_TYPE_SER:
-            snprintf(port->tmp, sizeof(port->tmp), "ser://%s@%d", port->file, port->baudrate);
+            snprintf(port->tmp, sizeof(port->tmp), "ser://%s@%d%s", port->file, port->baudrate,
+                port->lowLatency ? "?lowlat" : "");
             break;
         case PORT_TYPE_TCP:
             snprintf(port->tmp, sizeof(port->tmp), "tcp://%s:%u", port->file, port->port);
@@ -84,6 +126,28 @@ static const char *portSpecStr(PORT_t *port)
         case PORT_TYPE_TELNET:
             snprintf(port->tmp, sizeof(port->tmp), "telnet://%s:%u@%d", port->file, port->port, port->baudrate);
             break;
+        case PORT_TYPE_FILE:
+            if (port->baudrate > 0)
+            {
+                snprintf(port->tmp, sizeof(port->tmp), "file://%s@%d", port->file, port->baudrate);
+            }
+            else
+            {
+                snprintf(port->tmp, sizeof(port->tmp), "file://%s", port->file);
+            }
+            break;
+        case PORT_TYPE_FD:
+            snprintf(port->tmp, sizeof(port->tmp), "fd://%s", port->file);
+            break;
+        case PORT_TYPE_UNIX:
+            snprintf(port->tmp, sizeof(port->tmp), "unix://%s", port->file);
+            break;
+        case PORT_TYPE_PTY:
+            snprintf(port->tmp, sizeof(port->tmp), "pty://%s", port->file);
+            break;
+        case PORT_TYPE_TCPSRV:
+            snprintf(port->tmp, sizeof(port->tmp), "tcpsrv://%s:%u", port->file, port->port);
+            break;
     }
     return port->tmp;
 }
@@ -112,6 +176,7 @@ const char *_portErrStr(PORT_t *port, int err)
 // ---------------------------------------------------------------------------------------------------------------------
 
 static uint32_t _portBaudrateValue(const int baudrate);
+static bool _portBaudrateOk(const PORT_TYPE_t type, const int baudrate);
 
 bool portInit(PORT_t *port, const char *spec)
 {
@@ -153,6 +218,28 @@ bool portInit(PORT_t *port, const char *spec)
         {
             port->type = PORT_TYPE_TELNET;
         }
+#ifndef _WIN32
+        else if (strcmp(type, "file") == 0)
+        {
+            port->type = PORT_TYPE_FILE;
+        }
+        else if (strcmp(type, "fd") == 0)
+        {
+            port->type = PORT_TYPE_FD;
+        }
+        else if (strcmp(type, "unix") == 0)
+        {
+            port->type = PORT_TYPE_UNIX;
+        }
+        else if (strcmp(type, "pty") == 0)
+        {
+            port->type = PORT_TYPE_PTY;
+        }
+        else if (strcmp(type, "tcpsrv") == 0)
+        {
+            port->type = PORT_TYPE_TCPSRV;
+        }
+#endif
         else
         {
             WARNING("%s: Bad port type %s!", spec, type);
@@ -167,6 +254,25 @@ bool portInit(PORT_t *port, const char *spec)
         {
             case PORT_TYPE_SER:
             {
+                // Options
+                char *opts = strchr(addr, '?');
+                if (opts != NULL)
+                {
+                    *opts = '\0';
+                    opts++;
+                    for (char *opt = strtok(opts, ","); opt != NULL; opt = strtok(NULL, ","))
+                    {
+                        if (strcmp(opt, "lowlat") == 0)
+                        {
+                            port->lowLatency = true;
+                        }
+                        else
+                        {
+                            WARNING("%s: Bad option %s!", spec, opt);
+                            res = false;
+                        }
+                    }
+                }
                 addr = strtok(addr, "@");
                 char *arg = strtok(NULL, "@");
 #ifdef _WIN32
@@ -177,7 +283,7 @@ bool portInit(PORT_t *port, const char *spec)
                 free(real);
 #endif
                 const int baudrate = arg != NULL ? atoi(arg) : (isAcm ? 921600 : 9600);
-                if (_portBaudrateValue(baudrate) == 0)
+                if (!_portBaudrateOk(port->type, baudrate))
                 {
                     WARNING("%s: Bad baudrate %s!", spec, arg);
                     res = false;
@@ -224,7 +330,7 @@ bool portInit(PORT_t *port, const char *spec)
                 }
                 arg = strtok(NULL, "@");
                 const int baudrate = arg != NULL ? atoi(arg) : 9600;
-                if (_portBaudrateValue(baudrate) == 0)
+                if (!_portBaudrateOk(port->type, baudrate))
                 {
                     WARNING("%s: Bad baudrate %s!", spec, arg);
                     res = false;
@@ -235,6 +341,68 @@ bool portInit(PORT_t *port, const char *spec)
                 }
                 break;
             }
+            case PORT_TYPE_FILE:
+            {
+                addr = strtok(addr, "@");
+                char *arg = strtok(NULL, "@");
+                const int baudrate = arg != NULL ? atoi(arg) : 0;
+                if ( (addr == NULL) || ((arg != NULL) && (baudrate <= 0)) )
+                {
+                    WARNING("%s: Missing file or bad baudrate!", spec);
+                    res = false;
+                }
+                else
+                {
+                    strcat(port->file, addr);
+                    port->baudrate = baudrate;
+                }
+                break;
+            }
+            case PORT_TYPE_FD:
+            {
+                char *end = NULL;
+                const long fd = strtol(addr, &end, 10);
+                if ( (strcmp(addr, "-") != 0) && ((end == addr) || (*end != '\0') || (fd < 0) || (fd > INT_MAX)) )
+                {
+                    WARNING("%s: Bad file descriptor!", spec);
+                    res = false;
+                }
+                else
+                {
+                    strcat(port->file, addr);
+                }
+                break;
+            }
+            case PORT_TYPE_TCPSRV:
+            {
+                // Address is optional
+                char *colon = strrchr(addr, ':');
+                const int portnr = colon == NULL ? -1 : atoi(&colon[1]);
+                if ( (portnr < 1) || (portnr > UINT16_MAX))
+                {
+                    WARNING("%s: Missing or bad port number!", spec);
+                    res = false;
+                }
+                else
+                {
+                    *colon = '\0';
+                    port->port = (uint16_t)portnr;
+                    strcat(port->file, addr);
+                }
+                break;
+            }
+            case PORT_TYPE_UNIX:
+            case PORT_TYPE_PTY:
+                if (addr[0] == '\0')
+                {
+                    WARNING("%s: Missing path!", spec);
+                    res = false;
+                }
+                else
+                {
+                    strcat(port->file, addr);
+                }
+                break;
         }
     }
 
@@ -246,9 +414,15 @@ bool portInit(PORT_t *port, const char *spec)
     return res;
 }
 
+static bool _portTxEnqueue(PORT_t *port, const uint8_t *data, const int size);
+
 static bool _portOpenSer(PORT_t *port);
 static bool _portOpenTcp(PORT_t *port);
 static bool _portOpenTelnet(PORT_t *port);
+static bool _portOpenFd(PORT_t *port);
+static bool _portOpenTcpsrv(PORT_t *port);
+static bool _portGetIcount(PORT_t *port, uint32_t counts[5]);
+static bool _portOpenDone(PORT_t *port, bool res);
 
 bool portOpen(PORT_t *port)
 {
@@ -266,6 +440,36 @@ bool portOpen(PORT_t *port)
             case PORT_TYPE_TELNET:
                 res = _portOpenTelnet(port);
                 break;
+            case PORT_TYPE_FILE:
+            case PORT_TYPE_FD:
+            case PORT_TYPE_UNIX:
+            case PORT_TYPE_PTY:
+                res = _portOpenFd(port);
+                break;
+            case PORT_TYPE_TCPSRV:
+                res = _portOpenTcpsrv(port);
+                break;
+        }
+    }
+    return _portOpenDone(port, res);
+}
+
+// Setup after the port has been opened (successfully or not)
+static bool _portOpenDone(PORT_t *port, bool res)
+{
+    // Transmit queue
+    if (res && (port->txSize > 0))
+    {
+        port->txBuf = malloc(port->txSize);
+        port->txOffs = 0;
+        port->txLen = 0;
+        port->txNextTime = 0;
+        if (port->txBuf == NULL)
+        {
+            PORT_WARNING("malloc fail");
+            port->portOk = true;
+            portClose(port);
+            res = false;
         }
     }
 
@@ -273,6 +477,18 @@ bool portOpen(PORT_t *port)
     if (res)
     {
         port->portOk = true;
+        port->stats.numOpens++;
+        if (port->stats.numOpens == 1)
+        {
+            port->statsTime = TIME();
+        }
+        port->readableTime = 0;
+        port->hangup = false;
+        port->eof = false;
+        if (!_portGetIcount(port, port->icountBase))
+        {
+            memset(port->icountBase, 0, sizeof(port->icountBase));
+        }
         PORT_DEBUG("connected");
     }
     return res;
@@ -280,14 +496,63 @@ bool portOpen(PORT_t *port)
 
 // ---------------------------------------------------------------------------------------------------------------------
 
+static bool _portTcpConnectStart(PORT_t *port);
+static PORT_OPEN_t _portTcpConnectCheck(PORT_t *port, const uint32_t timeout);
+static bool _portTelnetSetup(PORT_t *port);
+
+PORT_OPEN_t portOpenAsync(PORT_t *port)
+{
+    if (port == NULL)
+    {
+        return PORT_OPEN_FAIL;
+    }
+    if (port->portOk)
+    {
+        return PORT_OPEN_OK;
+    }
+    if ( (port->type != PORT_TYPE_TCP) && (port->type != PORT_TYPE_TELNET) )
+    {
+        return portOpen(port) ? PORT_OPEN_OK : PORT_OPEN_FAIL;
+    }
+
+    if (!port->connecting && !_portTcpConnectStart(port))
+    {
+        return PORT_OPEN_FAIL;
+    }
+    const PORT_OPEN_t res = _portTcpConnectCheck(port, 0);
+    if (res != PORT_OPEN_OK)
+    {
+        return res;
+    }
+    if ( (port->type == PORT_TYPE_TELNET) && !_portTelnetSetup(port) )
+    {
+        return PORT_OPEN_FAIL;
+    }
+    return _portOpenDone(port, true) ? PORT_OPEN_OK : PORT_OPEN_FAIL;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
 static void _portCloseSer(PORT_t *port);
 static void _portCloseTcp(PORT_t *port);
 static void _portCloseTelnet(PORT_t *port);
+static void _portCloseFd(PORT_t *port);
+static void _portCloseTcpsrv(PORT_t *port);
 
 void portClose(PORT_t *port)
 {
     if (port != NULL)
     {
+        if (port->txBuf != NULL)
+        {
+            if (port->portOk && !portFlush(port, 1000))
+            {
+                PORT_WARNING("dropping %d bytes pending", port->txLen);
+            }
+            free(port->txBuf);
+            port->txBuf = NULL;
+            port->txLen = 0;
+        }
         switch (port->type)
         {
             case PORT_TYPE_SER:
@@ -299,9 +564,19 @@ void portClose(PORT_t *port)
             case PORT_TYPE_TELNET:
                 _portCloseTelnet(port);
                 break;
+            case PORT_TYPE_FILE:
+            case PORT_TYPE_FD:
+            case PORT_TYPE_UNIX:
+            case PORT_TYPE_PTY:
+                _portCloseFd(port);
+                break;
+            case PORT_TYPE_TCPSRV:
+                _portCloseTcpsrv(port);
+                break;
         }
         PORT_DEBUG("closed (rx=%u, tx=%u)", port->numRx, port->numTx);
         port->portOk = false;
+        port->connecting = false;
     }
 }
 
@@ -310,12 +585,22 @@ void portClose(PORT_t *port)
 static bool _portWriteSer(PORT_t *port, const uint8_t *data, const int size);
 static bool _portWriteTcp(PORT_t *port, const uint8_t *data, const int size);
 static bool _portWriteTelnet(PORT_t *port, const uint8_t *data, const int size);
+static bool _portWriteFd(PORT_t *port, const uint8_t *data, const int size);
+static bool _portWriteTcpsrv(PORT_t *port, const uint8_t *data, const int size);
 
 bool portWrite(PORT_t *port, const uint8_t *data, const int size)
 {
     bool res = false;
     if ( (port != NULL) && port->portOk && (size > 0) )
     {
+        // Backpressure: the data must fit into the queue entirely (in the worst case, all bytes need escaping)
+        if ( (port->txBuf != NULL) &&
+             ((port->txLen + (port->type == PORT_TYPE_TELNET ? 2 * size : size)) > port->txSize) )
+        {
+            port->txNumFull++;
+            PORT_TRACE("write %d queue full (%d/%d)", size, port->txLen, port->txSize);
+            return false;
+        }
         switch (port->type)
         {
             case PORT_TYPE_SER:
@@ -327,12 +612,23 @@ bool portWrite(PORT_t *port, const uint8_t *data, const int size)
             case PORT_TYPE_TELNET:
                 res = _portWriteTelnet(port, data, size);
                 break;
+            case PORT_TYPE_FILE:
+            case PORT_TYPE_FD:
+            case PORT_TYPE_UNIX:
+            case PORT_TYPE_PTY:
+                res = _portWriteFd(port, data, size);
+                break;
+            case PORT_TYPE_TCPSRV:
+                res = _portWriteTcpsrv(port, data, size);
+                break;
         }
     }
     PORT_TRACE("write %d %s", size, res ? "ok" : "fail");
     if (res)
     {
         port->numTx += size;
+        port->stats.txBytes += size;
+        port->stats.numWrites++;
     }
     return res;
 }
@@ -342,6 +638,9 @@ bool portWrite(PORT_t *port, const uint8_t *data, const int size)
 static bool _portReadSer(PORT_t *port, uint8_t *data, const int size, int *nRead);
 static bool _portReadTcp(PORT_t *port, uint8_t *data, const int size, int *nRead);
 static bool _portReadTelnet(PORT_t *port, uint8_t *data, const int size, int *nRead);
+static bool _portReadFd(PORT_t *port, uint8_t *data, const int size, int *nRead);
+static bool _portReadTcpsrv(PORT_t *port, uint8_t *data, const int size, int *nRead);
+static void _portStatsRead(PORT_t *port, const int num);
 
 bool portRead(PORT_t *port, uint8_t *data, const int size, int *nRead)
 {
@@ -349,6 +648,10 @@ bool portRead(PORT_t *port, uint8_t *data, const int size, int *nRead)
     *nRead = 0;
     if ( (port != NULL) && (nRead != NULL) && port->portOk && (size > 0) )
     {
+        if ( (port->txLen > 0) && !portFlush(port, 0) && !port->portOk )
+        {
+            return false;
+        }
         switch (port->type)
         {
             case PORT_TYPE_SER:
@@ -360,7 +663,25 @@ bool portRead(PORT_t *port, uint8_t *data, const int size, int *nRead)
             case PORT_TYPE_TELNET:
                 res = _portReadTelnet(port, data, size, nRead);
                 break;
+            case PORT_TYPE_FILE:
+            case PORT_TYPE_FD:
+            case PORT_TYPE_UNIX:
+            case PORT_TYPE_PTY:
+                res = _portReadFd(port, data, size, nRead);
+                break;
+            case PORT_TYPE_TCPSRV:
+                res = _portReadTcpsrv(port, data, size, nRead);
+                break;
+        }
+    }
+    if (port->hangup && (*nRead == 0))
+    {
+        if (!port->eof)
+        {
+            PORT_WARNING("read fail (%d): %s", size, "hangup");
+            port->eof = true;
         }
+        res = false;
     }
     if ((*nRead > 0) || !res)
     {
@@ -369,6 +690,7 @@ bool portRead(PORT_t *port, uint8_t *data, const int size, int *nRead)
     if (res)
     {
         port->numRx += *nRead;
+        _portStatsRead(port, *nRead);
     }
     return res;
 }
@@ -395,6 +717,12 @@ bool portCanBaudrate(PORT_t *port)
             case PORT_TYPE_TELNET:
                 res = _portCanBaudrateTelnet(port);
                 break;
+            case PORT_TYPE_FILE:
+            case PORT_TYPE_FD:
+            case PORT_TYPE_UNIX:
+            case PORT_TYPE_PTY:
+            case PORT_TYPE_TCPSRV:
+                break;
         }
     }
     return res;
@@ -409,7 +737,7 @@ static bool _portSetBaudrateTelnet(PORT_t *port, const int baudrate);
 bool portSetBaudrate(PORT_t *port, const int baudrate)
 {
     bool res = false;
-    if ( (port != NULL) && port->portOk && (_portBaudrateValue(baudrate) != 0) )
+    if ( (port != NULL) && port->portOk && _portBaudrateOk(port->type, baudrate) )
     {
         switch (port->type)
         {
@@ -422,6 +750,12 @@ bool portSetBaudrate(PORT_t *port, const int baudrate)
             case PORT_TYPE_TELNET:
                 res = _portSetBaudrateTelnet(port, baudrate);
                 break;
+            case PORT_TYPE_FILE:
+            case PORT_TYPE_FD:
+            case PORT_TYPE_UNIX:
+            case PORT_TYPE_PTY:
+            case PORT_TYPE_TCPSRV:
+                break;
         }
     }
     PORT_TRACE("baudrate %d %s", baudrate, res ? "ok" : "fail");
@@ -433,6 +767,7 @@ bool portSetBaudrate(PORT_t *port, const int baudrate)
 static int _portGetBaudrateSer(PORT_t *port);
 static int _portGetBaudrateTcp(PORT_t *port);
 static int _portGetBaudrateTelnet(PORT_t *port);
+static int _portGetBaudratePty(PORT_t *port);
 
 int portGetBaudrate(PORT_t *port)
 {
@@ -450,779 +785,1539 @@ int portGetBaudrate(PORT_t *port)
             case PORT_TYPE_TELNET:
                 res = _portGetBaudrateTelnet(port);
                 break;
+            case PORT_TYPE_FILE:
+                res = port->baudrate;
+                break;
+            case PORT_TYPE_PTY:
+                res = _portGetBaudratePty(port);
+                break;
+            case PORT_TYPE_FD:
+            case PORT_TYPE_UNIX:
+            case PORT_TYPE_TCPSRV:
+                break;
         }
     }
     return res;
 }
 
-/* ***** serial ports *************************************************************************** */
+// ---------------------------------------------------------------------------------------------------------------------
 
-static bool _portOpenSer(PORT_t *port)
+#ifdef __linux__
+static bool _portReadSysfs(const char *dir, const char *name, char *str, const int size)
 {
-#ifdef _WIN32
-
-    char file[PORT_SPEC_MAX_LEN];
-    snprintf(file, sizeof(file), "\\\\.\\%s", port->file);
-
-    HANDLE handle = CreateFileA(file, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
-    if (handle == INVALID_HANDLE_VALUE)
-    {
-        PORT_WARNING("Failed opening device: %s", _portErrStr(port, 0));
-        return false;
-    }
-
-    char settingsStr[256];
-    snprintf(settingsStr, sizeof(settingsStr), "baud=%u data=8 parity=n stop=1",
-        _portBaudrateValue(port->baudrate));
-    DCB settings;
-    memset(&settings, 0, sizeof(settings));
-    settings.DCBlength = sizeof(settings);
-    if (BuildCommDCBA(settingsStr, &settings) == 0)
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", dir, name) >= (int)sizeof(path))
     {
-        PORT_WARNING("Failed parsing settings: %s", _portErrStr(port, 0));
-        CloseHandle(handle);
         return false;
     }
-    if (SetCommState(handle, &settings) == 0)
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
     {
-        PORT_WARNING("Failed applying settings: %s", _portErrStr(port, 0));
-        CloseHandle(handle);
         return false;
     }
+    const bool res = (fgets(str, size, f) != NULL);
+    fclose(f);
+    str[strcspn(str, "\r\n")] = '\0';
+    return res && (str[0] != '\0');
+}
+#endif
 
-    COMMTIMEOUTS timeouts;
-    memset(&timeouts, 0, sizeof(timeouts));
-    timeouts.ReadIntervalTimeout = MAXDWORD;
-    if (SetCommTimeouts(handle, &timeouts) == 0)
+bool portGetDeviceId(PORT_t *port, char *id, const int size)
+{
+    if ( (port == NULL) || (id == NULL) || (size < 1) )
     {
-        PORT_WARNING("Failed applying timeouts: %s", _portErrStr(port, 0));
-        CloseHandle(handle);
         return false;
     }
-
-    port->handle = (void *)handle;
-
-#else
-
-    int fileno = open(port->file, O_RDWR | O_NOCTTY | O_NDELAY);
-    if (fileno < 0)
+    // The port without the baudrate
+    int len = 0;
+    switch (port->type)
     {
-        PORT_WARNING("Failed opening device: %s", _portErrStr(port, 0));
-        return false;
+        case PORT_TYPE_SER:
+            len = snprintf(id, size, "ser://%s", port->file);
+            break;
+        case PORT_TYPE_TCP:
+        case PORT_TYPE_TELNET:
+        case PORT_TYPE_TCPSRV:
+            len = snprintf(id, size, "%s://%s:%u", port->type == PORT_TYPE_TCP ? "tcp" :
+                (port->type == PORT_TYPE_TELNET ? "telnet" : "tcpsrv"), port->file, port->port);
+            break;
+        case PORT_TYPE_FILE:
+        case PORT_TYPE_FD:
+        case PORT_TYPE_UNIX:
+        case PORT_TYPE_PTY:
+            len = snprintf(id, size, "%s", portSpecStr(port));
+            break;
     }
 
-    if (flock(fileno, LOCK_EX | LOCK_NB) != 0)
+#ifdef __linux__
+    // The USB device (vendor, product, serial number) resp. the physical path of the serial device
+    if (port->type == PORT_TYPE_SER)
     {
-        PORT_WARNING("Failed locking device: %s", _portErrStr(port, 0));
-        close(fileno);
-        return false;
+        char *real = realpath(port->file, NULL);
+        const char *dev = real != NULL ? strrchr(real, '/') : NULL;
+        char path[PATH_MAX];
+        char *sys = NULL;
+        if ( (dev != NULL) && (snprintf(path, sizeof(path), "/sys/class/tty%s/device", dev) < (int)sizeof(path)) )
+        {
+            sys = realpath(path, NULL);
+        }
+        free(real);
+        if (sys != NULL)
+        {
+            // Walk up from the tty device to the USB device
+            char dir[PATH_MAX];
+            char vendor[20];
+            char product[20];
+            char serial[100];
+            snprintf(dir, sizeof(dir), "%s", sys);
+            bool usb = false;
+            while ( !usb && (strlen(dir) > 13) ) // "/sys/devices/"
+            {
+                usb = _portReadSysfs(dir, "idVendor", vendor, sizeof(vendor)) &&
+                      _portReadSysfs(dir, "idProduct", product, sizeof(product));
+                if (!usb)
+                {
+                    *strrchr(dir, '/') = '\0';
+                }
+            }
+            const int offs = MIN(len, size);
+            if (usb && _portReadSysfs(dir, "serial", serial, sizeof(serial)))
+            {
+                len += snprintf(&id[offs], size - offs, " usb=%s:%s:%s", vendor, product, serial);
+            }
+            else if (usb)
+            {
+                len += snprintf(&id[offs], size - offs, " usb=%s:%s sys=%s", vendor, product, &dir[12]);
+            }
+            else
+            {
+                len += snprintf(&id[offs], size - offs, " sys=%s", &sys[12]);
+            }
+            free(sys);
+        }
     }
+#endif
 
-    // ST eval kit needs this. Not sure if this affect other serial ports. We'll see...
-    // Man page: tty_ioctl(2)
-    const bool RTS = false; // false=clear, true=set
-    const bool DTR = false; // false=clear, true=set
-    const int RTSbits = TIOCM_RTS;
-    const int DTRbits = TIOCM_DTR;
-    if ((ioctl(fileno, RTS ? TIOCMBIS : TIOCMBIC, &RTSbits) < 0) ||
-        (ioctl(fileno, DTR ? TIOCMBIS : TIOCMBIC, &DTRbits) < 0)) {
-        PORT_WARNING("Failed setting RTS/DTR lines: %s", _portErrStr(port, 0));
-        // Let's continue anyway...
-    }
+    return len < size;
+}
 
+// ---------------------------------------------------------------------------------------------------------------------
 
-    struct termios settings;
-    memset(&settings, 0, sizeof(settings));
-    if (tcgetattr(fileno, &settings) != 0) {
-        PORT_WARNING("Failed getting port settings: %s", _portErrStr(port, 0));
-        // Let's continue anyway...
-    }
+static uint64_t _portTimeUs(void);
 
-    cfmakeraw(&settings);
-    settings.c_cflag |= CLOCAL;
-    settings.c_cc[VTIME] = 0;
-    settings.c_cc[VMIN] = 0;
+#ifndef _WIN32
 
-    // 8
-    settings.c_cflag &= ~CSIZE;
-    settings.c_cflag |= CS8;
-    // N
-    settings.c_iflag &= ~(PARMRK | INPCK);
-    settings.c_iflag |= IGNPAR;
-    settings.c_cflag &= ~PARENB;
-    // 1
-    settings.c_cflag &= ~CSTOPB;
+#define PORT_WAIT_MAX_FDS (PORT_TCPSRV_MAX_CLIENTS + 1) // Maximum number of fds to wait for per port
 
-    // No flow control
-    settings.c_cflag &= ~CRTSCTS;
-    settings.c_iflag &= ~(IXON | IXOFF | IXANY);
+static int _portTcpsrvPollFds(PORT_t *port, struct pollfd *pfds);
+static bool _portTcpsrvPollDone(PORT_t *port, const struct pollfd *pfds, const int numPfds);
 
-    if (tcsetattr(fileno, TCSANOW, &settings) != 0)
+// Replay: time when the next byte is due
+static uint64_t _portReplayDue(const PORT_t *port)
+{
+    return port->lastTime + ((((port->fileOffs + 1) * 10 * 1000) + port->baudrate - 1) / port->baudrate);
+}
+
+// Get the fds to wait for (at most PORT_WAIT_MAX_FDS) and limit the wait time (e.g. if sending is throttled). Returns
+// the number of fds, or -1 if the port is readable right away.
+static int _portPollFds(PORT_t *port, struct pollfd *pfds, uint32_t *waitTime)
+{
+    // Connection in progress (see portOpenAsync())
+    if (port->connecting)
     {
-        PORT_WARNING("Failed configuring device: %s", _portErrStr(port, 0));
-        flock(fileno, LOCK_UN);
-        close(fileno);
-        return false;
+        pfds[0] = (struct pollfd){ .fd = port->fd, .events = POLLOUT, .revents = 0 };
+        return 1;
     }
-
-    // We should be good now
-    port->fd = fileno;
-
-    // Set baudrate
-    if (!_portSetBaudrateSer(port, port->baudrate)) {
-        port->fd = -1;
-        flock(fileno, LOCK_UN);
-        close(fileno);
-        return false;
+    // Port failed, resp. nothing more to read, ever
+    if (!port->portOk || port->eof)
+    {
+        return 0;
     }
-
-#endif
-
-    return true;
-}
-
-static uint32_t _portBaudrateValue(const int baudrate)
-{
-    const int      rates[]  = { PORT_BAUDRATES };
-    const uint32_t values[] = { PORT_BAUDVALUES };
-    for (int ix = 0; ix < NUMOF(rates); ix++)
+    if (port->type == PORT_TYPE_TCPSRV)
     {
-        if (baudrate == rates[ix])
+        return _portTcpsrvPollFds(port, pfds);
+    }
+    // Replay: wait until the next byte is due
+    if ( (port->type == PORT_TYPE_FILE) && (port->baudrate > 0) )
+    {
+        const uint64_t due = _portReplayDue(port);
+        const uint64_t now = TIME();
+        if (due <= now)
         {
-            return values[ix];
+            return -1;
         }
+        *waitTime = MIN(*waitTime, due - now);
+        return 0;
     }
-    return 0;
+    // Also wait for the port to accept pending data. If sending is throttled, wait at most until it's allowed again.
+    pfds[0] = (struct pollfd){ .fd = port->fd, .events = POLLIN, .revents = 0 };
+    if (port->txLen > 0)
+    {
+        const uint32_t throttle = portTxThrottle(port);
+        if (throttle > 0)
+        {
+            *waitTime = MIN(*waitTime, throttle);
+        }
+        else
+        {
+            pfds[0].events |= POLLOUT;
+        }
+    }
+    return 1;
 }
 
-// ---------------------------------------------------------------------------------------------------------------------
-
-static void _portCloseSer(PORT_t *port)
+// Handle the poll() result for the fds from _portPollFds(), returns true if portRead() should be called
+static bool _portPollDone(PORT_t *port, const struct pollfd *pfds, const int numPfds)
 {
-#ifdef _WIN32
-    CloseHandle((HANDLE)port->handle);
-#else
-    flock(port->fd, LOCK_UN);
-    close(port->fd);
-#endif
+    if (port->connecting)
+    {
+        return pfds[0].revents != 0;
+    }
+    if (!port->portOk || port->eof)
+    {
+        return false;
+    }
+    if (port->type == PORT_TYPE_TCPSRV)
+    {
+        return _portTcpsrvPollDone(port, pfds, numPfds);
+    }
+    if ( (port->type == PORT_TYPE_FILE) && (port->baudrate > 0) )
+    {
+        return _portReplayDue(port) <= TIME();
+    }
+    PORT_XTRA_TRACE("wait -> 0x%04x", pfds[0].revents);
+    if (port->txLen > 0)
+    {
+        portFlush(port, 0);
+    }
+    if ( ((pfds[0].revents & POLLIN) != 0) && (port->readableTime == 0) )
+    {
+        port->readableTime = _portTimeUs();
+    }
+    // POLLERR or POLLHUP stay set once the other side is gone, so poll() would return immediately from now on. Make
+    // the subsequent read fail if it doesn't get any (remaining) data.
+    if ((pfds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) != 0)
+    {
+        port->hangup = true;
+    }
+    // POLLIN, but also POLLERR or POLLHUP, so that the subsequent read can detect the problem
+    return (pfds[0].revents & ~POLLOUT) != 0;
 }
 
-// ---------------------------------------------------------------------------------------------------------------------
+#endif // !_WIN32
 
-static bool _portWriteSer(PORT_t *port, const uint8_t *data, const int size)
+bool portWaitReadable(PORT_t *port, const uint32_t timeout)
 {
-#ifdef _WIN32
-
-    uint32_t num = 0;
-    // FIXME: handle ERROR_IO_PENDING?
-    const int res = WriteFile((HANDLE)port->handle, data, size, (LPDWORD)&num, NULL);
-    PORT_XTRA_TRACE("write %d -> %d %u", size, res, num);
-    if ( (res == 0) || ((int)num != size) )
+    if ( (port == NULL) || (!port->portOk && !port->connecting) )
     {
-        PORT_WARNING_THROTTLE("write fail (%d, %d): %s", size, res, _portErrStr(port, 0));
         return false;
     }
+    bool readable = false;
+    portWaitReadableMulti(&port, 1, timeout, &readable);
+    return readable;
+}
 
+bool portWaitReadableMulti(PORT_t * const *ports, const int numPorts, const uint32_t timeout, bool *readable)
+{
+    if ( (ports == NULL) || (numPorts < 1) || (numPorts > PORT_WAIT_MAX_PORTS) || (readable == NULL) )
+    {
+        return false;
+    }
+#ifdef _WIN32
+    // FIXME: use WaitForMultipleObjects() / WSAPoll()
+    SLEEP(MIN(timeout, 10));
+    bool any = false;
+    for (int ix = 0; ix < numPorts; ix++)
+    {
+        readable[ix] = (ports[ix] != NULL) && (ports[ix]->portOk || ports[ix]->connecting);
+        any = any || readable[ix];
+    }
+    return any;
 #else
-
-    const int res = write(port->fd, data, size);
-    PORT_XTRA_TRACE("write %d -> %d", size, res);
-    // FIXME: handle EAGAIN?
-    if ( (res < 0) || (res != size) )
+    struct pollfd pfds[PORT_WAIT_MAX_PORTS * PORT_WAIT_MAX_FDS];
+    int offs[PORT_WAIT_MAX_PORTS + 1]; // The fds of ports[ix] are pfds[offs[ix]]...pfds[offs[ix + 1] - 1]
+    int numPfds = 0;
+    uint32_t waitTime = timeout;
+    for (int ix = 0; ix < numPorts; ix++)
+    {
+        offs[ix] = numPfds;
+        readable[ix] = false;
+        const int n = ports[ix] != NULL ? _portPollFds(ports[ix], &pfds[numPfds], &waitTime) : 0;
+        if (n < 0)
+        {
+            waitTime = 0;
+        }
+        else
+        {
+            numPfds += n;
+        }
+    }
+    offs[numPorts] = numPfds;
+    if ( (poll(pfds, numPfds, waitTime > INT_MAX ? INT_MAX : (int)waitTime) < 0) && (errno != EINTR) )
     {
-        PORT_WARNING_THROTTLE("write fail (%d, %d): %s", size, res, _portErrStr(port, 0));
+        WARNING("port: poll fail: %s", strerror(errno));
         return false;
     }
-
+    bool any = false;
+    for (int ix = 0; ix < numPorts; ix++)
+    {
+        readable[ix] = (ports[ix] != NULL) && _portPollDone(ports[ix], &pfds[offs[ix]], offs[ix + 1] - offs[ix]);
+        any = any || readable[ix];
+    }
+    return any;
 #endif
-
-    return true;
 }
 
-// ---------------------------------------------------------------------------------------------------------------------
+/* ***** statistics ***************************************************************************** */
 
-static bool _portReadSer(PORT_t *port, uint8_t *data, const int size, int *nRead)
+// Monotonic time [us]
+static uint64_t _portTimeUs(void)
 {
 #ifdef _WIN32
-
-    uint32_t num = 0;
-    // FIXME: handle ERROR_IO_PENDING?
-    const int res = ReadFile((HANDLE)port->handle, data, size, (LPDWORD)&num, NULL);
-    PORT_XTRA_TRACE("read %d -> %d %u", size, res, num);
-    if (res == 0)
-    {
-        PORT_WARNING_THROTTLE("read fail (%d, %d): %s", size, res, _portErrStr(port, 0));
-        return false;
-    }
-    *nRead = (int)num;
-
+    return TIME() * 1000;
 #else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + ((uint64_t)ts.tv_nsec / 1000);
+#endif
+}
 
-    const int res = read(port->fd, data, size);
-    PORT_XTRA_TRACE("read %d -> %d", size, res);
-    if (res == -1) // EAGAIN
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void _portStatsRead(PORT_t *port, const int num)
+{
+    PORT_STATS_t *stats = &port->stats;
+    if (num > 0)
     {
-        *nRead = 0;
-        return true;
+        stats->rxBytes += num;
+        stats->numReads++;
+        int bin = 0;
+        while ( (bin < (PORT_STATS_HIST_SIZE - 1)) && ((num >> (bin + 1)) != 0) )
+        {
+            bin++;
+        }
+        stats->readHist[bin]++;
+        if (port->readableTime != 0)
+        {
+            const uint64_t latency = _portTimeUs() - port->readableTime;
+            const uint32_t latency32 = latency > UINT32_MAX ? UINT32_MAX : (uint32_t)latency;
+            port->readLatSum += latency32;
+            port->readLatNum++;
+            stats->readLatMax = MAX(stats->readLatMax, latency32);
+        }
     }
-    if (res < 0)
+    else
     {
-        PORT_WARNING_THROTTLE("read fail (%d, %d): %s", size, res, _portErrStr(port, 0));
-        *nRead = 0;
-        return false;
+        stats->numReadsEmpty++;
     }
-    *nRead = res;
-
-#endif
-
-    return true;
+    port->readableTime = 0;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 
-static bool _portCanBaudrateSer(PORT_t *port)
+// Serial line error counts (frame, parity, brk, overrun, buf_overrun) since the driver was loaded
+static bool _portGetIcount(PORT_t *port, uint32_t counts[5])
 {
-    (void)port;
-    return true;
+#if defined(__linux__) && defined(TIOCGICOUNT)
+    struct serial_icounter_struct icount;
+    if ( (port->type == PORT_TYPE_SER) && (ioctl(port->fd, TIOCGICOUNT, &icount) == 0) )
+    {
+        counts[0] = icount.frame;
+        counts[1] = icount.parity;
+        counts[2] = icount.brk;
+        counts[3] = icount.overrun;
+        counts[4] = icount.buf_overrun;
+        return true;
+    }
+#else
+    UNUSED(port);
+    UNUSED(counts);
+#endif
+    return false;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 
-static bool _portSetBaudrateSer(PORT_t *port, const int baudrate)
+bool portGetStats(PORT_t *port, PORT_STATS_t *stats)
 {
-#ifdef _WIN32
-
-    DCB settings;
-    settings.DCBlength = sizeof(settings);
-    if (GetCommState((HANDLE)port->handle, &settings) == 0)
+    if ( (port == NULL) || (stats == NULL) || (port->stats.numOpens == 0) )
     {
-        PORT_WARNING("Failed getting port (baudrate) settings: %s", _portErrStr(port, 0));
         return false;
     }
-    settings.BaudRate = _portBaudrateValue(baudrate);
-    if (SetCommState((HANDLE)port->handle, &settings) == 0)
+    *stats = port->stats;
+
+    const uint64_t now = TIME();
+    if (now > port->statsTime)
     {
-        PORT_WARNING("Failed applying (baudrate) settings: %s", _portErrStr(port, 0));
-        return false;
+        const double dt = (double)(now - port->statsTime) * 1e-3;
+        stats->rxRate   = (double)(stats->rxBytes  - port->statsRx)    / dt;
+        stats->txRate   = (double)(stats->txBytes  - port->statsTx)    / dt;
+        stats->readRate = (double)(stats->numReads - port->statsReads) / dt;
+        port->statsTime  = now;
+        port->statsRx    = stats->rxBytes;
+        port->statsTx    = stats->txBytes;
+        port->statsReads = stats->numReads;
+    }
+    if (port->readLatNum > 0)
+    {
+        stats->readLatMean = port->readLatSum / port->readLatNum;
     }
 
-#else
+    stats->txPending   = port->txLen;
+    stats->txHighWater = port->txHighWater;
+    stats->txNumFull   = port->txNumFull;
 
-    struct termios settings;
-    if (tcgetattr(port->fd, &settings) != 0)
+    uint32_t counts[5];
+    if (port->portOk && _portGetIcount(port, counts))
     {
-        PORT_WARNING("tcgetattr fail: %s", _portErrStr(port, 0));
-        return false;
+        stats->haveIcount   = true;
+        stats->frameErrors  = counts[0] - port->icountBase[0];
+        stats->parityErrors = counts[1] - port->icountBase[1];
+        stats->breaks       = counts[2] - port->icountBase[2];
+        stats->overruns     = counts[3] - port->icountBase[3];
+        stats->bufOverruns  = counts[4] - port->icountBase[4];
     }
+    return true;
+}
 
-    cfsetispeed(&settings, _portBaudrateValue(baudrate));
-    cfsetospeed(&settings, _portBaudrateValue(baudrate));
+/* ***** transmit queue ************************************************************************* */
 
-    if (tcsetattr(port->fd, TCSANOW, &settings) != 0)
+bool portSetTxQueue(PORT_t *port, const int size)
+{
+#ifdef _WIN32
+    UNUSED(size);
+    PORT_WARNING("transmit queue not supported");
+    return false;
+#else
+    if ( (port == NULL) || port->portOk || (size < 0) )
     {
-        PORT_WARNING("tcsetattr fail: %s", _portErrStr(port, 0));
         return false;
     }
-    port->baudrate = baudrate;
-
-#endif
-
+    port->txSize = size;
     return true;
+#endif
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 
-static int _portGetBaudrateSer(PORT_t *port)
+int portTxPending(const PORT_t *port)
 {
-    return port->baudrate;
+    return port != NULL ? port->txLen : 0;
 }
 
-/* ***** raw TCP/IP ***************************************************************************** */
-
-#define TCPIP_MAX_PACKET_SIZE 256
-
-#ifndef _WIN32
-typedef int SOCKET;
-#  define INVALID_SOCKET -1
-#  define SOCKET_ERROR -1
-#endif
-
-#ifdef _WIN32
-static int gWinTcpSocketsOpen;
+// ---------------------------------------------------------------------------------------------------------------------
 
-// Initialise Winsock API (once only)
-bool _winsockInit(PORT_t *port)
+// The remote device will not have infinite buffers. So don't send faster than the remote serial port at this baudrate
+// can transmit (see _portWriteTcp()).
+uint32_t portTxThrottle(const PORT_t *port)
 {
-    if (gWinTcpSocketsOpen > 0)
+    if ( ((port->type != PORT_TYPE_TCP) && (port->type != PORT_TYPE_TELNET)) || (port->baudrate == 0) )
     {
-        return true;
+        return 0;
     }
+    const uint64_t now = TIME();
+    return port->txNextTime > now ? port->txNextTime - now : 0;
+}
 
-    // https://docs.microsoft.com/en-us/windows/win32/api/
-
-    WORD versionWanted = MAKEWORD(2, 2);
-    WSADATA wsaData;
-    const int res = WSAStartup(versionWanted, &wsaData);
-    if (res != 0)
+// Add data to the queue and send as much as possible right away
+static bool _portTxEnqueue(PORT_t *port, const uint8_t *data, const int size)
+{
+    if ((port->txLen + size) > port->txSize)
     {
-        PORT_WARNING("Failed initialising winsock: %s", _portErrStr(port, res));
+        PORT_WARNING_THROTTLE("transmit queue full (%d, %d/%d)", size, port->txLen, port->txSize);
         return false;
     }
-    const int wsockVerMajor = LOBYTE(wsaData.wVersion);
-    const int wsockVerMinor = HIBYTE(wsaData.wVersion);
-    if ( (wsockVerMajor != 2) || (wsockVerMinor < 2) )
+    // Move pending data to the beginning of the queue if necessary
+    if ((port->txOffs + port->txLen + size) > port->txSize)
     {
-        PORT_WARNING("Unexpected winsock version %d.%d!", wsockVerMajor, wsockVerMinor);
-        WSACleanup();
-        return false;
+        memmove(port->txBuf, &port->txBuf[port->txOffs], port->txLen);
+        port->txOffs = 0;
     }
-    DEBUG("winsock version %d.%d", wsockVerMajor, wsockVerMinor);
-
-    gWinTcpSocketsOpen++;
-
-    return true;
+    memcpy(&port->txBuf[port->txOffs + port->txLen], data, size);
+    port->txLen += size;
+    port->txHighWater = MAX(port->txHighWater, port->txLen);
+    return portFlush(port, 0) || port->portOk;
 }
 
-void _winsockDeinit(PORT_t *port)
+#ifndef _WIN32
+// Send data without blocking, returns the number of bytes sent or -1 (and errno)
+static int _portTxRaw(PORT_t *port, const uint8_t *data, const int size)
 {
-    if (gWinTcpSocketsOpen <= 0)
+    switch (port->type)
     {
-        return;
+        case PORT_TYPE_TCP:
+        case PORT_TYPE_TELNET:
+        case PORT_TYPE_UNIX:
+        case PORT_TYPE_TCPSRV:
+            return send(port->fd, data, size, MSG_NOSIGNAL);
+        case PORT_TYPE_FILE:
+            return size; // Nowhere to send to
+        case PORT_TYPE_FD:
+            return write(port->fdOut, data, size);
+        case PORT_TYPE_SER:
+        case PORT_TYPE_PTY:
+            break;
     }
-    (void)port;
-    WSACleanup();
-    gWinTcpSocketsOpen--;
+    return write(port->fd, data, size);
 }
-
 #endif
 
-static bool _portOpenTcp(PORT_t *port)
+bool portFlush(PORT_t *port, const uint32_t timeout)
 {
-#ifdef _WIN32
-    if (!_winsockInit(port))
+    if ( (port == NULL) || (port->txBuf == NULL) || (port->txLen == 0) )
     {
-        return false;
+        return true;
     }
-#endif
-
-    // Find address, as per getaddrinfo(3)
-    struct addrinfo *result;
+    if (!port->portOk)
     {
-        struct addrinfo hints;
-        memset(&hints, 0, sizeof(hints));
-        hints.ai_family   = AF_UNSPEC;  // IPv4 or IPv6
-        hints.ai_socktype = SOCK_STREAM;
-        char portNrStr[20];
-        snprintf(portNrStr, sizeof(portNrStr), "%d", port->port);
-        const int res = getaddrinfo(port->file, portNrStr, &hints, &result);
-        if (res != 0)
-        {
+        return false;
+    }
 #ifdef _WIN32
-            PORT_WARNING("Failed connecting: %s", _portErrStr(port, 0));
-            _winsockDeinit(port);
+    UNUSED(timeout);
+    return false;
 #else
-            PORT_WARNING("Failed getting address: %s", gai_strerror(res));
-#endif
-            return false;
-        }
-    }
-
-    // Connect
-    SOCKET fd = INVALID_SOCKET;
-    for (struct addrinfo *rp = result; rp != NULL; rp = rp->ai_next)
+    const uint64_t t1 = TIME() + timeout;
+    while (port->txLen > 0)
     {
-        fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
-        if (fd == INVALID_SOCKET)
-        {
-            continue;
-        }
-
-#ifndef _WIN32
-#  if 1
-        struct timeval timeout;
-        timeout.tv_sec  = 5;
-        timeout.tv_usec = 0;
-        if (setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0)
+        // Send what the port accepts
+        const uint32_t throttle = portTxThrottle(port);
+        if (throttle == 0)
         {
-            PORT_WARNING("Failed setting SO_SNDTIMEO option: %s", _portErrStr(port, 0));
-        }
-#  else
-        const int count = 3;
-        if (setsockopt(fd, IPPROTO_TCP, TCP_SYNCNT, &count, sizeof(count)) != 0)
-        {
-            PORT_WARNING("Failed setting TCP_SYNCNT option: %s", _portErrStr(port, 0));
+            const bool isTcp = (port->type == PORT_TYPE_TCP) || (port->type == PORT_TYPE_TELNET);
+            const int sendSize = isTcp ? MIN(port->txLen, TCPIP_MAX_PACKET_SIZE) : port->txLen;
+            const int res = _portTxRaw(port, &port->txBuf[port->txOffs], sendSize);
+            PORT_XTRA_TRACE("flush %d -> %d", sendSize, res);
+            if (res > 0)
+            {
+                port->txOffs += res;
+                port->txLen -= res;
+                if (port->txLen == 0)
+                {
+                    port->txOffs = 0;
+                }
+                if ( isTcp && (port->baudrate != 0) )
+                {
+                    // Assume 11 bits per character to be on the safe side
+                    port->txNextTime = TIME() + (((uint64_t)res * 11 * 1000) / port->baudrate);
+                }
+                continue;
+            }
+            else if ( (res < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR) )
+            {
+                PORT_WARNING_THROTTLE("flush fail (%d, %d): %s", sendSize, res, _portErrStr(port, 0));
+                port->portOk = false;
+                return false;
+            }
         }
-#  endif
-#endif
 
-        int res = connect(fd, rp->ai_addr, rp->ai_addrlen);
-        if (res == SOCKET_ERROR)
+        // Wait for the port to accept more data (or until throttling expires)
+        const uint64_t now = TIME();
+        if (now >= t1)
         {
-            PORT_WARNING("Failed connecting: %s", _portErrStr(port, 0));
-#ifdef _WIN32
-            closesocket(fd);
-            _winsockDeinit(port);
-#else
-            close(fd);
-#endif
-            return false;
+            break;
         }
-        else
+        struct pollfd pfd = { .fd = port->type == PORT_TYPE_FD ? port->fdOut : port->fd,
+            .events = throttle > 0 ? 0 : POLLOUT, .revents = 0 };
+        const uint32_t wait = throttle > 0 ? MIN(throttle, t1 - now) : (t1 - now);
+        if ( (poll(&pfd, 1, (int)wait) < 0) && (errno != EINTR) )
         {
-            break;
+            return false;
         }
     }
+    return port->txLen == 0;
+#endif
+}
 
-    // Cleanup
-    freeaddrinfo(result);
+/* ***** serial ports *************************************************************************** */
 
-    // Happy?
-    if (fd == INVALID_SOCKET)
-    {
-        PORT_WARNING("No connection possible!"); // FIXME: but why?
-#ifdef _WIN32
-        _winsockDeinit(port);
+#ifndef _WIN32
+static void _portSetLowLatencySer(PORT_t *port);
 #endif
-        return false;
-    }
 
-    // Make non-blocking
+static bool _portOpenSer(PORT_t *port)
+{
 #ifdef _WIN32
-    unsigned long mode = 1;
-    if (ioctlsocket(fd, FIONBIO, &mode) != 0)
+
+    char file[PORT_SPEC_MAX_LEN];
+    snprintf(file, sizeof(file), "\\\\.\\%s", port->file);
+
+    HANDLE handle = CreateFileA(file, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
     {
-        PORT_WARNING("Failed setting non-blocking operation: %s", _portErrStr(port, 0));
-        closesocket(fd);
-        _winsockDeinit(port);
+        PORT_WARNING("Failed opening device: %s", _portErrStr(port, 0));
         return false;
     }
-#else
-    const int flags = fcntl(fd, F_GETFL, 0);
-    if (flags < 0)
+
+    char settingsStr[256];
+    snprintf(settingsStr, sizeof(settingsStr), "baud=%d data=8 parity=n stop=1", port->baudrate);
+    DCB settings;
+    memset(&settings, 0, sizeof(settings));
+    settings.DCBlength = sizeof(settings);
+    if (BuildCommDCBA(settingsStr, &settings) == 0)
     {
-        PORT_WARNING("Failed getting flags: %s", _portErrStr(port, 0));
-        close(fd);
+        PORT_WARNING("Failed parsing settings: %s", _portErrStr(port, 0));
+        CloseHandle(handle);
         return false;
     }
-    int res = fcntl(fd, F_SETFL, flags | O_NONBLOCK);
-    if (res < 0)
+    if (SetCommState(handle, &settings) == 0)
     {
-        PORT_WARNING("Failed setting flags: %s", _portErrStr(port, 0));
-        close(fd);
+        PORT_WARNING("Failed applying settings: %s", _portErrStr(port, 0));
+        CloseHandle(handle);
         return false;
     }
-#endif
 
-    // Send immediately
-#ifdef _WIN32
-    const DWORD enable = 1;
-    if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (const char *)&enable, sizeof(enable)) != 0)
+    COMMTIMEOUTS timeouts;
+    memset(&timeouts, 0, sizeof(timeouts));
+    timeouts.ReadIntervalTimeout = MAXDWORD;
+    if (SetCommTimeouts(handle, &timeouts) == 0)
     {
-        PORT_WARNING("Failed setting TCP_NODELAY option: %s", _portErrStr(port, 0));
-        closesocket(fd);
-        _winsockDeinit(port);
+        PORT_WARNING("Failed applying timeouts: %s", _portErrStr(port, 0));
+        CloseHandle(handle);
         return false;
     }
+
+    port->handle = (void *)handle;
+
 #else
-    const int enable = 1;
-    if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable)) != 0)
+
+    int fileno = open(port->file, O_RDWR | O_NOCTTY | O_NDELAY);
+    if (fileno < 0)
     {
-        PORT_WARNING("Failed setting TCP_NODELAY option: %s", _portErrStr(port, 0));
-        close(fd);
+        PORT_WARNING("Failed opening device: %s", _portErrStr(port, 0));
         return false;
     }
-#endif
 
-    // Remember socket
-#ifdef _WIN32
-    port->handle = (void *)fd;
-#else
-    port->fd = fd;
-#endif
+    if (flock(fileno, LOCK_EX | LOCK_NB) != 0)
+    {
+        PORT_WARNING("Failed locking device: %s", _portErrStr(port, 0));
+        close(fileno);
+        return false;
+    }
 
-    return true;
-}
+    // ST eval kit needs this. Not sure if this affect other serial ports. We'll see...
+    // Man page: tty_ioctl(2)
+    const bool RTS = false; // false=clear, true=set
+    const bool DTR = false; // false=clear, true=set
+    const int RTSbits = TIOCM_RTS;
+    const int DTRbits = TIOCM_DTR;
+    if ((ioctl(fileno, RTS ? TIOCMBIS : TIOCMBIC, &RTSbits) < 0) ||
+        (ioctl(fileno, DTR ? TIOCMBIS : TIOCMBIC, &DTRbits) < 0)) {
+        PORT_WARNING("Failed setting RTS/DTR lines: %s", _portErrStr(port, 0));
+        // Let's continue anyway...
+    }
 
-// ---------------------------------------------------------------------------------------------------------------------
 
-static void _portCloseTcp(PORT_t *port)
-{
-#ifdef _WIN32
-    closesocket((SOCKET)port->handle);
-    _winsockDeinit(port);
-#else
-    close(port->fd);
-#endif
-}
+    struct termios settings;
+    memset(&settings, 0, sizeof(settings));
+    if (tcgetattr(fileno, &settings) != 0) {
+        PORT_WARNING("Failed getting port settings: %s", _portErrStr(port, 0));
+        // Let's continue anyway...
+    }
 
-// ---------------------------------------------------------------------------------------------------------------------
+    cfmakeraw(&settings);
+    settings.c_cflag |= CLOCAL;
+    settings.c_cc[VTIME] = 0;
+    settings.c_cc[VMIN] = 0;
 
-static bool _portWriteTcp(PORT_t *port, const uint8_t *data, const int size)
-{
-    int rem = size;
-    int offs = 0;
-    while (rem > 0)
-    {
-        const int sendSize = rem > TCPIP_MAX_PACKET_SIZE ? TCPIP_MAX_PACKET_SIZE : rem;
+    // 8
+    settings.c_cflag &= ~CSIZE;
+    settings.c_cflag |= CS8;
+    // N
+    settings.c_iflag &= ~(PARMRK | INPCK);
+    settings.c_iflag |= IGNPAR;
+    settings.c_cflag &= ~PARENB;
+    // 1
+    settings.c_cflag &= ~CSTOPB;
 
-        // Throttle. The remote device will not have infinite buffers. So don't send faster than the remote
-        // serial port at this baudrate can transmit. Assume 11 bits per character to be on the safe side.
-        const int dt = TIME() - port->lastTime;
-        const int reqDt = port->baudrate != 0 ? (port->lastCount * 1000 / (port->baudrate / 11)) : 0;
-        const int wait = reqDt - dt;
-        if (wait > 0)
-        {
-            SLEEP(wait);
-        }
+    // No flow control
+    settings.c_cflag &= ~CRTSCTS;
+    settings.c_iflag &= ~(IXON | IXOFF | IXANY);
 
-#ifdef _WIN32
-        const int res = send((SOCKET)port->handle, (const char *)&data[offs], sendSize, 0);
-#else
-        const int res = send(port->fd, &data[offs], sendSize, 0);
-#endif
+    if (tcsetattr(fileno, TCSANOW, &settings) != 0)
+    {
+        PORT_WARNING("Failed configuring device: %s", _portErrStr(port, 0));
+        flock(fileno, LOCK_UN);
+        close(fileno);
+        return false;
+    }
 
-        port->lastTime = TIME();
-        port->lastCount = sendSize;
+    // We should be good now
+    port->fd = fileno;
 
-        PORT_XTRA_TRACE("tcp send (delay %d) %d -> %d", wait > 0 ? wait : 0, sendSize, res);
-        // FIXME: handle EAGAIN?
-        if ( (res < 0) || (res != sendSize) )
-        {
-            PORT_WARNING_THROTTLE("tcp send fail (%d, %d): %s", sendSize, res, _portErrStr(port, 0));
-            return false;
-        }
-        offs += sendSize;
-        rem  -= sendSize;
+    // Set baudrate
+    if (!_portSetBaudrateSer(port, port->baudrate)) {
+        port->fd = -1;
+        flock(fileno, LOCK_UN);
+        close(fileno);
+        return false;
     }
+
+    if (port->lowLatency)
+    {
+        _portSetLowLatencySer(port);
+    }
+
+#endif
+
     return true;
 }
 
-// ---------------------------------------------------------------------------------------------------------------------
-
-static bool _portReadTcp(PORT_t *port, uint8_t *data, const int size, int *nRead)
+// Standard baudrates (from PORT_BAUDRATES) are fine for all port types. Serial ports on Linux and Windows can do any
+// baudrate in a reasonable range.
+static bool _portBaudrateOk(const PORT_TYPE_t type, const int baudrate)
 {
-#ifdef _WIN32
-    const int res = recv((SOCKET)port->handle, (char *)data, size, 0);
-#else
-    const int res = recv(port->fd, data, size, 0);
-#endif
-    PORT_XTRA_TRACE("tpc recv %d -> %d", size, res);
-    // Got data
-    if (res > 0)
+    if (_portBaudrateValue(baudrate) != 0)
     {
-        *nRead = res;
         return true;
     }
-    // No more data at the moment
-#ifdef _WIN32
-    else if ( (res == -1) && (GetLastError() == WSAEWOULDBLOCK) )
-#else
-    else if ( (res == -1) && (errno == EAGAIN) )
-#endif
+#if defined(_WIN32) || PORT_HAVE_TERMIOS2
+    if ( (type == PORT_TYPE_SER) && (baudrate >= PORT_BAUDRATE_MIN) && (baudrate <= PORT_BAUDRATE_MAX) )
     {
-        *nRead = 0;
         return true;
     }
-    // Error
-    else
+#else
+    (void)type;
+#endif
+    return false;
+}
+
+static uint32_t _portBaudrateValue(const int baudrate)
+{
+    const int      rates[]  = { PORT_BAUDRATES };
+    const uint32_t values[] = { PORT_BAUDVALUES };
+    for (int ix = 0; ix < NUMOF(rates); ix++)
     {
-        PORT_WARNING_THROTTLE("tcp recv fail (%d, %d): %s", size, res, _portErrStr(port, 0));
-        *nRead = 0;
-        return false;
+        if (baudrate == rates[ix])
+        {
+            return values[ix];
+        }
     }
+    return 0;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 
-static bool _portCanBaudrateTcp(PORT_t *port)
+static void _portCloseSer(PORT_t *port)
 {
-    (void)port;
-    return false;
+#ifdef _WIN32
+    CloseHandle((HANDLE)port->handle);
+#else
+    flock(port->fd, LOCK_UN);
+    close(port->fd);
+#endif
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 
-static bool _portSetBaudrateTcp(PORT_t *port, const int baudrate)
+static bool _portWriteSer(PORT_t *port, const uint8_t *data, const int size)
 {
-    (void)port;
-    (void)baudrate;
-    return true;
-}
+    if (port->txBuf != NULL)
+    {
+        return _portTxEnqueue(port, data, size);
+    }
 
-// ---------------------------------------------------------------------------------------------------------------------
+#ifdef _WIN32
 
-static int _portGetBaudrateTcp(PORT_t *port)
-{
-    (void)port;
-    return 0;
-}
+    uint32_t num = 0;
+    // FIXME: handle ERROR_IO_PENDING?
+    const int res = WriteFile((HANDLE)port->handle, data, size, (LPDWORD)&num, NULL);
+    PORT_XTRA_TRACE("write %d -> %d %u", size, res, num);
+    if ( (res == 0) || ((int)num != size) )
+    {
+        PORT_WARNING_THROTTLE("write fail (%d, %d): %s", size, res, _portErrStr(port, 0));
+        return false;
+    }
 
-/* **** telnet + comport control **************************************************************** */
+#else
 
-// RFC854: Telnet Protocol Specification (https://tools.ietf.org/html/rfc854.html)
-// RFC855: Telnet Option Specifications (https://tools.ietf.org/html/rfc855.html)
-#define TELNET_IAC             255 // command escape
-#define TELNET_COMMAND_WILL    251 // option negotiation
-#define TELNET_COMMAND_WONT    252 // option negotiation
-#define TELNET_COMMAND_DO      253 // option negotiation
-#define TELNET_COMMAND_DONT    254 // option negotiation
-#define TELNET_COMMAND_SB      250 // suboption start
-#define TELNET_COMMAND_SE      240 // suboption end
-#define TELNET_COMMAND_NOP     241 // no operation
-#define TELNET_COMMAND_DM      242 // data mark
-#define TELNET_COMMAND_BRK     243 // terminal break
-#define TELNET_COMMAND_IP      244 // interrupt process
-#define TELNET_COMMAND_AO      245 // abort output
-#define TELNET_COMMAND_AYT     246 // are you there
-#define TELNET_COMMAND_EC      247 // erase character
-#define TELNET_COMMAND_EL      248 // erase line
-#define TELNET_COMMAND_GA      249 // go ahead
+    const int res = write(port->fd, data, size);
+    PORT_XTRA_TRACE("write %d -> %d", size, res);
+    // FIXME: handle EAGAIN?
+    if ( (res < 0) || (res != size) )
+    {
+        PORT_WARNING_THROTTLE("write fail (%d, %d): %s", size, res, _portErrStr(port, 0));
+        return false;
+    }
 
-// RFC856: Telnet Binary Transmission (https://tools.ietf.org/html/rfc856.html)
-// default: WON'T TRANSMIT-BINARY, DON'T TRANSMIT-BINARY
-#define TELNET_OPTION_TRANSMIT_BINARY      0
+#endif
 
-// RFC857: Telnet Echo Option (https://tools.ietf.org/html/rfc857.html)
-// default: WON'T ECHO, DON'T ECHO
-#define TELNET_OPTION_ECHO                 1
+    return true;
+}
 
-// RFC858: Telnet Suppress Go Ahead Option (https://tools.ietf.org/html/rfc858.html)
-// default: WON'T SUPPRESS-GO-AHEAD, DON'T SUPPRESS-GO-AHEAD
-#define TELNET_OPTION_SUPPRESS_GO_AHEAD    3
+// ---------------------------------------------------------------------------------------------------------------------
 
-// RFC859: Telnet Status Option (https://tools.ietf.org/html/rfc859.html)
-// default: DON'T STATUS, WON'T STATUS
-#define TELNET_OPTION_STATUS               5
+static bool _portReadSer(PORT_t *port, uint8_t *data, const int size, int *nRead)
+{
+#ifdef _WIN32
 
-// RFC2217: Telnet Com Port Control Option (https://tools.ietf.org/html/rfc2217.html)
-#define TELNET_OPTION_COM_PORT_OPTION     44
-#define TELNET_CPCO_SIGNATURE              0 // FIXME: is it 0? The RFC doesn't say..
-#define TELNET_CPCO_SET_BAUDRATE           1
-#define TELNET_CPCO_SET_DATASIZE           2
-#define TELNET_CPCO_SET_PARITY             3
-#define TELNET_CPCO_SET_STOPSIZE           4
-#define TELNET_CPCO_SET_CONTROL            5
-#define TELNET_CPCO_NOTIFY_LINESTATE       6
-#define TELNET_CPCO_NOTIFY_MODEMSTATE      7
-#define TELNET_CPCO_FLOWCONTROL_SUSPEND    8
-#define TELNET_CPCO_FLOWCONTROL_RESUME     9
-#define TELNET_CPCO_SET_LINESTATE_MASK    10
-#define TELNET_CPCO_SET_MODEMSTATE_MASK   11
-#define TELNET_CPCO_PURGE_DATA            12
-#define TELNET_CPCO_SERVER_TO_CLIENT_OFFS 100
+    uint32_t num = 0;
+    // FIXME: handle ERROR_IO_PENDING?
+    const int res = ReadFile((HANDLE)port->handle, data, size, (LPDWORD)&num, NULL);
+    PORT_XTRA_TRACE("read %d -> %d %u", size, res, num);
+    if (res == 0)
+    {
+        PORT_WARNING_THROTTLE("read fail (%d, %d): %s", size, res, _portErrStr(port, 0));
+        return false;
+    }
+    *nRead = (int)num;
 
-static const char *_telnetCommandStr(PORT_t *port, const uint8_t command)
-{
-    switch (command)
+#else
+
+    const int res = read(port->fd, data, size);
+    PORT_XTRA_TRACE("read %d -> %d", size, res);
+    if ( (res < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) )
     {
-        case TELNET_IAC:          return "IAC";
-        case TELNET_COMMAND_WILL: return "WILL";
-        case TELNET_COMMAND_WONT: return "WONT";
-        case TELNET_COMMAND_DO:   return "DO";
-        case TELNET_COMMAND_DONT: return "DONT";
-        case TELNET_COMMAND_SB:   return "SB";
-        case TELNET_COMMAND_SE:   return "SE";
-        default:
-            snprintf(port->tmp, sizeof(port->tmp), "%d", command);
-            return port->tmp;
+        *nRead = 0;
+        return true;
+    }
+    if (res < 0)
+    {
+        PORT_WARNING_THROTTLE("read fail (%d, %d): %s", size, res, _portErrStr(port, 0));
+        *nRead = 0;
+        return false;
     }
+    *nRead = res;
+
+#endif
+
+    return true;
 }
 
-static const char *_telnetOptionStr(PORT_t *port, const uint8_t option)
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portCanBaudrateSer(PORT_t *port)
 {
-    switch (option)
-    {
-        case TELNET_OPTION_TRANSMIT_BINARY:   return "TRANSMIT_BINARY";
-        case TELNET_OPTION_ECHO:              return "ECHO";
-        case TELNET_OPTION_SUPPRESS_GO_AHEAD: return "SUPPRESS_GO_AHEAD";
-        case TELNET_OPTION_STATUS:            return "STATUS";
-        case TELNET_OPTION_COM_PORT_OPTION:   return "COM_PORT_OPTION";
-        default:
-            snprintf(port->tmp, sizeof(port->tmp), "%d", option);
-            return port->tmp;
-    }
+    (void)port;
+    return true;
 }
 
-static const char *_telnetCpcoStr(PORT_t *port, const uint8_t cpco)
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portSetBaudrateSer(PORT_t *port, const int baudrate)
 {
-    const uint8_t _cpco = cpco >= TELNET_CPCO_SERVER_TO_CLIENT_OFFS ?
-        cpco - TELNET_CPCO_SERVER_TO_CLIENT_OFFS : cpco;
-    switch (_cpco)
+#ifdef _WIN32
+
+    DCB settings;
+    settings.DCBlength = sizeof(settings);
+    if (GetCommState((HANDLE)port->handle, &settings) == 0)
     {
-        case TELNET_CPCO_SIGNATURE:           return "SIGNATURE";
-        case TELNET_CPCO_SET_BAUDRATE:        return "SET_BAUDRATE";
-        case TELNET_CPCO_SET_DATASIZE:        return "SET_DATASIZE";
-        case TELNET_CPCO_SET_PARITY:          return "SET_PARITY";
-        case TELNET_CPCO_SET_STOPSIZE:        return "SET_STOPSIZE";
-        case TELNET_CPCO_SET_CONTROL:         return "SET_CONTROL";
-        case TELNET_CPCO_NOTIFY_LINESTATE:    return "NOTIFY_LINESTATE";
-        case TELNET_CPCO_NOTIFY_MODEMSTATE:   return "NOTIFY_MODEMSTATE";
-        case TELNET_CPCO_FLOWCONTROL_SUSPEND: return "FLOWCONTROL_SUSPEND";
-        case TELNET_CPCO_FLOWCONTROL_RESUME:  return "FLOWCONTROL_RESUME";
-        case TELNET_CPCO_SET_LINESTATE_MASK:  return "SET_LINESTATE_MASK";
-        case TELNET_CPCO_SET_MODEMSTATE_MASK: return "SET_MODEMSTATE_MASK";
-        case TELNET_CPCO_PURGE_DATA:          return "PURGE_DATA";
-        default:
-            snprintf(port->tmp, sizeof(port->tmp), "%d", cpco);
-            return port->tmp;
+        PORT_WARNING("Failed getting port (baudrate) settings: %s", _portErrStr(port, 0));
+        return false;
+    }
+    settings.BaudRate = baudrate;
+    if (SetCommState((HANDLE)port->handle, &settings) == 0)
+    {
+        PORT_WARNING("Failed applying (baudrate) settings: %s", _portErrStr(port, 0));
+        return false;
     }
-}
 
-// options to negotiate
-typedef struct TELNET_OPTION_s
-{
-    uint8_t command;
-    uint8_t option;
-    bool    agree;
-} TELNET_OPTION_t;
+#else
 
-typedef struct TELNET_CPCO_s
-{
-    uint8_t cpco;
-    uint8_t arg;
-} TELNET_CPCO_t;
+    const uint32_t value = _portBaudrateValue(baudrate);
 
-// Bug in some serial port server doesn't like more than 8 IACs in a row (in a packet?)
-//#define TELNET_SEND_MAX_IAC   8
+    // Standard baudrate
+    if (value != 0)
+    {
+        struct termios settings;
+        if (tcgetattr(port->fd, &settings) != 0)
+        {
+            PORT_WARNING("tcgetattr fail: %s", _portErrStr(port, 0));
+            return false;
+        }
 
-enum { TELNET_STATE_NORMAL, TELNET_STATE_IAC, TELNET_STATE_COMMAND, TELNET_STATE_SUBOPTION };
+        cfsetispeed(&settings, value);
+        cfsetospeed(&settings, value);
 
-void _telnetProcessInband(PORT_t *port, uint8_t *buf, int nIn, int *nOut, TELNET_OPTION_t *options, const int nOptions)
+        if (tcsetattr(port->fd, TCSANOW, &settings) != 0)
+        {
+            PORT_WARNING("tcsetattr fail: %s", _portErrStr(port, 0));
+            return false;
+        }
+    }
+#  if PORT_HAVE_TERMIOS2
+    // Arbitrary baudrate
+    else
+    {
+        struct termios2 settings;
+        if (ioctl(port->fd, TCGETS2, &settings) != 0)
+        {
+            PORT_WARNING("TCGETS2 fail: %s", _portErrStr(port, 0));
+            return false;
+        }
+
+        settings.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+        settings.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+        settings.c_ispeed = baudrate;
+        settings.c_ospeed = baudrate;
+
+        if (ioctl(port->fd, TCSETS2, &settings) != 0)
+        {
+            PORT_WARNING("TCSETS2 fail: %s", _portErrStr(port, 0));
+            return false;
+        }
+        // The driver may not be able to do the exact baudrate
+        if ( (ioctl(port->fd, TCGETS2, &settings) == 0) && ((int)settings.c_ospeed != baudrate) )
+        {
+            PORT_DEBUG("baudrate %d is actually %u", baudrate, settings.c_ospeed);
+        }
+    }
+#  else
+    else
+    {
+        return false;
+    }
+#  endif
+    port->baudrate = baudrate;
+
+#endif
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static int _portGetBaudrateSer(PORT_t *port)
 {
-    //TRACE_HEXDUMP(buf, nIn, "nIn=%d", nIn);
+    return port->baudrate;
+}
 
-    int      state   = port->tnState;
-    uint8_t *inband  = port->tnInband;
-    int      nInband = port->nTnInband;
+// ---------------------------------------------------------------------------------------------------------------------
 
-    const uint8_t *pIn = buf;
-    uint8_t *out = buf;
-    int nO = 0;
-    while (nIn > 0)
+#ifndef _WIN32
+static void _portSetLowLatencySer(PORT_t *port)
+{
+#  ifdef __linux__
+    // Tell the driver to push received data to the tty layer immediately
+    struct serial_struct serial;
+    if ( (ioctl(port->fd, TIOCGSERIAL, &serial) == 0) && ((serial.flags & ASYNC_LOW_LATENCY) == 0) )
     {
-        //DEBUG("nIn=%d *pIn=%d 0x%02x", nIn, *pIn, *pIn);
-        switch (state)
+        serial.flags |= ASYNC_LOW_LATENCY;
+        if (ioctl(port->fd, TIOCSSERIAL, &serial) != 0)
         {
-            case TELNET_STATE_NORMAL:
-                if (*pIn == TELNET_IAC)
-                {
-                    state = TELNET_STATE_IAC;
-                }
-                else // normal data
-                {
-                    out[nO++] = *pIn;
-                }
-                break;
-            case TELNET_STATE_IAC:
-                switch (*pIn)
-                {
-                    case TELNET_IAC: // escaped IAC
-                        out[nO++] = TELNET_IAC;
-                        state = TELNET_STATE_NORMAL; // back to normal
-                        break;
-                    case TELNET_COMMAND_WILL:
-                    case TELNET_COMMAND_WONT:
-                    case TELNET_COMMAND_DO:
+            PORT_DEBUG("ASYNC_LOW_LATENCY fail: %s", _portErrStr(port, 0));
+        }
+    }
+
+    // USB serial (FTDI) devices buffer data for up to latency_timer [ms] (default 16ms)
+    char *real = realpath(port->file, NULL);
+    const char *dev = real != NULL ? strrchr(real, '/') : NULL;
+    if (dev != NULL)
+    {
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "/sys/bus/usb-serial/devices/%s/latency_timer", &dev[1]);
+        FILE *f = fopen(path, "w");
+        if (f != NULL)
+        {
+            fputs("1", f);
+            if (fclose(f) != 0)
+            {
+                PORT_DEBUG("%s fail: %s", path, strerror(errno));
+            }
+        }
+        else if (errno != ENOENT)
+        {
+            PORT_WARNING("Cannot set latency timer (%s): %s", path, strerror(errno));
+        }
+    }
+    free(real);
+    PORT_DEBUG("low latency mode");
+#  else
+    PORT_WARNING("Low latency mode not supported on this platform");
+#  endif
+}
+#endif
+
+/* ***** raw TCP/IP ***************************************************************************** */
+
+#ifndef _WIN32
+typedef int SOCKET;
+#  define INVALID_SOCKET -1
+#  define SOCKET_ERROR -1
+#endif
+
+#ifdef _WIN32
+static int gWinTcpSocketsOpen;
+
+// Initialise Winsock API (once only)
+bool _winsockInit(PORT_t *port)
+{
+    if (gWinTcpSocketsOpen > 0)
+    {
+        return true;
+    }
+
+    // https://docs.microsoft.com/en-us/windows/win32/api/
+
+    WORD versionWanted = MAKEWORD(2, 2);
+    WSADATA wsaData;
+    const int res = WSAStartup(versionWanted, &wsaData);
+    if (res != 0)
+    {
+        PORT_WARNING("Failed initialising winsock: %s", _portErrStr(port, res));
+        return false;
+    }
+    const int wsockVerMajor = LOBYTE(wsaData.wVersion);
+    const int wsockVerMinor = HIBYTE(wsaData.wVersion);
+    if ( (wsockVerMajor != 2) || (wsockVerMinor < 2) )
+    {
+        PORT_WARNING("Unexpected winsock version %d.%d!", wsockVerMajor, wsockVerMinor);
+        WSACleanup();
+        return false;
+    }
+    DEBUG("winsock version %d.%d", wsockVerMajor, wsockVerMinor);
+
+    gWinTcpSocketsOpen++;
+
+    return true;
+}
+
+void _winsockDeinit(PORT_t *port)
+{
+    if (gWinTcpSocketsOpen <= 0)
+    {
+        return;
+    }
+    (void)port;
+    WSACleanup();
+    gWinTcpSocketsOpen--;
+}
+
+#endif
+
+static SOCKET _portTcpSocket(PORT_t *port)
+{
+#ifdef _WIN32
+    return (SOCKET)port->handle;
+#else
+    return port->fd;
+#endif
+}
+
+// Connecting to the current address failed, use the next one next time. Resolve the name again once all failed, but
+// not too often, as that blocks.
+static void _portTcpAddrFailed(PORT_t *port)
+{
+    port->addrFails++;
+    port->addrIx = (port->addrIx + 1) % port->addrNum;
+    if ( (port->addrFails >= port->addrNum) && ((TIME() - port->addrTime) >= PORT_RESOLVE_INTERVAL) )
+    {
+        port->addrNum = 0;
+    }
+}
+
+// Resolve the address (or use the cached ones), create a non-blocking socket and start connecting
+static bool _portTcpConnectStart(PORT_t *port)
+{
+#ifdef _WIN32
+    if (!_winsockInit(port))
+    {
+        return false;
+    }
+#endif
+
+    // Find addresses, as per getaddrinfo(3), and cache them, so that reconnecting does not need (blocking) name
+    // resolution
+    if (port->addrNum == 0)
+    {
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family   = AF_UNSPEC;  // IPv4 or IPv6
+        hints.ai_socktype = SOCK_STREAM;
+        char portNrStr[20];
+        snprintf(portNrStr, sizeof(portNrStr), "%d", port->port);
+        struct addrinfo *result;
+        const int res = getaddrinfo(port->file, portNrStr, &hints, &result);
+        if (res != 0)
+        {
+#ifdef _WIN32
+            PORT_WARNING("Failed getting address: %s", _portErrStr(port, 0));
+            _winsockDeinit(port);
+#else
+            PORT_WARNING("Failed getting address: %s", gai_strerror(res));
+#endif
+            return false;
+        }
+        for (struct addrinfo *rp = result; (rp != NULL) && (port->addrNum < PORT_MAX_ADDRS); rp = rp->ai_next)
+        {
+            PORT_ADDR_t *addr = &port->addrs[port->addrNum];
+            if (rp->ai_addrlen <= sizeof(addr->addr))
+            {
+                memcpy(addr->addr, rp->ai_addr, rp->ai_addrlen);
+                addr->addrLen = rp->ai_addrlen;
+                addr->family  = rp->ai_family;
+                addr->proto   = rp->ai_protocol;
+                port->addrNum++;
+            }
+        }
+        freeaddrinfo(result);
+        port->addrIx = 0;
+        port->addrFails = 0;
+        port->addrTime = TIME();
+        if (port->addrNum == 0)
+        {
+            PORT_WARNING("Failed getting address: bad address");
+#ifdef _WIN32
+            _winsockDeinit(port);
+#endif
+            return false;
+        }
+    }
+
+    // Create socket
+    const PORT_ADDR_t *addr = &port->addrs[port->addrIx];
+    const SOCKET fd = socket(addr->family, SOCK_STREAM, addr->proto);
+    if (fd == INVALID_SOCKET)
+    {
+        PORT_WARNING("Failed creating socket: %s", _portErrStr(port, 0));
+#ifdef _WIN32
+        _winsockDeinit(port);
+#endif
+        return false;
+    }
+#ifdef _WIN32
+    port->handle = (void *)fd;
+#else
+    port->fd = fd;
+#endif
+
+    // Make non-blocking
+#ifdef _WIN32
+    unsigned long mode = 1;
+    if (ioctlsocket(fd, FIONBIO, &mode) != 0)
+    {
+        PORT_WARNING("Failed setting non-blocking operation: %s", _portErrStr(port, 0));
+        _portCloseTcp(port);
+        return false;
+    }
+#else
+    const int flags = fcntl(fd, F_GETFL, 0);
+    if ( (flags < 0) || (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) )
+    {
+        PORT_WARNING("Failed setting flags: %s", _portErrStr(port, 0));
+        _portCloseTcp(port);
+        return false;
+    }
+#endif
+
+    // Start connecting
+    const int res = connect(fd, (const struct sockaddr *)addr->addr, addr->addrLen);
+#ifdef _WIN32
+    if ( (res == SOCKET_ERROR) && (WSAGetLastError() != WSAEWOULDBLOCK) )
+#else
+    if ( (res == SOCKET_ERROR) && (errno != EINPROGRESS) )
+#endif
+    {
+        PORT_WARNING("Failed connecting: %s", _portErrStr(port, 0));
+        _portCloseTcp(port);
+        _portTcpAddrFailed(port);
+        return false;
+    }
+    port->connecting = true;
+    port->connectTime = TIME();
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Check if the connection is established, waiting up to timeout [ms]
+static PORT_OPEN_t _portTcpConnectCheck(PORT_t *port, const uint32_t timeout)
+{
+    const SOCKET fd = _portTcpSocket(port);
+    struct pollfd pfd = { .fd = fd, .events = POLLOUT, .revents = 0 };
+#ifdef _WIN32
+    const int res = WSAPoll(&pfd, 1, timeout > INT_MAX ? INT_MAX : (int)timeout);
+#else
+    const int res = poll(&pfd, 1, timeout > INT_MAX ? INT_MAX : (int)timeout);
+#endif
+    int err = 0;
+    if ( (res == 0) || ((res < 0) && (errno == EINTR)) )
+    {
+        if ((TIME() - port->connectTime) < PORT_CONNECT_TIMEOUT)
+        {
+            return PORT_OPEN_PENDING;
+        }
+        err = ETIMEDOUT;
+    }
+    else if (res < 0)
+    {
+        err = errno;
+    }
+    else
+    {
+        socklen_t len = sizeof(err);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, (char *)&err, &len) != 0)
+        {
+            err = errno;
+        }
+    }
+
+    // Send immediately
+    if (err == 0)
+    {
+#ifdef _WIN32
+        const DWORD enable = 1;
+        if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (const char *)&enable, sizeof(enable)) != 0)
+#else
+        const int enable = 1;
+        if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable)) != 0)
+#endif
+        {
+            PORT_WARNING("Failed setting TCP_NODELAY option: %s", _portErrStr(port, 0));
+            port->connecting = false;
+            _portCloseTcp(port);
+            return PORT_OPEN_FAIL;
+        }
+        port->connecting = false;
+        port->addrFails = 0;
+        return PORT_OPEN_OK;
+    }
+
+    PORT_WARNING("Failed connecting: %s", _portErrStr(port, err));
+    port->connecting = false;
+    _portCloseTcp(port);
+    _portTcpAddrFailed(port);
+    return PORT_OPEN_FAIL;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portOpenTcp(PORT_t *port)
+{
+    // Try all addresses (if the name resolves to more than one, e.g. IPv6 and IPv4 for localhost)
+    PORT_OPEN_t res = PORT_OPEN_FAIL;
+    int attempt = 0;
+    do
+    {
+        if (!_portTcpConnectStart(port))
+        {
+            return false;
+        }
+        res = PORT_OPEN_PENDING;
+        while (res == PORT_OPEN_PENDING)
+        {
+            res = _portTcpConnectCheck(port, 100);
+        }
+        attempt++;
+    }
+    while ( (res == PORT_OPEN_FAIL) && (attempt < port->addrNum) );
+
+    return res == PORT_OPEN_OK;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void _portCloseTcp(PORT_t *port)
+{
+#ifdef _WIN32
+    closesocket((SOCKET)port->handle);
+    _winsockDeinit(port);
+#else
+    if (port->fd >= 0)
+    {
+        close(port->fd);
+        port->fd = -1;
+    }
+#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portWriteTcp(PORT_t *port, const uint8_t *data, const int size)
+{
+    if (port->txBuf != NULL)
+    {
+        return _portTxEnqueue(port, data, size);
+    }
+
+    int rem = size;
+    int offs = 0;
+    while (rem > 0)
+    {
+        const int sendSize = rem > TCPIP_MAX_PACKET_SIZE ? TCPIP_MAX_PACKET_SIZE : rem;
+
+        // Throttle. The remote device will not have infinite buffers. So don't send faster than the remote
+        // serial port at this baudrate can transmit. Assume 11 bits per character to be on the safe side.
+        const int dt = TIME() - port->lastTime;
+        const int reqDt = port->baudrate != 0 ? (port->lastCount * 1000 / (port->baudrate / 11)) : 0;
+        const int wait = reqDt - dt;
+        if (wait > 0)
+        {
+            SLEEP(wait);
+        }
+
+#ifdef _WIN32
+        const int res = send((SOCKET)port->handle, (const char *)&data[offs], sendSize, 0);
+#else
+        const int res = send(port->fd, &data[offs], sendSize, 0);
+#endif
+
+        port->lastTime = TIME();
+        port->lastCount = sendSize;
+
+        PORT_XTRA_TRACE("tcp send (delay %d) %d -> %d", wait > 0 ? wait : 0, sendSize, res);
+        // FIXME: handle EAGAIN?
+        if ( (res < 0) || (res != sendSize) )
+        {
+            PORT_WARNING_THROTTLE("tcp send fail (%d, %d): %s", sendSize, res, _portErrStr(port, 0));
+            return false;
+        }
+        offs += sendSize;
+        rem  -= sendSize;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portReadTcp(PORT_t *port, uint8_t *data, const int size, int *nRead)
+{
+#ifdef _WIN32
+    const int res = recv((SOCKET)port->handle, (char *)data, size, 0);
+#else
+    const int res = recv(port->fd, data, size, 0);
+#endif
+    PORT_XTRA_TRACE("tpc recv %d -> %d", size, res);
+    // Got data
+    if (res > 0)
+    {
+        *nRead = res;
+        return true;
+    }
+    // No more data at the moment
+#ifdef _WIN32
+    else if ( (res == -1) && (GetLastError() == WSAEWOULDBLOCK) )
+#else
+    else if ( (res == -1) && (errno == EAGAIN) )
+#endif
+    {
+        *nRead = 0;
+        return true;
+    }
+    // Connection closed
+    else if (res == 0)
+    {
+        PORT_WARNING_THROTTLE("tcp recv fail (%d): %s", size, "connection closed");
+        *nRead = 0;
+        return false;
+    }
+    // Error
+    else
+    {
+        PORT_WARNING_THROTTLE("tcp recv fail (%d, %d): %s", size, res, _portErrStr(port, 0));
+        *nRead = 0;
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portCanBaudrateTcp(PORT_t *port)
+{
+    (void)port;
+    return false;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portSetBaudrateTcp(PORT_t *port, const int baudrate)
+{
+    (void)port;
+    (void)baudrate;
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static int _portGetBaudrateTcp(PORT_t *port)
+{
+    (void)port;
+    return 0;
+}
+
+/* **** telnet + comport control **************************************************************** */
+
+// RFC854: Telnet Protocol Specification (https://tools.ietf.org/html/rfc854.html)
+// RFC855: Telnet Option Specifications (https://tools.ietf.org/html/rfc855.html)
+#define TELNET_IAC             255 // command escape
+#define TELNET_COMMAND_WILL    251 // option negotiation
+#define TELNET_COMMAND_WONT    252 // option negotiation
+#define TELNET_COMMAND_DO      253 // option negotiation
+#define TELNET_COMMAND_DONT    254 // option negotiation
+#define TELNET_COMMAND_SB      250 // suboption start
+#define TELNET_COMMAND_SE      240 // suboption end
+#define TELNET_COMMAND_NOP     241 // no operation
+#define TELNET_COMMAND_DM      242 // data mark
+#define TELNET_COMMAND_BRK     243 // terminal break
+#define TELNET_COMMAND_IP      244 // interrupt process
+#define TELNET_COMMAND_AO      245 // abort output
+#define TELNET_COMMAND_AYT     246 // are you there
+#define TELNET_COMMAND_EC      247 // erase character
+#define TELNET_COMMAND_EL      248 // erase line
+#define TELNET_COMMAND_GA      249 // go ahead
+
+// RFC856: Telnet Binary Transmission (https://tools.ietf.org/html/rfc856.html)
+// default: WON'T TRANSMIT-BINARY, DON'T TRANSMIT-BINARY
+#define TELNET_OPTION_TRANSMIT_BINARY      0
+
+// RFC857: Telnet Echo Option (https://tools.ietf.org/html/rfc857.html)
+// default: WON'T ECHO, DON'T ECHO
+#define TELNET_OPTION_ECHO                 1
+
+// RFC858: Telnet Suppress Go Ahead Option (https://tools.ietf.org/html/rfc858.html)
+// default: WON'T SUPPRESS-GO-AHEAD, DON'T SUPPRESS-GO-AHEAD
+#define TELNET_OPTION_SUPPRESS_GO_AHEAD    3
+
+// RFC859: Telnet Status Option (https://tools.ietf.org/html/rfc859.html)
+// default: DON'T STATUS, WON'T STATUS
+#define TELNET_OPTION_STATUS               5
+
+// RFC2217: Telnet Com Port Control Option (https://tools.ietf.org/html/rfc2217.html)
+#define TELNET_OPTION_COM_PORT_OPTION     44
+#define TELNET_CPCO_SIGNATURE              0 // FIXME: is it 0? The RFC doesn't say..
+#define TELNET_CPCO_SET_BAUDRATE           1
+#define TELNET_CPCO_SET_DATASIZE           2
+#define TELNET_CPCO_SET_PARITY             3
+#define TELNET_CPCO_SET_STOPSIZE           4
+#define TELNET_CPCO_SET_CONTROL            5
+#define TELNET_CPCO_NOTIFY_LINESTATE       6
+#define TELNET_CPCO_NOTIFY_MODEMSTATE      7
+#define TELNET_CPCO_FLOWCONTROL_SUSPEND    8
+#define TELNET_CPCO_FLOWCONTROL_RESUME     9
+#define TELNET_CPCO_SET_LINESTATE_MASK    10
+#define TELNET_CPCO_SET_MODEMSTATE_MASK   11
+#define TELNET_CPCO_PURGE_DATA            12
+#define TELNET_CPCO_SERVER_TO_CLIENT_OFFS 100
+
+static const char *_telnetCommandStr(PORT_t *port, const uint8_t command)
+{
+    switch (command)
+    {
+        case TELNET_IAC:          return "IAC";
+        case TELNET_COMMAND_WILL: return "WILL";
+        case TELNET_COMMAND_WONT: return "WONT";
+        case TELNET_COMMAND_DO:   return "DO";
+        case TELNET_COMMAND_DONT: return "DONT";
+        case TELNET_COMMAND_SB:   return "SB";
+        case TELNET_COMMAND_SE:   return "SE";
+        default:
+            snprintf(port->tmp, sizeof(port->tmp), "%d", command);
+            return port->tmp;
+    }
+}
+
+static const char *_telnetOptionStr(PORT_t *port, const uint8_t option)
+{
+    switch (option)
+    {
+        case TELNET_OPTION_TRANSMIT_BINARY:   return "TRANSMIT_BINARY";
+        case TELNET_OPTION_ECHO:              return "ECHO";
+        case TELNET_OPTION_SUPPRESS_GO_AHEAD: return "SUPPRESS_GO_AHEAD";
+        case TELNET_OPTION_STATUS:            return "STATUS";
+        case TELNET_OPTION_COM_PORT_OPTION:   return "COM_PORT_OPTION";
+        default:
+            snprintf(port->tmp, sizeof(port->tmp), "%d", option);
+            return port->tmp;
+    }
+}
+
+static const char *_telnetCpcoStr(PORT_t *port, const uint8_t cpco)
+{
+    const uint8_t _cpco = cpco >= TELNET_CPCO_SERVER_TO_CLIENT_OFFS ?
+        cpco - TELNET_CPCO_SERVER_TO_CLIENT_OFFS : cpco;
+    switch (_cpco)
+    {
+        case TELNET_CPCO_SIGNATURE:           return "SIGNATURE";
+        case TELNET_CPCO_SET_BAUDRATE:        return "SET_BAUDRATE";
+        case TELNET_CPCO_SET_DATASIZE:        return "SET_DATASIZE";
+        case TELNET_CPCO_SET_PARITY:          return "SET_PARITY";
+        case TELNET_CPCO_SET_STOPSIZE:        return "SET_STOPSIZE";
+        case TELNET_CPCO_SET_CONTROL:         return "SET_CONTROL";
+        case TELNET_CPCO_NOTIFY_LINESTATE:    return "NOTIFY_LINESTATE";
+        case TELNET_CPCO_NOTIFY_MODEMSTATE:   return "NOTIFY_MODEMSTATE";
+        case TELNET_CPCO_FLOWCONTROL_SUSPEND: return "FLOWCONTROL_SUSPEND";
+        case TELNET_CPCO_FLOWCONTROL_RESUME:  return "FLOWCONTROL_RESUME";
+        case TELNET_CPCO_SET_LINESTATE_MASK:  return "SET_LINESTATE_MASK";
+        case TELNET_CPCO_SET_MODEMSTATE_MASK: return "SET_MODEMSTATE_MASK";
+        case TELNET_CPCO_PURGE_DATA:          return "PURGE_DATA";
+        default:
+            snprintf(port->tmp, sizeof(port->tmp), "%d", cpco);
+            return port->tmp;
+    }
+}
+
+// options to negotiate
+typedef struct TELNET_OPTION_s
+{
+    uint8_t command;
+    uint8_t option;
+    bool    agree;
+} TELNET_OPTION_t;
+
+typedef struct TELNET_CPCO_s
+{
+    uint8_t cpco;
+    uint8_t arg;
+} TELNET_CPCO_t;
+
+// Bug in some serial port server doesn't like more than 8 IACs in a row (in a packet?)
+//#define TELNET_SEND_MAX_IAC   8
+
+enum { TELNET_STATE_NORMAL, TELNET_STATE_IAC, TELNET_STATE_COMMAND, TELNET_STATE_SUBOPTION };
+
+void _telnetProcessInband(PORT_t *port, uint8_t *buf, int nIn, int *nOut, TELNET_OPTION_t *options, const int nOptions)
+{
+    //TRACE_HEXDUMP(buf, nIn, "nIn=%d", nIn);
+
+    int      state   = port->tnState;
+    uint8_t *inband  = port->tnInband;
+    int      nInband = port->nTnInband;
+
+    const uint8_t *pIn = buf;
+    uint8_t *out = buf;
+    int nO = 0;
+    while (nIn > 0)
+    {
+        // Fast path: pass data up to the next IAC (usually all of it) straight through
+        if (state == TELNET_STATE_NORMAL)
+        {
+            const uint8_t *iac = memchr(pIn, TELNET_IAC, nIn);
+            const int nRun = iac != NULL ? (int)(iac - pIn) : nIn;
+            if (nRun > 0)
+            {
+                if (&out[nO] != pIn)
+                {
+                    memmove(&out[nO], pIn, nRun);
+                }
+                nO  += nRun;
+                pIn += nRun;
+                nIn -= nRun;
+                continue;
+            }
+        }
+
+        //DEBUG("nIn=%d *pIn=%d 0x%02x", nIn, *pIn, *pIn);
+        switch (state)
+        {
+            case TELNET_STATE_NORMAL:
+                if (*pIn == TELNET_IAC)
+                {
+                    state = TELNET_STATE_IAC;
+                }
+                else // normal data
+                {
+                    out[nO++] = *pIn;
+                }
+                break;
+            case TELNET_STATE_IAC:
+                switch (*pIn)
+                {
+                    case TELNET_IAC: // escaped IAC
+                        out[nO++] = TELNET_IAC;
+                        state = TELNET_STATE_NORMAL; // back to normal
+                        break;
+                    case TELNET_COMMAND_WILL:
+                    case TELNET_COMMAND_WONT:
+                    case TELNET_COMMAND_DO:
                     case TELNET_COMMAND_DONT:
                         nInband = 0;
                         inband[nInband++] = *pIn;
@@ -1297,303 +2392,915 @@ void _telnetProcessInband(PORT_t *port, uint8_t *buf, int nIn, int *nOut, TELNET
                 // Overflow case: wait for IAC SE sequence that marks the end of the suboption data
                 if (nInband < 0)
                 {
-                    // We have an IAC, so...
-                    if ( (nInband == -1) && (*pIn == TELNET_IAC) )
-                    {
-                        nInband = -2;
-                    }
-                    else if (nInband == -2)
-                    {
-                        // ...if the next byte is SE, we're done
-                        if (*pIn == TELNET_COMMAND_SE)
-                        {
-                            state = TELNET_STATE_NORMAL;
-                        }
-                        // otherwise go back waiting for IAC
-                        else if (*pIn != TELNET_IAC)
-                        {
-                            nInband = -1;
-                        }
-                        // else: this was another IAC, so try again...
-                    }
+                    // We have an IAC, so...
+                    if ( (nInband == -1) && (*pIn == TELNET_IAC) )
+                    {
+                        nInband = -2;
+                    }
+                    else if (nInband == -2)
+                    {
+                        // ...if the next byte is SE, we're done
+                        if (*pIn == TELNET_COMMAND_SE)
+                        {
+                            state = TELNET_STATE_NORMAL;
+                        }
+                        // otherwise go back waiting for IAC
+                        else if (*pIn != TELNET_IAC)
+                        {
+                            nInband = -1;
+                        }
+                        // else: this was another IAC, so try again...
+                    }
+                }
+                // Collect more data until sequence is complete
+                else
+                {
+                    inband[nInband++] = *pIn;
+                    if ( (inband[nInband - 2] == TELNET_IAC) && (inband[nInband - 1] == TELNET_COMMAND_SE) )
+                    {
+                        if (nInband > 2)
+                        {
+                            nInband -= 2;
+                            PORT_XTRA_TRACE("they say: %-4s %s (+%d)", _telnetCommandStr(port, inband[0]), _telnetOptionStr(port, inband[1]), nInband - 2);
+                            if (inband[1] == TELNET_OPTION_COM_PORT_OPTION)
+                            {
+                                PORT_TRACE("inband CPCO %s %d (0x%02x)", _telnetCpcoStr(port, inband[2]), inband[3], inband[3]);
+                            }
+                        }
+                        // else: inband[] overflow, discard
+                        state = TELNET_STATE_NORMAL;
+                    }
+                }
+                break;
+        }
+        nIn--;
+        pIn++;
+    }
+
+    port->tnState   = state;
+    port->nTnInband = nInband;
+    *nOut = nO;
+}
+
+static bool _portOpenTelnet(PORT_t *port)
+{
+    return _portOpenTcp(port) && _portTelnetSetup(port);
+}
+
+// Negotiate options and configure the port, after the connection has been established
+static bool _portTelnetSetup(PORT_t *port)
+{
+    port->tnState = TELNET_STATE_NORMAL;
+    port->nTnInband = 0;
+
+    uint8_t buf[TCPIP_MAX_PACKET_SIZE];
+
+    // Our offer
+    TELNET_OPTION_t telnetOptions[] =
+    {
+      //{ .agree = false, .command = TELNET_COMMAND_WILL, .option = TELNET_OPTION_SUPPRESS_GO_AHEAD },
+        { .agree = false, .command = TELNET_COMMAND_WILL, .option = TELNET_OPTION_TRANSMIT_BINARY },
+      //{ .agree = false, .command = TELNET_COMMAND_WONT, .option = TELNET_OPTION_ECHO },
+        { .agree = false, .command = TELNET_COMMAND_WILL, .option = TELNET_OPTION_COM_PORT_OPTION },
+      //{ .agree = false, .command = TELNET_COMMAND_DO,   .option = TELNET_OPTION_SUPPRESS_GO_AHEAD },
+        { .agree = false, .command = TELNET_COMMAND_DO,   .option = TELNET_OPTION_TRANSMIT_BINARY },
+      //{ .agree = false, .command = TELNET_COMMAND_DONT, .option = TELNET_OPTION_ECHO },
+        { .agree = false, .command = TELNET_COMMAND_DO,   .option = TELNET_OPTION_COM_PORT_OPTION }
+    };
+
+    // Announce our offer
+    for (int ix = 0; ix < NUMOF(telnetOptions); ix++)
+    {
+        buf[(ix * 3) + 0] = TELNET_IAC;
+        buf[(ix * 3) + 1] = telnetOptions[ix].command;
+        buf[(ix * 3) + 2] = telnetOptions[ix].option;
+        PORT_XTRA_TRACE("we offer: %-4s %s", _telnetCommandStr(port, telnetOptions[ix].command), _telnetOptionStr(port, telnetOptions[ix].option));
+    }
+    if (!_portWriteTcp(port, buf, 3 * NUMOF(telnetOptions)))
+    {
+        _portCloseTcp(port);
+        return false;
+    }
+
+    // Negotiate, process their answer
+    bool happy = false;
+    bool timeout = false;
+    const uint64_t t0 = TIME();
+    const uint64_t t1 = t0 + 1500;
+    while (!happy && !timeout)
+    {
+        if (TIME() > t1)
+        {
+            timeout = true;
+            break;
+        }
+
+        int nRead = 0;
+        if (!_portReadTcp(port, buf, sizeof(buf), &nRead))
+        {
+            break;
+        }
+        if (nRead == 0)
+        {
+            SLEEP(10);
+            continue;
+        }
+
+        int nOut = 0;
+        _telnetProcessInband(port, buf, nRead, &nOut, telnetOptions, NUMOF(telnetOptions));
+
+        PORT_XTRA_TRACE("State of negotiations:");
+        happy = true;
+        for (int ix = 0; ix < NUMOF(telnetOptions); ix++)
+        {
+            PORT_XTRA_TRACE("%d %-4s %-20s %s", ix, _telnetCommandStr(port, telnetOptions[ix].command),
+                _telnetOptionStr(port, telnetOptions[ix].option), telnetOptions[ix].agree ? ":-)" : ":-(");
+            if (!telnetOptions[ix].agree)
+            {
+                happy = false;
+            }
+        }
+        PORT_XTRA_TRACE("We %s happy", happy ? "are" : "are not (yet)");
+    }
+    if (!happy || timeout)
+    {
+        if (timeout)
+        {
+            PORT_WARNING("Timeout negotiating telnet options!");
+        }
+        else
+        {
+            PORT_WARNING("Failed negotiating telnet options!");
+        }
+        for (int ix = 0; ix < NUMOF(telnetOptions); ix++)
+        {
+            if (!telnetOptions[ix].agree)
+            {
+                PORT_DEBUG("Not agreeing on: %s %s", _telnetCommandStr(port, telnetOptions[ix].command),
+                _telnetOptionStr(port, telnetOptions[ix].option));
+            }
+        }
+        _portCloseTcp(port);
+        return false;
+    }
+
+    // Configure port
+    static const TELNET_CPCO_t kTelnetCpco[] =
+    {
+        { .cpco = TELNET_CPCO_SET_DATASIZE,        .arg = 8 }, // 8
+        { .cpco = TELNET_CPCO_SET_PARITY,          .arg = 1 }, // N
+        { .cpco = TELNET_CPCO_SET_STOPSIZE,        .arg = 1 }, // 1
+        { .cpco = TELNET_CPCO_SET_CONTROL,         .arg = 1 }, // no flow control
+        { .cpco = TELNET_CPCO_SET_MODEMSTATE_MASK, .arg = 0 },
+        { .cpco = TELNET_CPCO_SET_LINESTATE_MASK,  .arg = 0 }  // FIXME: maybe we should watch some of these?
+    };
+    for (int ix = 0; ix < NUMOF(kTelnetCpco); ix++)
+    {
+        buf[(ix * 6) + 0] = TELNET_IAC;
+        buf[(ix * 6) + 1] = TELNET_COMMAND_SB;
+        buf[(ix * 6) + 2] = TELNET_OPTION_COM_PORT_OPTION;
+        buf[(ix * 6) + 3] = kTelnetCpco[ix].cpco;
+        buf[(ix * 6) + 4] = kTelnetCpco[ix].arg;
+        buf[(ix * 6) + 5] = TELNET_COMMAND_SE;
+    }
+    if (!_portWriteTcp(port, buf, 6 * NUMOF(kTelnetCpco)) ||
+        !_portSetBaudrateTelnet(port, port->baudrate))
+    {
+        PORT_WARNING("Failed configuring port!");
+        _portCloseTcp(port);
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void _portCloseTelnet(PORT_t *port)
+{
+    _portCloseTcp(port);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portWriteTelnet(PORT_t *port, const uint8_t *data, const int size)
+{
+    uint8_t buf[TCPIP_MAX_PACKET_SIZE];
+    int nData = size;
+    const uint8_t *pData = data;
+    int nBuf = 0;
+    int nIac = 0;
+    while (nData > 0)
+    {
+        // Fill buf, escape IAC
+        if (*pData == TELNET_IAC)
+        {
+            // Enough space for 2 x IAC
+            if (nBuf < (int)(sizeof(buf) - 1))
+            {
+                buf[nBuf++] = TELNET_IAC;
+                buf[nBuf++] = TELNET_IAC;
+                pData++;
+                nData--;
+#ifdef TELNET_SEND_MAX_IAC
+                nIac++;
+#endif
+            }
+            // Only one byte left, trigger send
+            else
+            {
+                nIac = -1;
+            }
+        }
+        // Fill buf, normal byte
+        else
+        {
+            buf[nBuf++] = *pData;
+            pData++;
+            nData--;
+        }
+
+        // Send data now?
+        if ( (nBuf >= (int)sizeof(buf)) ||
+#ifdef TELNET_SEND_MAX_IAC
+             (nIac >= TELNET_SEND_MAX_IAC) ||
+#endif
+             (nIac < 0) || ((nData <= 0) && (nBuf > 0)) )
+        {
+            PORT_XTRA_TRACE("telnet send %d (nIac=%d)", nBuf, nIac);
+            if (!_portWriteTcp(port, buf, nBuf))
+            {
+                return false;
+            }
+            nBuf = 0;
+            nIac = 0;
+        }
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portReadTelnet(PORT_t *port, uint8_t *data, const int size, int *nRead)
+{
+    int nIn = 0;
+    if (_portReadTcp(port, data, size, &nIn))
+    {
+       int nOut = 0;
+        _telnetProcessInband(port, data, nIn, &nOut, NULL, 0);
+        *nRead = nOut;
+        return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portCanBaudrateTelnet(PORT_t *port)
+{
+    (void)port;
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portSetBaudrateTelnet(PORT_t *port, const int baudrate)
+{
+    const uint32_t b = (uint32_t)baudrate;
+    uint8_t buf[] =
+    {
+        TELNET_IAC, TELNET_COMMAND_SB,
+        TELNET_OPTION_COM_PORT_OPTION, TELNET_CPCO_SET_BAUDRATE,
+        ((b >> 24) & 0xff),
+        ((b >> 16) & 0xff),
+        ((b >>  8) & 0xff),
+        ( b        & 0xff),
+        TELNET_IAC, TELNET_COMMAND_SE
+    };
+    const bool res = _portWriteTcp(port, buf, sizeof(buf));
+    if (res)
+    {
+        port->baudrate = baudrate;
+    }
+    return res;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static int _portGetBaudrateTelnet(PORT_t *port)
+{
+    return port->baudrate;
+}
+
+/* ***** file, fd, unix and pty ports ********************************************************* */
+
+static bool _portOpenFd(PORT_t *port)
+{
+#ifdef _WIN32
+    PORT_WARNING("not supported");
+    return false;
+#else
+    port->eof = false;
+    port->fileOffs = 0;
+    port->fdOut = -1;
+    port->ptySlave = -1;
+    switch (port->type)
+    {
+        // Recorded file, replayed by _portReadFd()
+        case PORT_TYPE_FILE:
+            port->fd = open(port->file, O_RDONLY);
+            if (port->fd < 0)
+            {
+                PORT_WARNING("Failed opening file: %s", _portErrStr(port, 0));
+                return false;
+            }
+            port->lastTime = TIME();
+            break;
+
+        // Existing file descriptor(s), not ours to close
+        case PORT_TYPE_FD:
+        {
+            const bool stdio = (strcmp(port->file, "-") == 0);
+            port->fd    = stdio ? STDIN_FILENO  : atoi(port->file);
+            port->fdOut = stdio ? STDOUT_FILENO : port->fd;
+            port->fdFlags = fcntl(port->fd, F_GETFL);
+            if ( (port->fdFlags == -1) || (fcntl(port->fd, F_SETFL, port->fdFlags | O_NONBLOCK) == -1) )
+            {
+                PORT_WARNING("Bad file descriptor: %s", _portErrStr(port, 0));
+                return false;
+            }
+            break;
+        }
+
+        // Unix domain socket
+        case PORT_TYPE_UNIX:
+        {
+            struct sockaddr_un addr = { .sun_family = AF_UNIX };
+            if (strlen(port->file) >= sizeof(addr.sun_path))
+            {
+                PORT_WARNING("Path too long");
+                return false;
+            }
+            strcpy(addr.sun_path, port->file);
+            port->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (port->fd < 0)
+            {
+                PORT_WARNING("Failed creating socket: %s", _portErrStr(port, 0));
+                return false;
+            }
+            if (connect(port->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+            {
+                PORT_WARNING("Failed connecting: %s", _portErrStr(port, 0));
+                close(port->fd);
+                return false;
+            }
+            fcntl(port->fd, F_SETFL, fcntl(port->fd, F_GETFL) | O_NONBLOCK);
+            break;
+        }
+
+        // Pseudo terminal, other programs use the slave device (via the symlink) as if it were a serial port
+        case PORT_TYPE_PTY:
+        {
+            struct stat st;
+            if ( (lstat(port->file, &st) == 0) && !S_ISLNK(st.st_mode) )
+            {
+                PORT_WARNING("Path exists and is not a symlink");
+                return false;
+            }
+            port->fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+            const char *slave = port->fd < 0 ? NULL : ptsname(port->fd);
+            if ( (port->fd < 0) || (grantpt(port->fd) != 0) || (unlockpt(port->fd) != 0) || (slave == NULL) )
+            {
+                PORT_WARNING("Failed creating pty: %s", _portErrStr(port, 0));
+                if (port->fd >= 0)
+                {
+                    close(port->fd);
                 }
-                // Collect more data until sequence is complete
-                else
+                return false;
+            }
+            struct termios tio;
+            if (tcgetattr(port->fd, &tio) == 0)
+            {
+                cfmakeraw(&tio);
+                tcsetattr(port->fd, TCSANOW, &tio);
+            }
+            port->ptySlave = open(slave, O_RDWR | O_NOCTTY);
+            unlink(port->file);
+            if ( (port->ptySlave < 0) || (symlink(slave, port->file) != 0) )
+            {
+                PORT_WARNING("Failed creating symlink to %s: %s", slave, _portErrStr(port, 0));
+                if (port->ptySlave >= 0)
                 {
-                    inband[nInband++] = *pIn;
-                    if ( (inband[nInband - 2] == TELNET_IAC) && (inband[nInband - 1] == TELNET_COMMAND_SE) )
-                    {
-                        if (nInband > 2)
-                        {
-                            nInband -= 2;
-                            PORT_XTRA_TRACE("they say: %-4s %s (+%d)", _telnetCommandStr(port, inband[0]), _telnetOptionStr(port, inband[1]), nInband - 2);
-                            if (inband[1] == TELNET_OPTION_COM_PORT_OPTION)
-                            {
-                                PORT_TRACE("inband CPCO %s %d (0x%02x)", _telnetCpcoStr(port, inband[2]), inband[3], inband[3]);
-                            }
-                        }
-                        // else: inband[] overflow, discard
-                        state = TELNET_STATE_NORMAL;
-                    }
+                    close(port->ptySlave);
                 }
-                break;
+                close(port->fd);
+                return false;
+            }
+            PORT_DEBUG("pty %s", slave);
+            break;
         }
-        nIn--;
-        pIn++;
+
+        case PORT_TYPE_SER:
+        case PORT_TYPE_TCP:
+        case PORT_TYPE_TELNET:
+        case PORT_TYPE_TCPSRV:
+            return false;
     }
+    return true;
+#endif
+}
 
-    port->tnState   = state;
-    port->nTnInband = nInband;
-    *nOut = nO;
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The baudrate the other side has set on the slave device (a pty has no actual baudrate, but it stores the setting)
+static int _portGetBaudratePty(PORT_t *port)
+{
+#ifdef _WIN32
+    (void)port;
+    return 0;
+#else
+    if (!port->portOk)
+    {
+        return 0;
+    }
+#  if PORT_HAVE_TERMIOS2
+    struct termios2 settings2;
+    if (ioctl(port->ptySlave, TCGETS2, &settings2) == 0)
+    {
+        return settings2.c_ospeed;
+    }
+#  endif
+    struct termios settings;
+    if (tcgetattr(port->ptySlave, &settings) == 0)
+    {
+        const int      rates[]  = { PORT_BAUDRATES };
+        const uint32_t values[] = { PORT_BAUDVALUES };
+        const speed_t  speed    = cfgetospeed(&settings);
+        for (int ix = 0; ix < NUMOF(rates); ix++)
+        {
+            if (speed == values[ix])
+            {
+                return rates[ix];
+            }
+        }
+    }
+    return 0;
+#endif
 }
 
-static bool _portOpenTelnet(PORT_t *port)
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void _portCloseFd(PORT_t *port)
 {
-    if (!_portOpenTcp(port))
+#ifdef _WIN32
+    (void)port;
+#else
+    switch (port->type)
     {
-        return false;
+        case PORT_TYPE_FD:
+            fcntl(port->fd, F_SETFL, port->fdFlags);
+            break;
+        case PORT_TYPE_PTY:
+            unlink(port->file);
+            close(port->ptySlave);
+            close(port->fd);
+            break;
+        case PORT_TYPE_FILE:
+        case PORT_TYPE_UNIX:
+        case PORT_TYPE_SER:
+        case PORT_TYPE_TCP:
+        case PORT_TYPE_TELNET:
+        case PORT_TYPE_TCPSRV:
+            close(port->fd);
+            break;
     }
-    port->tnState = TELNET_STATE_NORMAL;
-    port->nTnInband = 0;
+#endif
+}
 
-    uint8_t buf[TCPIP_MAX_PACKET_SIZE];
+// ---------------------------------------------------------------------------------------------------------------------
 
-    // Our offer
-    TELNET_OPTION_t telnetOptions[] =
+static bool _portWriteFd(PORT_t *port, const uint8_t *data, const int size)
+{
+#ifdef _WIN32
+    (void)port;
+    (void)data;
+    (void)size;
+    return false;
+#else
+    if (port->txBuf != NULL)
     {
-      //{ .agree = false, .command = TELNET_COMMAND_WILL, .option = TELNET_OPTION_SUPPRESS_GO_AHEAD },
-        { .agree = false, .command = TELNET_COMMAND_WILL, .option = TELNET_OPTION_TRANSMIT_BINARY },
-      //{ .agree = false, .command = TELNET_COMMAND_WONT, .option = TELNET_OPTION_ECHO },
-        { .agree = false, .command = TELNET_COMMAND_WILL, .option = TELNET_OPTION_COM_PORT_OPTION },
-      //{ .agree = false, .command = TELNET_COMMAND_DO,   .option = TELNET_OPTION_SUPPRESS_GO_AHEAD },
-        { .agree = false, .command = TELNET_COMMAND_DO,   .option = TELNET_OPTION_TRANSMIT_BINARY },
-      //{ .agree = false, .command = TELNET_COMMAND_DONT, .option = TELNET_OPTION_ECHO },
-        { .agree = false, .command = TELNET_COMMAND_DO,   .option = TELNET_OPTION_COM_PORT_OPTION }
-    };
+        return _portTxEnqueue(port, data, size);
+    }
 
-    // Announce our offer
-    for (int ix = 0; ix < NUMOF(telnetOptions); ix++)
+    // The file descriptor may be non-blocking, wait a bit for the other side
+    int offs = 0;
+    while (offs < size)
     {
-        buf[(ix * 3) + 0] = TELNET_IAC;
-        buf[(ix * 3) + 1] = telnetOptions[ix].command;
-        buf[(ix * 3) + 2] = telnetOptions[ix].option;
-        PORT_XTRA_TRACE("we offer: %-4s %s", _telnetCommandStr(port, telnetOptions[ix].command), _telnetOptionStr(port, telnetOptions[ix].option));
+        const int res = _portTxRaw(port, &data[offs], size - offs);
+        PORT_XTRA_TRACE("write %d -> %d", size - offs, res);
+        if (res > 0)
+        {
+            offs += res;
+        }
+        else if ( (res < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) )
+        {
+            struct pollfd pfd = { .fd = port->type == PORT_TYPE_FD ? port->fdOut : port->fd, .events = POLLOUT };
+            if (poll(&pfd, 1, 1000) == 0)
+            {
+                PORT_WARNING_THROTTLE("write timeout (%d/%d)", offs, size);
+                return false;
+            }
+        }
+        else
+        {
+            PORT_WARNING_THROTTLE("write fail (%d, %d): %s", size, res, _portErrStr(port, 0));
+            return false;
+        }
     }
-    if (!_portWriteTcp(port, buf, 3 * NUMOF(telnetOptions)))
+    return true;
+#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portReadFd(PORT_t *port, uint8_t *data, const int size, int *nRead)
+{
+#ifdef _WIN32
+    (void)port;
+    (void)data;
+    (void)size;
+    (void)nRead;
+    return false;
+#else
+    if (port->eof)
+    {
+        return false;
+    }
+
+    // Replay paced at the baudrate (10 bits per character)
+    int readSize = size;
+    if ( (port->type == PORT_TYPE_FILE) && (port->baudrate > 0) )
+    {
+        const uint64_t due = ((TIME() - port->lastTime) * port->baudrate) / (10 * 1000);
+        readSize = due > port->fileOffs ? MIN((uint64_t)size, due - port->fileOffs) : 0;
+        if (readSize == 0)
+        {
+            *nRead = 0;
+            return true;
+        }
+    }
+
+    const int res = read(port->fd, data, readSize);
+    PORT_XTRA_TRACE("read %d -> %d", readSize, res);
+    if (res > 0)
+    {
+        port->fileOffs += res;
+        *nRead = res;
+        return true;
+    }
+    // No more data at the moment. For a pty this includes the other side having closed the slave device.
+    else if ( (res < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR) ||
+                            ((port->type == PORT_TYPE_PTY) && (errno == EIO))) )
+    {
+        *nRead = 0;
+        return true;
+    }
+    // End of file (or pipe closed)
+    else if ( (res == 0) && ((port->type == PORT_TYPE_FILE) || (port->type == PORT_TYPE_FD)) )
+    {
+        PORT_DEBUG("end of file (%" PRIu64 " bytes)", port->fileOffs);
+        port->eof = true;
+        *nRead = 0;
+        return false;
+    }
+    // Error (or unix socket closed)
+    else
     {
-        _portCloseTcp(port);
+        PORT_WARNING_THROTTLE("read fail (%d, %d): %s", readSize, res, res == 0 ? "closed" : _portErrStr(port, 0));
+        *nRead = 0;
         return false;
     }
+#endif
+}
 
-    // Negotiate, process their answer
-    bool happy = false;
-    bool timeout = false;
-    const uint64_t t0 = TIME();
-    const uint64_t t1 = t0 + 1500;
-    while (!happy && !timeout)
-    {
-        if (TIME() > t1)
+/* ***** tcp server ***************************************************************************** */
+
+#ifndef _WIN32
+
+STATIC_ASSERT((PORT_TCPSRV_BUF_SIZE & (PORT_TCPSRV_BUF_SIZE - 1)) == 0);
+
+typedef struct PORT_TCPSRV_CLIENT_s
+{
+    int       fd;
+    uint64_t  offs;                       // Position in the shared buffer up to which data was sent
+    char      addr[64];
+} PORT_TCPSRV_CLIENT_t;
+
+typedef struct PORT_TCPSRV_s
+{
+    uint8_t   buf[PORT_TCPSRV_BUF_SIZE];  // Shared buffer, data is written once and sent from here to all clients
+    uint64_t  head;                       // Total number of bytes written (position in the shared buffer)
+    int       numClients;
+    PORT_TCPSRV_CLIENT_t clients[PORT_TCPSRV_MAX_CLIENTS];
+    int       readIx;                     // Next client to read from (round-robin)
+} PORT_TCPSRV_t;
+
+static void _portTcpsrvRemove(PORT_t *port, const int ix, const char *reason)
+{
+    PORT_TCPSRV_t *srv = port->srv;
+    PORT_DEBUG("client %s %s (%d clients)", srv->clients[ix].addr, reason, srv->numClients - 1);
+    close(srv->clients[ix].fd);
+    srv->numClients--;
+    srv->clients[ix] = srv->clients[srv->numClients];
+}
+
+// Send pending data to a client, returns false if it failed (and the client was removed)
+static bool _portTcpsrvFlush(PORT_t *port, const int ix)
+{
+    PORT_TCPSRV_t *srv = port->srv;
+    PORT_TCPSRV_CLIENT_t *client = &srv->clients[ix];
+    while (client->offs < srv->head)
+    {
+        const uint32_t start = client->offs & (PORT_TCPSRV_BUF_SIZE - 1);
+        const uint32_t size = MIN(srv->head - client->offs, PORT_TCPSRV_BUF_SIZE - start);
+        const int res = send(client->fd, &srv->buf[start], size, MSG_NOSIGNAL);
+        if (res > 0)
+        {
+            client->offs += res;
+        }
+        else if ( (res < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) )
         {
-            timeout = true;
             break;
         }
+        else
+        {
+            _portTcpsrvRemove(port, ix, "send fail");
+            return false;
+        }
+    }
+    return true;
+}
 
-        int nRead = 0;
-        if (!_portReadTcp(port, buf, sizeof(buf), &nRead))
+static void _portTcpsrvAccept(PORT_t *port)
+{
+    PORT_TCPSRV_t *srv = port->srv;
+    while (true)
+    {
+        struct sockaddr_storage sa;
+        socklen_t saLen = sizeof(sa);
+        const int fd = accept(port->fd, (struct sockaddr *)&sa, &saLen);
+        if (fd < 0)
         {
             break;
         }
-        if (nRead == 0)
+        char host[NI_MAXHOST] = "";
+        char serv[NI_MAXSERV] = "";
+        getnameinfo((struct sockaddr *)&sa, saLen, host, sizeof(host), serv, sizeof(serv), NI_NUMERICHOST | NI_NUMERICSERV);
+        if (srv->numClients >= PORT_TCPSRV_MAX_CLIENTS)
         {
-            SLEEP(10);
+            PORT_WARNING_THROTTLE("too many clients, rejecting %s:%s", host, serv);
+            close(fd);
             continue;
         }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        PORT_TCPSRV_CLIENT_t *client = &srv->clients[srv->numClients];
+        client->fd = fd;
+        client->offs = srv->head;
+        snprintf(client->addr, sizeof(client->addr), "%s:%s", host, serv);
+        srv->numClients++;
+        PORT_DEBUG("client %s connected (%d clients)", client->addr, srv->numClients);
+    }
+}
 
-        int nOut = 0;
-        _telnetProcessInband(port, buf, nRead, &nOut, telnetOptions, NUMOF(telnetOptions));
+#endif // !_WIN32
 
-        PORT_XTRA_TRACE("State of negotiations:");
-        happy = true;
-        for (int ix = 0; ix < NUMOF(telnetOptions); ix++)
-        {
-            PORT_XTRA_TRACE("%d %-4s %-20s %s", ix, _telnetCommandStr(port, telnetOptions[ix].command),
-                _telnetOptionStr(port, telnetOptions[ix].option), telnetOptions[ix].agree ? ":-)" : ":-(");
-            if (!telnetOptions[ix].agree)
-            {
-                happy = false;
-            }
-        }
-        PORT_XTRA_TRACE("We %s happy", happy ? "are" : "are not (yet)");
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portOpenTcpsrv(PORT_t *port)
+{
+#ifdef _WIN32
+    PORT_WARNING("not supported");
+    return false;
+#else
+    struct addrinfo *result;
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags    = AI_PASSIVE;
+    char portNrStr[20];
+    snprintf(portNrStr, sizeof(portNrStr), "%d", port->port);
+    const int res = getaddrinfo(port->file[0] != '\0' ? port->file : NULL, portNrStr, &hints, &result);
+    if (res != 0)
+    {
+        PORT_WARNING("Failed getting address: %s", gai_strerror(res));
+        return false;
     }
-    if (!happy || timeout)
+
+    int fd = -1;
+    for (struct addrinfo *rp = result; rp != NULL; rp = rp->ai_next)
     {
-        if (timeout)
-        {
-            PORT_WARNING("Timeout negotiating telnet options!");
-        }
-        else
+        fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+        if (fd < 0)
         {
-            PORT_WARNING("Failed negotiating telnet options!");
+            continue;
         }
-        for (int ix = 0; ix < NUMOF(telnetOptions); ix++)
+        const int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if ( (bind(fd, rp->ai_addr, rp->ai_addrlen) == 0) && (listen(fd, PORT_TCPSRV_MAX_CLIENTS) == 0) )
         {
-            if (!telnetOptions[ix].agree)
-            {
-                PORT_DEBUG("Not agreeing on: %s %s", _telnetCommandStr(port, telnetOptions[ix].command),
-                _telnetOptionStr(port, telnetOptions[ix].option));
-            }
+            break;
         }
-        _portCloseTcp(port);
-        return false;
+        PORT_WARNING("Failed listening: %s", _portErrStr(port, 0));
+        close(fd);
+        fd = -1;
     }
-
-    // Configure port
-    static const TELNET_CPCO_t kTelnetCpco[] =
-    {
-        { .cpco = TELNET_CPCO_SET_DATASIZE,        .arg = 8 }, // 8
-        { .cpco = TELNET_CPCO_SET_PARITY,          .arg = 1 }, // N
-        { .cpco = TELNET_CPCO_SET_STOPSIZE,        .arg = 1 }, // 1
-        { .cpco = TELNET_CPCO_SET_CONTROL,         .arg = 1 }, // no flow control
-        { .cpco = TELNET_CPCO_SET_MODEMSTATE_MASK, .arg = 0 },
-        { .cpco = TELNET_CPCO_SET_LINESTATE_MASK,  .arg = 0 }  // FIXME: maybe we should watch some of these?
-    };
-    for (int ix = 0; ix < NUMOF(kTelnetCpco); ix++)
+    freeaddrinfo(result);
+    if (fd < 0)
     {
-        buf[(ix * 6) + 0] = TELNET_IAC;
-        buf[(ix * 6) + 1] = TELNET_COMMAND_SB;
-        buf[(ix * 6) + 2] = TELNET_OPTION_COM_PORT_OPTION;
-        buf[(ix * 6) + 3] = kTelnetCpco[ix].cpco;
-        buf[(ix * 6) + 4] = kTelnetCpco[ix].arg;
-        buf[(ix * 6) + 5] = TELNET_COMMAND_SE;
+        return false;
     }
-    if (!_portWriteTcp(port, buf, 6 * NUMOF(kTelnetCpco)) ||
-        !_portSetBaudrateTelnet(port, port->baudrate))
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    port->srv = calloc(1, sizeof(PORT_TCPSRV_t));
+    if (port->srv == NULL)
     {
-        PORT_WARNING("Failed configuring port!");
-        _portCloseTcp(port);
+        PORT_WARNING("malloc fail");
+        close(fd);
         return false;
     }
-
+    port->fd = fd;
     return true;
+#endif
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 
-static void _portCloseTelnet(PORT_t *port)
-{
-    _portCloseTcp(port);
-}
-
-// ---------------------------------------------------------------------------------------------------------------------
-
-static bool _portWriteTelnet(PORT_t *port, const uint8_t *data, const int size)
+static void _portCloseTcpsrv(PORT_t *port)
 {
-    uint8_t buf[TCPIP_MAX_PACKET_SIZE];
-    int nData = size;
-    const uint8_t *pData = data;
-    int nBuf = 0;
-    int nIac = 0;
-    while (nData > 0)
+#ifdef _WIN32
+    (void)port;
+#else
+    // Try sending pending data
+    const uint64_t t1 = TIME() + 1000;
+    PORT_TCPSRV_t *srv = port->srv;
+    while ( (srv->numClients > 0) && (TIME() < t1) )
     {
-        // Fill buf, escape IAC
-        if (*pData == TELNET_IAC)
+        bool pending = false;
+        for (int ix = srv->numClients - 1; ix >= 0; ix--)
         {
-            // Enough space for 2 x IAC
-            if (nBuf < (int)(sizeof(buf) - 1))
-            {
-                buf[nBuf++] = TELNET_IAC;
-                buf[nBuf++] = TELNET_IAC;
-                pData++;
-                nData--;
-#ifdef TELNET_SEND_MAX_IAC
-                nIac++;
-#endif
-            }
-            // Only one byte left, trigger send
-            else
+            if (_portTcpsrvFlush(port, ix) && (srv->clients[ix].offs < srv->head))
             {
-                nIac = -1;
+                pending = true;
             }
         }
-        // Fill buf, normal byte
-        else
+        if (!pending)
         {
-            buf[nBuf++] = *pData;
-            pData++;
-            nData--;
+            break;
         }
-
-        // Send data now?
-        if ( (nBuf >= (int)sizeof(buf)) ||
-#ifdef TELNET_SEND_MAX_IAC
-             (nIac >= TELNET_SEND_MAX_IAC) ||
+        SLEEP(10);
+    }
+    while (srv->numClients > 0)
+    {
+        _portTcpsrvRemove(port, srv->numClients - 1, "closed");
+    }
+    free(port->srv);
+    port->srv = NULL;
+    close(port->fd);
 #endif
-             (nIac < 0) || ((nData <= 0) && (nBuf > 0)) )
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static bool _portWriteTcpsrv(PORT_t *port, const uint8_t *data, const int size)
+{
+#ifdef _WIN32
+    (void)port;
+    (void)data;
+    (void)size;
+    return false;
+#else
+    PORT_TCPSRV_t *srv = port->srv;
+    if (size > PORT_TCPSRV_BUF_SIZE)
+    {
+        PORT_WARNING_THROTTLE("write too large (%d)", size);
+        return false;
+    }
+
+    // Disconnect clients that would lose data
+    for (int ix = srv->numClients - 1; ix >= 0; ix--)
+    {
+        if ((srv->head + size - srv->clients[ix].offs) > PORT_TCPSRV_BUF_SIZE)
         {
-            PORT_XTRA_TRACE("telnet send %d (nIac=%d)", nBuf, nIac);
-            if (!_portWriteTcp(port, buf, nBuf))
-            {
-                return false;
-            }
-            nBuf = 0;
-            nIac = 0;
+            PORT_WARNING("client %s too slow", srv->clients[ix].addr);
+            _portTcpsrvRemove(port, ix, "evicted");
         }
     }
 
+    // Add data to the shared buffer
+    const uint32_t start = srv->head & (PORT_TCPSRV_BUF_SIZE - 1);
+    const uint32_t size1 = MIN((uint32_t)size, PORT_TCPSRV_BUF_SIZE - start);
+    memcpy(&srv->buf[start], data, size1);
+    if ((uint32_t)size > size1)
+    {
+        memcpy(srv->buf, &data[size1], size - size1);
+    }
+    srv->head += size;
+
+    // Send to clients
+    for (int ix = srv->numClients - 1; ix >= 0; ix--)
+    {
+        _portTcpsrvFlush(port, ix);
+    }
     return true;
+#endif
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 
-static bool _portReadTelnet(PORT_t *port, uint8_t *data, const int size, int *nRead)
+static bool _portReadTcpsrv(PORT_t *port, uint8_t *data, const int size, int *nRead)
 {
-    int nIn = 0;
-    if (_portReadTcp(port, data, size, &nIn))
+#ifdef _WIN32
+    (void)port;
+    (void)data;
+    (void)size;
+    (void)nRead;
+    return false;
+#else
+    PORT_TCPSRV_t *srv = port->srv;
+
+    // Read from the next client that has data
+    *nRead = 0;
+    for (int n = srv->numClients; (n > 0) && (srv->numClients > 0); n--)
     {
-       int nOut = 0;
-        _telnetProcessInband(port, data, nIn, &nOut, NULL, 0);
-        *nRead = nOut;
-        return true;
+        const int ix = srv->readIx % srv->numClients;
+        srv->readIx = ix + 1;
+        const int res = recv(srv->clients[ix].fd, data, size, 0);
+        if (res > 0)
+        {
+            *nRead = res;
+            break;
+        }
+        else if ( (res == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) )
+        {
+            _portTcpsrvRemove(port, ix, res == 0 ? "disconnected" : "recv fail");
+        }
     }
-    return false;
+    return true;
+#endif
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 
-static bool _portCanBaudrateTelnet(PORT_t *port)
+#ifndef _WIN32
+static int _portTcpsrvPollFds(PORT_t *port, struct pollfd *pfds)
 {
-    (void)port;
-    return true;
+    // Wait for connections, data from clients, or clients ready to accept pending data
+    PORT_TCPSRV_t *srv = port->srv;
+    pfds[0] = (struct pollfd){ .fd = port->fd, .events = POLLIN, .revents = 0 };
+    for (int ix = 0; ix < srv->numClients; ix++)
+    {
+        pfds[ix + 1] = (struct pollfd){ .fd = srv->clients[ix].fd,
+            .events = POLLIN | (srv->clients[ix].offs < srv->head ? POLLOUT : 0), .revents = 0 };
+    }
+    return srv->numClients + 1;
 }
 
-// ---------------------------------------------------------------------------------------------------------------------
-
-static bool _portSetBaudrateTelnet(PORT_t *port, const int baudrate)
+static bool _portTcpsrvPollDone(PORT_t *port, const struct pollfd *pfds, const int numPfds)
 {
-    const uint32_t b = (uint32_t)baudrate;
-    uint8_t buf[] =
+    // Clients, backwards, as removing a client moves the last one into its place
+    bool readable = false;
+    for (int ix = numPfds - 1; ix > 0; ix--)
     {
-        TELNET_IAC, TELNET_COMMAND_SB,
-        TELNET_OPTION_COM_PORT_OPTION, TELNET_CPCO_SET_BAUDRATE,
-        ((b >> 24) & 0xff),
-        ((b >> 16) & 0xff),
-        ((b >>  8) & 0xff),
-        ( b        & 0xff),
-        TELNET_IAC, TELNET_COMMAND_SE
-    };
-    const bool res = _portWriteTcp(port, buf, sizeof(buf));
-    if (res)
+        if ( ((pfds[ix].revents & POLLOUT) != 0) && !_portTcpsrvFlush(port, ix - 1) )
+        {
+            continue;
+        }
+        if ((pfds[ix].revents & ~POLLOUT) != 0)
+        {
+            readable = true;
+        }
+    }
+    // New connections
+    if (pfds[0].revents != 0)
     {
-        port->baudrate = baudrate;
+        _portTcpsrvAccept(port);
     }
-    return res;
+    return readable;
 }
+#endif
 
 // ---------------------------------------------------------------------------------------------------------------------
 
-static int _portGetBaudrateTelnet(PORT_t *port)
+int portTcpsrvNumClients(const PORT_t *port)
 {
-    return port->baudrate;
+#ifdef _WIN32
+    (void)port;
+    return 0;
+#else
+    return (port != NULL) && (port->srv != NULL) ? port->srv->numClients : 0;
+#endif
 }
 
 #if 0
@@ -34,16 +34,67 @@ extern "C" {
 #  define PORT_BAUDVALUES  B9600, B19200, B38400, B57600, B115200, B230400, B460800, B921600
 #endif
 
+// Other baudrates in this range are possible on Linux and Windows
+#define PORT_BAUDRATE_MIN   1200
+#define PORT_BAUDRATE_MAX   12000000
+
 #define PORT_SPEC_MAX_LEN 256
 
 typedef enum PORT_TYPE_e
 {
-    PORT_TYPE_SER,    // Serial ports: ser://<device>[@baudrate]
+    PORT_TYPE_SER,    // Serial ports: ser://<device>[@baudrate][?lowlat]
     PORT_TYPE_TCP,    // TCP/IP sockets: tcp://<host>:<port>
-    PORT_TYPE_TELNET  // TCP/IP sockets with telnet (RFC854 etc.) and com port control (RFC2217): telnet://<host>:<port>[@<baudrate>]
-  //PORT_TYPE_HANDLE  // Use existing file handle (or pair of file handles, such as stdin/stdout)
+    PORT_TYPE_TELNET, // TCP/IP sockets with telnet (RFC854 etc.) and com port control (RFC2217): telnet://<host>:<port>[@<baudrate>]
+    PORT_TYPE_FILE,   // Replay of a recorded file, as fast as possible or paced at the baudrate: file://<path>[@<baudrate>]
+    PORT_TYPE_FD,     // Existing file descriptor, or stdin/stdout: fd://<fd> resp. fd://-
+    PORT_TYPE_UNIX,   // Unix domain (stream) sockets: unix://<path>
+    PORT_TYPE_PTY,    // Pseudo terminal, with a symlink to the slave device: pty://<path>
+    PORT_TYPE_TCPSRV, // TCP/IP server, writes go to all clients, reads come from any client: tcpsrv://[<addr>]:<port>
 } PORT_TYPE_t;
 
+#define PORT_STATS_HIST_SIZE 12 // Number of bins of the bytes per read histogram
+
+//! Port I/O statistics (see portGetStats())
+typedef struct PORT_STATS_s
+{
+    uint64_t    rxBytes;       // Number of bytes read
+    uint64_t    txBytes;       // Number of bytes written
+    uint32_t    numReads;      // Number of reads that returned data
+    uint32_t    numReadsEmpty; // Number of reads that returned no data
+    uint32_t    numWrites;     // Number of (successful) writes
+    uint32_t    readHist[PORT_STATS_HIST_SIZE]; // Bytes per read: bin n counts reads of 2^n...2^(n+1)-1 bytes (the last
+                                                // bin counts all larger reads)
+    // Read latency: time from portWaitReadable() reporting data to portRead() getting it (how quickly the host serves
+    // the port, e.g. delays due to processing, scheduling or a busy system)
+    uint32_t    readLatMax;    // Maximum read latency [us]
+    uint32_t    readLatMean;   // Mean read latency [us]
+    // Rates since the previous portGetStats() (resp. since the port was first opened)
+    double      rxRate;        // Bytes read per second
+    double      txRate;        // Bytes written per second
+    double      readRate;      // Reads (that returned data) per second
+    int         txPending;     // Bytes pending in the transmit queue (see portSetTxQueue())
+    int         txHighWater;   // Maximum bytes pending in the transmit queue
+    uint32_t    txNumFull;     // Number of writes rejected because the transmit queue was full
+    uint32_t    numOpens;      // Number of successful portOpen() (i.e. reconnects + 1)
+    // Serial line errors since portOpen() (TIOCGICOUNT, Linux only, and only if the driver supports it)
+    bool        haveIcount;    // The following counts are available
+    uint32_t    frameErrors;   // Framing errors (e.g. wrong baudrate, noise on the line)
+    uint32_t    parityErrors;  // Parity errors
+    uint32_t    breaks;        // Break conditions
+    uint32_t    overruns;      // UART (hardware FIFO) overruns, i.e. the driver did not serve the UART in time
+    uint32_t    bufOverruns;   // tty buffer overruns, i.e. the application did not read the port in time
+} PORT_STATS_t;
+
+#define PORT_MAX_ADDRS 4 // Maximum number of resolved addresses cached (tcp, telnet)
+
+typedef struct PORT_ADDR_s
+{
+    uint64_t    addr[16];   // struct sockaddr_storage
+    int         addrLen;
+    int         family;
+    int         proto;
+} PORT_ADDR_t;
+
 typedef struct PORT_s
 {
     PORT_TYPE_t type;
@@ -51,32 +102,128 @@ typedef struct PORT_s
     uint32_t    numTx;
     bool        portOk;
     int         baudrate;
+    bool        lowLatency; // serial: low-latency mode (ASYNC_LOW_LATENCY, FTDI latency timer)
     char        file[PORT_SPEC_MAX_LEN];
 #ifdef _WIN32
     void       *handle;
 #else
     int         fd;
+    int         fdOut;      // fd: file descriptor for writing
+    int         fdFlags;    // fd: original file status flags
+    int         ptySlave;   // pty: slave side, kept open so that the master does not see hangups
 #endif
+    bool        eof;        // file, fd: end of file reached, others: hung up (see hangup)
+    bool        hangup;     // poll() saw a hangup or error, the next read that gets no data fails
+    uint64_t    fileOffs;   // file: number of bytes replayed (for pacing)
+    struct PORT_TCPSRV_s *srv; // tcpsrv: server state
     // tcp
     uint16_t    port;
     uint64_t    lastTime;
     int         lastCount;
+    PORT_ADDR_t addrs[PORT_MAX_ADDRS]; // tcp, telnet: resolved addresses, cached for reconnecting
+    int         addrNum;    // number of resolved addresses (0 = resolve name)
+    int         addrIx;     // which of the resolved addresses to use (advances when connecting fails)
+    int         addrFails;  // number of consecutive connect failures since resolving
+    uint64_t    addrTime;   // time the name was resolved [ms]
+    bool        connecting; // tcp, telnet: connection in progress (see portOpenAsync())
+    uint64_t    connectTime;// time connecting started [ms]
     // telnet
     int         tnState;
     uint8_t     tnInband[12];
     int         nTnInband;
     char        tmp[PORT_SPEC_MAX_LEN + 32];
     uint32_t    lastWarn;
+    // transmit queue (see portSetTxQueue())
+    int         txSize;     // size of the queue [bytes] (0 = disabled)
+    uint8_t    *txBuf;      // queue buffer (allocated by portOpen() if txSize > 0)
+    int         txOffs;     // offset of pending data in the queue
+    int         txLen;      // pending data [bytes]
+    int         txHighWater;// maximum pending data [bytes]
+    uint32_t    txNumFull;  // number of portWrite() rejected because the queue was full
+    uint64_t    txNextTime; // earliest time for the next send (throttling of tcp and telnet ports)
+    // statistics (see portGetStats())
+    PORT_STATS_t stats;     // counters (the other fields are filled in by portGetStats())
+    uint64_t    statsTime;  // time of the previous portGetStats() (resp. portOpen()) [ms]
+    uint64_t    statsRx;    // stats.rxBytes at statsTime
+    uint64_t    statsTx;    // stats.txBytes at statsTime
+    uint32_t    statsReads; // stats.numReads at statsTime
+    uint64_t    readableTime; // time portWaitReadable() reported data [us] (0 = not pending)
+    uint64_t    readLatSum; // sum of read latencies [us]
+    uint32_t    readLatNum; // number of read latencies
+    uint32_t    icountBase[5]; // serial line error counts at portOpen() (frame, parity, brk, overrun, buf_overrun)
 } PORT_t;
 
 bool portInit(PORT_t *port, const char *spec);
 bool portOpen(PORT_t *port);
+
+#define PORT_CONNECT_TIMEOUT   5000 // Timeout for establishing a connection (tcp and telnet ports) [ms]
+#define PORT_RESOLVE_INTERVAL 30000 // Minimum time before resolving the name again, once all addresses failed [ms]
+
+typedef enum PORT_OPEN_e
+{
+    PORT_OPEN_FAIL,    // Failed
+    PORT_OPEN_PENDING, // In progress, call portOpenAsync() again later (e.g. after portWaitReadable())
+    PORT_OPEN_OK,      // Port is open
+} PORT_OPEN_t;
+
+// Non-blocking open: For tcp and telnet ports, this starts connecting, resp. checks if the connection has been
+// established. portWaitReadable() waits for that. Once connected, telnet option negotiation still blocks (typically for
+// a few milliseconds, up to 1.5s). Other ports are opened like portOpen(). The address of tcp and telnet ports is
+// resolved on the first connect and cached. If connecting fails, the next attempt resolves the name again and uses the
+// next address.
+PORT_OPEN_t portOpenAsync(PORT_t *port);
 void portClose(PORT_t *port);
 bool portWrite(PORT_t *port, const uint8_t *data, const int size);
 bool portRead(PORT_t *port, uint8_t *data, const int size, int *read);
 bool portCanBaudrate(PORT_t *port);
 bool portSetBaudrate(PORT_t *port, const int baudrate);
-int portGetBaudrate(PORT_t *port);
+int portGetBaudrate(PORT_t *port); // pty: the baudrate the other side has set (0 = n/a)
+
+// Get an identifier of the port and the device behind it, e.g. to cache information about the device. For serial ports
+// on Linux this includes the USB vendor, product and serial number (if available), or the physical (sysfs) path of the
+// device, so that it changes when a different device is plugged into the same port. Returns false if the identifier
+// does not fit into id.
+bool portGetDeviceId(PORT_t *port, char *id, const int size);
+
+// Wait until data is available for reading (or the port has an error), up to timeout [ms]. Returns true if
+// portRead() should be called, false on timeout (or if interrupted by a signal).
+bool portWaitReadable(PORT_t *port, const uint32_t timeout);
+
+// Wait for several ports at once, like portWaitReadable(), up to timeout [ms]. Sets readable[ix] if portRead() should
+// be called for ports[ix] (NULL entries are ignored). Returns true if any port is readable.
+#define PORT_WAIT_MAX_PORTS 4 // Maximum number of ports for portWaitReadableMulti()
+bool portWaitReadableMulti(PORT_t * const *ports, const int numPorts, const uint32_t timeout, bool *readable);
+
+// Transmit queue (not on Windows): With a queue, portWrite() does not block. It adds the data to the queue and sends as
+// much as the port accepts right away. The rest is sent later (coalesced into fewer, larger writes) by portRead(),
+// portWaitReadable() and portFlush(). portWrite() fails if the queue is full (backpressure), in which case none of the
+// data is queued. The queue size must be set before portOpen(). portClose() tries to send pending data.
+bool portSetTxQueue(PORT_t *port, const int size);
+
+// Send pending data, waiting up to timeout [ms] (0 = don't wait) for the port to accept it. Returns true if the queue
+// is empty (or there is no queue), false otherwise.
+bool portFlush(PORT_t *port, const uint32_t timeout);
+
+// Number of bytes pending in the transmit queue
+int portTxPending(const PORT_t *port);
+
+// Time [ms] until sending pending data is allowed again (throttling of tcp and telnet ports), 0 = not throttled
+uint32_t portTxThrottle(const PORT_t *port);
+
+// Get I/O statistics. The rates are calculated over the time since the previous call (resp. since the port was first
+// opened). The counters are kept across portClose() and portOpen() (reconnects), the serial line error counts are
+// reset by portOpen(). Returns false if the port has never been opened.
+bool portGetStats(PORT_t *port, PORT_STATS_t *stats);
+
+// TCP/IP server (tcpsrv://): Data written is stored once in a shared buffer from which it is sent to each client
+// without blocking. Clients that fall behind by more than the buffer size are disconnected. Clients that connect get
+// the data written after they connected. New clients are accepted, and data is sent to clients that could not take it
+// right away, in portWaitReadable() (resp. portWaitReadableMulti()). That must be called regularly.
+#define PORT_TCPSRV_MAX_CLIENTS 32           // Maximum number of clients
+#define PORT_TCPSRV_BUF_SIZE    (256 * 1024) // Size of the shared buffer [bytes] (must be a power of 2)
+
+// Number of connected clients
+int portTcpsrvNumClients(const PORT_t *port);
 
 /* ****************************************************************************************************************** */
 #ifdef __cplusplus
@@ -22,10 +22,20 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#ifdef __linux__
+#  include <sys/epoll.h>
+#endif
+#ifndef _WIN32
+#  include <pthread.h>
+#endif
 
 #include "ff_debug.h"
 #include "ff_stuff.h"
 #include "ff_ubx.h"
+#include "ff_rtcm3.h"
 #include "ff_parser.h"
 #include "ff_port.h"
 #include "ff_rx.h"
@@ -48,6 +58,33 @@
 
 // ---------------------------------------------------------------------------------------------------------------------
 
+#define RX_SUB_HASH_BITS 6 // Subscriptions hash table size (2^bits buckets)
+
+typedef struct RX_SUB_s
+{
+    uint64_t     key;            // Message key (see _rxMsgKey()), 0 = unused
+    RX_SUB_CB_t  cb;
+    void        *arg;
+    uint8_t      next;           // Next subscription in the hash bucket (index + 1), 0 = none
+} RX_SUB_t;
+
+typedef struct RX_APOLL_s
+{
+    int          id;             // Poll ID, 0 = unused
+    RX_POLL_CB_t cb;
+    void        *arg;
+    uint8_t      clsId;
+    uint8_t      msgId;
+    int          respSizeMin;
+    uint32_t     timeout;        // 0 = automatic (see _rxRttTimeout())
+    int          retries;
+    int          attempt;
+    uint64_t     sent;           // Time of the first attempt (TIME())
+    uint64_t     deadline;       // Response due (TIME())
+    int          reqSize;
+    uint8_t      req[RX_POLL_MAX_PAYLOAD + UBX_FRAME_SIZE];
+} RX_APOLL_t;
+
 typedef struct RX_s
 {
     RX_OPTS_t    opts;
@@ -59,8 +96,40 @@ typedef struct RX_s
     char         name[100];
     bool         abort;
     char         detectInfo[100];
+    struct RX_RING_s *ring;
+    uint64_t     ringTs;
+    bool         reconnecting;   // Port failed, reconnecting (see RX_OPTS_t.reconnect)
+    bool         reconnectRing;  // Restart the reader thread after reconnecting
+    uint64_t     reconnectTime;  // Time of the next reconnect attempt
+    uint32_t     reconnectDelay; // Current delay between reconnect attempts [ms]
+    uint64_t     rand;           // PRNG state (reconnect jitter)
+    char         cacheKey[PORT_SPEC_MAX_LEN + 200]; // Key for the detection cache (see RX_OPTS_t.cacheFile)
+    uint32_t     upshiftId;      // CFG-UARTx-BAUDRATE changed by rxUpshift(), 0 = none
+    int          upshiftOrig;    // Original baudrate
+    int          upshiftBaudrate; // Upshifted baudrate
+    RX_SUB_t     subs[RX_MAX_SUBS]; // Subscriptions
+    uint8_t      subHash[1 << RX_SUB_HASH_BITS]; // First subscription in bucket (index + 1), 0 = none
+    int          numSubs;
+    RX_APOLL_t   polls[RX_MAX_POLLS]; // Asynchronous polls
+    int          numPolls;
+    int          pollSeq;        // Last poll ID
+    bool         dispatching;    // In a subscription or poll callback
+    double       srtt;           // Smoothed round-trip time [ms] (see _rxRttSample())
+    double       rttvar;         // Round-trip time variation [ms]
+    uint32_t     rttNum;         // Number of round-trip time samples, 0 = none (use default timeouts)
+    uint32_t     rttLast;        // Last round-trip time sample [ms]
+    uint32_t     rttMin;         // Minimum round-trip time sample [ms]
+    uint32_t     rttMax;         // Maximum round-trip time sample [ms]
 } RX_t;
 
+static bool _rxRingStart(RX_t *rx);
+static bool _rxRingStop(RX_t *rx);
+static bool _rxRingGet(RX_t *rx);
+static bool _rxRingWait(RX_t *rx, const uint32_t timeout);
+static bool _rxRingFailed(RX_t *rx);
+static void _rxRingLockPort(RX_t *rx);
+static void _rxRingUnlockPort(RX_t *rx);
+
 RX_t *rxInit(const char *port, const RX_OPTS_t *opts)
 {
     if (port == NULL)
@@ -92,6 +161,9 @@ RX_t *rxInit(const char *port, const RX_OPTS_t *opts)
         rx->opts.name = rx->name;
         instCnt++;
     }
+    // Different for each process and receiver, so that clients that lose the connection at the same time don't
+    // reconnect in lockstep
+    rx->rand = ((uint64_t)time(NULL) << 32) ^ ((uint64_t)getpid() << 16) ^ (uintptr_t)rx;
     RX_PRINT("Connecting to receiver at port %s", port);
 
     // Initialise parser
@@ -104,6 +176,20 @@ RX_t *rxInit(const char *port, const RX_OPTS_t *opts)
         return NULL;
     }
 
+    // Transmit queue, not with the reader thread, which waits for the port without holding the port lock (and it would
+    // flush the queue while waiting)
+    if (rx->opts.txQueueSize > 0)
+    {
+        if (rx->opts.ringSize > 0)
+        {
+            RX_WARNING("Transmit queue not supported with reader thread");
+        }
+        else
+        {
+            portSetTxQueue(&rx->port, rx->opts.txQueueSize);
+        }
+    }
+
     RX_DEBUG("init detect=%d autobaud=%d baudrate=%d", rx->opts.detect, rx->opts.autobaud, rx->opts.baudrate);
 
     return rx;
@@ -128,6 +214,14 @@ bool rxOpen(RX_t *rx)
         return false;
     }
 
+    // Replay of a recorded file: there is no receiver to detect, and all data should go to the caller (at the pace
+    // the caller consumes it, so no reader thread)
+    if (rx->port.type == PORT_TYPE_FILE)
+    {
+        rx->opts.detect = RX_DET_NONE;
+        rx->opts.ringSize = 0;
+    }
+
     // We can only do this once the port is open
     rxSetBaudrate(rx, rx->opts.baudrate);
     if (rx->opts.autobaud && !portCanBaudrate(&rx->port))
@@ -144,9 +238,27 @@ bool rxOpen(RX_t *rx)
         return false;
     }
 
+    if (rx->opts.ringSize > 0)
+    {
+        _rxRingStart(rx);
+    }
+
     return true;
 }
 
+// Passive baudrate estimation: Sample the data the receiver outputs (if any) at a candidate baudrate and score it by
+// how much of it parses into valid messages. At a wrong baudrate the data is garbage and there are framing errors
+// (serial ports with TIOCGICOUNT only), which count as (lost) garbage bytes.
+#define RX_AUTOBAUD_SAMPLE_TIME   1100 // Maximum time to sample at each baudrate [ms] (covers 1Hz output)
+#define RX_AUTOBAUD_PRECHECK_TIME 300  // Maximum time to sample at the initial baudrate before the first detection [ms]
+#define RX_AUTOBAUD_SAMPLE_BYTES  512  // Stop sampling after this many bytes
+#define RX_AUTOBAUD_SAMPLE_MSGS   2    // Stop sampling after this many valid messages
+#define RX_AUTOBAUD_SAMPLE_IDLE   100  // Stop sampling when the line is idle this long after some data [ms]
+#define RX_AUTOBAUD_SCORE_MIN     0.5  // Minimum score (fraction of bytes in valid messages) for a likely baudrate
+#define RX_AUTOBAUD_SCORE_GOOD    0.9  // Score above which no other baudrates are sampled
+#define RX_AUTOBAUD_ESTIMATE_TIME 1500 // Maximum time to sample all baudrates [ms]
+#define RX_AUTOBAUD_ESTIMATE_BAD  2    // Stop sampling after this many baudrates with garbage
+
 static bool _rxDetect(RX_t *rx)
 {
     bool detected = false;
@@ -181,17 +293,55 @@ static bool _rxDetect(RX_t *rx)
     return detected;
 }
 
+static double _rxAutobaudSample(RX_t *rx, const int baudrate, const uint32_t timeout, int *nBytes, int *nMsgs);
+static bool _rxAutobaud(RX_t *rx, const bool estimate);
+static bool _rxCacheGet(RX_t *rx, int *baudrate, char *info, const int infoSize);
+static void _rxCachePut(RX_t *rx);
+
 static bool _rxOpenDetect(RX_t *rx)
 {
+    // Try the cached settings first
+    int cachedBaudrate = 0;
+    char cachedInfo[sizeof(rx->detectInfo)];
+    if (_rxCacheGet(rx, &cachedBaudrate, cachedInfo, sizeof(cachedInfo)))
+    {
+        const int baudrate = rxGetBaudrate(rx);
+        if ( ((cachedBaudrate == 0) || rxSetBaudrate(rx, cachedBaudrate)) && _rxDetect(rx) )
+        {
+            RX_PRINT("Receiver detected (cached): %s", rx->detectInfo);
+            if (strcmp(cachedInfo, rx->detectInfo) != 0)
+            {
+                _rxCachePut(rx);
+            }
+            return true;
+        }
+        RX_DEBUG("Cached settings (baudrate %d) failed", cachedBaudrate);
+        rxSetBaudrate(rx, baudrate);
+    }
+
+    // Don't bother with the quick first try if what the receiver outputs at the current baudrate is garbage (a silent
+    // receiver only costs the short sampling time here)
+    bool garbage = false;
+    bool silent = false;
+    if (rx->opts.autobaud && (rx->opts.detect != RX_DET_NONE))
+    {
+        int nBytes = 0;
+        int nMsgs = 0;
+        const double score = _rxAutobaudSample(rx, rxGetBaudrate(rx), RX_AUTOBAUD_PRECHECK_TIME, &nBytes, &nMsgs);
+        garbage = (nBytes > 0) && (score < RX_AUTOBAUD_SCORE_MIN);
+        silent = nBytes == 0;
+    }
+
     // Quick first try, which may just work..
-    if (_rxDetect(rx))
+    if (!garbage && _rxDetect(rx))
     {
         RX_PRINT("Receiver detected: %s", rx->detectInfo);
+        _rxCachePut(rx);
         return true;
     }
 
-    // Try different baudrates
-    if (rx->opts.autobaud && !rxAutobaud(rx))
+    // Try different baudrates (no point in estimating the baudrate if the line is silent)
+    if (rx->opts.autobaud && !_rxAutobaud(rx, !silent))
     {
         RX_WARNING("Failed autobauding!");
         return false;
@@ -208,6 +358,7 @@ static bool _rxOpenDetect(RX_t *rx)
         {
             RX_PRINT("Receiver detected: %s", rx->detectInfo);
         }
+        _rxCachePut(rx);
         return true;
     }
 
@@ -216,6 +367,123 @@ static bool _rxOpenDetect(RX_t *rx)
 
 // ---------------------------------------------------------------------------------------------------------------------
 
+// Cache file lines: <key> TAB <baudrate> TAB <detect> TAB <detectInfo> LF
+
+static bool _rxCacheEnabled(RX_t *rx)
+{
+    if ( (rx->opts.cacheFile == NULL) || (rx->opts.cacheFile[0] == '\0') || (rx->opts.detect == RX_DET_NONE) )
+    {
+        return false;
+    }
+    if (rx->cacheKey[0] == '\0')
+    {
+        portGetDeviceId(&rx->port, rx->cacheKey, sizeof(rx->cacheKey));
+        // Tabs and newlines would break the file format
+        rx->cacheKey[strcspn(rx->cacheKey, "\t\r\n")] = '\0';
+    }
+    return rx->cacheKey[0] != '\0';
+}
+
+static bool _rxCacheGet(RX_t *rx, int *baudrate, char *info, const int infoSize)
+{
+    if (!_rxCacheEnabled(rx))
+    {
+        return false;
+    }
+    FILE *f = fopen(rx->opts.cacheFile, "r");
+    if (f == NULL)
+    {
+        return false;
+    }
+    bool res = false;
+    char line[sizeof(rx->cacheKey) + sizeof(rx->detectInfo) + 50];
+    const int keyLen = strlen(rx->cacheKey);
+    while (!res && (fgets(line, sizeof(line), f) != NULL))
+    {
+        int detect = -1;
+        int offs = 0;
+        if ( (strncmp(line, rx->cacheKey, keyLen) == 0) && (line[keyLen] == '\t') &&
+             (sscanf(&line[keyLen + 1], "%d\t%d\t%n", baudrate, &detect, &offs) == 2) && (offs > 0) &&
+             (detect == (int)rx->opts.detect) )
+        {
+            char *str = &line[keyLen + 1 + offs];
+            str[strcspn(str, "\r\n")] = '\0';
+            snprintf(info, infoSize, "%s", str);
+            res = true;
+        }
+    }
+    fclose(f);
+    RX_DEBUG("Cache %s: %s", res ? "hit" : "miss", rx->cacheKey);
+    return res;
+}
+
+static void _rxCachePut(RX_t *rx)
+{
+    if (!_rxCacheEnabled(rx))
+    {
+        return;
+    }
+    // Keep the other entries (up to the maximum, dropping the oldest), and add ours at the end
+    char line[sizeof(rx->cacheKey) + sizeof(rx->detectInfo) + 50];
+    const int lineSize = sizeof(line);
+    char *lines = malloc(RX_CACHE_MAX_ENTRIES * lineSize);
+    if (lines == NULL)
+    {
+        return;
+    }
+    int nLines = 0;
+    FILE *f = fopen(rx->opts.cacheFile, "r");
+    if (f != NULL)
+    {
+        const int keyLen = strlen(rx->cacheKey);
+        while (fgets(line, sizeof(line), f) != NULL)
+        {
+            if ( (line[0] == '\0') || (line[strlen(line) - 1] != '\n') ||
+                 ((strncmp(line, rx->cacheKey, keyLen) == 0) && (line[keyLen] == '\t')) )
+            {
+                continue;
+            }
+            if (nLines >= (RX_CACHE_MAX_ENTRIES - 1))
+            {
+                memmove(lines, &lines[lineSize], (nLines - 1) * lineSize);
+                nLines--;
+            }
+            memcpy(&lines[nLines * lineSize], line, lineSize);
+            nLines++;
+        }
+        fclose(f);
+    }
+    snprintf(&lines[nLines * lineSize], lineSize, "%s\t%d\t%d\t%s\n", rx->cacheKey,
+        portCanBaudrate(&rx->port) ? rxGetBaudrate(rx) : 0, (int)rx->opts.detect, rx->detectInfo);
+    nLines++;
+
+    // Replace the file atomically, other processes may be using it, too
+    char tmpFile[PATH_MAX];
+    snprintf(tmpFile, sizeof(tmpFile), "%s.%d", rx->opts.cacheFile, (int)getpid());
+    f = fopen(tmpFile, "w");
+    bool res = (f != NULL);
+    for (int ix = 0; res && (ix < nLines); ix++)
+    {
+        res = (fputs(&lines[ix * lineSize], f) >= 0);
+    }
+    if (f != NULL)
+    {
+        res = (fclose(f) == 0) && res;
+    }
+    if (!res || (rename(tmpFile, rx->opts.cacheFile) != 0))
+    {
+        RX_WARNING("Failed writing cache %s: %s", rx->opts.cacheFile, strerror(errno));
+        remove(tmpFile);
+    }
+    else
+    {
+        RX_DEBUG("Cache update: %s", rx->cacheKey);
+    }
+    free(lines);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
 static void _rxCallbackData(RX_t *rx, const PARSER_MSGSRC_t src, const uint8_t *buf, const int size)
 {
     if (rx->opts.msgcb != NULL)
@@ -245,14 +513,104 @@ static void _rxCallbackMsg(RX_t *rx, PARSER_MSG_t *msg)
     }
 }
 
+static void _rxCallbackVirtual(RX_t *rx, const char *name, const char *info)
+{
+    if (rx->opts.msgcb != NULL)
+    {
+        PARSER_MSG_t msg =
+        {
+            .type = PARSER_MSGTYPE_GARBAGE, .data = (const uint8_t *)info, .size = strlen(info), .seq = 0,
+            .ts = TIME(), .src = PARSER_MSGSRC_VIRTUAL, .name = name, .info = info
+        };
+        rx->opts.msgcb(&msg, rx->opts.cbarg);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+// xorshift64*
+static uint64_t _rxRandom(RX_t *rx)
+{
+    rx->rand ^= rx->rand >> 12;
+    rx->rand ^= rx->rand << 25;
+    rx->rand ^= rx->rand >> 27;
+    return rx->rand * UINT64_C(2685821657736338717);
+}
+
+// Next reconnect delay, with "equal jitter": half of it fixed, the other half random
+static uint64_t _rxReconnectJitter(RX_t *rx, const uint32_t delay)
+{
+    return (delay / 2) + ((_rxRandom(rx) >> 32) % ((delay / 2) + 1));
+}
+
+// The port failed, close it and schedule reconnecting. Returns false if not reconnecting.
+static bool _rxDisconnected(RX_t *rx)
+{
+    if ( !rx->opts.reconnect || ((rx->port.type != PORT_TYPE_TCP) && (rx->port.type != PORT_TYPE_TELNET)) )
+    {
+        return false;
+    }
+    rx->reconnectRing = _rxRingStop(rx);
+    portClose(&rx->port);
+    rx->reconnecting = true;
+    rx->reconnectDelay = RX_RECONNECT_DELAY_MIN;
+    rx->reconnectTime = TIME() + _rxReconnectJitter(rx, rx->reconnectDelay);
+    RX_WARNING("Connection lost, reconnecting...");
+    _rxCallbackVirtual(rx, RX_MSGNAME_DISCONNECTED, "connection lost");
+    return true;
+}
+
+// Attempt to reconnect, returns true if the connection has been re-established
+static bool _rxReconnect(RX_t *rx)
+{
+    if (!rx->port.connecting && (TIME() < rx->reconnectTime))
+    {
+        return false;
+    }
+    switch (portOpenAsync(&rx->port))
+    {
+        case PORT_OPEN_PENDING:
+            return false;
+        case PORT_OPEN_FAIL:
+            rx->reconnectDelay = MIN(2 * rx->reconnectDelay, RX_RECONNECT_DELAY_MAX);
+            rx->reconnectTime = TIME() + _rxReconnectJitter(rx, rx->reconnectDelay);
+            RX_DEBUG("reconnect failed, next attempt in %u ms", (uint32_t)(rx->reconnectTime - TIME()));
+            return false;
+        case PORT_OPEN_OK:
+            break;
+    }
+    rx->reconnecting = false;
+    if (rx->reconnectRing)
+    {
+        _rxRingStart(rx);
+    }
+    RX_PRINT("Reconnected");
+    _rxCallbackVirtual(rx, RX_MSGNAME_RECONNECTED, "connection re-established");
+    return true;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 
+static void _rxUpshiftRestore(RX_t *rx);
+
 void rxClose(RX_t *rx)
 {
     if (rx != NULL)
     {
         rx->abort = false;
+        for (int ix = 0; ix < RX_MAX_POLLS; ix++)
+        {
+            rxPollCancel(rx, rx->polls[ix].id);
+        }
+        if (rx->rttNum > 0)
+        {
+            RX_DEBUG("rtt: %u samples, min %u, max %u, srtt %.1f, rttvar %.1f [ms]", rx->rttNum, rx->rttMin, rx->rttMax,
+                rx->srtt, rx->rttvar);
+        }
+        _rxUpshiftRestore(rx);
+        _rxRingStop(rx);
         portClose(&rx->port);
+        rx->reconnecting = false;
     }
 }
 
@@ -271,18 +629,64 @@ bool rxSend(RX_t *rx, const uint8_t *data, const int size)
     if ( (rx != NULL) && !rx->abort )
     {
         _rxCallbackData(rx, PARSER_MSGSRC_TO_RX, data, size);
-        return portWrite(&rx->port, data, size);
+        _rxRingLockPort(rx);
+        const bool res = portWrite(&rx->port, data, size);
+        _rxRingUnlockPort(rx);
+        return res;
     }
     return false;
 }
 
+bool rxIsEof(RX_t *rx)
+{
+    return (rx != NULL) && rx->port.eof;
+}
+
+bool rxIsConnected(RX_t *rx)
+{
+    return (rx != NULL) && rx->port.portOk;
+}
+
+bool rxGetTxQueueStats(RX_t *rx, RX_TXQ_STATS_t *stats)
+{
+    if ( (rx == NULL) || (stats == NULL) )
+    {
+        return false;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (rx->port.txBuf != NULL)
+    {
+        stats->size      = rx->port.txSize;
+        stats->pending   = rx->port.txLen;
+        stats->highWater = rx->port.txHighWater;
+        stats->numFull   = rx->port.txNumFull;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+bool rxGetPortStats(RX_t *rx, PORT_STATS_t *stats)
+{
+    if ( (rx == NULL) || (stats == NULL) )
+    {
+        return false;
+    }
+    _rxRingLockPort(rx);
+    const bool res = portGetStats(&rx->port, stats);
+    _rxRingUnlockPort(rx);
+    return res;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 
 int rxGetBaudrate(RX_t *rx)
 {
     if (rx != NULL)
     {
-        int res = portGetBaudrate(&rx->port);
+        _rxRingLockPort(rx);
+        const int res = portGetBaudrate(&rx->port);
+        _rxRingUnlockPort(rx);
         return res;
     }
     return 0;
@@ -294,30 +698,208 @@ bool rxSetBaudrate(RX_t *rx, const int baudrate)
 {
     if (rx != NULL)
     {
-        return portSetBaudrate(&rx->port, baudrate);
+        // The round-trip times depend on the baudrate (and we may be talking to a different receiver port now)
+        rx->rttNum = 0;
+        _rxRingLockPort(rx);
+        const bool res = portSetBaudrate(&rx->port, baudrate);
+        _rxRingUnlockPort(rx);
+        return res;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+#define RX_UPSHIFT_ACK_TIMEOUT 500 // Timeout for the acknowledgement of the baudrate change [ms]
+
+static bool _rxFlushRx(RX_t *rx);
+
+// Change the baudrate of a receiver UART (RAM layer only). The receiver switches once the acknowledgement is out, so
+// it may well be lost or garbled.
+static bool _rxSetUartBaudrate(RX_t *rx, const uint32_t id, const int baudrate)
+{
+    const UBLOXCFG_KEYVAL_t kv = { .id = id, .val = { .U4 = baudrate } };
+    int nMsgs = 0;
+    UBX_CFG_VALSET_MSG_t *msgs = ubxKeyValToUbxCfgValset(&kv, 1, true, false, false, &nMsgs);
+    if (msgs == NULL)
+    {
+        return false;
+    }
+    const bool res = (nMsgs == 1) && rxSendUbxCfg(rx, msgs[0].msg, msgs[0].size, RX_UPSHIFT_ACK_TIMEOUT);
+    free(msgs);
+    return res;
+}
+
+static bool _rxUpshift(RX_t *rx, const int baudrate, const int newBaudrate)
+{
+    // Find the receiver port we're connected to, which must be a UART configured to the current baudrate
+    const uint32_t keys[] = { UBLOXCFG_CFG_UART1_BAUDRATE_ID, UBLOXCFG_CFG_UART2_BAUDRATE_ID };
+    UBLOXCFG_KEYVAL_t kv[NUMOF(keys)];
+    const int nKv = rxGetConfig(rx, UBLOXCFG_LAYER_RAM, keys, NUMOF(keys), kv, NUMOF(kv));
+
+    // Try each candidate. If both UARTs are at the current baudrate, the wrong one continues to work at the old
+    // baudrate, in which case we undo the change and try the other one.
+    for (int ix = 0; !rx->abort && (ix < nKv); ix++)
+    {
+        if (kv[ix].val.U4 != (uint32_t)baudrate)
+        {
+            continue;
+        }
+        const char *uart = (kv[ix].id == UBLOXCFG_CFG_UART1_BAUDRATE_ID ? "UART1" : "UART2");
+        RX_PRINT("Changing baudrate of %s from %d to %d", uart, baudrate, newBaudrate);
+        _rxSetUartBaudrate(rx, kv[ix].id, newBaudrate);
+
+        char verStr[50];
+        if (rxSetBaudrate(rx, newBaudrate) && _rxFlushRx(rx) && rxGetVerStr(rx, verStr, sizeof(verStr)))
+        {
+            rx->upshiftId       = kv[ix].id;
+            rx->upshiftOrig     = baudrate;
+            rx->upshiftBaudrate = newBaudrate;
+            return true;
+        }
+
+        RX_DEBUG("No response at baudrate %d, reverting %s", newBaudrate, uart);
+        rxSetBaudrate(rx, baudrate);
+        _rxFlushRx(rx);
+        if (!_rxSetUartBaudrate(rx, kv[ix].id, baudrate))
+        {
+            RX_WARNING("Lost receiver while changing baudrate!");
+            _rxAutobaud(rx, true);
+            return false;
+        }
     }
+
+    RX_WARNING("Failed changing baudrate of the receiver (not connected to a UART?)");
     return false;
 }
 
+bool rxUpshift(RX_t *rx, const int maxBaudrate)
+{
+    if (rx == NULL)
+    {
+        return false;
+    }
+    if (!portCanBaudrate(&rx->port) || (rx->opts.detect != RX_DET_UBX))
+    {
+        RX_WARNING("Cannot change baudrate of this port or receiver!");
+        return false;
+    }
+    if (rx->upshiftId != 0)
+    {
+        return true;
+    }
+
+    // Highest standard baudrate (the ones the receiver supports) up to the maximum requested
+    const int baudrates[] = { PORT_BAUDRATES };
+    const int baudrate = rxGetBaudrate(rx);
+    int newBaudrate = 0;
+    for (int ix = 0; ix < NUMOF(baudrates); ix++)
+    {
+        if (baudrates[ix] <= maxBaudrate)
+        {
+            newBaudrate = baudrates[ix];
+        }
+    }
+    if (newBaudrate <= baudrate)
+    {
+        RX_DEBUG("Baudrate %d already >= %d", baudrate, newBaudrate);
+        return true;
+    }
+
+    // The reader thread must not interfere with switching the baudrate
+    const bool ring = _rxRingStop(rx);
+    const uint64_t t0 = TIME();
+    const bool res = _rxUpshift(rx, baudrate, newBaudrate);
+    if (ring)
+    {
+        _rxRingStart(rx);
+    }
+    if (res)
+    {
+        RX_PRINT("Receiver now at baudrate %d (%"PRIu64"ms)", newBaudrate, TIME() - t0);
+    }
+    return res;
+}
+
+static void _rxUpshiftRestore(RX_t *rx)
+{
+    // Only if still at the baudrate we have set (a receiver reset, for example, changes it back)
+    if ( (rx->upshiftId != 0) && rx->port.portOk && (rxGetBaudrate(rx) == rx->upshiftBaudrate) )
+    {
+        RX_PRINT("Restoring baudrate %d", rx->upshiftOrig);
+        _rxSetUartBaudrate(rx, rx->upshiftId, rx->upshiftOrig);
+        rxSetBaudrate(rx, rx->upshiftOrig);
+    }
+    rx->upshiftId = 0;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 
+static bool _rxWaitUntil(RX_t *rx, const uint64_t t1);
+static void _rxAsyncDispatch(RX_t *rx, const PARSER_MSG_t *msg);
+static void _rxAsyncTimeouts(RX_t *rx);
+
 PARSER_MSG_t *rxGetNextMessage(RX_t *rx)
 {
     PARSER_MSG_t *msg = NULL;
-    if (rx != NULL)
+    if ( (rx == NULL) || (rx->reconnecting && !_rxReconnect(rx)) )
+    {
+        return NULL;
+    }
+    _rxAsyncTimeouts(rx);
+
+    // Get data from the reader thread, one chunk at a time, so that we know the arrival time of the messages
+    if (rx->ring != NULL)
     {
-        int readSize;
-        while ( !rx->abort && portRead(&rx->port, rx->readBuf, sizeof(rx->readBuf), &readSize) && (readSize > 0) )
+        while (!rx->abort)
         {
-            parserAdd(&rx->parser, rx->readBuf, readSize);
+            if (parserProcess(&rx->parser, &rx->msg, true))
+            {
+                msg = &rx->msg;
+                msg->src = PARSER_MSGSRC_FROM_RX;
+                msg->ts = rx->ringTs;
+                break;
+            }
+            if (!_rxRingGet(rx))
+            {
+                // Port failed and all data consumed. If not reconnecting, stop the thread and read the port
+                // directly, so that rxWaitReadable() waits on the port instead of returning right away.
+                if (_rxRingFailed(rx) && !_rxDisconnected(rx))
+                {
+                    _rxRingStop(rx);
+                }
+                break;
+            }
         }
-
-        if (parserProcess(&rx->parser, &rx->msg, true))
+    }
+    // Read port directly, only as much as needed so that fast sources (e.g. file replay) don't overflow the parser
+    else
+    {
+        while (!rx->abort)
         {
-            msg = &rx->msg;
-            msg->src = PARSER_MSGSRC_FROM_RX;
+            if (parserProcess(&rx->parser, &rx->msg, true))
+            {
+                msg = &rx->msg;
+                msg->src = PARSER_MSGSRC_FROM_RX;
+                break;
+            }
+            int readSize;
+            if (!portRead(&rx->port, rx->readBuf, sizeof(rx->readBuf), &readSize))
+            {
+                _rxDisconnected(rx);
+                break;
+            }
+            if (readSize <= 0)
+            {
+                break;
+            }
+            parserAdd(&rx->parser, rx->readBuf, readSize);
         }
     }
+    if (msg != NULL)
+    {
+        _rxAsyncDispatch(rx, msg);
+    }
     return msg;
 }
 
@@ -328,7 +910,7 @@ PARSER_MSG_t *rxGetNextMessageTimeout(RX_t *rx, const uint32_t timeout)
     {
         const uint64_t t0 = TIME();
         const uint64_t t1 = t0 + timeout;
-        while (TIME() < t1)
+        while (true)
         {
             if (rx->abort)
             {
@@ -339,26 +921,208 @@ PARSER_MSG_t *rxGetNextMessageTimeout(RX_t *rx, const uint32_t timeout)
             {
                 break;
             }
-            SLEEP(10);
+            if (!_rxWaitUntil(rx, t1))
+            {
+                break;
+            }
         }
     }
     return msg;
 }
 
-/* ****************************************************************************************************************** */
-
-PARSER_MSG_t *rxPollUbx(RX_t *rx, const RX_POLL_UBX_t *param, bool *pollNak)
+bool rxWaitReadable(RX_t *rx, const uint32_t timeout)
 {
-    if ( (rx == NULL) || (param == NULL) ||
-         ((param->payload != NULL) && (param->payloadSize > (int)(sizeof(rx->pollBuf) - UBX_FRAME_SIZE))) )
+    if ( (rx == NULL) || rx->abort )
+    {
+        return false;
+    }
+    // Wait for the connection being established, resp. until the next attempt to reconnect is due
+    if (rx->reconnecting && !rx->port.connecting)
+    {
+        const uint64_t now = TIME();
+        const uint64_t wait = rx->reconnectTime > now ? rx->reconnectTime - now : 0;
+        SLEEP(MIN(wait, timeout));
+        return wait <= timeout;
+    }
+    return rx->ring != NULL ? _rxRingWait(rx, timeout) : portWaitReadable(&rx->port, timeout);
+}
+
+bool rxWaitReadablePort(RX_t *rx, PORT_t *port, const uint32_t timeout, bool *portReadable)
+{
+    if (portReadable != NULL)
+    {
+        *portReadable = false;
+    }
+    if ( (rx == NULL) || rx->abort )
+    {
+        return false;
+    }
+    if ( (port == NULL) || (portReadable == NULL) )
+    {
+        return rxWaitReadable(rx, timeout);
+    }
+    // Wait for both ports (also while connecting, see rxWaitReadable())
+    const bool reconnectWait = rx->reconnecting && !rx->port.connecting;
+    if (!reconnectWait && (rx->ring == NULL))
+    {
+        PORT_t *ports[] = { &rx->port, port };
+        bool readable[NUMOF(ports)] = { false, false };
+        portWaitReadableMulti(ports, NUMOF(ports), timeout, readable);
+        *portReadable = readable[1];
+        return readable[0];
+    }
+    // Wait for the other port only, until the next attempt to reconnect is due, resp. shortly, as the reader thread
+    // cannot be waited for at the same time
+    uint32_t wait = MIN(timeout, 10);
+    if (reconnectWait)
+    {
+        const uint64_t now = TIME();
+        wait = rx->reconnectTime > now ? MIN(rx->reconnectTime - now, timeout) : 0;
+    }
+    *portReadable = portWaitReadable(port, wait);
+    return rxWaitReadable(rx, 0);
+}
+
+// Wait for data until the given time, returns false if that time has passed
+static bool _rxWaitUntil(RX_t *rx, const uint64_t t1)
+{
+    const uint64_t now = TIME();
+    if (now >= t1)
+    {
+        return false;
+    }
+    rxWaitReadable(rx, t1 - now);
+    return true;
+}
+
+/* ****************************************************************************************************************** */
+
+// Round-trip time (RTT) estimator, as for TCP (RFC 6298): the smoothed RTT (SRTT) and its variation (RTTVAR) give the
+// retransmission timeout (RTO), which replaces the default timeouts for polls and acknowledgements once there are
+// samples. The samples exclude the time for transferring the request and the response at the current baudrate, so
+// that small (e.g. UBX-ACK-ACK) and large (e.g. UBX-CFG-VALGET) responses give comparable samples. The transfer time
+// is added back to the timeouts. A response after a retry could be to any attempt, so there is no sample then (Karn's
+// algorithm), and neither for a response that was queued behind the response to another request, as that measures
+// the gap between the two. The timeout doubles for each further attempt.
+
+#define RX_RTT_RTO_MIN   200   // Minimum RTO [ms]
+#define RX_RTT_RTO_MAX   10000 // Maximum RTO (incl. backoff) [ms]
+#define RX_RTT_RESP_SIZE 1000  // Assumed maximum size of a poll response [bytes]
+
+// Time to transfer size bytes at the current baudrate (8N1, i.e. 10 bits per byte) [ms], 0 if unknown
+static uint32_t _rxTxTime(RX_t *rx, const int size)
+{
+    const int baudrate = rxGetBaudrate(rx);
+    return (baudrate > 0) && (size > 0) ? (uint32_t)((((uint64_t)size * 10000) + baudrate - 1) / baudrate) : 0;
+}
+
+static uint32_t _rxRto(RX_t *rx)
+{
+    const double rto = rx->srtt + MAX(4.0 * rx->rttvar, 1.0);
+    return CLIP((uint32_t)rto, RX_RTT_RTO_MIN, RX_RTT_RTO_MAX);
+}
+
+// Add a sample for a response of respSize bytes to a request sent at t0. The reqSize is the size of the request, or 0
+// if it was already received by the receiver at t0 (e.g. pipelined requests, where t0 is the previous response).
+static void _rxRttSample(RX_t *rx, const uint64_t t0, const int reqSize, const int respSize)
+{
+    const uint32_t dt = TIME() - t0;
+    const uint32_t txTime = _rxTxTime(rx, reqSize + respSize);
+    const uint32_t rtt = dt > txTime ? dt - txTime : 0;
+    if (rx->rttNum == 0)
+    {
+        rx->srtt   = rtt;
+        rx->rttvar = (double)rtt / 2.0;
+        rx->rttMin = rtt;
+        rx->rttMax = rtt;
+    }
+    else
+    {
+        rx->rttvar = (0.75 * rx->rttvar) + (0.25 * ABS(rx->srtt - (double)rtt));
+        rx->srtt   = (0.875 * rx->srtt) + (0.125 * (double)rtt);
+        rx->rttMin = MIN(rx->rttMin, rtt);
+        rx->rttMax = MAX(rx->rttMax, rtt);
+    }
+    rx->rttNum++;
+    rx->rttLast = rtt;
+    RX_DEBUG("rtt %u (dt %u, tx %u), srtt %.1f, rttvar %.1f, rto %u [ms]", rtt, dt, txTime, rx->srtt, rx->rttvar,
+        _rxRto(rx));
+}
+
+// Timeout for an attempt (1, 2, ...) of a request of reqSize bytes with a response of up to respSize bytes [ms], the
+// defaultTimeout until there are samples
+static uint32_t _rxRttTimeout(RX_t *rx, const uint32_t defaultTimeout, const int attempt, const int reqSize,
+    const int respSize)
+{
+    if (rx->rttNum == 0)
+    {
+        return defaultTimeout;
+    }
+    uint32_t rto = _rxRto(rx);
+    for (int ix = 1; (ix < attempt) && (rto < RX_RTT_RTO_MAX); ix++)
+    {
+        rto *= 2;
+    }
+    return MIN(rto, (uint32_t)RX_RTT_RTO_MAX) + _rxTxTime(rx, reqSize + respSize);
+}
+
+// Is the message a UBX-CFG that writes to the Flash? Those can take a while, and their acknowledgements are no
+// measure of the round-trip time.
+static bool _rxIsFlashWrite(const uint8_t *msg, const int size)
+{
+    if ( (size < (UBX_FRAME_SIZE + 2)) || (UBX_CLSID(msg) != UBX_CFG_CLSID) )
+    {
+        return false;
+    }
+    const uint8_t layers = msg[UBX_HEAD_SIZE + 1]; // UBX-CFG-VALSET.layers resp. UBX-CFG-VALDEL.layers
+    switch (UBX_MSGID(msg))
+    {
+        case UBX_CFG_CFG_MSGID:
+            return true;
+        case UBX_CFG_VALSET_MSGID:
+            return (layers & UBX_CFG_VALSET_V1_LAYER_FLASH) != 0;
+        case UBX_CFG_VALDEL_MSGID:
+            return (layers & UBX_CFG_VALDEL_V1_LAYER_FLASH) != 0;
+    }
+    return false;
+}
+
+bool rxGetRttStats(RX_t *rx, RX_RTT_STATS_t *stats)
+{
+    if ( (rx == NULL) || (stats == NULL) )
+    {
+        return false;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (rx->rttNum > 0)
+    {
+        stats->numSamples = rx->rttNum;
+        stats->last       = rx->rttLast;
+        stats->min        = rx->rttMin;
+        stats->max        = rx->rttMax;
+        stats->srtt       = rx->srtt;
+        stats->rttvar     = rx->rttvar;
+        stats->rto        = _rxRto(rx);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+#define RX_POLL_TIMEOUT_DEFAULT 1500 // Default poll timeout [ms]
+#define RX_POLL_RETRIES_DEFAULT 2    // Default number of poll attempts
+
+PARSER_MSG_t *rxPollUbx(RX_t *rx, const RX_POLL_UBX_t *param, bool *pollNak)
+{
+    if ( (rx == NULL) || (param == NULL) ||
+         ((param->payload != NULL) && (param->payloadSize > (int)(sizeof(rx->pollBuf) - UBX_FRAME_SIZE))) )
     {
         return NULL;
     }
 
     // Parameters
-    const int timeout     = param->timeout     > 0 ? param->timeout     : 1500;
     const int respSizeMin = param->respSizeMin > 0 ? param->respSizeMin : (UBX_FRAME_SIZE + 1);
-    const int retries     = param->retries     > 0 ? param->retries     : 2;
+    const int retries     = param->retries     > 0 ? param->retries     : RX_POLL_RETRIES_DEFAULT;
     const bool isUbxCfg   = param->clsId == UBX_CFG_CLSID;
 
     // Create poll request message, use parser's tmp message buffer
@@ -371,7 +1135,9 @@ PARSER_MSG_t *rxPollUbx(RX_t *rx, const RX_POLL_UBX_t *param, bool *pollNak)
     bool _pollNak = false;
     for (int attempt = 1; attempt <= retries; attempt++)
     {
-        RX_DEBUG("poll %s, size %d, timeout=%d, isUbxCfg=%d, attempt %d/%d.",
+        const uint32_t timeout = param->timeout > 0 ? param->timeout :
+            _rxRttTimeout(rx, RX_POLL_TIMEOUT_DEFAULT, attempt, pollSize, RX_RTT_RESP_SIZE);
+        RX_DEBUG("poll %s, size %d, timeout=%u, isUbxCfg=%d, attempt %d/%d.",
             pollName, pollSize, timeout, attempt, isUbxCfg, retries);
 
         // Send request
@@ -392,7 +1158,7 @@ PARSER_MSG_t *rxPollUbx(RX_t *rx, const RX_POLL_UBX_t *param, bool *pollNak)
             PARSER_MSG_t *msg = rxGetNextMessage(rx);
             if (msg == NULL)
             {
-                SLEEP(10);
+                _rxWaitUntil(rx, t1);
                 continue;
             }
             if ( (msg->type == PARSER_MSGTYPE_UBX) &&
@@ -401,6 +1167,10 @@ PARSER_MSG_t *rxPollUbx(RX_t *rx, const RX_POLL_UBX_t *param, bool *pollNak)
                  (UBX_MSGID(msg->data) == param->msgId) )
             {
                 RX_DEBUG("poll answer %s, size=%d, dt=%"PRIu64, msg->name, msg->size, TIME() - t0);
+                if (attempt == 1)
+                {
+                    _rxRttSample(rx, t0, pollSize, msg->size);
+                }
                 res = msg;
                 break;
             }
@@ -414,6 +1184,10 @@ PARSER_MSG_t *rxPollUbx(RX_t *rx, const RX_POLL_UBX_t *param, bool *pollNak)
                     const UBX_ACK_ACK_V0_GROUP0_t *ack = (const UBX_ACK_ACK_V0_GROUP0_t *)&msg->data[UBX_HEAD_SIZE];
                     if ( (ack->clsId == param->clsId) && (ack->msgId == param->msgId) )
                     {
+                        if (attempt == 1)
+                        {
+                            _rxRttSample(rx, t0, pollSize, msg->size);
+                        }
                         _pollNak = true;
                         attempt = retries; // No need to try again
                         break;
@@ -452,7 +1226,10 @@ bool rxSendUbxCfg(RX_t *rx, const uint8_t *msg, const int size, const uint32_t t
     }
     char sendName[PARSER_MAX_NAME_SIZE];
     ubxMessageName(sendName, sizeof(sendName), msg, size);
-    RX_DEBUG("Sending %s, size %d, timeout %u", sendName, size, timeout);
+    const bool flashWrite = _rxIsFlashWrite(msg, size);
+    const uint32_t ackTimeout = (timeout > 0) || flashWrite ? timeout :
+        _rxRttTimeout(rx, 1000, 1, size, UBX_ACK_ACK_V0_SIZE);
+    RX_DEBUG("Sending %s, size %d, timeout %u", sendName, size, ackTimeout);
     RX_TRACE_HD(msg, size, "%s", sendName);
 
     const uint8_t clsId = UBX_CLSID(msg);
@@ -464,7 +1241,7 @@ bool rxSendUbxCfg(RX_t *rx, const uint8_t *msg, const int size, const uint32_t t
     }
 
     const uint64_t t0 = TIME();
-    const uint64_t t1 = t0 + (timeout > 0 ? timeout : 1000);
+    const uint64_t t1 = t0 + (ackTimeout > 0 ? ackTimeout : 1000);
     bool res = true;
     bool resp = false;
     while ( !resp && (TIME() < t1) )
@@ -476,7 +1253,7 @@ bool rxSendUbxCfg(RX_t *rx, const uint8_t *msg, const int size, const uint32_t t
         PARSER_MSG_t *pmsg = rxGetNextMessage(rx);
         if (pmsg == NULL)
         {
-            SLEEP(10);
+            _rxWaitUntil(rx, t1);
             continue;
         }
         _rxCallbackMsg(rx, pmsg);
@@ -506,6 +1283,10 @@ bool rxSendUbxCfg(RX_t *rx, const uint8_t *msg, const int size, const uint32_t t
         }
     }
 
+    if (resp && !flashWrite)
+    {
+        _rxRttSample(rx, t0, size, UBX_ACK_ACK_V0_SIZE);
+    }
     if (!resp)
     {
         RX_DEBUG("ack/nak %s timeout", sendName);
@@ -516,128 +1297,626 @@ bool rxSendUbxCfg(RX_t *rx, const uint8_t *msg, const int size, const uint32_t t
 
 // ---------------------------------------------------------------------------------------------------------------------
 
-bool rxGetVerStr(RX_t *rx, char *str, const int size)
+static uint64_t _rxSubKey(const PARSER_MSGTYPE_t type, const uint32_t id)
 {
-    if ( (rx == NULL) || (str == NULL) )
+    return ((uint64_t)type << 32) | id;
+}
+
+// NMEA formatter ("GGA", "PUBX", ...) as a number
+static uint32_t _rxNmeaId(const char *formatter, const int len)
+{
+    if ( (len < 1) || (len > 4) )
     {
-        return false;
+        return 0;
     }
+    uint32_t id = 0;
+    for (int ix = 0; ix < len; ix++)
+    {
+        id = (id << 8) | (uint8_t)formatter[ix];
+    }
+    return id;
+}
 
-    RX_POLL_UBX_t pollParam = { .clsId = UBX_MON_CLSID, .msgId = UBX_MON_VER_MSGID };
-    PARSER_MSG_t *ubxMonVer = rxPollUbx(rx, &pollParam, NULL);
-    if (ubxMonVer != NULL)
+// Message key for the subscriptions, 0 if not subscribable
+static uint64_t _rxMsgKey(const PARSER_MSG_t *msg)
+{
+    switch (msg->type)
     {
-        _rxCallbackMsg(rx, ubxMonVer);
-        return ubxMonVerToVerStr(str, size, ubxMonVer->data, ubxMonVer->size);
+        case PARSER_MSGTYPE_UBX:
+            return _rxSubKey(msg->type, ((uint32_t)UBX_CLSID(msg->data) << 8) | UBX_MSGID(msg->data));
+        case PARSER_MSGTYPE_NMEA: {
+            // "$GPGGA,...": formatter "GGA", proprietary "$PUBX,...": formatter "PUBX"
+            const char *addr = (const char *)&msg->data[1];
+            int len = 0;
+            while ( (len < (msg->size - 1)) && (addr[len] != ',') && (addr[len] != '*') )
+            {
+                len++;
+            }
+            if ( (addr[0] != 'P') && (len > 2) )
+            {
+                addr += 2;
+                len -= 2;
+            }
+            const uint32_t id = _rxNmeaId(addr, len);
+            return id != 0 ? _rxSubKey(msg->type, id) : 0; }
+        case PARSER_MSGTYPE_RTCM3:
+            return msg->size > (RTCM3_HEAD_SIZE + 2) ? _rxSubKey(msg->type, RTCM3_TYPE(msg->data)) : 0;
+        case PARSER_MSGTYPE_SPARTN:
+        case PARSER_MSGTYPE_NOVATEL:
+        case PARSER_MSGTYPE_GARBAGE:
+            break;
     }
-    return false;
+    return 0;
 }
 
-static bool _rxFlushRx(RX_t *rx)
+static uint32_t _rxSubHash(const uint64_t key)
 {
-    if (rx == NULL)
+    return (uint32_t)((key * UINT64_C(0x9e3779b97f4a7c15)) >> (64 - RX_SUB_HASH_BITS));
+}
+
+static int _rxSubscribe(RX_t *rx, const uint64_t key, RX_SUB_CB_t cb, void *arg)
+{
+    if ( (rx == NULL) || (key == 0) || (cb == NULL) )
     {
-        return false;
+        return 0;
     }
-    int maxRead = 1000;
-    int readSize = 0;
-    while ( !rx->abort && (maxRead > 0) && portRead(&rx->port, rx->readBuf, sizeof(rx->readBuf), &readSize) && (readSize > 0) )
+    for (int ix = 0; ix < RX_MAX_SUBS; ix++)
     {
-        maxRead--;
+        RX_SUB_t *sub = &rx->subs[ix];
+        if (sub->key == 0)
+        {
+            const uint32_t bucket = _rxSubHash(key);
+            sub->key  = key;
+            sub->cb   = cb;
+            sub->arg  = arg;
+            sub->next = rx->subHash[bucket];
+            rx->subHash[bucket] = ix + 1;
+            rx->numSubs++;
+            return ix + 1;
+        }
     }
-    return maxRead > 0 ? true : false;
+    RX_WARNING("Too many subscriptions!");
+    return 0;
 }
 
-static bool _rxFlushTx(RX_t *rx)
+int rxSubscribeUbx(RX_t *rx, const uint8_t clsId, const uint8_t msgId, RX_SUB_CB_t cb, void *arg)
 {
-    if (rx == NULL)
+    return _rxSubscribe(rx, _rxSubKey(PARSER_MSGTYPE_UBX, ((uint32_t)clsId << 8) | msgId), cb, arg);
+}
+
+int rxSubscribeNmea(RX_t *rx, const char *formatter, RX_SUB_CB_t cb, void *arg)
+{
+    const uint32_t id = formatter != NULL ? _rxNmeaId(formatter, strlen(formatter)) : 0;
+    return id != 0 ? _rxSubscribe(rx, _rxSubKey(PARSER_MSGTYPE_NMEA, id), cb, arg) : 0;
+}
+
+int rxSubscribeRtcm3(RX_t *rx, const int type, RX_SUB_CB_t cb, void *arg)
+{
+    return (type > 0) && (type < 4096) ? _rxSubscribe(rx, _rxSubKey(PARSER_MSGTYPE_RTCM3, type), cb, arg) : 0;
+}
+
+bool rxUnsubscribe(RX_t *rx, const int subId)
+{
+    if ( (rx == NULL) || (subId < 1) || (subId > RX_MAX_SUBS) || (rx->subs[subId - 1].key == 0) )
     {
         return false;
     }
-    const uint8_t flushSeq[1024] = { [0 ... 1023] = 0x55 };
-    return rxSend(rx, flushSeq, sizeof(flushSeq));
+    RX_SUB_t *sub = &rx->subs[subId - 1];
+    uint8_t *link = &rx->subHash[_rxSubHash(sub->key)];
+    while (*link != 0)
+    {
+        if (*link == subId)
+        {
+            *link = sub->next;
+            break;
+        }
+        link = &rx->subs[*link - 1].next;
+    }
+    memset(sub, 0, sizeof(*sub));
+    rx->numSubs--;
+    return true;
 }
 
-bool rxAutobaud(RX_t *rx)
+// ---------------------------------------------------------------------------------------------------------------------
+
+static uint32_t _rxAsyncTimeout(RX_t *rx, const RX_APOLL_t *poll)
 {
-    if (rx == NULL)
+    return poll->timeout > 0 ? poll->timeout :
+        _rxRttTimeout(rx, RX_POLL_TIMEOUT_DEFAULT, poll->attempt, poll->reqSize, RX_RTT_RESP_SIZE);
+}
+
+int rxPollUbxAsync(RX_t *rx, const RX_POLL_UBX_t *param, RX_POLL_CB_t cb, void *arg)
+{
+    if ( (rx == NULL) || (param == NULL) || (cb == NULL) ||
+         ((param->payload != NULL) && ((param->payloadSize < 0) || (param->payloadSize > RX_POLL_MAX_PAYLOAD))) )
+    {
+        return 0;
+    }
+    RX_APOLL_t *poll = NULL;
+    for (int ix = 0; ix < RX_MAX_POLLS; ix++)
+    {
+        if (rx->polls[ix].id == 0)
+        {
+            poll = &rx->polls[ix];
+            break;
+        }
+    }
+    if (poll == NULL)
+    {
+        RX_WARNING("Too many pending polls!");
+        return 0;
+    }
+
+    poll->clsId       = param->clsId;
+    poll->msgId       = param->msgId;
+    poll->timeout     = param->timeout;
+    poll->respSizeMin = param->respSizeMin > 0 ? param->respSizeMin : (UBX_FRAME_SIZE + 1);
+    poll->retries     = param->retries     > 0 ? param->retries     : RX_POLL_RETRIES_DEFAULT;
+    poll->reqSize     = ubxMakeMessage(param->clsId, param->msgId, param->payload,
+        param->payload != NULL ? param->payloadSize : 0, poll->req);
+    poll->cb          = cb;
+    poll->arg         = arg;
+    poll->attempt     = 1;
+    if (!rxSend(rx, poll->req, poll->reqSize))
+    {
+        return 0;
+    }
+    const uint32_t timeout = _rxAsyncTimeout(rx, poll);
+    poll->sent = TIME();
+    poll->deadline = poll->sent + timeout;
+    rx->pollSeq = (rx->pollSeq < INT32_MAX ? rx->pollSeq + 1 : 1);
+    poll->id = rx->pollSeq;
+    rx->numPolls++;
+    RX_DEBUG("poll %02x:%02x async, id %d, size %d, timeout=%u", poll->clsId, poll->msgId, poll->id, poll->reqSize,
+        timeout);
+    return poll->id;
+}
+
+// Free the poll slot first, so that the callback can start new polls
+static void _rxPollDone(RX_t *rx, RX_APOLL_t *poll, const RX_POLL_RES_t res, const PARSER_MSG_t *msg)
+{
+    const int id = poll->id;
+    RX_POLL_CB_t cb = poll->cb;
+    void *arg = poll->arg;
+    poll->id = 0;
+    rx->numPolls--;
+    RX_DEBUG("poll %02x:%02x async, id %d, res %d", poll->clsId, poll->msgId, id, res);
+    const bool dispatching = rx->dispatching;
+    rx->dispatching = true;
+    cb(rx, id, res, msg, arg);
+    rx->dispatching = dispatching;
+}
+
+bool rxPollCancel(RX_t *rx, const int pollId)
+{
+    if ( (rx == NULL) || (pollId <= 0) )
     {
         return false;
     }
+    for (int ix = 0; ix < RX_MAX_POLLS; ix++)
+    {
+        if (rx->polls[ix].id == pollId)
+        {
+            _rxPollDone(rx, &rx->polls[ix], RX_POLL_CANCEL, NULL);
+            return true;
+        }
+    }
+    return false;
+}
 
-    int baudrate = 0;
-    const int currentBaudrate = rxGetBaudrate(rx);
-    int baudrates[] = { currentBaudrate, 9600, 38400, 115200, 230400, 460800, 921600 };
+int rxPollPending(RX_t *rx)
+{
+    return rx != NULL ? rx->numPolls : 0;
+}
 
-    // First, try quickly..
+// Earliest poll deadline, 0 if none
+static uint64_t _rxAsyncDeadline(RX_t *rx)
+{
+    uint64_t deadline = 0;
+    for (int ix = 0; (rx->numPolls > 0) && (ix < RX_MAX_POLLS); ix++)
     {
-        for (int ix = 0; !rx->abort && (ix < NUMOF(baudrates)); ix++)
+        if ( (rx->polls[ix].id != 0) && ((deadline == 0) || (rx->polls[ix].deadline < deadline)) )
         {
-            if ( (ix > 0) && (baudrates[ix] == currentBaudrate) )
-            {
-                continue;
-            }
-            if (!rxSetBaudrate(rx, baudrates[ix]))
+            deadline = rx->polls[ix].deadline;
+        }
+    }
+    return deadline;
+}
+
+static void _rxAsyncTimeouts(RX_t *rx)
+{
+    if ( (rx->numPolls == 0) || rx->dispatching )
+    {
+        return;
+    }
+    const uint64_t now = TIME();
+    for (int ix = 0; ix < RX_MAX_POLLS; ix++)
+    {
+        RX_APOLL_t *poll = &rx->polls[ix];
+        if ( (poll->id == 0) || (poll->deadline > now) )
+        {
+            continue;
+        }
+        if (poll->attempt < poll->retries)
+        {
+            poll->attempt++;
+            const uint32_t timeout = _rxAsyncTimeout(rx, poll);
+            RX_DEBUG("poll %02x:%02x async, id %d, timeout=%u, attempt %d/%d", poll->clsId, poll->msgId, poll->id,
+                timeout, poll->attempt, poll->retries);
+            poll->deadline = now + timeout;
+            if (rxSend(rx, poll->req, poll->reqSize))
             {
                 continue;
             }
-            RX_DEBUG("autobaud %d (quick)", baudrates[ix]);
-            if (_rxDetect(rx))
-            {
-                baudrate = baudrates[ix];
-                break;
-            }
         }
+        _rxPollDone(rx, poll, RX_POLL_TIMEOUT, NULL);
     }
-    // Try harder
-    if (baudrate == 0)
+}
+
+static void _rxAsyncDispatch(RX_t *rx, const PARSER_MSG_t *msg)
+{
+    if ( ((rx->numPolls == 0) && (rx->numSubs == 0)) || rx->dispatching )
     {
-        for (int ix = 0; !rx->abort && (ix < NUMOF(baudrates)); ix++)
+        return;
+    }
+
+    // Response to a poll (the oldest one for this message), or UBX-ACK-NAK to a UBX-CFG poll
+    if ( (rx->numPolls > 0) && (msg->type == PARSER_MSGTYPE_UBX) )
+    {
+        const uint8_t clsId = UBX_CLSID(msg->data);
+        const uint8_t msgId = UBX_MSGID(msg->data);
+        const bool nak = (clsId == UBX_ACK_CLSID) && (msgId == UBX_ACK_NAK_MSGID) &&
+            (msg->size >= (int)(sizeof(UBX_ACK_NAK_V0_GROUP0_t) + UBX_FRAME_SIZE));
+        const UBX_ACK_NAK_V0_GROUP0_t *ack = (const UBX_ACK_NAK_V0_GROUP0_t *)&msg->data[UBX_HEAD_SIZE];
+        RX_APOLL_t *poll = NULL;
+        for (int ix = 0; ix < RX_MAX_POLLS; ix++)
         {
-            if ( (ix > 0) && (baudrates[ix] == currentBaudrate) )
+            RX_APOLL_t *cand = &rx->polls[ix];
+            if ( (cand->id != 0) && ((poll == NULL) || (cand->id < poll->id)) &&
+                 ( ((clsId == cand->clsId) && (msgId == cand->msgId) && (msg->size >= cand->respSizeMin)) ||
+                   (nak && (cand->clsId == UBX_CFG_CLSID) && (ack->clsId == cand->clsId) && (ack->msgId == cand->msgId)) ) )
             {
-                continue;
+                poll = cand;
             }
-            if (!rxSetBaudrate(rx, baudrates[ix]))
+        }
+        if (poll != NULL)
+        {
+            if (poll->attempt == 1)
             {
-                continue;
+                _rxRttSample(rx, poll->sent, poll->reqSize, msg->size);
             }
-            RX_DEBUG("autobaud %d (flush rx/tx)", baudrates[ix]);
-            _rxFlushRx(rx);
-            _rxFlushTx(rx);
-            if (_rxDetect(rx))
+            _rxPollDone(rx, poll, nak ? RX_POLL_NAK : RX_POLL_OK, msg);
+        }
+    }
+
+    // Subscriptions (collect first, the callbacks may change them)
+    if (rx->numSubs > 0)
+    {
+        const uint64_t key = _rxMsgKey(msg);
+        if (key == 0)
+        {
+            return;
+        }
+        RX_SUB_t subs[RX_MAX_SUBS];
+        int nSubs = 0;
+        for (uint8_t ix = rx->subHash[_rxSubHash(key)]; ix != 0; ix = rx->subs[ix - 1].next)
+        {
+            if (rx->subs[ix - 1].key == key)
             {
-                baudrate = baudrates[ix];
-                break;
+                subs[nSubs++] = rx->subs[ix - 1];
             }
         }
+        rx->dispatching = true;
+        for (int ix = 0; ix < nSubs; ix++)
+        {
+            subs[ix].cb(rx, msg, subs[ix].arg);
+        }
+        rx->dispatching = false;
     }
+}
 
-    if ( !rx->abort && (baudrate != 0) )
+bool rxAsyncRun(RX_t *rx, const uint32_t timeout)
+{
+    if (rx == NULL)
     {
-        RX_DEBUG("autobaud %d success: %s", baudrate, rx->detectInfo);
-        return true;
+        return false;
     }
-    else
+    const uint64_t t1 = TIME() + timeout;
+    while (!rx->abort && (rx->numPolls > 0))
     {
-        RX_DEBUG("autobaud fail");
-        return false;
+        PARSER_MSG_t *msg = rxGetNextMessage(rx);
+        if (msg != NULL)
+        {
+            _rxCallbackMsg(rx, msg);
+            continue;
+        }
+        // Wait for data, but not past the next poll deadline
+        const uint64_t now = TIME();
+        if (now >= t1)
+        {
+            break;
+        }
+        const uint64_t deadline = _rxAsyncDeadline(rx);
+        const uint64_t until = (deadline != 0) && (deadline < t1) ? deadline : t1;
+        if (until > now)
+        {
+            rxWaitReadable(rx, until - now);
+        }
     }
+    return rx->numPolls == 0;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
 
-/* ****************************************************************************************************************** */
-
-bool rxReset(RX_t *rx, const RX_RESET_t reset)
+bool rxGetVerStr(RX_t *rx, char *str, const int size)
 {
-    if ( (rx == NULL) || (reset == RX_RESET_NONE) )
+    if ( (rx == NULL) || (str == NULL) )
     {
         return false;
     }
-    RX_PRINT("Doing receiver reset: %s", rxResetStr(reset));
 
-    // Delete config?
-    if ( (reset == RX_RESET_DEFAULT) || (reset == RX_RESET_FACTORY) )
+    RX_POLL_UBX_t pollParam = { .clsId = UBX_MON_CLSID, .msgId = UBX_MON_VER_MSGID };
+    PARSER_MSG_t *ubxMonVer = rxPollUbx(rx, &pollParam, NULL);
+    if (ubxMonVer != NULL)
+    {
+        _rxCallbackMsg(rx, ubxMonVer);
+        return ubxMonVerToVerStr(str, size, ubxMonVer->data, ubxMonVer->size);
+    }
+    return false;
+}
+
+static bool _rxFlushRx(RX_t *rx)
+{
+    if (rx == NULL)
+    {
+        return false;
+    }
+    int maxRead = 1000;
+    int readSize = 0;
+    while ( !rx->abort && (maxRead > 0) && portRead(&rx->port, rx->readBuf, sizeof(rx->readBuf), &readSize) && (readSize > 0) )
+    {
+        maxRead--;
+    }
+    return maxRead > 0 ? true : false;
+}
+
+static bool _rxFlushTx(RX_t *rx)
+{
+    if (rx == NULL)
+    {
+        return false;
+    }
+    const uint8_t flushSeq[1024] = { [0 ... 1023] = 0x55 };
+    return rxSend(rx, flushSeq, sizeof(flushSeq));
+}
+
+bool rxAutobaud(RX_t *rx)
+{
+    if (rx == NULL)
+    {
+        return false;
+    }
+    // The reader thread must not interfere with flushing and detecting
+    const bool ring = _rxRingStop(rx);
+    const bool res = _rxAutobaud(rx, true);
+    if (ring)
+    {
+        _rxRingStart(rx);
+    }
+    return res;
+}
+
+static double _rxAutobaudSample(RX_t *rx, const int baudrate, const uint32_t timeout, int *nBytes, int *nMsgs)
+{
+    *nBytes = 0;
+    *nMsgs = 0;
+    if (!rxSetBaudrate(rx, baudrate))
+    {
+        return 0.0;
+    }
+    _rxFlushRx(rx);
+    parserInit(&rx->parser);
+    PORT_STATS_t stats0;
+    const bool haveIcount = portGetStats(&rx->port, &stats0) && stats0.haveIcount;
+
+    int nValid = 0;
+    const uint64_t t1 = TIME() + timeout;
+    uint64_t tIdle = t1;
+    while (!rx->abort && (*nBytes < RX_AUTOBAUD_SAMPLE_BYTES) && (*nMsgs < RX_AUTOBAUD_SAMPLE_MSGS))
+    {
+        int readSize = 0;
+        if (!portRead(&rx->port, rx->readBuf, sizeof(rx->readBuf), &readSize))
+        {
+            break;
+        }
+        if (readSize > 0)
+        {
+            *nBytes += readSize;
+            parserAdd(&rx->parser, rx->readBuf, readSize);
+            while (parserProcess(&rx->parser, &rx->msg, false))
+            {
+                if (rx->msg.type != PARSER_MSGTYPE_GARBAGE)
+                {
+                    nValid += rx->msg.size;
+                    (*nMsgs)++;
+                }
+            }
+            tIdle = MIN(t1, TIME() + RX_AUTOBAUD_SAMPLE_IDLE);
+            continue;
+        }
+        const uint64_t now = TIME();
+        if (now >= tIdle)
+        {
+            break;
+        }
+        portWaitReadable(&rx->port, tIdle - now);
+    }
+
+    PORT_STATS_t stats1;
+    if (haveIcount && portGetStats(&rx->port, &stats1))
+    {
+        *nBytes += (stats1.frameErrors - stats0.frameErrors) + (stats1.parityErrors - stats0.parityErrors);
+    }
+    parserInit(&rx->parser);
+    const double score = *nBytes > 0 ? (double)nValid / (double)*nBytes : 0.0;
+    RX_DEBUG("autobaud %d (sample): %d bytes, %d messages, score %.2f", baudrate, *nBytes, *nMsgs, score);
+    return score;
+}
+
+// Returns the most likely baudrate, or 0 if the receiver is silent or none of the baudrates looks plausible. This is
+// only a shortcut for the detection that follows, so it gives up early if the data doesn't parse at several baudrates
+// (e.g. a receiver with an unknown protocol).
+static int _rxAutobaudEstimate(RX_t *rx, const int *baudrates, const int numBaudrates)
+{
+    int bestBaudrate = 0;
+    double bestScore = 0.0;
+    int numBad = 0;
+    const uint64_t t1 = TIME() + RX_AUTOBAUD_ESTIMATE_TIME;
+    for (int ix = 0; !rx->abort && (ix < numBaudrates); ix++)
+    {
+        if ( (ix > 0) && (baudrates[ix] == baudrates[0]) )
+        {
+            continue;
+        }
+        const uint64_t now = TIME();
+        if (now >= t1)
+        {
+            RX_DEBUG("autobaud: out of time, cannot estimate baudrate");
+            break;
+        }
+        int nBytes = 0;
+        int nMsgs = 0;
+        const double score = _rxAutobaudSample(rx, baudrates[ix], MIN(RX_AUTOBAUD_SAMPLE_TIME, t1 - now),
+            &nBytes, &nMsgs);
+        // Nothing at all on the line, it will be the same at any other baudrate
+        if (nBytes == 0)
+        {
+            RX_DEBUG("autobaud: no data, cannot estimate baudrate");
+            return 0;
+        }
+        if (score < RX_AUTOBAUD_SCORE_MIN)
+        {
+            numBad++;
+            if (numBad >= RX_AUTOBAUD_ESTIMATE_BAD)
+            {
+                RX_DEBUG("autobaud: garbage at %d baudrates, cannot estimate baudrate", numBad);
+                break;
+            }
+        }
+        if ( (nMsgs > 0) && (score > bestScore) )
+        {
+            bestScore = score;
+            bestBaudrate = baudrates[ix];
+            if (score >= RX_AUTOBAUD_SCORE_GOOD)
+            {
+                break;
+            }
+        }
+    }
+    return bestScore >= RX_AUTOBAUD_SCORE_MIN ? bestBaudrate : 0;
+}
+
+static bool _rxAutobaud(RX_t *rx, const bool estimate)
+{
+    int baudrate = 0;
+    const int currentBaudrate = rxGetBaudrate(rx);
+    int baudrates[] = { currentBaudrate, 9600, 38400, 115200, 230400, 460800, 921600 };
+
+    // Try the most likely baudrate first, if the receiver outputs something
+    const int estBaudrate = estimate ? _rxAutobaudEstimate(rx, baudrates, NUMOF(baudrates)) : 0;
+    if ( !rx->abort && (estBaudrate != 0) && rxSetBaudrate(rx, estBaudrate) )
+    {
+        RX_DEBUG("autobaud %d (estimated)", estBaudrate);
+        if (_rxDetect(rx))
+        {
+            baudrate = estBaudrate;
+        }
+    }
+
+    // Otherwise, try quickly..
+    if (baudrate == 0)
+    {
+        for (int ix = 0; !rx->abort && (ix < NUMOF(baudrates)); ix++)
+        {
+            if ( ((ix > 0) && (baudrates[ix] == currentBaudrate)) || (baudrates[ix] == estBaudrate) )
+            {
+                continue;
+            }
+            if (!rxSetBaudrate(rx, baudrates[ix]))
+            {
+                continue;
+            }
+            RX_DEBUG("autobaud %d (quick)", baudrates[ix]);
+            if (_rxDetect(rx))
+            {
+                baudrate = baudrates[ix];
+                break;
+            }
+        }
+    }
+    // Try harder
+    if (baudrate == 0)
+    {
+        for (int ix = 0; !rx->abort && (ix < NUMOF(baudrates)); ix++)
+        {
+            if ( (ix > 0) && (baudrates[ix] == currentBaudrate) )
+            {
+                continue;
+            }
+            if (!rxSetBaudrate(rx, baudrates[ix]))
+            {
+                continue;
+            }
+            RX_DEBUG("autobaud %d (flush rx/tx)", baudrates[ix]);
+            _rxFlushRx(rx);
+            _rxFlushTx(rx);
+            if (_rxDetect(rx))
+            {
+                baudrate = baudrates[ix];
+                break;
+            }
+        }
+    }
+
+    if ( !rx->abort && (baudrate != 0) )
+    {
+        RX_DEBUG("autobaud %d success: %s", baudrate, rx->detectInfo);
+        return true;
+    }
+    else
+    {
+        RX_DEBUG("autobaud fail");
+        return false;
+    }
+}
+
+
+/* ****************************************************************************************************************** */
+
+static bool _rxReset(RX_t *rx, const RX_RESET_t reset);
+
+bool rxReset(RX_t *rx, const RX_RESET_t reset)
+{
+    if ( (rx == NULL) || (reset == RX_RESET_NONE) )
+    {
+        return false;
+    }
+    // The port may be closed and re-opened
+    const bool ring = _rxRingStop(rx);
+    const bool res = _rxReset(rx, reset);
+    if (ring && rx->port.portOk)
+    {
+        _rxRingStart(rx);
+    }
+    return res;
+}
+
+static bool _rxReset(RX_t *rx, const RX_RESET_t reset)
+{
+    RX_PRINT("Doing receiver reset: %s", rxResetStr(reset));
+
+    // Delete config?
+    if ( (reset == RX_RESET_DEFAULT) || (reset == RX_RESET_FACTORY) )
     {
         RX_DEBUG("Deleting configuration from BBR and Flash layers");
 #if 0
@@ -845,175 +2124,601 @@ const char *rxResetStr(const RX_RESET_t reset)
 
 /* ****************************************************************************************************************** */
 
-int rxGetConfig(RX_t *rx, const UBLOXCFG_LAYER_t layer, const uint32_t *keys, const int numKeys, UBLOXCFG_KEYVAL_t *kv, const int maxKv)
+#define RX_GETCONFIG_WINDOW   4    // Maximum number of UBX-CFG-VALGET polls in flight
+#define RX_GETCONFIG_TIMEOUT  2000 // Timeout for a UBX-CFG-VALGET response [ms]
+#define RX_GETCONFIG_RETRIES  2    // Number of attempts for each UBX-CFG-VALGET poll
+
+typedef struct RX_GETCONFIG_POLL_s
+{
+    int       reqIx;     // Request (index into reqs[])
+    uint16_t  position;  // Position (and index into the request's kv[])
+    uint8_t   layer;     // UBX-CFG-VALGET layer
+    int       attempt;
+    uint64_t  sent;      // Time of the first attempt
+    uint64_t  deadline;
+} RX_GETCONFIG_POLL_t;
+
+typedef struct RX_GETCONFIG_STATE_s
 {
-    if ( (rx == NULL) || (keys == NULL) || (numKeys < 1) || (kv == NULL) || (maxKv < 1) )
+    uint8_t   layer;     // UBX-CFG-VALGET layer
+    int       nextPos;   // Next position to poll
+    int       endPos;    // Number of items, once known (-1 = unknown)
+    int       numPages;  // Number of pages (positions < endPos) received
+    int       recvEnd;   // Position after the last item received
+    bool      failed;
+} RX_GETCONFIG_STATE_t;
+
+// All items received?
+static bool _rxGetConfigComplete(const RX_GETCONFIG_STATE_t *st)
+{
+    return (st->endPos >= 0) &&
+        (st->numPages >= ((st->endPos + UBX_CFG_VALGET_V1_MAX_KV - 1) / UBX_CFG_VALGET_V1_MAX_KV));
+}
+
+static bool _rxGetConfigSend(RX_t *rx, const RX_GETCONFIG_t *req, RX_GETCONFIG_POLL_t *poll)
+{
+    UBX_CFG_VALGET_V0_GROUP0_t pollHead =
     {
-        return -1;
+        .version  = UBX_CFG_VALGET_V0_VERSION,
+        .layer    = poll->layer,
+        .position = poll->position
+    };
+    uint8_t pollPayload[UBX_CFG_VALGET_V0_MAX_SIZE];
+    memcpy(&pollPayload[0], &pollHead, sizeof(pollHead));
+    const int keysSize = req->numKeys * sizeof(uint32_t);
+    memcpy(&pollPayload[sizeof(pollHead)], req->keys, keysSize);
+    const int pollSize = ubxMakeMessage(UBX_CFG_CLSID, UBX_CFG_VALGET_MSGID, pollPayload, sizeof(pollHead) + keysSize,
+        rx->pollBuf);
+    poll->attempt++;
+    const uint32_t timeout =
+        _rxRttTimeout(rx, RX_GETCONFIG_TIMEOUT, poll->attempt, pollSize, UBX_CFG_VALGET_V1_MAX_SIZE);
+    const uint64_t now = TIME();
+    if (poll->attempt == 1)
+    {
+        poll->sent = now;
     }
+    poll->deadline = now + timeout;
+    RX_DEBUG("poll UBX-CFG-VALGET (position=%u, layer=%s, timeout=%u, attempt %d/%d)",
+        poll->position, ubloxcfg_layerName(req->layer), timeout, poll->attempt, RX_GETCONFIG_RETRIES);
+    return rxSend(rx, rx->pollBuf, pollSize);
+}
 
-    const char *layerName = ubloxcfg_layerName(layer);
-    RX_DEBUG("Polling receiver configuration for layer %s", layerName);
+// Remove answered polls from the front of the list. Others stay, to keep the order for matching the NAKs.
+static void _rxGetConfigRemoveAnswered(RX_GETCONFIG_POLL_t *polls, bool *answered, int *numPolls)
+{
+    while ( (*numPolls > 0) && answered[0] )
+    {
+        memmove(&polls[0], &polls[1], (*numPolls - 1) * sizeof(*polls));
+        memmove(&answered[0], &answered[1], (*numPolls - 1) * sizeof(*answered));
+        (*numPolls)--;
+    }
+}
 
-    uint8_t pollLayer = UBLOXCFG_LAYER_DEFAULT;
+static bool _rxGetConfigLayer(const UBLOXCFG_LAYER_t layer, uint8_t *pollLayer)
+{
     switch (layer)
     {
         case UBLOXCFG_LAYER_RAM:
-            pollLayer = UBX_CFG_VALGET_V0_LAYER_RAM;
-            break;
+            *pollLayer = UBX_CFG_VALGET_V0_LAYER_RAM;
+            return true;
         case UBLOXCFG_LAYER_BBR:
-            pollLayer = UBX_CFG_VALGET_V0_LAYER_BBR;
-            break;
+            *pollLayer = UBX_CFG_VALGET_V0_LAYER_BBR;
+            return true;
         case UBLOXCFG_LAYER_FLASH:
-            pollLayer = UBX_CFG_VALGET_V0_LAYER_FLASH;
-            break;
+            *pollLayer = UBX_CFG_VALGET_V0_LAYER_FLASH;
+            return true;
         case UBLOXCFG_LAYER_DEFAULT:
-            pollLayer = UBX_CFG_VALGET_V0_LAYER_DEFAULT;
-            break;
+            *pollLayer = UBX_CFG_VALGET_V0_LAYER_DEFAULT;
+            return true;
     }
+    return false;
+}
 
-    uint64_t t0 = TIME();
-    bool done = false;
-    bool res = true;
-    int totNumKv = 0;
-    uint16_t position = 0;
-    while (!done)
+bool rxGetConfigMulti(RX_t *rx, RX_GETCONFIG_t *reqs, const int numReqs)
+{
+    if ( (rx == NULL) || (reqs == NULL) || (numReqs < 1) || (numReqs > RX_GETCONFIG_MAX_REQS) )
     {
-        if (rx->abort)
+        return false;
+    }
+    RX_GETCONFIG_STATE_t state[RX_GETCONFIG_MAX_REQS];
+    memset(state, 0, sizeof(state));
+    for (int reqIx = 0; reqIx < numReqs; reqIx++)
+    {
+        RX_GETCONFIG_t *req = &reqs[reqIx];
+        req->numKv = -1;
+        if ( (req->keys == NULL) || (req->numKeys < 1) || (req->numKeys > UBX_CFG_VALGET_V0_MAX_K) ||
+             (req->kv == NULL) || (req->maxKv < 1) || !_rxGetConfigLayer(req->layer, &state[reqIx].layer) )
         {
-            break;
+            return false;
         }
+        state[reqIx].endPos = -1;
+        RX_DEBUG("Polling receiver configuration for layer %s", ubloxcfg_layerName(req->layer));
+    }
 
-        // UBX-CFG-VALGET poll request payload
-        UBX_CFG_VALGET_V0_GROUP0_t pollHead =
-        {
-            .version  = UBX_CFG_VALGET_V0_VERSION,
-            .layer    = pollLayer,
-            .position = position
-        };
-        uint8_t pollPayload[UBX_CFG_VALGET_V0_MAX_SIZE];
-        memcpy(&pollPayload[0], &pollHead, sizeof(pollHead));
-        const int keysSize = numKeys * sizeof(uint32_t);
-        memcpy(&pollPayload[sizeof(pollHead)], keys, keysSize);
+    // Polls in flight, in the order they were sent. The receiver handles them in this order.
+    RX_GETCONFIG_POLL_t polls[RX_GETCONFIG_WINDOW];
+    bool answered[RX_GETCONFIG_WINDOW];
+    int numPolls = 0;
+    uint64_t progress = 0; // Time of the last response
 
-        // Poll UBX-CFG-VALGET
-        RX_POLL_UBX_t pollParam =
+    const uint64_t t0 = TIME();
+    bool res = true;
+    while (!rx->abort)
+    {
+        // Send more polls, round-robin over the requests
+        for (bool sent = true; sent && (numPolls < RX_GETCONFIG_WINDOW); )
         {
-            .clsId = UBX_CFG_CLSID, .msgId = UBX_CFG_VALGET_MSGID,
-            .payload = pollPayload, .payloadSize = (sizeof(UBX_CFG_VALGET_V0_GROUP0_t) + keysSize),
-            .retries = 2, .timeout = 2000,
-        };
-        bool pollNak = false;
-        PARSER_MSG_t *msg = rxPollUbx(rx, &pollParam, &pollNak);
-        if (msg == NULL)
+            sent = false;
+            for (int reqIx = 0; (reqIx < numReqs) && (numPolls < RX_GETCONFIG_WINDOW); reqIx++)
+            {
+                RX_GETCONFIG_STATE_t *st = &state[reqIx];
+                // Speculatively poll the next position(s) while we don't know the number of items
+                if ( st->failed || ((st->endPos >= 0) && (st->nextPos >= st->endPos)) ||
+                     (st->nextPos >= reqs[reqIx].maxKv) || (st->nextPos > UINT16_MAX) )
+                {
+                    continue;
+                }
+                RX_GETCONFIG_POLL_t *poll = &polls[numPolls];
+                poll->reqIx    = reqIx;
+                poll->position = st->nextPos;
+                poll->layer    = st->layer;
+                poll->attempt  = 0;
+                if (!_rxGetConfigSend(rx, &reqs[reqIx], poll))
+                {
+                    st->failed = true;
+                    continue;
+                }
+                answered[numPolls] = false;
+                numPolls++;
+                st->nextPos += UBX_CFG_VALGET_V1_MAX_KV;
+                sent = true;
+            }
+        }
+
+        // Are we done? Wait until all polls are answered (or timed out), so that late responses don't confuse
+        // subsequent polls.
+        bool done = true;
+        for (int reqIx = 0; reqIx < numReqs; reqIx++)
         {
-            if (pollNak)
+            RX_GETCONFIG_STATE_t *st = &state[reqIx];
+            if (st->failed || _rxGetConfigComplete(st))
             {
-                RX_DEBUG("No data in layer %s!", layerName);
+                continue;
             }
-            else
+            done = false;
+            bool inFlight = false;
+            for (int ix = 0; ix < numPolls; ix++)
             {
-                RX_WARNING("No response polling UBX-CFG-VALGET (position=%u, layer=%s)!", position, layerName);
-                res = false;
+                inFlight = inFlight || (polls[ix].reqIx == reqIx);
+            }
+            if (!inFlight && (st->endPos < 0) && (st->nextPos >= reqs[reqIx].maxKv))
+            {
+                RX_WARNING("Too many config items (position=%d, layer=%s)!", st->nextPos,
+                    ubloxcfg_layerName(reqs[reqIx].layer));
+                st->failed = true;
             }
+        }
+        if (done && (numPolls == 0))
+        {
             break;
         }
 
-        _rxCallbackMsg(rx, msg);
-
-        // No key-val pairs in data
-        if (msg->size < (int)(UBX_FRAME_SIZE + sizeof(UBX_CFG_VALGET_V0_GROUP0_t) + 4 + 1))
+        // Handle timeouts, resend (as the newest poll) or give up
+        const uint64_t now = TIME();
+        for (int ix = 0; ix < numPolls; ix++)
         {
-            // No data in this layer
-            if ( (position == 0) && ((layer == UBLOXCFG_LAYER_BBR) || (layer == UBLOXCFG_LAYER_FLASH)) )
+            RX_GETCONFIG_POLL_t *poll = &polls[ix];
+            if (answered[ix] || (now < poll->deadline))
             {
-                break;
+                continue;
             }
-            // No more data for this poll
-            else if (position > 0)
+            RX_GETCONFIG_POLL_t retry = *poll;
+            memmove(&polls[ix], &polls[ix + 1], (numPolls - ix - 1) * sizeof(*polls));
+            memmove(&answered[ix], &answered[ix + 1], (numPolls - ix - 1) * sizeof(*answered));
+            numPolls--;
+            ix--;
+            RX_GETCONFIG_STATE_t *st = &state[retry.reqIx];
+            const bool needed = !st->failed && ((st->endPos < 0) || (retry.position < st->endPos));
+            if (!needed)
             {
-                break;
+                continue;
+            }
+            if ( (retry.attempt < RX_GETCONFIG_RETRIES) && _rxGetConfigSend(rx, &reqs[retry.reqIx], &retry) )
+            {
+                polls[numPolls] = retry;
+                answered[numPolls] = false;
+                numPolls++;
             }
-            // Unexpectedly no data for layer that must have data
             else
             {
-                RX_WARNING("Bad response polling UBX-CFG-VALGET (position=%u, layer=%s)!", position, layerName);
-                res = false;
-                break;
+                RX_WARNING("No response polling UBX-CFG-VALGET (position=%u, layer=%s)!",
+                    retry.position, ubloxcfg_layerName(reqs[retry.reqIx].layer));
+                st->failed = true;
             }
-
-            res = false;
-            break;
-        }
-
-        // Check result
-        UBX_CFG_VALGET_V1_GROUP0_t respHead;
-        memcpy(&respHead, &msg->data[UBX_HEAD_SIZE], sizeof(respHead));
-        if ( (respHead.version != UBX_CFG_VALGET_V1_VERSION) || (respHead.position != position) ||
-            (respHead.layer != pollLayer) )
-        {
-            RX_WARNING("Unexpected response polling UBX-CFG-VALGET (position=%u, layer=%s)!", position, layerName);
-            DEBUG_HEXDUMP(msg->data, msg->size, "version: %u %u, position: %u %u, layer: %u %u",
-                respHead.version, UBX_CFG_VALGET_V1_VERSION,
-                respHead.position, position, respHead.layer, layer);
-            res = false;
-            break;
         }
+        _rxGetConfigRemoveAnswered(polls, answered, &numPolls);
 
-        // Add received data to list
-        int numKv = 0;
-        const int cfgDataSize = msg->size - UBX_FRAME_SIZE - sizeof(UBX_CFG_VALGET_V1_GROUP0_t);
-        if (cfgDataSize > 0)
+        // Get next message
+        PARSER_MSG_t *msg = rxGetNextMessage(rx);
+        if (msg == NULL)
         {
-            if (!ubloxcfg_parseData(&msg->data[UBX_HEAD_SIZE + sizeof(UBX_CFG_VALGET_V1_GROUP0_t)],
-                cfgDataSize, &kv[totNumKv], UBX_CFG_VALGET_V1_MAX_KV, &numKv))
+            uint64_t deadline = now + 100;
+            for (int ix = 0; ix < numPolls; ix++)
             {
-                RX_WARNING("Bad config data in UBX-CFG-VALGET response (position=%u, layer=%s)!", position, layerName);
-                DEBUG_HEXDUMP(msg->data, msg->size, NULL);
-                res = false;
-                break;
+                deadline = MIN(deadline, polls[ix].deadline);
             }
-            totNumKv += numKv;
+            _rxWaitUntil(rx, deadline);
+            continue;
+        }
+        _rxCallbackMsg(rx, msg);
+        if ( (msg->type != PARSER_MSGTYPE_UBX) || (numPolls == 0) )
+        {
+            continue;
         }
 
-        // Are we done?
-        if (numKv < UBX_CFG_VALGET_V1_MAX_KV)
+        // Find the poll this is the answer to: UBX-CFG-VALGET responses have the layer and position. UBX-ACK-NAK
+        // don't, see below. UBX-ACK-ACK (after responses) are not needed.
+        const uint8_t clsId = UBX_CLSID(msg->data);
+        const uint8_t msgId = UBX_MSGID(msg->data);
+        int pollIx = -1;
+        uint64_t sent = 0;
+        bool retried = false; // Response could be to an earlier attempt
+        bool nak = false;
+        UBX_CFG_VALGET_V1_GROUP0_t respHead;
+        if ( (clsId == UBX_CFG_CLSID) && (msgId == UBX_CFG_VALGET_MSGID) &&
+             (msg->size >= (int)(UBX_FRAME_SIZE + sizeof(respHead))) )
+        {
+            memcpy(&respHead, &msg->data[UBX_HEAD_SIZE], sizeof(respHead));
+            for (int ix = 0; ix < numPolls; ix++)
+            {
+                if (!answered[ix] && (polls[ix].layer == respHead.layer) && (polls[ix].position == respHead.position))
+                {
+                    pollIx = ix;
+                    break;
+                }
+            }
+            if ( (pollIx < 0) || (respHead.version != UBX_CFG_VALGET_V1_VERSION) )
+            {
+                RX_DEBUG("Unexpected UBX-CFG-VALGET response (version=%u, position=%u, layer=%u)",
+                    respHead.version, respHead.position, respHead.layer);
+                continue;
+            }
+            sent = polls[pollIx].sent;
+            retried = polls[pollIx].attempt > 1;
+        }
+        else if ( (clsId == UBX_ACK_CLSID) && (msgId == UBX_ACK_NAK_MSGID) &&
+                  (msg->size >= (int)(UBX_FRAME_SIZE + sizeof(UBX_ACK_ACK_V0_GROUP0_t))) )
         {
-            done = true;
+            const UBX_ACK_ACK_V0_GROUP0_t *ack = (const UBX_ACK_ACK_V0_GROUP0_t *)&msg->data[UBX_HEAD_SIZE];
+            if ( (ack->clsId != UBX_CFG_CLSID) || (ack->msgId != UBX_CFG_VALGET_MSGID) )
+            {
+                continue;
+            }
+            // The NAK is for the oldest poll not answered yet, unless the responses to that (and maybe more) were
+            // lost. If all unanswered polls are for the same request, we can use the one with the highest position:
+            // there's no data at or beyond the position the NAK is really for. That only bounds the end, and the
+            // NAKs for the other polls (or their re-sends) will take it down to the actual end. With polls for
+            // different requests in flight we can't tell and have to go with the oldest.
+            int oldestIx = -1;
+            bool sameReq = true;
+            for (int ix = 0; ix < numPolls; ix++)
+            {
+                if (answered[ix])
+                {
+                    continue;
+                }
+                if (oldestIx < 0)
+                {
+                    oldestIx = ix;
+                    pollIx = ix;
+                }
+                if (polls[ix].attempt > 1)
+                {
+                    retried = true;
+                }
+                if (polls[ix].reqIx != polls[oldestIx].reqIx)
+                {
+                    sameReq = false;
+                }
+                else if (polls[ix].position > polls[pollIx].position)
+                {
+                    pollIx = ix;
+                }
+            }
+            if (oldestIx < 0)
+            {
+                continue;
+            }
+            if (!sameReq)
+            {
+                pollIx = oldestIx;
+            }
+            // There can't be a NAK for a position below data we already have. The response to the oldest poll must
+            // have been lost, and the NAK is for a later poll. Re-send the oldest poll now (or give up), and let the
+            // others time out.
+            if (polls[pollIx].position < state[polls[pollIx].reqIx].recvEnd)
+            {
+                RX_DEBUG("Unexpected UBX-ACK-NAK (position=%u < %d)", polls[pollIx].position,
+                    state[polls[pollIx].reqIx].recvEnd);
+                polls[oldestIx].deadline = 0;
+                continue;
+            }
+            // Whichever poll the NAK is for, it wasn't sent before the oldest one
+            sent = polls[oldestIx].sent;
+            nak = true;
         }
         else
         {
-            position += UBX_CFG_VALGET_V1_MAX_KV;
+            continue;
+        }
+        const RX_GETCONFIG_POLL_t poll = polls[pollIx];
+        answered[pollIx] = true;
+
+        // No round-trip time sample if the response may have been queued behind the previous one, or may be to an
+        // earlier attempt (the polls are small, so we don't bother about their transfer time)
+        if (!retried && (sent >= progress))
+        {
+            _rxRttSample(rx, sent, 0, msg->size);
+        }
+        progress = TIME();
+
+        // Responses to the other polls may be queued behind this one (e.g. on slow links), so the timeout is for no
+        // progress rather than for each poll
+        for (int ix = 0; ix < numPolls; ix++)
+        {
+            polls[ix].deadline = MAX(polls[ix].deadline,
+                progress + _rxRttTimeout(rx, RX_GETCONFIG_TIMEOUT, polls[ix].attempt, 0, UBX_CFG_VALGET_V1_MAX_SIZE));
+        }
+
+        _rxGetConfigRemoveAnswered(polls, answered, &numPolls);
+
+        RX_GETCONFIG_t *req = &reqs[poll.reqIx];
+        RX_GETCONFIG_STATE_t *st = &state[poll.reqIx];
+        const char *layerName = ubloxcfg_layerName(req->layer);
+        if (st->failed || ((st->endPos >= 0) && (poll.position >= st->endPos)))
+        {
+            continue; // No longer needed
         }
 
-        // Debug
-        RX_DEBUG("Received %d items from (position=%u, layer=%s, done=%s)",
-            numKv, position, layerName, done ? "yes" : "no");
+        // No (more) data
+        const int cfgDataSize = nak ? 0 : msg->size - UBX_FRAME_SIZE - sizeof(UBX_CFG_VALGET_V1_GROUP0_t);
+        if (cfgDataSize <= 0)
+        {
+            // The end can't be below data we already have
+            if (poll.position < st->recvEnd)
+            {
+                RX_WARNING("Inconsistent UBX-CFG-VALGET response (position=%u, layer=%s)!", poll.position, layerName);
+                st->failed = true;
+                continue;
+            }
+            // Layers RAM and Default must have data
+            if ( !nak && (poll.position == 0) &&
+                 ((req->layer == UBLOXCFG_LAYER_RAM) || (req->layer == UBLOXCFG_LAYER_DEFAULT)) )
+            {
+                RX_WARNING("Bad response polling UBX-CFG-VALGET (position=%u, layer=%s)!", poll.position, layerName);
+                st->failed = true;
+                continue;
+            }
+            if (nak && (poll.position == 0))
+            {
+                RX_DEBUG("No data in layer %s!", layerName);
+            }
+            st->endPos = poll.position;
+            continue;
+        }
+
+        // Add received data to list, at the position
+        int numKv = 0;
+        if (!ubloxcfg_parseData(&msg->data[UBX_HEAD_SIZE + sizeof(UBX_CFG_VALGET_V1_GROUP0_t)], cfgDataSize,
+                &req->kv[poll.position], MIN(UBX_CFG_VALGET_V1_MAX_KV, req->maxKv - poll.position), &numKv))
+        {
+            RX_WARNING("Bad config data in UBX-CFG-VALGET response (position=%u, layer=%s)!", poll.position, layerName);
+            DEBUG_HEXDUMP(msg->data, msg->size, NULL);
+            st->failed = true;
+            continue;
+        }
+        // A short page is the last one, so there can't be data beyond it
+        if ( (numKv < UBX_CFG_VALGET_V1_MAX_KV) && ((poll.position + numKv) < st->recvEnd) )
+        {
+            RX_WARNING("Inconsistent UBX-CFG-VALGET response (position=%u, layer=%s)!", poll.position, layerName);
+            st->failed = true;
+            continue;
+        }
+        st->numPages++;
+        st->recvEnd = MAX(st->recvEnd, poll.position + numKv);
+        if (numKv < UBX_CFG_VALGET_V1_MAX_KV)
+        {
+            st->endPos = poll.position + numKv;
+        }
+        RX_DEBUG("Received %d items from (position=%u, layer=%s)", numKv, poll.position, layerName);
         if (isTRACE())
         {
-            for (int ix = totNumKv - numKv; ix < totNumKv; ix++)
+            for (int ix = poll.position; ix < (poll.position + numKv); ix++)
             {
                 char str[UBLOXCFG_MAX_KEYVAL_STR_SIZE];
-                if (ubloxcfg_stringifyKeyVal(str, sizeof(str), &kv[ix]))
+                if (ubloxcfg_stringifyKeyVal(str, sizeof(str), &req->kv[ix]))
                 {
                     RX_TRACE("kv[%d]: %s", ix, str);
                 }
             }
         }
+    }
 
-        // Enough space left in list?
-        if ( (totNumKv + UBX_CFG_VALGET_V1_MAX_KV) > maxKv )
+    for (int reqIx = 0; reqIx < numReqs; reqIx++)
+    {
+        RX_GETCONFIG_t *req = &reqs[reqIx];
+        const RX_GETCONFIG_STATE_t *st = &state[reqIx];
+        if (!st->failed && _rxGetConfigComplete(st))
+        {
+            req->numKv = st->endPos;
+            // Report the baudrate the receiver UART will be at again after rxClose(), not the one rxUpshift() set
+            if ( (rx->upshiftId != 0) && (req->layer == UBLOXCFG_LAYER_RAM) )
+            {
+                for (int ix = 0; ix < req->numKv; ix++)
+                {
+                    if (req->kv[ix].id == rx->upshiftId)
+                    {
+                        req->kv[ix].val.U4 = rx->upshiftOrig;
+                    }
+                }
+            }
+        }
+        else
         {
-            RX_WARNING("Too many config items (position=%u, layer=%s)!", position, layerName);
             res = false;
+        }
+        RX_DEBUG("Total %d items for layer %s", req->numKv, ubloxcfg_layerName(req->layer));
+    }
+    RX_DEBUG("Poll duration %"PRIu64"ms, res=%d", TIME() - t0, res);
+    return res;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+int rxGetConfig(RX_t *rx, const UBLOXCFG_LAYER_t layer, const uint32_t *keys, const int numKeys, UBLOXCFG_KEYVAL_t *kv, const int maxKv)
+{
+    RX_GETCONFIG_t req = { .layer = layer, .keys = keys, .numKeys = numKeys, .kv = kv, .maxKv = maxKv };
+    return rxGetConfigMulti(rx, &req, 1) ? req.numKv : -1;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+#define RX_SETCONFIG_WINDOW   4    // Maximum number of UBX-CFG-VALSET messages in flight
+#define RX_SETCONFIG_TIMEOUT  2500 // Timeout for a UBX-ACK-ACK resp. UBX-ACK-NAK [ms]
+#define RX_SETCONFIG_RETRIES  2    // Number of attempts for the whole transaction
+
+// No progress timeout, pending = size of the messages not acknowledged yet [bytes]
+static uint32_t _rxSetConfigTimeout(RX_t *rx, const bool flash, const int attempt, const int pending)
+{
+    return flash ? RX_SETCONFIG_TIMEOUT :
+        _rxRttTimeout(rx, RX_SETCONFIG_TIMEOUT, attempt, pending, UBX_ACK_ACK_V0_SIZE);
+}
+
+// Send the UBX-CFG-VALSET messages, with up to RX_SETCONFIG_WINDOW of them in flight. The receiver handles them in
+// order, so the UBX-ACK-ACK and UBX-ACK-NAK are for the oldest message not acknowledged yet. On failure (NAK, timeout)
+// no more messages are sent, but we wait for the responses to the ones in flight, so that they don't confuse a retry.
+// After a timeout that's one more timeout period at most.
+// The acknowledgements give round-trip time samples in the first attempt only (in a later attempt they could be late
+// ones from an earlier attempt), if they were not queued behind the previous one, and not when writing to the Flash.
+static bool _rxSetConfigSend(RX_t *rx, const UBX_CFG_VALSET_MSG_t *msgs, const int nMsgs, const int attempt)
+{
+    int sendIx = 0;   // Next message to send
+    int ackIx = 0;    // Next message to be acknowledged
+    uint64_t deadline = 0;
+    uint64_t sent[RX_SETCONFIG_WINDOW]; // Time the messages in flight were sent, by index modulo window size
+    uint64_t progress = 0;              // Time of the last acknowledgement
+    int pending = 0;                    // Size of the messages in flight [bytes]
+    const bool flash = (nMsgs > 0) && _rxIsFlashWrite(msgs[0].msg, msgs[0].size);
+    bool res = true;
+    bool timeout = false;
+    while (!rx->abort && (ackIx < (res ? nMsgs : sendIx)))
+    {
+        // Fill the window
+        bool didSend = false;
+        while ( res && (sendIx < nMsgs) && ((sendIx - ackIx) < RX_SETCONFIG_WINDOW) )
+        {
+            RX_PRINT("Sending UBX-CFG-VALSET %d/%d (%s)", sendIx + 1, nMsgs, msgs[sendIx].info);
+            RX_TRACE_HD(msgs[sendIx].msg, msgs[sendIx].size, "UBX-CFG-VALSET");
+            if (!rxSend(rx, msgs[sendIx].msg, msgs[sendIx].size))
+            {
+                res = false;
+                break;
+            }
+            sent[sendIx % RX_SETCONFIG_WINDOW] = TIME();
+            pending += msgs[sendIx].size;
+            sendIx++;
+            didSend = true;
+        }
+        // The timeout is for no progress (sending the messages may take a while on slow links)
+        if (didSend)
+        {
+            deadline = TIME() + _rxSetConfigTimeout(rx, flash, attempt, pending);
+        }
+        if (ackIx >= sendIx)
+        {
             break;
         }
 
+        PARSER_MSG_t *msg = rxGetNextMessage(rx);
+        if (msg == NULL)
+        {
+            if (TIME() >= deadline)
+            {
+                if (timeout)
+                {
+                    break;
+                }
+                // Wait once more for late acknowledgements of the messages in flight
+                RX_DEBUG("ack/nak UBX-CFG-VALSET %d/%d timeout", ackIx + 1, nMsgs);
+                res = false;
+                timeout = true;
+                deadline = TIME() + _rxSetConfigTimeout(rx, flash, attempt, pending);
+            }
+            _rxWaitUntil(rx, deadline);
+            continue;
+        }
+        _rxCallbackMsg(rx, msg);
+        if ( (msg->type != PARSER_MSGTYPE_UBX) || (UBX_CLSID(msg->data) != UBX_ACK_CLSID) ||
+             (msg->size < (int)(UBX_FRAME_SIZE + sizeof(UBX_ACK_ACK_V0_GROUP0_t))) )
+        {
+            continue;
+        }
+        const UBX_ACK_ACK_V0_GROUP0_t *ack = (const UBX_ACK_ACK_V0_GROUP0_t *)&msg->data[UBX_HEAD_SIZE];
+        if ( (ack->clsId != UBX_CFG_CLSID) || (ack->msgId != UBX_CFG_VALSET_MSGID) )
+        {
+            continue;
+        }
+        if (UBX_MSGID(msg->data) == UBX_ACK_NAK_MSGID)
+        {
+            RX_DEBUG("UBX-ACK-NAK: UBX-CFG-VALSET %d/%d", ackIx + 1, nMsgs);
+            res = false;
+        }
+        else
+        {
+            RX_DEBUG("UBX-ACK-ACK: UBX-CFG-VALSET %d/%d", ackIx + 1, nMsgs);
+        }
+        // The acknowledgement may have been queued behind the previous one
+        const uint64_t msgSent = sent[ackIx % RX_SETCONFIG_WINDOW];
+        if ( (attempt == 1) && !flash && (msgSent >= progress) )
+        {
+            _rxRttSample(rx, msgSent, msgs[ackIx].size, msg->size);
+        }
+        progress = TIME();
+        pending -= msgs[ackIx].size;
+        ackIx++;
+        deadline = progress + _rxSetConfigTimeout(rx, flash, attempt, pending);
     }
-    // while 64 left, not complete, ...
-    RX_DEBUG("Total %d items for layer %s (poll duration %"PRIu64"ms), res=%d", totNumKv, layerName, TIME() - t0, res);
+    return res && (ackIx >= nMsgs);
+}
 
-    return res ? totNumKv : -1;
+// Discard the changes of a failed transaction by starting a new, empty transaction (which also discards the changes
+// buffered so far) and ending it.
+static void _rxSetConfigRollback(RX_t *rx, const UBX_CFG_VALSET_MSG_t *msg)
+{
+    RX_PRINT("Rolling back UBX-CFG-VALSET transaction");
+    UBX_CFG_VALSET_V1_GROUP0_t head =
+    {
+        .version     = UBX_CFG_VALSET_V1_VERSION,
+        .layers      = msg->msg[UBX_HEAD_SIZE + offsetof(UBX_CFG_VALSET_V1_GROUP0_t, layers)],
+        .transaction = UBX_CFG_VALSET_V1_TRANSACTION_BEGIN,
+        .reserved    = UBX_CFG_VALSET_V1_RESERVED,
+    };
+    UBX_CFG_VALSET_MSG_t *empty = calloc(2, sizeof(UBX_CFG_VALSET_MSG_t));
+    if (empty == NULL)
+    {
+        RX_WARNING("malloc fail");
+        return;
+    }
+    empty[0].size = ubxMakeMessage(UBX_CFG_CLSID, UBX_CFG_VALSET_MSGID, (const uint8_t *)&head, sizeof(head), empty[0].msg);
+    snprintf(empty[0].info, sizeof(empty[0].info), "empty, transaction begin");
+    head.transaction = UBX_CFG_VALSET_V1_TRANSACTION_END;
+    empty[1].size = ubxMakeMessage(UBX_CFG_CLSID, UBX_CFG_VALSET_MSGID, (const uint8_t *)&head, sizeof(head), empty[1].msg);
+    snprintf(empty[1].info, sizeof(empty[1].info), "empty, transaction end");
+    if (!_rxSetConfigSend(rx, empty, 2, RX_SETCONFIG_RETRIES + 1)) // After the failed attempts
+    {
+        RX_WARNING("Failed rolling back UBX-CFG-VALSET transaction!");
+    }
+    free(empty);
 }
 
 bool rxSetConfig(RX_t *rx, const UBLOXCFG_KEYVAL_t *kv, const int nKv, const bool ram, const bool bbr, const bool flash)
@@ -1030,23 +2735,782 @@ bool rxSetConfig(RX_t *rx, const UBLOXCFG_KEYVAL_t *kv, const int nKv, const boo
         return false;
     }
 
+    // Several messages make a transaction. Retrying it (after a NAK or timeout) starts it over with the
+    // "transaction begin" message, which discards the changes buffered by the receiver so far.
     RX_PRINT("Sending %d key-value pairs in %d UBX-CFG-VALSET messages", nKv, nMsgs);
-    bool res = true;
-    for (int ix = 0; ix < nMsgs; ix++)
+    const uint64_t t0 = TIME();
+    bool res = false;
+    for (int attempt = 1; !res && !rx->abort && (attempt <= RX_SETCONFIG_RETRIES); attempt++)
     {
-        RX_PRINT("Sending UBX-CFG-VALSET %d/%d (%s)", ix + 1, nMsgs, msgs[ix].info);
-        if (!rxSendUbxCfg(rx, msgs[ix].msg, msgs[ix].size, 2500))
+        if (attempt > 1)
         {
-            RX_WARNING("Failed configuring receiver!");
-            res = false;
-            break;
+            RX_PRINT("Retrying UBX-CFG-VALSET (attempt %d/%d)", attempt, RX_SETCONFIG_RETRIES);
+        }
+        res = _rxSetConfigSend(rx, msgs, nMsgs, attempt);
+    }
+    if (!res)
+    {
+        if (nMsgs > 1)
+        {
+            _rxSetConfigRollback(rx, &msgs[0]);
         }
+        RX_WARNING("Failed configuring receiver!");
     }
+    RX_DEBUG("Config duration %"PRIu64"ms, res=%d", TIME() - t0, res);
 
     free(msgs);
     return res;
 }
 
+/* ****************************************************************************************************************** */
+
+// Reader thread and single-producer single-consumer ring buffer. The reader thread (producer) reads chunks of data
+// from the port into the ring buffer and notes their arrival time. rxGetNextMessage() (consumer) feeds one chunk at a
+// time to the parser. Only the chunk positions (chunkHead, written by producer) and the consumed position (tail,
+// written by consumer) are shared. The port is shared, too: the reader thread reads while the caller's thread writes
+// (and e.g. gets the statistics). Port accesses are serialised by portMutex, as reading may write (e.g. telnet
+// negotiation) and both update the statistics.
+
+#ifndef _WIN32
+
+#define RX_RING_NUM_CHUNKS  1024 // Must be a power of 2
+#define RX_RING_CHUNK_SIZE  4096 // Max size of a chunk (one port read)
+
+typedef struct RX_RING_CHUNK_s
+{
+    uint64_t        end;         // Position after the chunk
+    uint64_t        ts;          // Arrival time of the chunk (TIME())
+} RX_RING_CHUNK_t;
+
+typedef struct RX_RING_s
+{
+    // Ring buffer
+    uint8_t        *buf;
+    uint32_t        size;        // Power of 2
+    uint64_t        head;        // Write position (producer)
+    uint64_t        tail;        // Read position (consumer)
+    RX_RING_CHUNK_t chunks[RX_RING_NUM_CHUNKS];
+    uint64_t        chunkHead;   // Next chunk to write (producer)
+    uint64_t        chunkTail;   // Next chunk to read (consumer)
+    // Statistics (producer)
+    uint32_t        highWater;
+    uint32_t        numChunks;
+    uint32_t        numOverruns;
+    uint32_t        numDropped;
+    // Reader thread
+    pthread_t       thread;
+    bool            run;
+    bool            failed;      // Port failed, thread stopped
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    bool            waiting;     // Consumer waits for data
+    pthread_mutex_t portMutex;   // Port access, see _rxRingLockPort()
+    uint8_t         readBuf[RX_RING_CHUNK_SIZE];
+} RX_RING_t;
+
+static void *_rxRingThread(void *arg)
+{
+    RX_t *rx = (RX_t *)arg;
+    RX_RING_t *ring = rx->ring;
+    RX_DEBUG("reader thread start");
+    while (__atomic_load_n(&ring->run, __ATOMIC_ACQUIRE))
+    {
+        if (!portWaitReadable(&rx->port, 100))
+        {
+            continue;
+        }
+        int readSize = 0;
+        pthread_mutex_lock(&ring->portMutex);
+        const bool readOk = portRead(&rx->port, ring->readBuf, sizeof(ring->readBuf), &readSize);
+        pthread_mutex_unlock(&ring->portMutex);
+        if (!readOk)
+        {
+            // Port failed, let the consumer reconnect
+            if (rx->opts.reconnect)
+            {
+                __atomic_store_n(&ring->failed, true, __ATOMIC_RELEASE);
+                pthread_mutex_lock(&ring->mutex);
+                pthread_cond_signal(&ring->cond);
+                pthread_mutex_unlock(&ring->mutex);
+                break;
+            }
+            SLEEP(100); // Don't spin
+            continue;
+        }
+        if (readSize <= 0)
+        {
+            continue;
+        }
+        const uint64_t ts = TIME();
+        ring->numChunks++;
+
+        // Check space
+        const uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        const uint64_t chunkTail = __atomic_load_n(&ring->chunkTail, __ATOMIC_ACQUIRE);
+        const uint32_t used = ring->head - tail;
+        if ( ((used + readSize) > ring->size) || ((ring->chunkHead - chunkTail) >= RX_RING_NUM_CHUNKS) )
+        {
+            ring->numOverruns++;
+            ring->numDropped += readSize;
+            continue;
+        }
+        if ((used + readSize) > ring->highWater)
+        {
+            ring->highWater = used + readSize;
+        }
+
+        // Copy data, publish chunk
+        const uint32_t offs = ring->head & (ring->size - 1);
+        const uint32_t size1 = MIN((uint32_t)readSize, ring->size - offs);
+        memcpy(&ring->buf[offs], ring->readBuf, size1);
+        memcpy(ring->buf, &ring->readBuf[size1], readSize - size1);
+        ring->head += readSize;
+        RX_RING_CHUNK_t *chunk = &ring->chunks[ring->chunkHead & (RX_RING_NUM_CHUNKS - 1)];
+        chunk->end = ring->head;
+        chunk->ts = ts;
+        // Publish chunk, then check if the consumer waits. This (and the opposite in _rxRingWait()) is a store followed
+        // by a load, which needs sequential consistency. With acquire/release both sides could see the old value and
+        // the consumer would sleep despite data being available.
+        __atomic_store_n(&ring->chunkHead, ring->chunkHead + 1, __ATOMIC_SEQ_CST);
+
+        // Wake up consumer
+        if (__atomic_load_n(&ring->waiting, __ATOMIC_SEQ_CST))
+        {
+            pthread_mutex_lock(&ring->mutex);
+            pthread_cond_signal(&ring->cond);
+            pthread_mutex_unlock(&ring->mutex);
+        }
+    }
+    RX_DEBUG("reader thread stop");
+    return NULL;
+}
+
+static bool _rxRingStart(RX_t *rx)
+{
+    if (rx->ring != NULL)
+    {
+        return true;
+    }
+    RX_RING_t *ring = calloc(1, sizeof(RX_RING_t));
+    uint32_t size = RX_RING_CHUNK_SIZE;
+    while (size < rx->opts.ringSize)
+    {
+        size <<= 1;
+    }
+    if ( (ring == NULL) || ((ring->buf = malloc(size)) == NULL) )
+    {
+        RX_WARNING("Reader thread malloc fail!");
+        free(ring);
+        return false;
+    }
+    ring->size = size;
+    ring->run = true;
+    pthread_mutex_init(&ring->mutex, NULL);
+    pthread_mutex_init(&ring->portMutex, NULL);
+    // Use the monotonic clock for waiting, so that wall clock changes don't affect the timeout
+    pthread_condattr_t condAttr;
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    pthread_cond_init(&ring->cond, &condAttr);
+    pthread_condattr_destroy(&condAttr);
+    rx->ring = ring;
+    if (pthread_create(&ring->thread, NULL, _rxRingThread, rx) != 0)
+    {
+        RX_WARNING("Reader thread start fail!");
+        rx->ring = NULL;
+        pthread_cond_destroy(&ring->cond);
+        pthread_mutex_destroy(&ring->mutex);
+        pthread_mutex_destroy(&ring->portMutex);
+        free(ring->buf);
+        free(ring);
+        return false;
+    }
+    RX_DEBUG("reader thread ring buffer %u bytes", size);
+    return true;
+}
+
+static bool _rxRingStop(RX_t *rx)
+{
+    RX_RING_t *ring = rx->ring;
+    if (ring == NULL)
+    {
+        return false;
+    }
+    __atomic_store_n(&ring->run, false, __ATOMIC_RELEASE);
+    pthread_join(ring->thread, NULL);
+    RX_DEBUG("reader thread stats: chunks %u, high water %u/%u, overruns %u (%u bytes)",
+        ring->numChunks, ring->highWater, ring->size, ring->numOverruns, ring->numDropped);
+    rx->ring = NULL;
+    pthread_cond_destroy(&ring->cond);
+    pthread_mutex_destroy(&ring->mutex);
+    pthread_mutex_destroy(&ring->portMutex);
+    free(ring->buf);
+    free(ring);
+    return true;
+}
+
+// Feed next chunk to the parser, returns false if there was no data
+static bool _rxRingGet(RX_t *rx)
+{
+    RX_RING_t *ring = rx->ring;
+    if (ring->chunkTail == __atomic_load_n(&ring->chunkHead, __ATOMIC_ACQUIRE))
+    {
+        return false;
+    }
+    const RX_RING_CHUNK_t *chunk = &ring->chunks[ring->chunkTail & (RX_RING_NUM_CHUNKS - 1)];
+    const uint32_t size = chunk->end - ring->tail;
+    const uint32_t offs = ring->tail & (ring->size - 1);
+    const uint32_t size1 = MIN(size, ring->size - offs);
+    parserAdd(&rx->parser, &ring->buf[offs], size1);
+    if (size1 < size)
+    {
+        parserAdd(&rx->parser, ring->buf, size - size1);
+    }
+    rx->ringTs = chunk->ts; // Arrival time of the last chunk given to the parser
+    __atomic_store_n(&ring->tail, chunk->end, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->chunkTail, ring->chunkTail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool _rxRingWait(RX_t *rx, const uint32_t timeout)
+{
+    RX_RING_t *ring = rx->ring;
+    pthread_mutex_lock(&ring->mutex);
+    __atomic_store_n(&ring->waiting, true, __ATOMIC_SEQ_CST); // See _rxRingThread()
+    bool avail = ring->chunkTail != __atomic_load_n(&ring->chunkHead, __ATOMIC_SEQ_CST);
+    if (!avail && !__atomic_load_n(&ring->failed, __ATOMIC_ACQUIRE))
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        ts.tv_sec  += timeout / 1000;
+        ts.tv_nsec += (timeout % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&ring->cond, &ring->mutex, &ts);
+        avail = ring->chunkTail != __atomic_load_n(&ring->chunkHead, __ATOMIC_ACQUIRE);
+    }
+    __atomic_store_n(&ring->waiting, false, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&ring->mutex);
+    return avail || __atomic_load_n(&ring->failed, __ATOMIC_ACQUIRE);
+}
+
+static bool _rxRingFailed(RX_t *rx)
+{
+    return __atomic_load_n(&rx->ring->failed, __ATOMIC_ACQUIRE);
+}
+
+// Serialise port accesses from the caller's thread with the reader thread, if it is running. The ring is only started
+// and stopped by the caller's thread, so no lock is needed for checking that.
+static void _rxRingLockPort(RX_t *rx)
+{
+    if (rx->ring != NULL)
+    {
+        pthread_mutex_lock(&rx->ring->portMutex);
+    }
+}
+
+static void _rxRingUnlockPort(RX_t *rx)
+{
+    if (rx->ring != NULL)
+    {
+        pthread_mutex_unlock(&rx->ring->portMutex);
+    }
+}
+
+bool rxGetRingStats(RX_t *rx, RX_RING_STATS_t *stats)
+{
+    if ( (rx == NULL) || (stats == NULL) )
+    {
+        return false;
+    }
+    memset(stats, 0, sizeof(*stats));
+    const RX_RING_t *ring = rx->ring;
+    if (ring != NULL)
+    {
+        stats->active      = true;
+        stats->size        = ring->size;
+        stats->used        = ring->head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        stats->highWater   = ring->highWater;
+        stats->numChunks   = ring->numChunks;
+        stats->numOverruns = ring->numOverruns;
+        stats->numDropped  = ring->numDropped;
+    }
+    return true;
+}
+
+#else // _WIN32
+
+static bool _rxRingStart(RX_t *rx)
+{
+    RX_WARNING("Reader thread not supported on this platform");
+    return false;
+}
+
+static bool _rxRingStop(RX_t *rx)
+{
+    (void)rx;
+    return false;
+}
+
+static bool _rxRingGet(RX_t *rx)
+{
+    (void)rx;
+    return false;
+}
+
+static bool _rxRingWait(RX_t *rx, const uint32_t timeout)
+{
+    (void)rx;
+    (void)timeout;
+    return false;
+}
+
+static bool _rxRingFailed(RX_t *rx)
+{
+    (void)rx;
+    return false;
+}
+
+static void _rxRingLockPort(RX_t *rx)
+{
+    (void)rx;
+}
+
+static void _rxRingUnlockPort(RX_t *rx)
+{
+    (void)rx;
+}
+
+bool rxGetRingStats(RX_t *rx, RX_RING_STATS_t *stats)
+{
+    if ( (rx == NULL) || (stats == NULL) )
+    {
+        return false;
+    }
+    memset(stats, 0, sizeof(*stats));
+    return true;
+}
+
+#endif // _WIN32
+
+/* ****************************************************************************************************************** */
+
+#ifdef __linux__
+
+#define RX_REACTOR_MAX_EVENTS 64 // Max number of epoll events handled per rxReactorRun() iteration
+#define RX_REACTOR_MAX_READS   4 // Max number of reads per receiver and iteration, for fairness with busy receivers
+#define RX_REACTOR_TX_WAIT     5 // Max wait [ms] for pending transmit data if the port cannot be watched for writability
+#define RX_REACTOR_CONN_WAIT  10 // Max wait [ms] while reconnecting is in progress (see portOpenAsync())
+
+typedef struct RX_REACTOR_ENTRY_s
+{
+    RX_t           *rx;
+    RX_REACTOR_CB_t evcb;
+    void           *arg;
+    bool            active;     // Registered in epoll set
+    bool            txArmed;    // Registered for EPOLLOUT (data pending in the transmit queue)
+    bool            removed;    // Removed (during rxReactorRun()), to be freed
+    uint64_t        timer;      // Timer expiry (TIME()), 0 = not armed
+} RX_REACTOR_ENTRY_t;
+
+struct RX_REACTOR_s
+{
+    int                  epfd;
+    RX_REACTOR_ENTRY_t **entries;
+    int                  numEntries;
+    int                  maxEntries;
+    bool                 running;
+};
+
+RX_REACTOR_t *rxReactorCreate(void)
+{
+    RX_REACTOR_t *reactor = calloc(1, sizeof(RX_REACTOR_t));
+    if (reactor == NULL)
+    {
+        WARNING("rxReactorCreate() malloc fail!");
+        return NULL;
+    }
+    reactor->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (reactor->epfd < 0)
+    {
+        WARNING("rxReactorCreate() epoll fail: %s", strerror(errno));
+        free(reactor);
+        return NULL;
+    }
+    return reactor;
+}
+
+void rxReactorDestroy(RX_REACTOR_t *reactor)
+{
+    if (reactor != NULL)
+    {
+        for (int ix = 0; ix < reactor->numEntries; ix++)
+        {
+            free(reactor->entries[ix]);
+        }
+        free(reactor->entries);
+        close(reactor->epfd);
+        free(reactor);
+    }
+}
+
+static RX_REACTOR_ENTRY_t *_rxReactorFind(RX_REACTOR_t *reactor, RX_t *rx)
+{
+    for (int ix = 0; ix < reactor->numEntries; ix++)
+    {
+        RX_REACTOR_ENTRY_t *entry = reactor->entries[ix];
+        if ( (entry->rx == rx) && !entry->removed )
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+bool rxReactorAdd(RX_REACTOR_t *reactor, RX_t *rx, RX_REACTOR_CB_t evcb, void *arg)
+{
+    // Receivers with reader thread (RX_OPTS_t.ringSize) are not supported
+    if ( (reactor == NULL) || (rx == NULL) || !rx->port.portOk || (rx->ring != NULL) ||
+         (_rxReactorFind(reactor, rx) != NULL) )
+    {
+        return false;
+    }
+    if (reactor->numEntries >= reactor->maxEntries)
+    {
+        const int maxEntries = reactor->maxEntries > 0 ? 2 * reactor->maxEntries : 16;
+        RX_REACTOR_ENTRY_t **entries = realloc(reactor->entries, maxEntries * sizeof(*entries));
+        if (entries == NULL)
+        {
+            RX_WARNING("rxReactorAdd() malloc fail!");
+            return false;
+        }
+        reactor->entries = entries;
+        reactor->maxEntries = maxEntries;
+    }
+    RX_REACTOR_ENTRY_t *entry = calloc(1, sizeof(RX_REACTOR_ENTRY_t));
+    if (entry == NULL)
+    {
+        RX_WARNING("rxReactorAdd() malloc fail!");
+        return false;
+    }
+    entry->rx   = rx;
+    entry->evcb = evcb;
+    entry->arg  = arg;
+
+    struct epoll_event ev = { .events = EPOLLIN, .data = { .ptr = entry } };
+    if (epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, rx->port.fd, &ev) != 0)
+    {
+        RX_WARNING("rxReactorAdd() epoll fail: %s", strerror(errno));
+        free(entry);
+        return false;
+    }
+    entry->active = true;
+    reactor->entries[reactor->numEntries++] = entry;
+    RX_DEBUG("reactor add (%d receivers)", reactor->numEntries);
+    return true;
+}
+
+static void _rxReactorDeactivate(RX_REACTOR_t *reactor, RX_REACTOR_ENTRY_t *entry)
+{
+    if (entry->active)
+    {
+        // This may fail if the fd was already closed (rxClose()), in which case it's no longer in the set anyway
+        epoll_ctl(reactor->epfd, EPOLL_CTL_DEL, entry->rx->port.fd, NULL);
+        entry->active = false;
+        entry->txArmed = false;
+    }
+}
+
+static void _rxReactorCleanup(RX_REACTOR_t *reactor)
+{
+    int numEntries = 0;
+    for (int ix = 0; ix < reactor->numEntries; ix++)
+    {
+        RX_REACTOR_ENTRY_t *entry = reactor->entries[ix];
+        if (entry->removed)
+        {
+            free(entry);
+        }
+        else
+        {
+            reactor->entries[numEntries++] = entry;
+        }
+    }
+    reactor->numEntries = numEntries;
+}
+
+bool rxReactorRemove(RX_REACTOR_t *reactor, RX_t *rx)
+{
+    RX_REACTOR_ENTRY_t *entry = (reactor != NULL) && (rx != NULL) ? _rxReactorFind(reactor, rx) : NULL;
+    if (entry == NULL)
+    {
+        return false;
+    }
+    _rxReactorDeactivate(reactor, entry);
+    entry->removed = true;
+    // Pending events may still refer to the entry, rxReactorRun() will clean up
+    if (!reactor->running)
+    {
+        _rxReactorCleanup(reactor);
+    }
+    RX_DEBUG("reactor remove");
+    return true;
+}
+
+bool rxReactorSetTimer(RX_REACTOR_t *reactor, RX_t *rx, const uint32_t timeout)
+{
+    RX_REACTOR_ENTRY_t *entry = (reactor != NULL) && (rx != NULL) ? _rxReactorFind(reactor, rx) : NULL;
+    if (entry == NULL)
+    {
+        return false;
+    }
+    entry->timer = timeout > 0 ? TIME() + timeout : 0;
+    return true;
+}
+
+// Send pending data. If some remains, watch the port for writability (EPOLLOUT), or wait until throttling (tcp and
+// telnet) expires. Returns the max time [ms] to wait.
+static uint64_t _rxReactorTx(RX_REACTOR_t *reactor, RX_REACTOR_ENTRY_t *entry)
+{
+    PORT_t *port = &entry->rx->port;
+    uint64_t wait = UINT64_MAX;
+    bool txArm = false;
+    if ( (portTxPending(port) > 0) && !portFlush(port, 0) && port->portOk )
+    {
+        const uint32_t throttle = portTxThrottle(port);
+        if (throttle > 0)
+        {
+            wait = throttle;
+        }
+        // fd ports may write to a different fd, which is not in the epoll set
+        else if ( (port->type == PORT_TYPE_FD) && (port->fdOut != port->fd) )
+        {
+            wait = RX_REACTOR_TX_WAIT;
+        }
+        else
+        {
+            txArm = true;
+        }
+    }
+    if (txArm != entry->txArmed)
+    {
+        struct epoll_event ev = { .events = EPOLLIN | (txArm ? EPOLLOUT : 0), .data = { .ptr = entry } };
+        if (epoll_ctl(reactor->epfd, EPOLL_CTL_MOD, port->fd, &ev) == 0)
+        {
+            entry->txArmed = txArm;
+        }
+        else if (txArm)
+        {
+            wait = RX_REACTOR_TX_WAIT;
+        }
+    }
+    return wait;
+}
+
+// Read and dispatch available data, returns number of messages
+static int _rxReactorRead(RX_t *rx, int *nBytes, bool *fail)
+{
+    int nMsgs = 0;
+    for (int n = 0; n < RX_REACTOR_MAX_READS; n++)
+    {
+        int readSize = 0;
+        if (!portRead(&rx->port, rx->readBuf, sizeof(rx->readBuf), &readSize))
+        {
+            *fail = true;
+            break;
+        }
+        if (readSize <= 0)
+        {
+            break;
+        }
+        *nBytes += readSize;
+        parserAdd(&rx->parser, rx->readBuf, readSize);
+        while (parserProcess(&rx->parser, &rx->msg, true))
+        {
+            rx->msg.src = PARSER_MSGSRC_FROM_RX;
+            _rxAsyncDispatch(rx, &rx->msg);
+            _rxCallbackMsg(rx, &rx->msg);
+            nMsgs++;
+        }
+        if (readSize < (int)sizeof(rx->readBuf))
+        {
+            break;
+        }
+    }
+    return nMsgs;
+}
+
+int rxReactorRun(RX_REACTOR_t *reactor, const uint32_t timeout)
+{
+    if ( (reactor == NULL) || reactor->running )
+    {
+        return -1;
+    }
+
+    // Don't wait longer than the next timer
+    uint64_t now = TIME();
+    uint64_t wait = timeout;
+    for (int ix = 0; ix < reactor->numEntries; ix++)
+    {
+        const uint64_t timer = reactor->entries[ix]->timer;
+        if (timer != 0)
+        {
+            wait = timer > now ? MIN(wait, timer - now) : 0;
+        }
+        const uint64_t deadline = _rxAsyncDeadline(reactor->entries[ix]->rx);
+        if (deadline != 0)
+        {
+            wait = deadline > now ? MIN(wait, deadline - now) : 0;
+        }
+        if (reactor->entries[ix]->active)
+        {
+            wait = MIN(wait, _rxReactorTx(reactor, reactor->entries[ix]));
+        }
+        // Next attempt to reconnect
+        const RX_t *rx = reactor->entries[ix]->rx;
+        if (!reactor->entries[ix]->removed && rx->reconnecting)
+        {
+            wait = rx->port.connecting ? MIN(wait, RX_REACTOR_CONN_WAIT) :
+                (rx->reconnectTime > now ? MIN(wait, rx->reconnectTime - now) : 0);
+        }
+    }
+
+    struct epoll_event events[RX_REACTOR_MAX_EVENTS];
+    int nEvents = epoll_wait(reactor->epfd, events, NUMOF(events), MIN(wait, INT32_MAX));
+    if (nEvents < 0)
+    {
+        if (errno != EINTR)
+        {
+            WARNING("rxReactorRun() epoll fail: %s", strerror(errno));
+            return -1;
+        }
+        nEvents = 0;
+    }
+
+    reactor->running = true;
+    int nMsgs = 0;
+
+    // Read and dispatch data
+    for (int evIx = 0; evIx < nEvents; evIx++)
+    {
+        RX_REACTOR_ENTRY_t *entry = events[evIx].data.ptr;
+        if (entry->removed || !entry->active)
+        {
+            continue;
+        }
+        RX_t *rx = entry->rx;
+        // Port accepts more data. The next rxReactorRun() stops watching for this once the queue is empty.
+        if ((events[evIx].events & EPOLLOUT) != 0)
+        {
+            portFlush(&rx->port, 0);
+        }
+        if ((events[evIx].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) == 0)
+        {
+            continue;
+        }
+        int nBytes = 0;
+        bool fail = false;
+        nMsgs += _rxReactorRead(rx, &nBytes, &fail);
+        if ( fail || ((nBytes == 0) && ((events[evIx].events & (EPOLLERR | EPOLLHUP)) != 0)) )
+        {
+            // Stop watching the port before it's closed, and reconnect below if possible
+            _rxReactorDeactivate(reactor, entry);
+            if (!_rxDisconnected(rx))
+            {
+                RX_WARNING("Port failed!");
+                if (entry->evcb != NULL)
+                {
+                    entry->evcb(reactor, rx, RX_REACTOR_EV_ERROR, entry->arg);
+                }
+            }
+        }
+    }
+
+    // Reconnect, handle expired timers and poll timeouts
+    now = TIME();
+    for (int ix = 0; ix < reactor->numEntries; ix++)
+    {
+        RX_REACTOR_ENTRY_t *entry = reactor->entries[ix];
+        RX_t *rx = entry->rx;
+        if (!entry->removed && rx->reconnecting && _rxReconnect(rx))
+        {
+            struct epoll_event ev = { .events = EPOLLIN, .data = { .ptr = entry } };
+            if (epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, rx->port.fd, &ev) == 0)
+            {
+                entry->active = true;
+            }
+            else
+            {
+                RX_WARNING("rxReactorRun() epoll fail: %s", strerror(errno));
+            }
+        }
+        if (!entry->removed && entry->active)
+        {
+            _rxAsyncTimeouts(entry->rx);
+        }
+        if ( !entry->removed && (entry->timer != 0) && (entry->timer <= now) )
+        {
+            entry->timer = 0;
+            if (entry->evcb != NULL)
+            {
+                entry->evcb(reactor, entry->rx, RX_REACTOR_EV_TIMER, entry->arg);
+            }
+        }
+    }
+
+    _rxReactorCleanup(reactor);
+    reactor->running = false;
+    return nMsgs;
+}
+
+#else // __linux__
+
+RX_REACTOR_t *rxReactorCreate(void)
+{
+    WARNING("rxReactorCreate() not supported on this platform");
+    return NULL;
+}
+
+void rxReactorDestroy(RX_REACTOR_t *reactor)
+{
+    (void)reactor;
+}
+
+bool rxReactorAdd(RX_REACTOR_t *reactor, RX_t *rx, RX_REACTOR_CB_t evcb, void *arg)
+{
+    (void)reactor;
+    (void)rx;
+    (void)evcb;
+    (void)arg;
+    return false;
+}
+
+bool rxReactorRemove(RX_REACTOR_t *reactor, RX_t *rx)
+{
+    (void)reactor;
+    (void)rx;
+    return false;
+}
+
+bool rxReactorSetTimer(RX_REACTOR_t *reactor, RX_t *rx, const uint32_t timeout)
+{
+    (void)reactor;
+    (void)rx;
+    (void)timeout;
+    return false;
+}
+
+int rxReactorRun(RX_REACTOR_t *reactor, const uint32_t timeout)
+{
+    (void)reactor;
+    (void)timeout;
+    return -1;
+}
+
+#endif // __linux__
 
 /* ****************************************************************************************************************** */
 // eof
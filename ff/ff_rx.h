@@ -23,6 +23,7 @@
 
 #include "ubloxcfg/ubloxcfg.h"
 #include "ff_parser.h"
+#include "ff_port.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -51,28 +52,123 @@ typedef struct RX_OPTS_s
     char    *name;     //!< Name of the receiver (automatic if NULL)
     void   (*msgcb)(PARSER_MSG_t *, void *arg); //!< Optional callback for every message received
     void    *cbarg;    //!< Optional user argument for callback
+    uint32_t ringSize; //!< Read the port in a separate thread into a ring buffer of this size [bytes] (0 = disabled)
+    uint32_t txQueueSize; //!< Non-blocking transmit queue of this size [bytes] (0 = disabled, see portSetTxQueue())
+    bool     reconnect; //!< Automatically reconnect tcp and telnet ports if the connection fails (see below)
+    const char *cacheFile; //!< Cache detection results in this file (NULL = disabled, see below)
 } RX_OPTS_t;
 
-#define RX_OPTS_DEFAULT() { .detect = RX_DET_UBX, .autobaud = true, .baudrate = 0, .verbose = true, .name = NULL, .msgcb = NULL, .cbarg = NULL }
+#define RX_OPTS_DEFAULT() { .detect = RX_DET_UBX, .autobaud = true, .baudrate = 0, .verbose = true, .name = NULL, .msgcb = NULL, .cbarg = NULL, .ringSize = 0, .txQueueSize = 0, .reconnect = false, .cacheFile = NULL }
+
+// Detection cache (RX_OPTS_t.cacheFile): rxOpen() stores the baudrate, the detection method and the receiver version
+// (see rxGetVerStr()) of a detected receiver in the file (a text file with one line per receiver). The entries are
+// keyed by the port and the device (see portGetDeviceId()). The next rxOpen() of the same receiver first tries the
+// cached baudrate, and only does the full detection (and autobauding) if that fails. The string must remain valid
+// while the receiver is used.
+#define RX_CACHE_MAX_ENTRIES       100 //!< Maximum number of receivers in the cache file (oldest entries are dropped)
+
+// Reconnecting (RX_OPTS_t.reconnect): When reading from the port fails, rxGetNextMessage() (resp. rxReactorRun())
+// closes the port and tries to reconnect (without blocking, see portOpenAsync()) with exponentially increasing delays
+// (with random jitter) between attempts. Meanwhile it returns no messages and rxSend() fails. Virtual messages (src
+// PARSER_MSGSRC_VIRTUAL, type PARSER_MSGTYPE_GARBAGE, named RX_MSGNAME_DISCONNECTED resp. RX_MSGNAME_RECONNECTED) are
+// given to the RX_OPTS_t.msgcb callback when the connection is lost resp. re-established. The receiver is not detected
+// again.
+#define RX_RECONNECT_DELAY_MIN     500   //!< Initial delay before reconnecting [ms]
+#define RX_RECONNECT_DELAY_MAX     30000 //!< Maximum delay between reconnect attempts [ms]
+#define RX_MSGNAME_DISCONNECTED    "RX-DISCONNECTED"
+#define RX_MSGNAME_RECONNECTED     "RX-RECONNECTED"
 
 RX_t *rxInit(const char *port, const RX_OPTS_t *opts);
 
 bool rxOpen(RX_t *rx);
 void rxClose(RX_t *rx);
 
+// Get the next message. It is valid until the next call, use msgPoolCopy() (see ff_msgpool.h) to keep it longer.
 PARSER_MSG_t *rxGetNextMessage(RX_t *rx);
 PARSER_MSG_t *rxGetNextMessageTimeout(RX_t *rx, const uint32_t timeout);
 
+// Wait until data is available from the receiver, up to timeout [ms]. Returns true if there may be data for
+// rxGetNextMessage(), false on timeout.
+bool rxWaitReadable(RX_t *rx, const uint32_t timeout);
+
+// Like rxWaitReadable(), but also wait for another port (for example, when relaying data between the receiver and the
+// port). Sets portReadable if portRead() should be called for the port. Returns true if there may be data for
+// rxGetNextMessage().
+bool rxWaitReadablePort(RX_t *rx, PORT_t *port, const uint32_t timeout, bool *portReadable);
+
 bool rxSend(RX_t *rx, const uint8_t *data, const int size);
 
+// Check if the end of the input was reached (file:// and fd:// ports), resp. the port hung up (e.g. serial device gone)
+bool rxIsEof(RX_t *rx);
+
+// Check if the receiver is connected (false while reconnecting, see RX_OPTS_t.reconnect)
+bool rxIsConnected(RX_t *rx);
+
+// Find the baudrate of the receiver: First the data the receiver outputs (if any) is sampled at the candidate
+// baudrates and the most likely baudrate (the one at which the data parses into valid messages) is tried. If that
+// fails, or if the receiver does not output anything, all candidate baudrates are tried.
 bool rxAutobaud(RX_t *rx);
 int rxGetBaudrate(RX_t *rx);
 bool rxSetBaudrate(RX_t *rx, const int baudrate);
 
+// Temporarily increase the baudrate of the link, e.g. for bulk transfers: Change the baudrate of the receiver UART
+// we're connected to (CFG-UARTx-BAUDRATE in the RAM layer) to the highest standard baudrate up to maxBaudrate, switch
+// the port and verify that the receiver responds. If it doesn't, the previous baudrate is restored. rxClose()
+// restores the original baudrate, and rxGetConfig() reports the original baudrate for the RAM layer meanwhile. Returns
+// true if the link is now at the higher baudrate (or already was).
+bool rxUpshift(RX_t *rx, const int maxBaudrate);
+
 void rxAbort(RX_t *rx);
 
 const PARSER_t *rxGetParser(RX_t *rx);
 
+//! Reader thread ring buffer statistics (see RX_OPTS_t.ringSize)
+typedef struct RX_RING_STATS_s
+{
+    bool     active;       //!< Reader thread is running
+    uint32_t size;         //!< Size of the ring buffer [bytes]
+    uint32_t used;         //!< Currently used [bytes]
+    uint32_t highWater;    //!< Maximum used [bytes]
+    uint32_t numChunks;    //!< Number of chunks read from the port
+    uint32_t numOverruns;  //!< Number of chunks dropped because the ring buffer was full
+    uint32_t numDropped;   //!< Number of bytes dropped because the ring buffer was full
+} RX_RING_STATS_t;
+
+bool rxGetRingStats(RX_t *rx, RX_RING_STATS_t *stats);
+
+//! Transmit queue statistics (see RX_OPTS_t.txQueueSize)
+typedef struct RX_TXQ_STATS_s
+{
+    uint32_t size;         //!< Size of the queue [bytes] (0 = no queue)
+    uint32_t pending;      //!< Currently pending [bytes]
+    uint32_t highWater;    //!< Maximum pending [bytes]
+    uint32_t numFull;      //!< Number of writes rejected because the queue was full
+} RX_TXQ_STATS_t;
+
+bool rxGetTxQueueStats(RX_t *rx, RX_TXQ_STATS_t *stats);
+
+// Port I/O statistics (see portGetStats()). With the reader thread (see RX_OPTS_t.ringSize) the counters are updated
+// by that thread, and a snapshot may be slightly inconsistent.
+bool rxGetPortStats(RX_t *rx, PORT_STATS_t *stats);
+
+//! Round-trip time statistics (see rxGetRttStats())
+typedef struct RX_RTT_STATS_s
+{
+    uint32_t numSamples; //!< Number of samples, 0 = none (the default timeouts are used)
+    uint32_t last;       //!< Last sample [ms]
+    uint32_t min;        //!< Smallest sample [ms]
+    uint32_t max;        //!< Largest sample [ms]
+    double   srtt;       //!< Smoothed round-trip time [ms]
+    double   rttvar;     //!< Round-trip time variation [ms]
+    uint32_t rto;        //!< Retransmission timeout (for the first attempt, without the transfer time) [ms]
+} RX_RTT_STATS_t;
+
+// Round-trip time statistics. The round-trip time is measured for each response to a poll or UBX-CFG message (without
+// the time for transferring the messages at the current baudrate, and not for writes to the Flash). It determines the
+// timeouts for rxPollUbx() and rxPollUbxAsync() (with RX_POLL_UBX_t.timeout = 0), rxSendUbxCfg() (timeout = 0),
+// rxGetConfig() and rxSetConfig(), and their increase for retries. The samples are discarded when the baudrate changes.
+bool rxGetRttStats(RX_t *rx, RX_RTT_STATS_t *stats);
+
 /* ****************************************************************************************************************** */
 
 bool rxGetVerStr(RX_t *rx, char *str, const int size);
@@ -83,7 +179,7 @@ typedef struct RX_POLL_UBX_s
     uint8_t        msgId;
     const uint8_t *payload;
     int            payloadSize;
-    uint32_t       timeout;
+    uint32_t       timeout;     // Timeout [ms], 0 = automatic (see rxGetRttStats())
     int            retries;
     int            respSizeMin;
 } RX_POLL_UBX_t;
@@ -92,6 +188,54 @@ PARSER_MSG_t *rxPollUbx(RX_t *rx, const RX_POLL_UBX_t *param, bool *pollNak);
 
 bool rxSendUbxCfg(RX_t *rx, const uint8_t *msg, const int size, const uint32_t timeout);
 
+// Message subscriptions and asynchronous polls
+//
+// Subscriptions call a callback for each message of a specific UBX class/message ID, NMEA formatter (e.g. "GGA", or
+// "PUBX" for proprietary messages) or RTCM3 message type received. They are kept in a hash table, so having many of
+// them is cheap. Asynchronous polls send a request and call a callback once the response (a UBX message with the same
+// class and message ID), a UBX-ACK-NAK (UBX-CFG polls) or no response in time (after all retries) has been received.
+// Several polls can be pending at once, also several for the same message (which are answered in order). Both are
+// driven by reading messages: rxGetNextMessage() (and all functions using it, such as rxPollUbx()) and rxReactorRun()
+// dispatch the messages and handle poll timeouts and retries. rxAsyncRun() reads messages until no polls are pending.
+//
+// The callbacks must not read messages from the receiver (e.g. rxGetNextMessage() or rxPollUbx()), but they can start
+// new polls or change subscriptions. The message is only valid during the callback. rxClose() cancels pending polls.
+
+#define RX_MAX_SUBS         64  //!< Maximum number of subscriptions per receiver
+#define RX_MAX_POLLS        16  //!< Maximum number of pending asynchronous polls per receiver
+#define RX_POLL_MAX_PAYLOAD 256 //!< Maximum asynchronous poll request payload size
+
+//! Subscription callback
+typedef void (*RX_SUB_CB_t)(RX_t *rx, const PARSER_MSG_t *msg, void *arg);
+
+// Subscribe to messages, returns a subscription ID (> 0), or 0 on error
+int rxSubscribeUbx(RX_t *rx, const uint8_t clsId, const uint8_t msgId, RX_SUB_CB_t cb, void *arg);
+int rxSubscribeNmea(RX_t *rx, const char *formatter, RX_SUB_CB_t cb, void *arg);
+int rxSubscribeRtcm3(RX_t *rx, const int type, RX_SUB_CB_t cb, void *arg);
+bool rxUnsubscribe(RX_t *rx, const int subId);
+
+//! Asynchronous poll result
+typedef enum RX_POLL_RES_e
+{
+    RX_POLL_OK,       //!< Response received (msg)
+    RX_POLL_NAK,      //!< UBX-ACK-NAK received (msg)
+    RX_POLL_TIMEOUT,  //!< No response (msg = NULL)
+    RX_POLL_CANCEL,   //!< Poll cancelled (msg = NULL)
+} RX_POLL_RES_t;
+
+//! Asynchronous poll completion callback
+typedef void (*RX_POLL_CB_t)(RX_t *rx, const int pollId, const RX_POLL_RES_t res, const PARSER_MSG_t *msg, void *arg);
+
+// Start a poll (see RX_POLL_UBX_t for the parameters and defaults), returns a poll ID (> 0), or 0 on error
+int rxPollUbxAsync(RX_t *rx, const RX_POLL_UBX_t *param, RX_POLL_CB_t cb, void *arg);
+// Cancel a pending poll (the callback is called with RX_POLL_CANCEL)
+bool rxPollCancel(RX_t *rx, const int pollId);
+// Number of pending polls
+int rxPollPending(RX_t *rx);
+// Read and dispatch messages until no polls are pending (returns true) or timeout [ms]. Other messages go to the
+// RX_OPTS_t.msgcb callback.
+bool rxAsyncRun(RX_t *rx, const uint32_t timeout);
+
 typedef enum RX_RESET_e
 {
     RX_RESET_NONE,          // No reset
@@ -114,8 +258,64 @@ const char *rxResetStr(const RX_RESET_t reset);
 
 int rxGetConfig(RX_t *rx, const UBLOXCFG_LAYER_t layer, const uint32_t *keys, const int numKeys, UBLOXCFG_KEYVAL_t *kv, const int maxKv);
 
+//! Configuration request (see rxGetConfigMulti())
+typedef struct RX_GETCONFIG_s
+{
+    UBLOXCFG_LAYER_t   layer;   //!< Layer
+    const uint32_t    *keys;    //!< Keys (can be wildcards) to get
+    int                numKeys; //!< Number of keys (1...UBX_CFG_VALGET_V0_MAX_K)
+    UBLOXCFG_KEYVAL_t *kv;      //!< Storage for the key-value pairs
+    int                maxKv;   //!< Size of kv
+    int                numKv;   //!< Result: number of key-value pairs in kv, -1 on error
+} RX_GETCONFIG_t;
+
+#define RX_GETCONFIG_MAX_REQS 8 //!< Maximum number of requests for rxGetConfigMulti()
+
+// Get configuration for several requests (e.g. layers or key groups) at once. The UBX-CFG-VALGET polls for all requests
+// (and for all positions within a request) are pipelined, i.e. several polls are in flight at any time. Returns true if
+// all requests succeeded. rxGetConfig() is the same for a single request.
+bool rxGetConfigMulti(RX_t *rx, RX_GETCONFIG_t *reqs, const int numReqs);
+
 bool rxSetConfig(RX_t *rx, const UBLOXCFG_KEYVAL_t *kv, const int nKv, const bool ram, const bool bbr, const bool flash);
 
+/* ****************************************************************************************************************** */
+
+// Reactor: serve many receivers from one thread (Linux only, the functions fail on other platforms)
+//
+// Receivers (opened with rxOpen()) are added to the reactor, which then waits for data from any of them, reads and
+// parses it and dispatches the messages to the receiver's RX_OPTS_t.msgcb callback. Each receiver also has a timer
+// (e.g. for poll timeouts). Timer expiry and port errors are reported to the event callback. Receivers with
+// RX_OPTS_t.reconnect reconnect in the reactor, without a port error event. After a port error the receiver stays in
+// the reactor, but no more data is read from it. To reconnect, the receiver can be removed, closed, opened and added
+// again.
+
+//! Reactor handle
+typedef struct RX_REACTOR_s RX_REACTOR_t;
+
+//! Reactor events
+typedef enum RX_REACTOR_EV_e
+{
+    RX_REACTOR_EV_TIMER,    //!< Receiver timer expired
+    RX_REACTOR_EV_ERROR,    //!< Receiver port failed (e.g. device unplugged or connection closed)
+} RX_REACTOR_EV_t;
+
+//! Reactor event callback
+typedef void (*RX_REACTOR_CB_t)(RX_REACTOR_t *reactor, RX_t *rx, const RX_REACTOR_EV_t ev, void *arg);
+
+RX_REACTOR_t *rxReactorCreate(void);
+void rxReactorDestroy(RX_REACTOR_t *reactor);
+
+// Add receiver, evcb (may be NULL) is called with arg for events of this receiver
+bool rxReactorAdd(RX_REACTOR_t *reactor, RX_t *rx, RX_REACTOR_CB_t evcb, void *arg);
+bool rxReactorRemove(RX_REACTOR_t *reactor, RX_t *rx);
+
+// Arm (timeout > 0) or cancel (timeout = 0) the receiver's (one-shot) timer [ms]
+bool rxReactorSetTimer(RX_REACTOR_t *reactor, RX_t *rx, const uint32_t timeout);
+
+// Wait up to timeout [ms] for data or timers and dispatch messages and events. Returns the number of messages
+// dispatched, or -1 on error.
+int rxReactorRun(RX_REACTOR_t *reactor, const uint32_t timeout);
+
 /* ****************************************************************************************************************** */
 #ifdef __cplusplus
 }
@@ -0,0 +1,1315 @@
+// clang-format off
+// flipflip's u-blox positioning receiver simulator
+//
+// Copyright (c) Philippe Kehl (flipflip at oinkzwurgl dot org) and contributors
+// https://oinkzwurgl.org/projaeggd/ubloxcfg/
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+// even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program.
+// If not, see <https://www.gnu.org/licenses/>.
+
+#include <string.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "ff_debug.h"
+#include "ff_stuff.h"
+#include "ff_ubx.h"
+#include "ff_nmea.h"
+#include "ff_rtcm3.h"
+#include "ff_crc.h"
+#include "ff_time.h"
+#include "ff_parser.h"
+#include "ff_port.h"
+
+#include "ff_rxsim.h"
+
+/* ****************************************************************************************************************** */
+
+#define RXSIM_PRINT(fmt, ...)   if (sim->opts.verbose) { PRINT("%s: " fmt, sim->name, ## __VA_ARGS__); }
+#define RXSIM_WARNING(fmt, ...) WARNING("%s: " fmt, sim->name, ## __VA_ARGS__)
+#define RXSIM_DEBUG(fmt, ...)   DEBUG(  "%s: " fmt, sim->name, ## __VA_ARGS__)
+#define RXSIM_TRACE(fmt, ...)   TRACE(  "%s: " fmt, sim->name, ## __VA_ARGS__)
+
+#define RXSIM_NUM_LAYERS   4    // RAM, BBR, Flash, Default (UBLOXCFG_LAYER_t)
+#define RXSIM_TXN_MAX      4096 // Maximum number of items in a UBX-CFG-VALSET/VALDEL transaction
+#define RXSIM_TXQ_CHUNKS   1024 // Maximum number of messages in the transmit buffer (must be a power of 2)
+#define RXSIM_NUM_SAT      12   // Number of (GPS) satellites
+#define RXSIM_LEAPSEC      18   // GPS leap seconds
+#define RXSIM_MEAS_MIN     25   // Minimum measurement period [ms]
+
+// Simulated output messages
+typedef enum RXSIM_OUT_e
+{
+    RXSIM_OUT_UBX_NAV_PVT,
+    RXSIM_OUT_UBX_RXM_RAWX,
+    RXSIM_OUT_NMEA_GGA,
+    RXSIM_OUT_NMEA_RMC,
+    RXSIM_OUT_RTCM3_1005,
+    RXSIM_OUT_RTCM3_1077,
+    RXSIM_OUT_NUM
+} RXSIM_OUT_t;
+
+static const char * const kRxSimOutNames[RXSIM_OUT_NUM] =
+{
+    [RXSIM_OUT_UBX_NAV_PVT]  = "UBX-NAV-PVT",
+    [RXSIM_OUT_UBX_RXM_RAWX] = "UBX-RXM-RAWX",
+    [RXSIM_OUT_NMEA_GGA]     = "NMEA-STANDARD-GGA",
+    [RXSIM_OUT_NMEA_RMC]     = "NMEA-STANDARD-RMC",
+    [RXSIM_OUT_RTCM3_1005]   = "RTCM-3X-TYPE1005",
+    [RXSIM_OUT_RTCM3_1077]   = "RTCM-3X-TYPE1077",
+};
+
+// Item ID to index into the layer values, sorted by ID
+typedef struct RXSIM_ID_s
+{
+    uint32_t            id;
+    int                 ix;
+} RXSIM_ID_t;
+
+// Configuration layer
+typedef struct RXSIM_LAYER_s
+{
+    UBLOXCFG_VALUE_t   *val;
+    bool               *have;           // RAM and Default have all items
+} RXSIM_LAYER_t;
+
+// Pending change of a transaction
+typedef struct RXSIM_OP_s
+{
+    bool                del;            // UBX-CFG-VALDEL (true) or UBX-CFG-VALSET (false)
+    uint8_t             layers;         // UBX-CFG-VALSET.layers resp. UBX-CFG-VALDEL.layers
+    int                 ix;             // Item index
+    UBLOXCFG_VALUE_t    val;
+} RXSIM_OP_t;
+
+// Message in the transmit buffer
+typedef struct RXSIM_CHUNK_s
+{
+    uint64_t            end;            // Position after the message
+    uint64_t            ts;             // Time when it can be sent (latency)
+} RXSIM_CHUNK_t;
+
+struct RXSIM_s
+{
+    RXSIM_OPTS_t        opts;
+    char                name[100];
+    PORT_t              port;
+    PARSER_t            parser;
+    PARSER_MSG_t        msg;
+    uint64_t            rand;           // PRNG state
+    // Configuration
+    const UBLOXCFG_ITEM_t **items;
+    int                 numItems;
+    RXSIM_ID_t         *ids;
+    RXSIM_LAYER_t       layers[RXSIM_NUM_LAYERS];
+    int                 ixMeas;         // Index of some items we need often
+    int                 ixNav;
+    int                 ixBaudrate;
+    int                 ixInProtUbx;
+    int                 ixOutProtUbx;
+    int                 ixOutProtNmea;
+    int                 ixOutProtRtcm3;
+    int                 ixOut[RXSIM_OUT_NUM];
+    RXSIM_OP_t         *txnOps;
+    int                 txnNum;
+    bool                txnActive;
+    // State
+    bool                resetting;
+    uint64_t            resetEnd;
+    bool                gnssStopped;
+    uint64_t            nextEpoch;
+    uint32_t            measCnt;
+    uint32_t            navCnt;
+    int                 baudrate;       // Current baudrate
+    int                 baudNext;       // New baudrate, once all data queued up to baudPos has been sent
+    uint64_t            baudPos;
+    bool                baudMismatch;
+    // Transmit buffer
+    uint8_t             txBuf[RXSIM_TXBUF_SIZE];
+    uint64_t            txHead;
+    uint64_t            txTail;
+    RXSIM_CHUNK_t       txChunks[RXSIM_TXQ_CHUNKS];
+    uint64_t            txChunkHead;
+    uint64_t            txChunkTail;
+    double              txCredit;       // Bytes that can be sent now (baudrate pacing)
+    uint64_t            txCreditTime;
+    RXSIM_STATS_t       stats;
+};
+
+static void _rxSimInitDb(RXSIM_t *sim);
+static bool _rxSimPortOpen(RXSIM_t *sim, const char *port);
+
+/* ****************************************************************************************************************** */
+
+static int _rxSimIdCmp(const void *a, const void *b)
+{
+    const uint32_t idA = ((const RXSIM_ID_t *)a)->id;
+    const uint32_t idB = ((const RXSIM_ID_t *)b)->id;
+    return idA < idB ? -1 : (idA > idB ? 1 : 0);
+}
+
+RXSIM_t *rxSimCreate(const char *port, const RXSIM_OPTS_t *opts)
+{
+    if (port == NULL)
+    {
+        return NULL;
+    }
+    RXSIM_t *sim = calloc(1, sizeof(RXSIM_t));
+    if (sim == NULL)
+    {
+        WARNING("rxSimCreate() malloc fail!");
+        return NULL;
+    }
+    const RXSIM_OPTS_t optsDefault = RXSIM_OPTS_DEFAULT();
+    sim->opts = (opts == NULL ? optsDefault : *opts);
+    static int instCnt;
+    if ( (sim->opts.name != NULL) && (sim->opts.name[0] != '\0') )
+    {
+        snprintf(sim->name, sizeof(sim->name), "%s", sim->opts.name);
+    }
+    else
+    {
+        snprintf(sim->name, sizeof(sim->name), "sim%d", instCnt);
+    }
+    instCnt++;
+    sim->opts.name = NULL;
+    sim->rand = sim->opts.seed != 0 ? sim->opts.seed : ((uint64_t)time(NULL) << 16) ^ (uintptr_t)sim;
+
+    // Configuration database
+    sim->items = ubloxcfg_getAllItems(&sim->numItems);
+    sim->ids = malloc(sim->numItems * sizeof(*sim->ids));
+    sim->txnOps = malloc(RXSIM_TXN_MAX * sizeof(*sim->txnOps));
+    bool res = (sim->ids != NULL) && (sim->txnOps != NULL);
+    for (int layer = 0; layer < RXSIM_NUM_LAYERS; layer++)
+    {
+        sim->layers[layer].val  = calloc(sim->numItems, sizeof(UBLOXCFG_VALUE_t));
+        sim->layers[layer].have = calloc(sim->numItems, sizeof(bool));
+        res = res && (sim->layers[layer].val != NULL) && (sim->layers[layer].have != NULL);
+    }
+    if (!res)
+    {
+        RXSIM_WARNING("malloc fail!");
+        rxSimDestroy(sim);
+        return NULL;
+    }
+    for (int ix = 0; ix < sim->numItems; ix++)
+    {
+        sim->ids[ix].id = sim->items[ix]->id;
+        sim->ids[ix].ix = ix;
+    }
+    qsort(sim->ids, sim->numItems, sizeof(*sim->ids), _rxSimIdCmp);
+    _rxSimInitDb(sim);
+
+    if (!_rxSimPortOpen(sim, port))
+    {
+        rxSimDestroy(sim);
+        return NULL;
+    }
+    sim->nextEpoch = TIME();
+    RXSIM_PRINT("Simulating receiver on %s at baudrate %d (%d items, latency %ums, loss %.3f, nak %.3f)",
+        port, sim->baudrate, sim->numItems, sim->opts.latency, sim->opts.loss, sim->opts.nak);
+    return sim;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+void rxSimDestroy(RXSIM_t *sim)
+{
+    if (sim == NULL)
+    {
+        return;
+    }
+    portClose(&sim->port);
+    for (int layer = 0; layer < RXSIM_NUM_LAYERS; layer++)
+    {
+        free(sim->layers[layer].val);
+        free(sim->layers[layer].have);
+    }
+    free(sim->ids);
+    free(sim->txnOps);
+    free(sim);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+void rxSimGetStats(const RXSIM_t *sim, RXSIM_STATS_t *stats)
+{
+    if ( (sim == NULL) || (stats == NULL) )
+    {
+        return;
+    }
+    *stats = sim->stats;
+    stats->baudrate = sim->baudrate;
+    stats->baudMismatch = sim->baudMismatch;
+}
+
+/* ***** configuration database ************************************************************************************* */
+
+static int _rxSimItemIx(const RXSIM_t *sim, const uint32_t id)
+{
+    const RXSIM_ID_t key = { .id = id };
+    const RXSIM_ID_t *res = bsearch(&key, sim->ids, sim->numItems, sizeof(*sim->ids), _rxSimIdCmp);
+    return res != NULL ? res->ix : -1;
+}
+
+static uint32_t _rxSimGetU(const RXSIM_t *sim, const int ix)
+{
+    if (ix < 0)
+    {
+        return 0;
+    }
+    const UBLOXCFG_VALUE_t *val = &sim->layers[UBLOXCFG_LAYER_RAM].val[ix];
+    switch (sim->items[ix]->size)
+    {
+        case UBLOXCFG_SIZE_BIT:   return val->L ? 1 : 0;
+        case UBLOXCFG_SIZE_ONE:   return val->U1;
+        case UBLOXCFG_SIZE_TWO:   return val->U2;
+        case UBLOXCFG_SIZE_FOUR:  return val->U4;
+        case UBLOXCFG_SIZE_EIGHT: return (uint32_t)val->U8;
+    }
+    return 0;
+}
+
+// Reload RAM layer from Default, Flash and BBR layers
+static void _rxSimLoadRam(RXSIM_t *sim)
+{
+    const UBLOXCFG_LAYER_t order[] = { UBLOXCFG_LAYER_DEFAULT, UBLOXCFG_LAYER_FLASH, UBLOXCFG_LAYER_BBR };
+    RXSIM_LAYER_t *ram = &sim->layers[UBLOXCFG_LAYER_RAM];
+    for (int ix = 0; ix < sim->numItems; ix++)
+    {
+        for (int lIx = 0; lIx < NUMOF(order); lIx++)
+        {
+            const RXSIM_LAYER_t *layer = &sim->layers[order[lIx]];
+            if (layer->have[ix])
+            {
+                ram->val[ix] = layer->val[ix];
+            }
+        }
+        ram->have[ix] = true;
+    }
+}
+
+static void _rxSimInitDb(RXSIM_t *sim)
+{
+    RXSIM_LAYER_t *def = &sim->layers[UBLOXCFG_LAYER_DEFAULT];
+    for (int ix = 0; ix < sim->numItems; ix++)
+    {
+        def->have[ix] = true;
+    }
+    sim->ixMeas         = _rxSimItemIx(sim, UBLOXCFG_CFG_RATE_MEAS_ID);
+    sim->ixNav          = _rxSimItemIx(sim, UBLOXCFG_CFG_RATE_NAV_ID);
+    sim->ixBaudrate     = _rxSimItemIx(sim, UBLOXCFG_CFG_UART1_BAUDRATE_ID);
+    sim->ixInProtUbx    = _rxSimItemIx(sim, UBLOXCFG_CFG_UART1INPROT_UBX_ID);
+    sim->ixOutProtUbx   = _rxSimItemIx(sim, UBLOXCFG_CFG_UART1OUTPROT_UBX_ID);
+    sim->ixOutProtNmea  = _rxSimItemIx(sim, UBLOXCFG_CFG_UART1OUTPROT_NMEA_ID);
+    sim->ixOutProtRtcm3 = _rxSimItemIx(sim, UBLOXCFG_CFG_UART1OUTPROT_RTCM3X_ID);
+    for (int out = 0; out < RXSIM_OUT_NUM; out++)
+    {
+        const UBLOXCFG_MSGRATE_t *rate = ubloxcfg_getMsgRateCfg(kRxSimOutNames[out]);
+        sim->ixOut[out] = (rate != NULL) && (rate->itemUart1 != NULL) ? _rxSimItemIx(sim, rate->itemUart1->id) : -1;
+    }
+
+    // Defaults that make a useful receiver
+    const UBLOXCFG_KEYVAL_t defaults[] =
+    {
+        UBLOXCFG_KEYVAL_ANY( CFG_RATE_MEAS,           1000 ),
+        UBLOXCFG_KEYVAL_ANY( CFG_RATE_NAV,            1 ),
+        UBLOXCFG_KEYVAL_ANY( CFG_UART1_BAUDRATE,      sim->opts.baudrate > 0 ? sim->opts.baudrate : 38400 ),
+        UBLOXCFG_KEYVAL_ANY( CFG_UART1INPROT_UBX,     true ),
+        UBLOXCFG_KEYVAL_ANY( CFG_UART1INPROT_NMEA,    true ),
+        UBLOXCFG_KEYVAL_ANY( CFG_UART1INPROT_RTCM3X,  true ),
+        UBLOXCFG_KEYVAL_ANY( CFG_UART1OUTPROT_UBX,    true ),
+        UBLOXCFG_KEYVAL_ANY( CFG_UART1OUTPROT_NMEA,   true ),
+        UBLOXCFG_KEYVAL_ANY( CFG_UART1OUTPROT_RTCM3X, true ),
+        UBLOXCFG_KEYVAL_MSG( CFG_MSGOUT_NMEA_ID_GGA,  UART1, 1 ),
+        UBLOXCFG_KEYVAL_MSG( CFG_MSGOUT_NMEA_ID_RMC,  UART1, 1 ),
+    };
+    rxSimSetConfig(sim, UBLOXCFG_LAYER_DEFAULT, defaults, NUMOF(defaults));
+    _rxSimLoadRam(sim);
+    sim->baudrate = _rxSimGetU(sim, sim->ixBaudrate);
+}
+
+static void _rxSimApplySet(RXSIM_t *sim, const uint8_t layers, const int ix, const UBLOXCFG_VALUE_t *val)
+{
+    const uint8_t flags[] = { UBX_CFG_VALSET_V1_LAYER_RAM, UBX_CFG_VALSET_V1_LAYER_BBR, UBX_CFG_VALSET_V1_LAYER_FLASH };
+    const UBLOXCFG_LAYER_t layer[] = { UBLOXCFG_LAYER_RAM, UBLOXCFG_LAYER_BBR, UBLOXCFG_LAYER_FLASH };
+    for (int lIx = 0; lIx < NUMOF(flags); lIx++)
+    {
+        if ((layers & flags[lIx]) != 0)
+        {
+            sim->layers[layer[lIx]].val[ix]  = *val;
+            sim->layers[layer[lIx]].have[ix] = true;
+        }
+    }
+}
+
+static void _rxSimApplyDel(RXSIM_t *sim, const uint8_t layers, const int ix)
+{
+    if ((layers & UBX_CFG_VALDEL_V1_LAYER_BBR) != 0)
+    {
+        sim->layers[UBLOXCFG_LAYER_BBR].have[ix] = false;
+    }
+    if ((layers & UBX_CFG_VALDEL_V1_LAYER_FLASH) != 0)
+    {
+        sim->layers[UBLOXCFG_LAYER_FLASH].have[ix] = false;
+    }
+}
+
+bool rxSimSetConfig(RXSIM_t *sim, const UBLOXCFG_LAYER_t layer, const UBLOXCFG_KEYVAL_t *kv, const int nKv)
+{
+    if ( (sim == NULL) || (kv == NULL) || (nKv < 0) )
+    {
+        return false;
+    }
+    bool res = true;
+    for (int kvIx = 0; kvIx < nKv; kvIx++)
+    {
+        const int ix = _rxSimItemIx(sim, kv[kvIx].id);
+        if (ix < 0)
+        {
+            RXSIM_WARNING("Unknown item 0x%08x", kv[kvIx].id);
+            res = false;
+            continue;
+        }
+        switch (layer)
+        {
+            case UBLOXCFG_LAYER_DEFAULT:
+                sim->layers[UBLOXCFG_LAYER_DEFAULT].val[ix] = kv[kvIx].val;
+                _rxSimApplySet(sim, UBX_CFG_VALSET_V1_LAYER_RAM, ix, &kv[kvIx].val);
+                break;
+            case UBLOXCFG_LAYER_RAM:
+                _rxSimApplySet(sim, UBX_CFG_VALSET_V1_LAYER_RAM, ix, &kv[kvIx].val);
+                break;
+            case UBLOXCFG_LAYER_BBR:
+                _rxSimApplySet(sim, UBX_CFG_VALSET_V1_LAYER_BBR, ix, &kv[kvIx].val);
+                break;
+            case UBLOXCFG_LAYER_FLASH:
+                _rxSimApplySet(sim, UBX_CFG_VALSET_V1_LAYER_FLASH, ix, &kv[kvIx].val);
+                break;
+        }
+    }
+    return res;
+}
+
+/* ***** output ***************************************************************************************************** */
+
+// xorshift64*, returns [0, 1)
+static double _rxSimRandom(RXSIM_t *sim)
+{
+    sim->rand ^= sim->rand >> 12;
+    sim->rand ^= sim->rand << 25;
+    sim->rand ^= sim->rand >> 27;
+    return (double)((sim->rand * UINT64_C(2685821657736338717)) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Queue message for sending
+static void _rxSimOutput(RXSIM_t *sim, const uint8_t *msg, const int size)
+{
+    if ( (sim->opts.loss > 0.0) && (_rxSimRandom(sim) < sim->opts.loss) )
+    {
+        sim->stats.numLost++;
+        return;
+    }
+    if ( ((sim->txHead - sim->txTail + size) > RXSIM_TXBUF_SIZE) ||
+         ((sim->txChunkHead - sim->txChunkTail) >= RXSIM_TXQ_CHUNKS) )
+    {
+        sim->stats.numOverflow++;
+        RXSIM_TRACE("overflow, drop %d bytes", size);
+        return;
+    }
+    for (int ix = 0; ix < size; ix++)
+    {
+        sim->txBuf[(sim->txHead + ix) % RXSIM_TXBUF_SIZE] = msg[ix];
+    }
+    sim->txHead += size;
+    RXSIM_CHUNK_t *chunk = &sim->txChunks[sim->txChunkHead % RXSIM_TXQ_CHUNKS];
+    chunk->end = sim->txHead;
+    chunk->ts  = TIME() + sim->opts.latency;
+    sim->txChunkHead++;
+    sim->stats.numMsgsOut++;
+}
+
+static void _rxSimOutputUbx(RXSIM_t *sim, const uint8_t clsId, const uint8_t msgId, const uint8_t *payload, const int size)
+{
+    if (_rxSimGetU(sim, sim->ixOutProtUbx) == 0)
+    {
+        return;
+    }
+    uint8_t msg[UBX_FRAME_SIZE + 2000];
+    if ((size + UBX_FRAME_SIZE) <= (int)sizeof(msg))
+    {
+        const int msgSize = ubxMakeMessage(clsId, msgId, payload, size, msg);
+        _rxSimOutput(sim, msg, msgSize);
+    }
+}
+
+static void _rxSimAck(RXSIM_t *sim, const PARSER_MSG_t *msg, const bool ack)
+{
+    const UBX_ACK_ACK_V0_GROUP0_t payload = { .clsId = UBX_CLSID(msg->data), .msgId = UBX_MSGID(msg->data) };
+    _rxSimOutputUbx(sim, UBX_ACK_CLSID, ack ? UBX_ACK_ACK_MSGID : UBX_ACK_NAK_MSGID,
+        (const uint8_t *)&payload, sizeof(payload));
+    if (ack)
+    {
+        sim->stats.numAcks++;
+    }
+    else
+    {
+        sim->stats.numNaks++;
+    }
+}
+
+// Send data that is due, at most as much as the baudrate allows
+static bool _rxSimFlush(RXSIM_t *sim, const uint64_t now)
+{
+    const double bytesPerMs = (double)sim->baudrate / 10.0 / 1000.0;
+    sim->txCredit += (double)(now - sim->txCreditTime) * bytesPerMs;
+    sim->txCredit = MIN(sim->txCredit, MAX(64.0, bytesPerMs * 10.0));
+    sim->txCreditTime = now;
+
+    while (true)
+    {
+        // Change baudrate, once the data sent at the old baudrate (e.g. the UBX-ACK-ACK) is out
+        if ( (sim->baudNext != 0) && (sim->txTail >= sim->baudPos) )
+        {
+            RXSIM_PRINT("Baudrate %d -> %d", sim->baudrate, sim->baudNext);
+            sim->baudrate = sim->baudNext;
+            sim->baudNext = 0;
+        }
+        if (sim->txChunkTail >= sim->txChunkHead)
+        {
+            break;
+        }
+        const RXSIM_CHUNK_t *chunk = &sim->txChunks[sim->txChunkTail % RXSIM_TXQ_CHUNKS];
+        if (chunk->ts > now)
+        {
+            break;
+        }
+        int size = MIN((int)(chunk->end - sim->txTail), (int)sim->txCredit);
+        size = MIN(size, RXSIM_TXBUF_SIZE - (int)(sim->txTail % RXSIM_TXBUF_SIZE));
+        if (sim->baudNext != 0)
+        {
+            size = MIN(size, (int)(sim->baudPos - sim->txTail));
+        }
+        if (size <= 0)
+        {
+            break;
+        }
+        uint8_t *data = &sim->txBuf[sim->txTail % RXSIM_TXBUF_SIZE];
+        // The client cannot read what we send at a different baudrate
+        if (sim->baudMismatch)
+        {
+            for (int ix = 0; ix < size; ix++)
+            {
+                data[ix] = (uint8_t)(_rxSimRandom(sim) * 256.0);
+            }
+        }
+        if (!portWrite(&sim->port, data, size))
+        {
+            if (!sim->port.portOk)
+            {
+                return false;
+            }
+            break; // Port (queue) full, try again later
+        }
+        sim->txTail += size;
+        sim->txCredit -= size;
+        sim->stats.numBytesOut += size;
+        if (sim->txTail >= chunk->end)
+        {
+            sim->txChunkTail++;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void _rxSimBits(uint8_t *buf, int *offs, const int nBits, const uint64_t val)
+{
+    for (int ix = nBits - 1; ix >= 0; ix--)
+    {
+        const int pos = *offs;
+        if ((val >> ix) & 0x1)
+        {
+            buf[pos / 8] |= (0x80 >> (pos % 8));
+        }
+        (*offs)++;
+    }
+}
+
+static void _rxSimOutputRtcm3(RXSIM_t *sim, uint8_t *msg, const int nBits)
+{
+    const int size = (nBits + 7) / 8;
+    msg[0] = RTCM3_PREAMBLE;
+    msg[1] = (size >> 8) & 0x03;
+    msg[2] = size & 0xff;
+    const uint32_t crc = crcRtcm3(msg, RTCM3_HEAD_SIZE + size);
+    msg[RTCM3_HEAD_SIZE + size + 0] = (crc >> 16) & 0xff;
+    msg[RTCM3_HEAD_SIZE + size + 1] = (crc >>  8) & 0xff;
+    msg[RTCM3_HEAD_SIZE + size + 2] =  crc        & 0xff;
+    _rxSimOutput(sim, msg, RTCM3_FRAME_SIZE + size);
+}
+
+// Generate output message (contents are synthetic: static position, fixed satellites)
+static void _rxSimGenerate(RXSIM_t *sim, const RXSIM_OUT_t out)
+{
+    // Time of the epoch, rounded to the measurement period
+    const uint32_t measPeriod = MAX(RXSIM_MEAS_MIN, _rxSimGetU(sim, sim->ixMeas));
+    const double   gpsTime    = posixNow() - 315964800.0 + RXSIM_LEAPSEC;
+    const double   epochTime  = floor(gpsTime * 1000.0 / measPeriod + 0.5) * measPeriod * 1e-3;
+    const int      week       = (int)floor(epochTime / 604800.0);
+    const double   tow        = epochTime - ((double)week * 604800.0);
+    const time_t   utc        = (time_t)floor(epochTime + 315964800.0 - RXSIM_LEAPSEC);
+    const double   utcSec     = fmod(epochTime - RXSIM_LEAPSEC, 60.0);
+    struct tm tm;
+    gmtime_r(&utc, &tm);
+
+    switch (out)
+    {
+        case RXSIM_OUT_UBX_NAV_PVT:
+        {
+            UBX_NAV_PVT_V1_GROUP0_t pvt = { 0 };
+            pvt.iTOW    = (uint32_t)floor(tow * 1e3 + 0.5);
+            pvt.year    = tm.tm_year + 1900;
+            pvt.month   = tm.tm_mon + 1;
+            pvt.day     = tm.tm_mday;
+            pvt.hour    = tm.tm_hour;
+            pvt.min     = tm.tm_min;
+            pvt.sec     = tm.tm_sec;
+            pvt.nano    = (int32_t)floor((utcSec - floor(utcSec)) * 1e9 + 0.5);
+            pvt.valid   = UBX_NAV_PVT_V1_VALID_VALIDDATE | UBX_NAV_PVT_V1_VALID_VALIDTIME | UBX_NAV_PVT_V1_VALID_FULLYRESOLVED;
+            pvt.tAcc    = 20;
+            pvt.fixType = UBX_NAV_PVT_V1_FIXTYPE_3D;
+            pvt.flags   = UBX_NAV_PVT_V1_FLAGS_GNSSFIXOK;
+            pvt.flags2  = UBX_NAV_PVT_V1_FLAGS2_CONFAVAIL | UBX_NAV_PVT_V1_FLAGS2_CONFDATE | UBX_NAV_PVT_V1_FLAGS2_CONFTIME;
+            pvt.numSV   = RXSIM_NUM_SAT;
+            pvt.lon     =  85000000;
+            pvt.lat     = 473000000;
+            pvt.height  =    500000;
+            pvt.hMSL    =    452000;
+            pvt.hAcc    =      1500;
+            pvt.vAcc    =      2500;
+            pvt.sAcc    =       100;
+            pvt.headAcc =  18000000;
+            pvt.pDOP    =       120;
+            _rxSimOutputUbx(sim, UBX_NAV_CLSID, UBX_NAV_PVT_MSGID, (const uint8_t *)&pvt, sizeof(pvt));
+            break;
+        }
+        case RXSIM_OUT_UBX_RXM_RAWX:
+        {
+            uint8_t payload[sizeof(UBX_RXM_RAWX_V1_GROUP0_t) + (2 * RXSIM_NUM_SAT * sizeof(UBX_RXM_RAWX_V1_GROUP1_t))];
+            const UBX_RXM_RAWX_V1_GROUP0_t head =
+            {
+                .rcvTow = tow, .week = week, .leapS = RXSIM_LEAPSEC, .numMeas = 2 * RXSIM_NUM_SAT,
+                .recStat = UBX_RXM_RAWX_V1_RECSTAT_LEAPSEC, .version = UBX_RXM_RAWX_V1_VERSION
+            };
+            memcpy(payload, &head, sizeof(head));
+            for (int ix = 0; ix < (2 * RXSIM_NUM_SAT); ix++)
+            {
+                const int svIx = ix / 2;
+                const UBX_RXM_RAWX_V1_GROUP1_t meas =
+                {
+                    .prMeas = 2.0e7 + (svIx * 1.0e5), .cpMeas = (2.0e7 + (svIx * 1.0e5)) / 0.19, .doMeas = 0.0f,
+                    .gnssId = UBX_GNSSID_GPS, .svId = svIx + 1, .sigId = (ix % 2) == 0 ? UBX_SIGID_GPS_L1CA : UBX_SIGID_GPS_L2CL,
+                    .locktime = 64500, .cno = 40 + svIx, .prStdev = 5, .cpStdev = 2, .doStdev = 5,
+                    .trkStat = UBX_RXM_RAWX_V1_TRKSTAT_PRVALID | UBX_RXM_RAWX_V1_TRKSTAT_CPVALID | UBX_RXM_RAWX_V1_TRKSTAT_HALFCYC
+                };
+                memcpy(&payload[sizeof(head) + (ix * sizeof(meas))], &meas, sizeof(meas));
+            }
+            _rxSimOutputUbx(sim, UBX_RXM_CLSID, UBX_RXM_RAWX_MSGID, payload, sizeof(payload));
+            break;
+        }
+        case RXSIM_OUT_NMEA_GGA:
+        case RXSIM_OUT_NMEA_RMC:
+        {
+            if (_rxSimGetU(sim, sim->ixOutProtNmea) == 0)
+            {
+                break;
+            }
+            char payload[200];
+            char msg[sizeof(payload) + NMEA_FRAME_SIZE + 10];
+            if (out == RXSIM_OUT_NMEA_GGA)
+            {
+                snprintf(payload, sizeof(payload), "%02d%02d%06.3f,4718.0000,N,00830.0000,E,1,%02d,0.90,452.000,M,48.000,M,,",
+                    tm.tm_hour, tm.tm_min, utcSec, RXSIM_NUM_SAT);
+            }
+            else
+            {
+                snprintf(payload, sizeof(payload), "%02d%02d%06.3f,A,4718.0000,N,00830.0000,E,0.000,,%02d%02d%02d,,,A,V",
+                    tm.tm_hour, tm.tm_min, utcSec, tm.tm_mday, tm.tm_mon + 1, tm.tm_year % 100);
+            }
+            const int size = nmeaMakeMessage("GN", out == RXSIM_OUT_NMEA_GGA ? "GGA" : "RMC", payload, msg);
+            _rxSimOutput(sim, (const uint8_t *)msg, size);
+            break;
+        }
+        case RXSIM_OUT_RTCM3_1005:
+        {
+            if (_rxSimGetU(sim, sim->ixOutProtRtcm3) == 0)
+            {
+                break;
+            }
+            uint8_t msg[RTCM3_FRAME_SIZE + 19] = { 0 };
+            uint8_t *payload = &msg[RTCM3_HEAD_SIZE];
+            int offs = 0;
+            _rxSimBits(payload, &offs, 12, 1005);
+            _rxSimBits(payload, &offs, 12, 0);       // Reference station ID
+            _rxSimBits(payload, &offs,  6, 0);       // ITRF realisation year
+            _rxSimBits(payload, &offs,  4, 0x8);     // GPS, no GLONASS, no Galileo, not a reference station
+            _rxSimBits(payload, &offs, 38, (uint64_t)INT64_C(42797200000) & 0x3fffffffff); // ECEF X [0.1mm]
+            _rxSimBits(payload, &offs,  2, 0);       // Single receiver oscillator, reserved
+            _rxSimBits(payload, &offs, 38, (uint64_t)INT64_C(6394500000) & 0x3fffffffff);  // ECEF Y [0.1mm]
+            _rxSimBits(payload, &offs,  2, 0);       // Quarter cycle indicator
+            _rxSimBits(payload, &offs, 38, (uint64_t)INT64_C(46784300000) & 0x3fffffffff); // ECEF Z [0.1mm]
+            _rxSimOutputRtcm3(sim, msg, offs);
+            break;
+        }
+        case RXSIM_OUT_RTCM3_1077:
+        {
+            if (_rxSimGetU(sim, sim->ixOutProtRtcm3) == 0)
+            {
+                break;
+            }
+            // MSM7 with two signals (1C, 2L) for each satellite. Only the header and the rough ranges are meaningful.
+            const int nSig = 2;
+            const int nCell = RXSIM_NUM_SAT * nSig;
+            uint8_t msg[RTCM3_FRAME_SIZE + 400] = { 0 };
+            uint8_t *payload = &msg[RTCM3_HEAD_SIZE];
+            int offs = 0;
+            _rxSimBits(payload, &offs, 12, 1077);
+            _rxSimBits(payload, &offs, 12, 0);       // Reference station ID
+            _rxSimBits(payload, &offs, 30, (uint64_t)floor(tow * 1e3 + 0.5)); // GPS epoch time [ms]
+            _rxSimBits(payload, &offs, 19, 0);       // Multiple message bit, IODS, reserved, clock steering etc.
+            _rxSimBits(payload, &offs, 64, (UINT64_MAX << (64 - RXSIM_NUM_SAT))); // Satellite mask: G01..G12
+            _rxSimBits(payload, &offs, 32, (UINT32_C(1) << (32 - 2)) | (UINT32_C(1) << (32 - 16))); // Signal mask: 1C, 2L
+            _rxSimBits(payload, &offs, nCell, (UINT64_C(1) << nCell) - 1); // Cell mask
+            for (int ix = 0; ix < RXSIM_NUM_SAT; ix++)
+            {
+                _rxSimBits(payload, &offs, 8, 67 + ix); // Rough range, integer milliseconds
+            }
+            offs += RXSIM_NUM_SAT * (4 + 10 + 14);  // Extended info, rough range modulo 1ms, rough phase range rate
+            offs += nCell * (20 + 24 + 10 + 1 + 10 + 15); // Fine pseudorange, phaserange, lock time, half-cycle,
+                                                          // CNR, fine phase range rate
+            _rxSimOutputRtcm3(sim, msg, offs);
+            break;
+        }
+        case RXSIM_OUT_NUM:
+            break;
+    }
+}
+
+// Generate output of measurement (and navigation) epoch
+static void _rxSimEpoch(RXSIM_t *sim, const uint64_t now)
+{
+    if (sim->resetting || sim->gnssStopped || (now < sim->nextEpoch))
+    {
+        return;
+    }
+    const uint32_t measPeriod = MAX(RXSIM_MEAS_MIN, _rxSimGetU(sim, sim->ixMeas));
+    const uint32_t navRate = MAX(1, _rxSimGetU(sim, sim->ixNav));
+    sim->nextEpoch += measPeriod;
+    if (sim->nextEpoch <= now)
+    {
+        sim->nextEpoch = now + measPeriod;
+    }
+    sim->stats.numEpochs++;
+    sim->measCnt++;
+    const bool navEpoch = (sim->measCnt % navRate) == 0;
+    if (navEpoch)
+    {
+        sim->navCnt++;
+    }
+    for (int out = 0; out < RXSIM_OUT_NUM; out++)
+    {
+        const uint32_t rate = _rxSimGetU(sim, sim->ixOut[out]);
+        if (rate == 0)
+        {
+            continue;
+        }
+        // Measurements are output every measurement epoch, everything else every navigation epoch
+        if (out == RXSIM_OUT_UBX_RXM_RAWX ? ((sim->measCnt % rate) == 0) : (navEpoch && ((sim->navCnt % rate) == 0)))
+        {
+            _rxSimGenerate(sim, (RXSIM_OUT_t)out);
+        }
+    }
+}
+
+/* ***** input ****************************************************************************************************** */
+
+static void _rxSimMonVer(RXSIM_t *sim)
+{
+    uint8_t payload[sizeof(UBX_MON_VER_V0_GROUP0_t) + (4 * sizeof(UBX_MON_VER_V0_GROUP1_t))] = { 0 };
+    UBX_MON_VER_V0_GROUP0_t *head = (UBX_MON_VER_V0_GROUP0_t *)payload;
+    snprintf(head->swVersion, sizeof(head->swVersion), "EXT CORE 1.00 (rxsim)");
+    snprintf(head->hwVersion, sizeof(head->hwVersion), "00190000");
+    const char * const exts[] = { "FWVER=SIM 1.00", "PROTVER=34.00", "MOD=RXSIM", "GPS" };
+    for (int ix = 0; ix < NUMOF(exts); ix++)
+    {
+        UBX_MON_VER_V0_GROUP1_t *ext = (UBX_MON_VER_V0_GROUP1_t *)&payload[sizeof(*head) + (ix * sizeof(*ext))];
+        snprintf(ext->extension, sizeof(ext->extension), "%s", exts[ix]);
+    }
+    _rxSimOutputUbx(sim, UBX_MON_CLSID, UBX_MON_VER_MSGID, payload, sizeof(payload));
+}
+
+// Plausible values for a receiver with a good antenna and no interference
+static void _rxSimMonHw(RXSIM_t *sim)
+{
+    UBX_MON_HW_V0_GROUP0_t hw = { 0 };
+    hw.noisePerMS = 80 + (uint16_t)(_rxSimRandom(sim) * 10.0);
+    hw.agcCnt     = 5000 + (uint16_t)(_rxSimRandom(sim) * 200.0);
+    hw.aStatus    = UBX_MON_HW_V0_ASTATUS_OK;
+    hw.aPower     = UBX_MON_HW_V0_APOWER_ON;
+    hw.flags      = UBX_MON_HW_V0_FLAGS_RTCCALIB | (UBX_MON_HW_V0_FLAGS_JAMMINGSTATE_OK << 2);
+    hw.jamInd     = 5 + (uint8_t)(_rxSimRandom(sim) * 5.0);
+    _rxSimOutputUbx(sim, UBX_MON_CLSID, UBX_MON_HW_MSGID, (const uint8_t *)&hw, sizeof(hw));
+}
+
+static void _rxSimMonRf(RXSIM_t *sim)
+{
+    uint8_t payload[sizeof(UBX_MON_RF_V0_GROUP0_t) + sizeof(UBX_MON_RF_V0_GROUP1_t)] = { 0 };
+    UBX_MON_RF_V0_GROUP0_t *head = (UBX_MON_RF_V0_GROUP0_t *)payload;
+    UBX_MON_RF_V0_GROUP1_t *block = (UBX_MON_RF_V0_GROUP1_t *)&payload[sizeof(*head)];
+    head->version     = UBX_MON_RF_V0_VERSION;
+    head->nBlocks     = 1;
+    block->flags      = UBX_MON_RF_V0_FLAGS_JAMMINGSTATE_OK;
+    block->antStatus  = UBX_MON_RF_V0_ANTSTATUS_OK;
+    block->antPower   = UBX_MON_RF_V0_ANTPOWER_ON;
+    block->noisePerMS = 80 + (uint16_t)(_rxSimRandom(sim) * 10.0);
+    block->agcCnt     = 5000 + (uint16_t)(_rxSimRandom(sim) * 200.0);
+    block->jamInd     = 5 + (uint8_t)(_rxSimRandom(sim) * 5.0);
+    block->magI       = 120;
+    block->magQ       = 120;
+    _rxSimOutputUbx(sim, UBX_MON_CLSID, UBX_MON_RF_MSGID, payload, sizeof(payload));
+}
+
+static void _rxSimMonComms(RXSIM_t *sim)
+{
+    uint8_t payload[sizeof(UBX_MON_COMMS_V0_GROUP0_t) + sizeof(UBX_MON_COMMS_V0_GROUP1_t)] = { 0 };
+    UBX_MON_COMMS_V0_GROUP0_t *head = (UBX_MON_COMMS_V0_GROUP0_t *)payload;
+    UBX_MON_COMMS_V0_GROUP1_t *port = (UBX_MON_COMMS_V0_GROUP1_t *)&payload[sizeof(*head)];
+    head->version     = UBX_MON_COMMS_V0_VERSION;
+    head->nPorts      = 1;
+    head->protIds[0]  = UBX_MON_COMMS_V0_PROTIDS_UBX;
+    head->protIds[1]  = UBX_MON_COMMS_V0_PROTIDS_NMEA;
+    head->protIds[2]  = UBX_MON_COMMS_V0_PROTIDS_RTCM3;
+    head->protIds[3]  = UBX_MON_COMMS_V0_PROTIDS_OTHER;
+    port->portId      = 0x0100; // UART1
+    port->txPending   = sim->txHead - sim->txTail;
+    port->txBytes     = sim->stats.numBytesOut;
+    port->txUsage     = (sim->txHead - sim->txTail) * 100 / RXSIM_TXBUF_SIZE;
+    port->txPeakUsage = port->txUsage;
+    port->msgs[0]     = sim->stats.numMsgsIn;
+    port->skipped     = sim->stats.numGarbage;
+    _rxSimOutputUbx(sim, UBX_MON_CLSID, UBX_MON_COMMS_MSGID, payload, sizeof(payload));
+}
+
+static bool _rxSimValgetMatch(const uint32_t key, const uint32_t id)
+{
+    if (key == UBX_CFG_VALGET_V0_ALL_WILDCARD)
+    {
+        return true;
+    }
+    if (UBLOXCFG_ID2IDGRP(key) == 0xffff)
+    {
+        return UBLOXCFG_ID2GROUP(key) == UBLOXCFG_ID2GROUP(id);
+    }
+    return key == id;
+}
+
+static bool _rxSimValget(RXSIM_t *sim, const uint8_t *payload, const int size)
+{
+    UBX_CFG_VALGET_V0_GROUP0_t head;
+    const int numKeys = (size - (int)sizeof(head)) / 4;
+    if ( (size < (int)sizeof(head)) || (numKeys < 1) || (numKeys > UBX_CFG_VALGET_V0_MAX_K) )
+    {
+        return false;
+    }
+    memcpy(&head, payload, sizeof(head));
+    UBLOXCFG_LAYER_t layer;
+    switch (head.layer)
+    {
+        case UBX_CFG_VALGET_V0_LAYER_RAM:     layer = UBLOXCFG_LAYER_RAM;     break;
+        case UBX_CFG_VALGET_V0_LAYER_BBR:     layer = UBLOXCFG_LAYER_BBR;     break;
+        case UBX_CFG_VALGET_V0_LAYER_FLASH:   layer = UBLOXCFG_LAYER_FLASH;   break;
+        case UBX_CFG_VALGET_V0_LAYER_DEFAULT: layer = UBLOXCFG_LAYER_DEFAULT; break;
+        default:
+            return false;
+    }
+    const RXSIM_LAYER_t *db = &sim->layers[layer];
+
+    // Collect the items for the keys (and wildcards), starting at the requested position
+    UBLOXCFG_KEYVAL_t kv[UBX_CFG_VALGET_V1_MAX_KV];
+    int nKv = 0;
+    int pos = 0;
+    for (int keyIx = 0; (keyIx < numKeys) && (nKv < NUMOF(kv)); keyIx++)
+    {
+        uint32_t key;
+        memcpy(&key, &payload[sizeof(head) + (keyIx * 4)], sizeof(key));
+        const bool wildcard = (key == UBX_CFG_VALGET_V0_ALL_WILDCARD) || (UBLOXCFG_ID2IDGRP(key) == 0xffff);
+        if (!wildcard)
+        {
+            const int ix = _rxSimItemIx(sim, key);
+            if (ix < 0)
+            {
+                return false;
+            }
+            if (db->have[ix] && (pos++ >= head.position))
+            {
+                kv[nKv].id  = key;
+                kv[nKv].val = db->val[ix];
+                nKv++;
+            }
+            continue;
+        }
+        for (int ix = 0; (ix < sim->numItems) && (nKv < NUMOF(kv)); ix++)
+        {
+            if (db->have[ix] && _rxSimValgetMatch(key, sim->items[ix]->id) && (pos++ >= head.position))
+            {
+                kv[nKv].id  = sim->items[ix]->id;
+                kv[nKv].val = db->val[ix];
+                nKv++;
+            }
+        }
+    }
+    if (nKv == 0)
+    {
+        return false;
+    }
+
+    uint8_t resp[sizeof(UBX_CFG_VALGET_V1_GROUP0_t) + UBX_CFG_VALGET_V1_CFGDATA_MAX];
+    const UBX_CFG_VALGET_V1_GROUP0_t respHead =
+    {
+        .version = UBX_CFG_VALGET_V1_VERSION, .layer = head.layer, .position = head.position
+    };
+    memcpy(resp, &respHead, sizeof(respHead));
+    int dataSize = 0;
+    if (!ubloxcfg_makeData(&resp[sizeof(respHead)], sizeof(resp) - sizeof(respHead), kv, nKv, &dataSize))
+    {
+        return false;
+    }
+    _rxSimOutputUbx(sim, UBX_CFG_CLSID, UBX_CFG_VALGET_MSGID, resp, sizeof(respHead) + dataSize);
+    return true;
+}
+
+// UBX-CFG-VALSET and UBX-CFG-VALDEL, with transactions. Both have the same header (version, layers, transaction).
+static bool _rxSimValsetValdel(RXSIM_t *sim, const bool del, const uint8_t *payload, const int size)
+{
+    if (size < (int)sizeof(UBX_CFG_VALSET_V1_GROUP0_t))
+    {
+        return false;
+    }
+    UBX_CFG_VALSET_V1_GROUP0_t head;
+    memcpy(&head, payload, sizeof(head));
+    const uint8_t transaction = (head.version == UBX_CFG_VALSET_V1_VERSION) ? head.transaction : UBX_CFG_VALSET_V1_TRANSACTION_NONE;
+    const uint8_t *data = &payload[sizeof(head)];
+    const int dataSize = size - sizeof(head);
+
+    // Items to set (resp. delete)
+    UBLOXCFG_KEYVAL_t kv[UBX_CFG_VALSET_V1_MAX_KV];
+    int nKv = 0;
+    if (del)
+    {
+        nKv = dataSize / 4;
+        if ( ((dataSize % 4) != 0) || (nKv > NUMOF(kv)) )
+        {
+            return false;
+        }
+        for (int ix = 0; ix < nKv; ix++)
+        {
+            memcpy(&kv[ix].id, &data[ix * 4], sizeof(kv[ix].id));
+        }
+    }
+    else if ( (dataSize > 0) && !ubloxcfg_parseData(data, dataSize, kv, NUMOF(kv), &nKv) )
+    {
+        return false;
+    }
+
+    // A new transaction discards a pending one, a failing message cancels it
+    if (transaction == UBX_CFG_VALSET_V1_TRANSACTION_BEGIN)
+    {
+        sim->txnNum = 0;
+        sim->txnActive = true;
+    }
+    else if ( (transaction != UBX_CFG_VALSET_V1_TRANSACTION_NONE) && !sim->txnActive )
+    {
+        return false;
+    }
+    // Items are collected after the ones of the pending transaction, if any
+    RXSIM_OP_t *ops = sim->txnOps;
+    const int first = sim->txnActive ? sim->txnNum : 0;
+    int nOps = first;
+    for (int kvIx = 0; kvIx < nKv; kvIx++)
+    {
+        const bool wildcard = del && ((kv[kvIx].id == UBX_CFG_VALGET_V0_ALL_WILDCARD) || (UBLOXCFG_ID2IDGRP(kv[kvIx].id) == 0xffff));
+        for (int ix = 0; ix < sim->numItems; ix++)
+        {
+            const int itemIx = wildcard ? ix : _rxSimItemIx(sim, kv[kvIx].id);
+            if ( (itemIx < 0) || (nOps >= RXSIM_TXN_MAX) )
+            {
+                sim->txnActive = false;
+                return false;
+            }
+            if (!wildcard || _rxSimValgetMatch(kv[kvIx].id, sim->items[itemIx]->id))
+            {
+                ops[nOps].del    = del;
+                ops[nOps].layers = head.layers;
+                ops[nOps].ix     = itemIx;
+                ops[nOps].val    = kv[kvIx].val;
+                nOps++;
+            }
+            if (!wildcard)
+            {
+                break;
+            }
+        }
+    }
+
+    // Apply now, or later at the end of the transaction
+    int applyIx = first;
+    if (transaction != UBX_CFG_VALSET_V1_TRANSACTION_NONE)
+    {
+        sim->txnNum = nOps;
+        if (transaction != UBX_CFG_VALSET_V1_TRANSACTION_END)
+        {
+            return true;
+        }
+        sim->txnActive = false;
+        applyIx = 0;
+        RXSIM_DEBUG("Transaction end, %d items", nOps);
+    }
+    for (int ix = applyIx; ix < nOps; ix++)
+    {
+        if (ops[ix].del)
+        {
+            _rxSimApplyDel(sim, ops[ix].layers, ops[ix].ix);
+        }
+        else
+        {
+            _rxSimApplySet(sim, ops[ix].layers, ops[ix].ix, &ops[ix].val);
+        }
+    }
+    return true;
+}
+
+// UBX-CFG-CFG (deprecated interface, used by rxReset() to clear the configuration)
+static bool _rxSimCfgCfg(RXSIM_t *sim, const uint8_t *payload, const int size)
+{
+    UBX_CFG_CFG_V0_GROUP0_t head;
+    if (size < (int)sizeof(head))
+    {
+        return false;
+    }
+    memcpy(&head, payload, sizeof(head));
+    const uint8_t deviceMask = size > (int)sizeof(head) ? payload[sizeof(head)] :
+        (UBX_CFG_CFG_V0_DEVICE_BBR | UBX_CFG_CFG_V0_DEVICE_FLASH);
+    const UBLOXCFG_LAYER_t layers[] = { UBLOXCFG_LAYER_BBR, UBLOXCFG_LAYER_FLASH };
+    const uint8_t flags[] = { UBX_CFG_CFG_V0_DEVICE_BBR, UBX_CFG_CFG_V0_DEVICE_FLASH };
+    for (int lIx = 0; lIx < NUMOF(layers); lIx++)
+    {
+        if ((deviceMask & flags[lIx]) == 0)
+        {
+            continue;
+        }
+        RXSIM_LAYER_t *layer = &sim->layers[layers[lIx]];
+        if (head.clearMask != 0)
+        {
+            memset(layer->have, 0, sim->numItems * sizeof(*layer->have));
+        }
+        if (head.saveMask != 0)
+        {
+            memcpy(layer->val, sim->layers[UBLOXCFG_LAYER_RAM].val, sim->numItems * sizeof(*layer->val));
+            memset(layer->have, 1, sim->numItems * sizeof(*layer->have));
+        }
+    }
+    if (head.loadMask != 0)
+    {
+        _rxSimLoadRam(sim);
+    }
+    return true;
+}
+
+static void _rxSimReset(RXSIM_t *sim, const uint8_t *payload, const int size)
+{
+    UBX_CFG_RST_V0_GROUP0_t rst;
+    if (size != (int)sizeof(rst))
+    {
+        return;
+    }
+    memcpy(&rst, payload, sizeof(rst));
+    switch (rst.resetMode)
+    {
+        case UBX_CFG_RST_V0_RESETMODE_HW_FORCED:
+        case UBX_CFG_RST_V0_RESETMODE_SW:
+        case UBX_CFG_RST_V0_RESETMODE_HW_CONTROLLED:
+            RXSIM_PRINT("Reset (mode 0x%02x)", rst.resetMode);
+            sim->stats.numResets++;
+            sim->resetting = true;
+            sim->resetEnd = TIME() + sim->opts.resetTime;
+            // Anything not sent yet is lost
+            sim->txTail = sim->txHead;
+            sim->txChunkTail = sim->txChunkHead;
+            sim->baudNext = 0;
+            break;
+        case UBX_CFG_RST_V0_RESETMODE_GNSS:
+            RXSIM_PRINT("GNSS restart");
+            sim->gnssStopped = false;
+            break;
+        case UBX_CFG_RST_V0_RESETMODE_GNSS_STOP:
+            RXSIM_PRINT("GNSS stop");
+            sim->gnssStopped = true;
+            break;
+        case UBX_CFG_RST_V0_RESETMODE_GNSS_START:
+            RXSIM_PRINT("GNSS start");
+            sim->gnssStopped = false;
+            break;
+    }
+}
+
+static void _rxSimResetDone(RXSIM_t *sim)
+{
+    _rxSimLoadRam(sim);
+    sim->resetting = false;
+    sim->gnssStopped = false;
+    sim->txnActive = false;
+    sim->baudrate = _rxSimGetU(sim, sim->ixBaudrate);
+    sim->nextEpoch = TIME();
+    parserInit(&sim->parser);
+    RXSIM_PRINT("Reset done, baudrate %d", sim->baudrate);
+}
+
+static void _rxSimHandleUbx(RXSIM_t *sim, const PARSER_MSG_t *msg)
+{
+    const uint8_t clsId = UBX_CLSID(msg->data);
+    const uint8_t msgId = UBX_MSGID(msg->data);
+    const uint8_t *payload = &msg->data[UBX_HEAD_SIZE];
+    const int size = msg->size - UBX_FRAME_SIZE;
+    if (_rxSimGetU(sim, sim->ixInProtUbx) == 0)
+    {
+        return;
+    }
+
+    if (clsId == UBX_CFG_CLSID)
+    {
+        bool injectNak = false;
+        switch (msgId)
+        {
+            case UBX_CFG_VALGET_MSGID:
+                sim->stats.numValget++;
+                injectNak = true;
+                break;
+            case UBX_CFG_VALSET_MSGID:
+                sim->stats.numValset++;
+                injectNak = true;
+                break;
+            case UBX_CFG_VALDEL_MSGID:
+                sim->stats.numValdel++;
+                injectNak = true;
+                break;
+            case UBX_CFG_RST_MSGID:
+                _rxSimReset(sim, payload, size);
+                return;
+            case UBX_CFG_CFG_MSGID:
+                _rxSimAck(sim, msg, _rxSimCfgCfg(sim, payload, size));
+                return;
+            default:
+                _rxSimAck(sim, msg, false);
+                return;
+        }
+        if (injectNak && (sim->opts.nak > 0.0) && (_rxSimRandom(sim) < sim->opts.nak))
+        {
+            RXSIM_DEBUG("Inject NAK for %s", msg->name);
+            sim->stats.numNaksInj++;
+            sim->txnActive = false;
+            _rxSimAck(sim, msg, false);
+            return;
+        }
+        bool res = false;
+        switch (msgId)
+        {
+            case UBX_CFG_VALGET_MSGID:
+                res = _rxSimValget(sim, payload, size);
+                break;
+            case UBX_CFG_VALSET_MSGID:
+                res = _rxSimValsetValdel(sim, false, payload, size);
+                break;
+            case UBX_CFG_VALDEL_MSGID:
+                res = _rxSimValsetValdel(sim, true, payload, size);
+                break;
+        }
+        _rxSimAck(sim, msg, res);
+
+        // Baudrate change takes effect after the acknowledgement has been sent
+        const int baudrate = _rxSimGetU(sim, sim->ixBaudrate);
+        if ( (baudrate != sim->baudrate) && (baudrate != sim->baudNext) && (baudrate >= PORT_BAUDRATE_MIN) &&
+             (baudrate <= PORT_BAUDRATE_MAX) )
+        {
+            sim->baudNext = baudrate;
+            sim->baudPos = sim->txHead;
+        }
+        return;
+    }
+
+    // Polls
+    if (size == 0)
+    {
+        if ( (clsId == UBX_MON_CLSID) && (msgId == UBX_MON_VER_MSGID) )
+        {
+            _rxSimMonVer(sim);
+        }
+        else if ( (clsId == UBX_MON_CLSID) && (msgId == UBX_MON_HW_MSGID) )
+        {
+            _rxSimMonHw(sim);
+        }
+        else if ( (clsId == UBX_MON_CLSID) && (msgId == UBX_MON_RF_MSGID) )
+        {
+            _rxSimMonRf(sim);
+        }
+        else if ( (clsId == UBX_MON_CLSID) && (msgId == UBX_MON_COMMS_MSGID) )
+        {
+            _rxSimMonComms(sim);
+        }
+        else if ( (clsId == UBX_NAV_CLSID) && (msgId == UBX_NAV_PVT_MSGID) )
+        {
+            _rxSimGenerate(sim, RXSIM_OUT_UBX_NAV_PVT);
+        }
+        else if ( (clsId == UBX_RXM_CLSID) && (msgId == UBX_RXM_RAWX_MSGID) )
+        {
+            _rxSimGenerate(sim, RXSIM_OUT_UBX_RXM_RAWX);
+        }
+    }
+}
+
+static bool _rxSimInput(RXSIM_t *sim)
+{
+    uint8_t buf[4096];
+    int size = 0;
+    while (true)
+    {
+        if (!portRead(&sim->port, buf, sizeof(buf), &size))
+        {
+            return false;
+        }
+        if (size <= 0)
+        {
+            break;
+        }
+        // Nothing useful arrives at the wrong baudrate, and nothing is received while resetting
+        if (sim->baudMismatch || sim->resetting)
+        {
+            sim->stats.numGarbage += size;
+            continue;
+        }
+        if (!parserAdd(&sim->parser, buf, size))
+        {
+            parserInit(&sim->parser);
+            parserAdd(&sim->parser, buf, size);
+        }
+        while (parserProcess(&sim->parser, &sim->msg, false))
+        {
+            switch (sim->msg.type)
+            {
+                case PARSER_MSGTYPE_UBX:
+                    sim->stats.numMsgsIn++;
+                    _rxSimHandleUbx(sim, &sim->msg);
+                    break;
+                case PARSER_MSGTYPE_NMEA:
+                case PARSER_MSGTYPE_RTCM3:
+                case PARSER_MSGTYPE_SPARTN:
+                case PARSER_MSGTYPE_NOVATEL:
+                    sim->stats.numMsgsIn++;
+                    break;
+                case PARSER_MSGTYPE_GARBAGE:
+                    sim->stats.numGarbage += sim->msg.size;
+                    break;
+            }
+        }
+    }
+    return true;
+}
+
+/* ****************************************************************************************************************** */
+
+static bool _rxSimPortOpen(RXSIM_t *sim, const char *port)
+{
+    if (!portInit(&sim->port, port))
+    {
+        return false;
+    }
+    // Don't block if the client does not read
+    NOT_WIN( portSetTxQueue(&sim->port, RXSIM_TXBUF_SIZE) );
+    return portOpen(&sim->port);
+}
+
+bool rxSimRun(RXSIM_t *sim, const uint32_t timeout)
+{
+    if (sim == NULL)
+    {
+        return false;
+    }
+    const uint64_t t1 = TIME() + timeout;
+    while (true)
+    {
+        const uint64_t now = TIME();
+        if (sim->resetting && (now >= sim->resetEnd))
+        {
+            _rxSimResetDone(sim);
+        }
+
+        // Client baudrate (pty only)
+        const int clientBaudrate = portGetBaudrate(&sim->port);
+        const bool mismatch = (clientBaudrate != 0) && (clientBaudrate != sim->baudrate);
+        if (mismatch != sim->baudMismatch)
+        {
+            RXSIM_DEBUG("Client baudrate %d %s", clientBaudrate, mismatch ? "mismatch" : "match");
+            sim->baudMismatch = mismatch;
+        }
+
+        if (!_rxSimInput(sim))
+        {
+            return false;
+        }
+        _rxSimEpoch(sim, now);
+        if (!_rxSimFlush(sim, now))
+        {
+            return false;
+        }
+        if (now >= t1)
+        {
+            break;
+        }
+
+        // Wait for input, or until there's something else to do
+        uint64_t wake = t1;
+        if (sim->resetting)
+        {
+            wake = MIN(wake, sim->resetEnd);
+        }
+        else if (!sim->gnssStopped)
+        {
+            wake = MIN(wake, sim->nextEpoch);
+        }
+        if (sim->txChunkTail < sim->txChunkHead)
+        {
+            const uint64_t ts = sim->txChunks[sim->txChunkTail % RXSIM_TXQ_CHUNKS].ts;
+            wake = MIN(wake, MAX(ts, now + 1));
+        }
+        if (wake > now)
+        {
+            portWaitReadable(&sim->port, wake - now);
+        }
+    }
+    return true;
+}
+
+/* ****************************************************************************************************************** */
+// eof
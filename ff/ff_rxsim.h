@@ -0,0 +1,171 @@
+// clang-format off
+// flipflip's u-blox positioning receiver simulator
+//
+// Copyright (c) Philippe Kehl (flipflip at oinkzwurgl dot org) and contributors
+// https://oinkzwurgl.org/projaeggd/ubloxcfg/
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation, either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+// even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program.
+// If not, see <https://www.gnu.org/licenses/>.
+
+/*!
+    \defgroup FF_RXSIM u-blox receiver simulator
+
+    \b Concept
+
+    - The simulator serves a port (see \ref ff_port.h), typically a pseudo terminal (pty://<path>) or a TCP/IP server
+      (tcpsrv://[<addr>]:<port>), to which clients (e.g. \ref ff_rx.h) connect as if it were a receiver on a UART
+    - It has a configuration database with all items known to the library (see ubloxcfg_getAllItems()) in the RAM,
+      BBR, Flash and Default layers. All items are 0 in the Default layer, except for a few that make the simulator
+      behave like a real receiver (measurement rate 1Hz, UART1 at 38400 baud with all protocols enabled, NMEA-GGA and
+      NMEA-RMC output).
+    - It answers UBX-MON-VER, UBX-CFG-VALGET, UBX-CFG-VALSET, UBX-CFG-VALDEL (incl. transactions), UBX-CFG-CFG and
+      UBX-CFG-RST, as well as polls (messages with an empty payload) of the output messages
+    - It outputs UBX-NAV-PVT, UBX-RXM-RAWX, NMEA-GGA, NMEA-RMC, RTCM3-1005 and RTCM3-1077 messages on UART1 as
+      configured (CFG-RATE-*, CFG-MSGOUT-*, CFG-UART1OUTPROT-*). The message contents are synthetic (a static
+      position, a fixed set of satellites).
+    - Output is paced at the baudrate (CFG-UART1-BAUDRATE). Messages that do not fit into the transmit buffer are
+      dropped. For pty ports, if the baudrate set by the client differs, the output is garbled and the input is
+      discarded (as on a real UART with mismatched baudrates).
+    - Latency (delay of all output), loss (of output messages) and NAKs (of configuration messages) can be injected
+    - A reset (UBX-CFG-RST) makes the simulator unresponsive for a while. Then the RAM layer is reloaded from the
+      Default, Flash and BBR layers.
+
+    \b Example
+
+    \code{.c}
+    RXSIM_OPTS_t opts = RXSIM_OPTS_DEFAULT();
+    opts.latency = 50;
+    RXSIM_t *sim = rxSimCreate("pty:///tmp/rxsim", &opts);
+    while (!abort)
+    {
+        if (!rxSimRun(sim, 100))
+        {
+            break;
+        }
+    }
+    rxSimDestroy(sim);
+    \endcode
+
+    @{
+*/
+
+#ifndef __FF_RXSIM_H__
+#define __FF_RXSIM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ubloxcfg/ubloxcfg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************************************************** */
+
+//! Simulator handle
+typedef struct RXSIM_s RXSIM_t;
+
+//! Simulator options
+typedef struct RXSIM_OPTS_s
+{
+    int         baudrate;   //!< Initial baudrate (CFG-UART1-BAUDRATE in the Default layer)
+    uint32_t    latency;    //!< Delay of all output [ms]
+    double      loss;       //!< Probability that an output message is lost (0.0 ... 1.0)
+    double      nak;        //!< Probability that a UBX-CFG-VALGET/VALSET/VALDEL is rejected (0.0 ... 1.0)
+    uint32_t    resetTime;  //!< Time the simulator is unresponsive after a reset [ms]
+    uint32_t    seed;       //!< Seed for the random numbers (loss, NAKs), 0 = random
+    bool        verbose;    //!< Print what's going on
+    const char *name;       //!< Name of the simulator (automatic if NULL)
+} RXSIM_OPTS_t;
+
+#define RXSIM_OPTS_DEFAULT() { .baudrate = 38400, .latency = 0, .loss = 0.0, .nak = 0.0, .resetTime = 500, .seed = 0, .verbose = true, .name = NULL }
+
+#define RXSIM_TXBUF_SIZE (16 * 1024) //!< Size of the transmit buffer [bytes]
+
+//! Simulator statistics
+typedef struct RXSIM_STATS_s
+{
+    int         baudrate;       //!< Current baudrate
+    bool        baudMismatch;   //!< Client uses a different baudrate (pty only)
+    uint32_t    numMsgsIn;      //!< Number of messages received
+    uint32_t    numMsgsOut;     //!< Number of messages output
+    uint64_t    numBytesOut;    //!< Number of bytes sent
+    uint32_t    numEpochs;      //!< Number of measurement epochs
+    uint32_t    numValget;      //!< Number of UBX-CFG-VALGET polls
+    uint32_t    numValset;      //!< Number of UBX-CFG-VALSET
+    uint32_t    numValdel;      //!< Number of UBX-CFG-VALDEL
+    uint32_t    numAcks;        //!< Number of UBX-ACK-ACK
+    uint32_t    numNaks;        //!< Number of UBX-ACK-NAK (incl. injected)
+    uint32_t    numNaksInj;     //!< Number of injected NAKs
+    uint32_t    numLost;        //!< Number of output messages lost (injected)
+    uint32_t    numOverflow;    //!< Number of output messages dropped because the transmit buffer was full
+    uint32_t    numResets;      //!< Number of resets
+    uint32_t    numGarbage;     //!< Number of bytes received discarded (garbage, or input during reset or with a
+                                //!  baudrate mismatch)
+} RXSIM_STATS_t;
+
+//! Create simulator
+/*!
+    \param[in]  port  Port (see portInit()) to serve
+    \param[in]  opts  Options (NULL for defaults)
+
+    \returns the simulator handle (with the port opened), or NULL on error
+*/
+RXSIM_t *rxSimCreate(const char *port, const RXSIM_OPTS_t *opts);
+
+//! Destroy simulator
+/*!
+    \param[in]  sim  Simulator handle (can be NULL)
+*/
+void rxSimDestroy(RXSIM_t *sim);
+
+//! Run simulator
+/*!
+    Handles input, generates and sends output, for the given time. This should be called in a loop.
+
+    \param[in]  sim      Simulator handle
+    \param[in]  timeout  Time to run [ms]
+
+    \returns true if the simulator is running, false if the port failed
+*/
+bool rxSimRun(RXSIM_t *sim, const uint32_t timeout);
+
+//! Configure simulator
+/*!
+    Like UBX-CFG-VALSET, but for any one layer, incl. the Default layer. Changes to the Default layer also apply to the
+    RAM layer.
+
+    \param[in]  sim    Simulator handle
+    \param[in]  layer  Layer
+    \param[in]  kv     Configuration
+    \param[in]  nKv    Number of key-value pairs
+
+    \returns true if all items were known and stored, false otherwise
+*/
+bool rxSimSetConfig(RXSIM_t *sim, const UBLOXCFG_LAYER_t layer, const UBLOXCFG_KEYVAL_t *kv, const int nKv);
+
+//! Get statistics
+/*!
+    \param[in]  sim    Simulator handle
+    \param[out] stats  Statistics
+
+    \note This may be called from another thread than rxSimRun(), in which case the statistics may be slightly
+          inconsistent.
+*/
+void rxSimGetStats(const RXSIM_t *sim, RXSIM_STATS_t *stats);
+
+/* ****************************************************************************************************************** */
+#ifdef __cplusplus
+}
+#endif
+#endif // __FF_RXSIM_H__
+///@}
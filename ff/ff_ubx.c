@@ -642,6 +642,8 @@ static int _strUbxRxmSfrbx(char *info, const int size, const uint8_t *msg, const
 static int _strUbxMonVer(char *info, const int size, const uint8_t *msg, const int msgSize);
 static int _strUbxMonTemp(char *info, const int size, const uint8_t *msg, const int msgSize);
 static int _strUbxMonRf(char *info, const int size, const uint8_t *msg, const int msgSize);
+static int _strUbxMonHw(char *info, const int size, const uint8_t *msg, const int msgSize);
+static int _strUbxMonComms(char *info, const int size, const uint8_t *msg, const int msgSize);
 static int _strUbxCfgValset(char *info, const int size, const uint8_t *msg, const int msgSize);
 static int _strUbxCfgValget(char *info, const int size, const uint8_t *msg, const int msgSize);
 static int _strUbxAckAck(char *info, const int size, const uint8_t *msg, const int msgSize, const bool ack);
@@ -757,6 +759,12 @@ bool ubxMessageInfo(char *info, const int size, const uint8_t *msg, const int ms
                 case UBX_MON_RF_MSGID:
                     len = _strUbxMonRf(info, size, msg, msgSize);
                     break;
+                case UBX_MON_HW_MSGID:
+                    len = _strUbxMonHw(info, size, msg, msgSize);
+                    break;
+                case UBX_MON_COMMS_MSGID:
+                    len = _strUbxMonComms(info, size, msg, msgSize);
+                    break;
             }
             break;
         case UBX_CFG_CLSID:
@@ -1208,6 +1216,52 @@ static int _strUbxMonRf(char *info, const int size, const uint8_t *msg, const in
     return len;
 }
 
+static int _strUbxMonHw(char *info, const int size, const uint8_t *msg, const int msgSize)
+{
+    if (msgSize != UBX_MON_HW_V0_SIZE)
+    {
+        return 0;
+    }
+    UBX_MON_HW_V0_GROUP0_t hw;
+    memcpy(&hw, &msg[UBX_HEAD_SIZE], sizeof(hw));
+    const char* jammingStrs[] = { "UNKNOWN", "OK", "WARNING", "CRITICAL" };
+    const char* antStatusStrs[] = { "INIT", "DONTKNOW", "OK", "SHORT", "OPEN" };
+    const char* antPowerStrs[] = { "OFF", "ON", "DONTKNOW" };
+    return snprintf(info, size, "noise %u, agc %u, jamming %u (%s), antenna %s %s",
+        hw.noisePerMS, hw.agcCnt, hw.jamInd, jammingStrs[UBX_MON_HW_V0_FLAGS_JAMMINGSTATE_GET(hw.flags)],
+        hw.aStatus < NUMOF(antStatusStrs) ? antStatusStrs[hw.aStatus] : "?",
+        hw.aPower < NUMOF(antPowerStrs)   ? antPowerStrs[hw.aPower]   : "?");
+}
+
+static int _strUbxMonComms(char *info, const int size, const uint8_t *msg, const int msgSize)
+{
+    if ( (UBX_MON_COMMS_VERSION_GET(msg) != UBX_MON_COMMS_V0_VERSION) || (msgSize < UBX_MON_COMMS_V0_MIN_SIZE) )
+    {
+        return 0;
+    }
+    UBX_MON_COMMS_V0_GROUP0_t head;
+    memcpy(&head, &msg[UBX_HEAD_SIZE], sizeof(head));
+    const char* portStrs[] = { "I2C", "UART1", "UART2", "USB", "SPI" };
+    int len = 0;
+    int rem = size;
+    for (int ix = 0; (ix < head.nPorts) && (rem > 50); ix++)
+    {
+        const int offs = UBX_HEAD_SIZE + sizeof(head) + (ix * sizeof(UBX_MON_COMMS_V0_GROUP1_t));
+        if ((offs + (int)sizeof(UBX_MON_COMMS_V0_GROUP1_t)) > (msgSize - UBX_FRAME_SIZE + UBX_HEAD_SIZE))
+        {
+            break;
+        }
+        UBX_MON_COMMS_V0_GROUP1_t port;
+        memcpy(&port, &msg[offs], sizeof(port));
+        const int portIx = port.portId >> 8;
+        len += snprintf(&info[len], rem, "%s%s tx %u%% (%u%%) rx %u%% (%u%%)", ix == 0 ? "" : ", ",
+            portIx < NUMOF(portStrs) ? portStrs[portIx] : "?",
+            port.txUsage, port.txPeakUsage, port.rxUsage, port.rxPeakUsage);
+        rem = size - len;
+    }
+    return len;
+}
+
 static int _strUbxCfgValset(char *info, const int size, const uint8_t *msg, const int msgSize)
 {
     if (msgSize < (int)sizeof(UBX_CFG_VALSET_V1_GROUP0_t))
@@ -358,6 +358,7 @@ extern "C" {
 #define UBX_GNSSID_BDS      3
 #define UBX_GNSSID_QZSS     5
 #define UBX_GNSSID_GLO      6
+#define UBX_GNSSID_NAVIC    7
 
 #define UBX_SIGID_NONE      0xff
 #define UBX_SIGID_GPS_L1CA  0
@@ -0,0 +1,210 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include "ff_stuff.h"
+#include "ff_ubx.h"
+#include "ff_parser.h"
+#include "ff_msgpool.h"
+// Keeping messages: malloc() copies vs. message pool, in one thread and handed over to another thread:
+// gcc -O2 -o msgpool_bench -DFF_VERSION_STRING=\"bench\" -I.. -I../ff -I../ubloxcfg msgpool_bench.c ../ff/*.c ../ubloxcfg/*.c -lm -lpthread
+// ./msgpool_bench [num]
+
+#define NUM_KEEP  256  // Messages kept before releasing the oldest
+#define QUEUE_LEN 1024 // Messages in flight between the threads
+
+static double _now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+// Copy into a single malloc()ed buffer, the obvious alternative to the pool
+static PARSER_MSG_t *_mallocCopy(const PARSER_MSG_t *msg)
+{
+    const int nameSize = strlen(msg->name) + 1;
+    PARSER_MSG_t *copy = malloc(sizeof(*copy) + msg->size + nameSize);
+    if (copy != NULL)
+    {
+        *copy = *msg;
+        uint8_t *data = (uint8_t *)&copy[1];
+        memcpy(data, msg->data, msg->size);
+        memcpy(&data[msg->size], msg->name, nameSize);
+        copy->data = data;
+        copy->name = (const char *)&data[msg->size];
+        copy->info = NULL;
+    }
+    return copy;
+}
+
+// Single producer, single consumer queue
+typedef struct QUEUE_s
+{
+    PARSER_MSG_t   *msgs[QUEUE_LEN];
+    uint64_t        head;
+    uint64_t        tail;
+    bool            done;
+    bool            pool;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+} QUEUE_t;
+
+static void *_consumer(void *arg)
+{
+    QUEUE_t *q = arg;
+    while (true)
+    {
+        pthread_mutex_lock(&q->mutex);
+        while ( (q->tail == q->head) && !q->done )
+        {
+            pthread_cond_wait(&q->cond, &q->mutex);
+        }
+        if (q->tail == q->head)
+        {
+            pthread_mutex_unlock(&q->mutex);
+            break;
+        }
+        PARSER_MSG_t *msg = q->msgs[q->tail % QUEUE_LEN];
+        q->tail++;
+        pthread_cond_signal(&q->cond);
+        pthread_mutex_unlock(&q->mutex);
+        if (q->pool)
+        {
+            msgPoolRelease(msg);
+        }
+        else
+        {
+            free(msg);
+        }
+    }
+    return NULL;
+}
+
+static void _push(QUEUE_t *q, PARSER_MSG_t *msg)
+{
+    pthread_mutex_lock(&q->mutex);
+    while ((q->head - q->tail) >= QUEUE_LEN)
+    {
+        pthread_cond_wait(&q->cond, &q->mutex);
+    }
+    q->msgs[q->head % QUEUE_LEN] = msg;
+    q->head++;
+    pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+static double _runThreads(const PARSER_MSG_t *msgs, const int nMsgs, const int num, MSGPOOL_t *pool)
+{
+    QUEUE_t q;
+    memset(&q, 0, sizeof(q));
+    q.pool = (pool != NULL);
+    pthread_mutex_init(&q.mutex, NULL);
+    pthread_cond_init(&q.cond, NULL);
+    pthread_t thread;
+    pthread_create(&thread, NULL, _consumer, &q);
+    const double t0 = _now();
+    for (int ix = 0; ix < num; ix++)
+    {
+        const PARSER_MSG_t *msg = &msgs[ix % nMsgs];
+        PARSER_MSG_t *copy = (pool != NULL ? msgPoolCopy(pool, msg) : _mallocCopy(msg));
+        _push(&q, copy);
+    }
+    pthread_mutex_lock(&q.mutex);
+    q.done = true;
+    pthread_cond_signal(&q.cond);
+    pthread_mutex_unlock(&q.mutex);
+    pthread_join(thread, NULL);
+    const double dt = _now() - t0;
+    pthread_mutex_destroy(&q.mutex);
+    pthread_cond_destroy(&q.cond);
+    return dt;
+}
+
+int main(int argc, char **argv)
+{
+    const int num = argc > 1 ? atoi(argv[1]) : 2000000;
+
+    // Typical message mix: NMEA, UBX-NAV-PVT, UBX-NAV-SAT and UBX-RXM-RAWX
+    static uint8_t stream[20000];
+    int size = 0;
+    static uint8_t payload[8192];
+    memset(payload, 0x55, sizeof(payload));
+    const char *gga = "$GNGGA,092725.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,*5B\r\n";
+    for (int ix = 0; ix < 4; ix++)
+    {
+        memcpy(&stream[size], gga, strlen(gga));
+        size += strlen(gga);
+        size += ubxMakeMessage(UBX_NAV_CLSID, UBX_NAV_PVT_MSGID, payload, 92, &stream[size]);
+    }
+    size += ubxMakeMessage(UBX_NAV_CLSID, UBX_NAV_SAT_MSGID, payload, 8 + (40 * 12), &stream[size]);
+    size += ubxMakeMessage(UBX_RXM_CLSID, UBX_RXM_RAWX_MSGID, payload, 16 + (60 * 32), &stream[size]);
+    PARSER_t parser;
+    parserInit(&parser);
+    parserAdd(&parser, stream, size);
+    PARSER_MSG_t msgs[20];
+    static uint8_t data[20000];
+    static char names[20][PARSER_MAX_NAME_SIZE];
+    int nMsgs = 0;
+    int dataSize = 0;
+    PARSER_MSG_t msg;
+    while ( (nMsgs < NUMOF(msgs)) && parserProcess(&parser, &msg, false) )
+    {
+        msgs[nMsgs] = msg;
+        memcpy(&data[dataSize], msg.data, msg.size);
+        msgs[nMsgs].data = &data[dataSize];
+        dataSize += msg.size;
+        snprintf(names[nMsgs], sizeof(names[nMsgs]), "%s", msg.name);
+        msgs[nMsgs].name = names[nMsgs];
+        nMsgs++;
+    }
+    printf("%d messages (%d bytes) in the mix, %d copies\n", nMsgs, dataSize, num);
+
+    // One thread, keep the last NUM_KEEP messages
+    PARSER_MSG_t *keep[NUM_KEEP] = { NULL };
+    double t0 = _now();
+    for (int ix = 0; ix < num; ix++)
+    {
+        free(keep[ix % NUM_KEEP]);
+        keep[ix % NUM_KEEP] = _mallocCopy(&msgs[ix % nMsgs]);
+    }
+    for (int ix = 0; ix < NUM_KEEP; ix++)
+    {
+        free(keep[ix]);
+        keep[ix] = NULL;
+    }
+    const double dtMalloc = _now() - t0;
+    MSGPOOL_t *pool = msgPoolCreate(0);
+    t0 = _now();
+    for (int ix = 0; ix < num; ix++)
+    {
+        msgPoolRelease(keep[ix % NUM_KEEP]);
+        keep[ix % NUM_KEEP] = msgPoolCopy(pool, &msgs[ix % nMsgs]);
+    }
+    for (int ix = 0; ix < NUM_KEEP; ix++)
+    {
+        msgPoolRelease(keep[ix]);
+    }
+    const double dtPool = _now() - t0;
+    printf("%-24s malloc %6.1f ns/msg, pool %6.1f ns/msg\n", "one thread", dtMalloc * 1e9 / num, dtPool * 1e9 / num);
+
+    // Hand over to another thread, which releases the messages
+    const double dtMallocThr = _runThreads(msgs, nMsgs, num, NULL);
+    const double dtPoolThr = _runThreads(msgs, nMsgs, num, pool);
+    printf("%-24s malloc %6.1f ns/msg, pool %6.1f ns/msg\n", "two threads", dtMallocThr * 1e9 / num,
+        dtPoolThr * 1e9 / num);
+
+    MSGPOOL_STATS_t stats;
+    msgPoolGetStats(pool, &stats);
+    printf("pool: %u slabs (%u bytes), %u used, %u free, %"PRIu64" copies, %"PRIu64" fails\n", stats.numSlabs,
+        stats.size, stats.numUsed, stats.numFree, stats.numCopies, stats.numFails);
+    for (int cls = 0; cls < MSGPOOL_NUM_CLASSES; cls++)
+    {
+        printf("  class %5u: %u used, %u free\n", stats.classSize[cls], stats.classUsed[cls], stats.classFree[cls]);
+    }
+    msgPoolDestroy(pool);
+    return 0;
+}
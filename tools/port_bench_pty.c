@@ -0,0 +1,110 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include "ff_stuff.h"
+#include "ff_port.h"
+// Serial port throughput and latency test using a pseudo terminal pair:
+// gcc -O2 -o port_bench_pty -I../ff -I../ubloxcfg port_bench_pty.c ../ff/ff_port.c ../ff/ff_stuff.c ../ff/ff_debug.c
+// ./port_bench_pty [baudrate] [options], e.g. ./port_bench_pty 3000000 lowlat
+
+static double _now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+int main(int argc, char **argv)
+{
+    const int baudrate = argc > 1 ? atoi(argv[1]) : 921600;
+    const char *opts = argc > 2 ? argv[2] : NULL;
+
+    // The master side is the "receiver", the slave side is opened with the port library
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if ( (master < 0) || (grantpt(master) != 0) || (unlockpt(master) != 0) )
+    {
+        perror("posix_openpt");
+        return 1;
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    char spec[200];
+    snprintf(spec, sizeof(spec), "ser://%s@%d%s%s", ptsname(master), baudrate, opts != NULL ? "?" : "", opts != NULL ? opts : "");
+    PORT_t port;
+    if (!portInit(&port, spec) || !portOpen(&port))
+    {
+        return 1;
+    }
+    printf("port %s, baudrate %d\n", spec, portGetBaudrate(&port));
+
+    // Throughput: master writes, port reads
+    {
+        static uint8_t buf[4096];
+        memset(buf, 0x55, sizeof(buf));
+        const int total = 16 * 1024 * 1024;
+        int nWritten = 0;
+        int nRead = 0;
+        const double t0 = _now();
+        while (nRead < total)
+        {
+            if (nWritten < total)
+            {
+                const int res = write(master, buf, MIN((int)sizeof(buf), total - nWritten));
+                if (res > 0)
+                {
+                    nWritten += res;
+                }
+            }
+            int num = 0;
+            if (portRead(&port, buf, sizeof(buf), &num) && (num > 0))
+            {
+                nRead += num;
+            }
+            else if (nWritten >= total)
+            {
+                portWaitReadable(&port, 100);
+            }
+        }
+        const double dt = _now() - t0;
+        printf("throughput: %d bytes in %.3fs, %.1f MiB/s\n", nRead, dt, (double)nRead / dt / 1048576.0);
+    }
+
+    // Latency: master writes a small message, port waits for it
+    {
+        const int n = 1000;
+        double sum = 0.0;
+        double max = 0.0;
+        uint8_t msg[100];
+        memset(msg, 0xaa, sizeof(msg));
+        for (int ix = 0; ix < n; ix++)
+        {
+            const double t0 = _now();
+            if (write(master, msg, sizeof(msg)) != sizeof(msg))
+            {
+                perror("write");
+                return 1;
+            }
+            int got = 0;
+            while (got < (int)sizeof(msg))
+            {
+                portWaitReadable(&port, 1000);
+                int num = 0;
+                if (portRead(&port, msg, sizeof(msg) - got, &num))
+                {
+                    got += num;
+                }
+            }
+            const double dt = _now() - t0;
+            sum += dt;
+            max = MAX(max, dt);
+        }
+        printf("latency: %d x %d bytes, mean %.1fus, max %.1fus\n", n, (int)sizeof(msg), sum / n * 1e6, max * 1e6);
+    }
+
+    portClose(&port);
+    close(master);
+    return 0;
+}
@@ -0,0 +1,180 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "ff_stuff.h"
+#include "ff_ubx.h"
+#include "ff_rx.h"
+#include "ff_rxsim.h"
+// Receiver control benchmark (detect/autobaud, get/set configuration, message stream) using the simulator:
+// gcc -O2 -o rx_bench_sim -DFF_VERSION_STRING=\"bench\" -I.. -I../ff -I../ubloxcfg rx_bench_sim.c ../ff/*.c ../ubloxcfg/*.c -lm -lpthread
+// ./rx_bench_sim [latency] [baudrate] [nak] [loss], e.g. ./rx_bench_sim 50 115200 0.02 0.01
+
+#define SIM_PORT "/tmp/rx_bench_sim"
+
+static volatile bool gAbort;
+
+static double _now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+static void _countCb(RX_t *rx, const PARSER_MSG_t *msg, void *arg)
+{
+    (void)rx;
+    (void)msg;
+    (*(int *)arg)++;
+}
+
+static void _pollCb(RX_t *rx, const int pollId, const RX_POLL_RES_t res, const PARSER_MSG_t *msg, void *arg)
+{
+    (void)rx;
+    (void)pollId;
+    (void)msg;
+    if (res == RX_POLL_OK)
+    {
+        (*(int *)arg)++;
+    }
+}
+
+static void *_simThread(void *arg)
+{
+    RXSIM_t *sim = arg;
+    while (!gAbort && rxSimRun(sim, 50))
+    {
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    RXSIM_OPTS_t simOpts = RXSIM_OPTS_DEFAULT();
+    simOpts.latency  = argc > 1 ? atoi(argv[1]) : 20;
+    simOpts.baudrate = argc > 2 ? atoi(argv[2]) : 115200;
+    simOpts.nak      = argc > 3 ? atof(argv[3]) : 0.0;
+    simOpts.loss     = argc > 4 ? atof(argv[4]) : 0.0;
+    simOpts.seed     = 1;
+    simOpts.verbose  = false;
+    RXSIM_t *sim = rxSimCreate("pty://" SIM_PORT, &simOpts);
+    if (sim == NULL)
+    {
+        return 1;
+    }
+    // Stream of 5Hz NAV-PVT, RXM-RAWX, NMEA and RTCM3 (about 60% of the bandwidth at 115200)
+    const UBLOXCFG_KEYVAL_t simCfg[] =
+    {
+        UBLOXCFG_KEYVAL_ANY( CFG_RATE_MEAS,                200 ),
+        UBLOXCFG_KEYVAL_MSG( CFG_MSGOUT_UBX_NAV_PVT,       UART1, 1 ),
+        UBLOXCFG_KEYVAL_MSG( CFG_MSGOUT_UBX_RXM_RAWX,      UART1, 1 ),
+        UBLOXCFG_KEYVAL_MSG( CFG_MSGOUT_RTCM_3X_TYPE1077,  UART1, 1 ),
+    };
+    rxSimSetConfig(sim, UBLOXCFG_LAYER_DEFAULT, simCfg, NUMOF(simCfg));
+    pthread_t thread;
+    pthread_create(&thread, NULL, _simThread, sim);
+    printf("simulator: latency %ums, baudrate %d, nak %.3f, loss %.3f\n", simOpts.latency, simOpts.baudrate, simOpts.nak,
+        simOpts.loss);
+
+    // Detect receiver (autobaud from 9600)
+    RX_OPTS_t rxOpts = RX_OPTS_DEFAULT();
+    rxOpts.verbose = false;
+    RX_t *rx = rxInit(SIM_PORT, &rxOpts);
+    double t0 = _now();
+    const bool detected = (rx != NULL) && rxOpen(rx);
+    printf("%-24s %s %8.1fms\n", "detect (autobaud)", detected ? "ok  " : "FAIL", (_now() - t0) * 1e3);
+    if (!detected)
+    {
+        gAbort = true;
+        pthread_join(thread, NULL);
+        rxSimDestroy(sim);
+        return 1;
+    }
+
+    // Get all items in the Default layer
+    int nAll = 0;
+    ubloxcfg_getAllItems(&nAll);
+    UBLOXCFG_KEYVAL_t *kv = malloc(nAll * sizeof(*kv));
+    const uint32_t keys[] = { UBX_CFG_VALGET_V0_ALL_WILDCARD };
+    t0 = _now();
+    const int nKv = rxGetConfig(rx, UBLOXCFG_LAYER_DEFAULT, keys, NUMOF(keys), kv, nAll);
+    printf("%-24s %s %8.1fms (%d items)\n", "get config (Default)", nKv == nAll ? "ok  " : "FAIL", (_now() - t0) * 1e3, nKv);
+
+    // Store 300 items in BBR (transaction of several UBX-CFG-VALSET)
+    int nSet = 0;
+    for (int ix = 0; (ix < nKv) && (nSet < 300); ix++)
+    {
+        const uint32_t group = UBLOXCFG_ID2GROUP(kv[ix].id);
+        if ( (group != UBLOXCFG_ID2GROUP(UBLOXCFG_CFG_UART1_BAUDRATE_ID)) &&
+             (group != UBLOXCFG_ID2GROUP(UBLOXCFG_CFG_UART1INPROT_UBX_ID)) &&
+             (group != UBLOXCFG_ID2GROUP(UBLOXCFG_CFG_UART1OUTPROT_UBX_ID)) )
+        {
+            kv[nSet++] = kv[ix];
+        }
+    }
+    t0 = _now();
+    const bool setOk = rxSetConfig(rx, kv, nSet, false, true, false);
+    printf("%-24s %s %8.1fms (%d items)\n", "set config (BBR)", setOk ? "ok  " : "FAIL", (_now() - t0) * 1e3, nSet);
+    free(kv);
+
+    // Monitoring polls, one after the other and all at once
+    const RX_POLL_UBX_t monPolls[] =
+    {
+        { .clsId = UBX_MON_CLSID, .msgId = UBX_MON_HW_MSGID },
+        { .clsId = UBX_MON_CLSID, .msgId = UBX_MON_RF_MSGID },
+        { .clsId = UBX_MON_CLSID, .msgId = UBX_MON_COMMS_MSGID },
+    };
+    int nPollOk = 0;
+    t0 = _now();
+    for (int ix = 0; ix < NUMOF(monPolls); ix++)
+    {
+        nPollOk += (rxPollUbx(rx, &monPolls[ix], NULL) != NULL ? 1 : 0);
+    }
+    printf("%-24s %s %8.1fms\n", "poll MON x3 (sync)", nPollOk == NUMOF(monPolls) ? "ok  " : "FAIL", (_now() - t0) * 1e3);
+    nPollOk = 0;
+    t0 = _now();
+    for (int ix = 0; ix < NUMOF(monPolls); ix++)
+    {
+        rxPollUbxAsync(rx, &monPolls[ix], _pollCb, &nPollOk);
+    }
+    rxAsyncRun(rx, 5000);
+    printf("%-24s %s %8.1fms\n", "poll MON x3 (async)", nPollOk == NUMOF(monPolls) ? "ok  " : "FAIL", (_now() - t0) * 1e3);
+    RX_RTT_STATS_t rtt;
+    rxGetRttStats(rx, &rtt);
+    printf("%-24s %u samples, min %u, max %u, srtt %.1f, rttvar %.1f, rto %u [ms]\n", "round-trip time",
+        rtt.numSamples, rtt.min, rtt.max, rtt.srtt, rtt.rttvar, rtt.rto);
+
+    // Message stream
+    int nPvt = 0;
+    int nRtcm = 0;
+    rxSubscribeUbx(rx, UBX_NAV_CLSID, UBX_NAV_PVT_MSGID, _countCb, &nPvt);
+    rxSubscribeRtcm3(rx, 1077, _countCb, &nRtcm);
+    int nMsgs = 0;
+    int nBytes = 0;
+    t0 = _now();
+    while ((_now() - t0) < 2.0)
+    {
+        PARSER_MSG_t *msg = rxGetNextMessageTimeout(rx, 100);
+        if ( (msg != NULL) && (msg->type != PARSER_MSGTYPE_GARBAGE) )
+        {
+            nMsgs++;
+            nBytes += msg->size;
+        }
+    }
+    const double dt = _now() - t0;
+    printf("%-24s %s %8.1f msgs/s, %.1f bytes/s (%d NAV-PVT, %d RTCM3-1077)\n", "stream", nMsgs > 0 ? "ok  " : "FAIL",
+        nMsgs / dt, nBytes / dt, nPvt, nRtcm);
+
+    rxClose(rx);
+    free(rx);
+    gAbort = true;
+    pthread_join(thread, NULL);
+    RXSIM_STATS_t stats;
+    rxSimGetStats(sim, &stats);
+    printf("simulator: %u msgs in, %u msgs out, %u acks, %u naks (%u injected), %u overflow\n",
+        stats.numMsgsIn, stats.numMsgsOut, stats.numAcks, stats.numNaks, stats.numNaksInj, stats.numOverflow);
+    rxSimDestroy(sim);
+    return 0;
+}
@@ -0,0 +1,102 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ff_stuff.h"
+#include "ff_port.h"
+// Telnet (RFC854, RFC2217) in-band data processing throughput:
+// gcc -O2 -o telnet_bench -I../ff -I../ubloxcfg telnet_bench.c ../ff/ff_port.c ../ff/ff_stuff.c ../ff/ff_debug.c
+// ./telnet_bench [megabytes]
+
+// Not in ff_port.h
+typedef struct TELNET_OPTION_s TELNET_OPTION_t;
+void _telnetProcessInband(PORT_t *port, uint8_t *buf, int nIn, int *nOut, TELNET_OPTION_t *options, const int nOptions);
+
+#define CHUNK_SIZE 4096
+
+static double _now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+// Make telnet stream (escaped IACs, and a RFC2217 NOTIFY-LINESTATE every notifyEvery bytes), and the expected data
+static int _makeStream(uint8_t *stream, uint8_t *expected, const int size, const bool withIac, const int notifyEvery,
+    int *nExpected)
+{
+    int nStream = 0;
+    int nExp = 0;
+    srand(42);
+    while (nStream < (size - 8))
+    {
+        uint8_t c = rand() & 0xff;
+        if (!withIac && (c == 0xff))
+        {
+            c = 0x55;
+        }
+        expected[nExp++] = c;
+        stream[nStream++] = c;
+        if (c == 0xff)
+        {
+            stream[nStream++] = 0xff;
+        }
+        if ( (notifyEvery > 0) && ((nExp % notifyEvery) == 0) )
+        {
+            // IAC SB COM-PORT-OPTION NOTIFY-LINESTATE (106) <state> IAC SE
+            const uint8_t notify[] = { 0xff, 0xfa, 44, 106, 0x60, 0xff, 0xf0 };
+            memcpy(&stream[nStream], notify, sizeof(notify));
+            nStream += sizeof(notify);
+        }
+    }
+    *nExpected = nExp;
+    return nStream;
+}
+
+static void _bench(const char *name, const bool withIac, const int notifyEvery, const int totalMb)
+{
+    const int streamSize = 1024 * 1024;
+    uint8_t *stream = malloc(streamSize);
+    uint8_t *expected = malloc(streamSize);
+    uint8_t *out = malloc(streamSize);
+    int nExpected = 0;
+    const int nStream = _makeStream(stream, expected, streamSize, withIac, notifyEvery, &nExpected);
+
+    PORT_t port;
+    memset(&port, 0, sizeof(port));
+    const int nIter = totalMb * 1024 * 1024 / nStream;
+    bool ok = true;
+    const double t0 = _now();
+    for (int iter = 0; iter < nIter; iter++)
+    {
+        // Process in chunks (as read from the socket), in place
+        int nOut = 0;
+        for (int offs = 0; offs < nStream; offs += CHUNK_SIZE)
+        {
+            const int n = MIN(CHUNK_SIZE, nStream - offs);
+            memcpy(&out[nOut], &stream[offs], n);
+            int nChunk = 0;
+            _telnetProcessInband(&port, &out[nOut], n, &nChunk, NULL, 0);
+            nOut += nChunk;
+        }
+        if (iter == 0)
+        {
+            ok = (nOut == nExpected) && (memcmp(out, expected, nOut) == 0);
+        }
+    }
+    const double dt = _now() - t0;
+    printf("%-28s %s %7.1f MiB/s\n", name, ok ? "ok  " : "FAIL", (double)nIter * nStream / dt / 1048576.0);
+    free(stream);
+    free(expected);
+    free(out);
+}
+
+int main(int argc, char **argv)
+{
+    const int totalMb = argc > 1 ? atoi(argv[1]) : 256;
+    _bench("no IAC",                    false, 0,    totalMb);
+    _bench("escaped IAC",               true,  0,    totalMb);
+    _bench("escaped IAC, notify/1KiB",  true,  1024, totalMb);
+    return 0;
+}